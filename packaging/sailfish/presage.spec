@@ -15,6 +15,9 @@
 # Please submit bugfixes or comments via http://bugs.opensuse.org/
 #
 
+# text2marisa is built when the MARISA headers are found
+%bcond_without marisa
+
 Name:           presage
 Version:        2.0.0
 Release:        1
@@ -33,12 +36,14 @@ BuildRequires:  gcc-c++
 BuildRequires:  help2man
 BuildRequires:  libtool
 BuildRequires:  ncurses-devel
+%if %{with marisa}
 BuildRequires:  libmarisa-devel
 BuildRequires:  libmarisa
+%endif
 BuildRequires:  hunspell-devel >= 1.5.1
 BuildRequires:  hunspell >= 1.5.1
 BuildRoot:      %{_tmppath}/%{name}-%{version}-root
-Requires:       libpresage1
+Requires:       libpresage3
 
 %description
 Presage is an intelligent predictive text entry platform.
@@ -73,13 +78,15 @@ Categories:
   - Office
   - Library
 
-%package -n libpresage1
+%package -n libpresage3
 Summary:        Intelligent predictive text entry platform (shared library)
 Group:          System/Libraries
 Requires:       presage-data
+%if %{with marisa}
 Requires:       libmarisa
+%endif
 
-%description -n libpresage1
+%description -n libpresage3
 Presage is an intelligent predictive text entry platform.
 
 A predictive text entry system attempts to improve the ease and speed of textual input by predicting words. Word prediction consists in computing which word tokens or word completions are most likely to be entered next. The system analyses the text already entered and combines the information thus extracted with other information sources to calculate the set of most probable tokens.
@@ -169,9 +176,9 @@ cp packaging/sailfish/presage.xml %{buildroot}%{_sysconfdir}/presage.xml
 cp packaging/sailfish/database_empty.db %{buildroot}%{_datadir}/presage/
 cp -r packaging/sailfish/database_empty %{buildroot}%{_datadir}/presage/
 
-%post -n libpresage1 -p /sbin/ldconfig
+%post -n libpresage3 -p /sbin/ldconfig
 
-%postun -n libpresage1 -p /sbin/ldconfig
+%postun -n libpresage3 -p /sbin/ldconfig
 
 %files
 %defattr(-,root,root)
@@ -180,13 +187,18 @@ cp -r packaging/sailfish/database_empty %{buildroot}%{_datadir}/presage/
 %{_bindir}/presage_demo_text
 %{_bindir}/presage_demo_forget
 %{_bindir}/presage_simulator
+%{_bindir}/presage_bench
 %{_bindir}/text2ngram
+%{_bindir}/arpa2bin
+%if %{with marisa}
+%{_bindir}/text2marisa
+%endif
 
-%files -n libpresage1
+%files -n libpresage3
 %defattr(-,root,root)
 %{_libdir}/libpresage.so
-%{_libdir}/libpresage.so.1
-%{_libdir}/libpresage.so.1.1.1
+%{_libdir}/libpresage.so.3
+%{_libdir}/libpresage.so.3.0.0
 
 %files -n libpresage-devel
 %defattr(-,root,root)
@@ -213,7 +225,12 @@ cp -r packaging/sailfish/database_empty %{buildroot}%{_datadir}/presage/
 %{_mandir}/man1/presage_demo.1.gz
 %{_mandir}/man1/presage_demo_text.1.gz
 %{_mandir}/man1/presage_simulator.1.gz
+%{_mandir}/man1/presage_bench.1.gz
 %{_mandir}/man1/text2ngram.1.gz
+%{_mandir}/man1/arpa2bin.1.gz
+%if %{with marisa}
+%{_mandir}/man1/text2marisa.1.gz
+%endif
 
 %changelog
 * Wed Feb 08 2017 Miklos Marton <martonmiklosqdev@gmail.com> 2.1.0-0.0.3
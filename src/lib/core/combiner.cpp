@@ -25,7 +25,8 @@
 #include "combiner.h"
 #include "profile.h"
 
-#include <set>
+#include <vector>
+#include <unordered_map>
 
 Combiner::Combiner()
 {
@@ -49,50 +50,47 @@ Combiner::~Combiner()
  *  foo, 0.3
  *  foz, 0.1
  *
- * FIXME : current implementation is O(n^2) ... it doesn't have to be.
+ * Duplicates are found through a hash index on the token, so
+ * filtering is linear in the size of the prediction.
  *
  */
 Prediction Combiner::filter(const Prediction& prediction) const
 {
     Prediction result;
 
-    std::set<std::string> seen_tokens;
+    // unique suggestions, in order of first occurrence, and index of
+    // each token into it
+    std::vector<Suggestion> unique;
+    std::unordered_map<std::string, size_t> index;
 
     size_t size = prediction.size();
-    Suggestion suggestion;
-    std::string token;
+    unique.reserve(size);
+    index.reserve(size);
     for (size_t i = 0; i < size; i++)
     {
-        suggestion = prediction.getSuggestion(i);
-        token = suggestion.getWord();
-        //std::cerr << "[filter] token: " << token << std::endl;
-        if (seen_tokens.find(token) == seen_tokens.end())
-	{
-            // if token has not been seen before, then look for
-            // potential duplicates and incrementally add the
-            // interpolated combined probability and remember that
-            // this token has now been processed
-            //
-
-            //std::cerr << "[filter] searching for possible duplicates" << std::endl;
-            for (int j = i + 1; j < size; j++)
-	    {
-                if (token == prediction.getSuggestion(j).getWord())
-		{
-		    // duplicate of token found, increment probability, up to MAX_PROBABILITY
-		    suggestion.setProbability(
-			(  (suggestion.getProbability() + prediction.getSuggestion(j).getProbability()) > Suggestion::MAX_PROBABILITY
-			 ? Suggestion::MAX_PROBABILITY 
-			 : (suggestion.getProbability() + prediction.getSuggestion(j).getProbability()))
-			);
-                    //std::cerr << "[filter] duplicate found, adjusting probability" << std::endl;
-                }
-            }
-            seen_tokens.insert(token);
-            result.addSuggestion(suggestion);
-            //std::cerr << "[filter] added token " << token << std::endl;
+        Suggestion suggestion = prediction.getSuggestion(i);
+        std::pair<std::unordered_map<std::string, size_t>::iterator, bool> entry =
+            index.insert(std::make_pair(suggestion.getWord(), unique.size()));
+        if (entry.second)
+        {
+            // token has not been seen before
+            unique.push_back(suggestion);
+        }
+        else
+        {
+            // duplicate of token found, increment probability, up to MAX_PROBABILITY
+            Suggestion& first = unique[entry.first->second];
+            double probability = first.getProbability() + suggestion.getProbability();
+            first.setProbability(probability > Suggestion::MAX_PROBABILITY
+                                 ? Suggestion::MAX_PROBABILITY
+                                 : probability);
         }
     }
 
+    for (size_t i = 0; i < unique.size(); i++)
+    {
+        result.addSuggestion(unique[i]);
+    }
+
     return result;
 }
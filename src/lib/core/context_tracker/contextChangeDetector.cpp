@@ -37,7 +37,8 @@ ContextChangeDetector::ContextChangeDetector(const std::string wChars,
 					     const std::string bChars,
 					     const std::string cChars,
 					     bool lowercase)
-    : wordChars      (wChars),
+    : sliding_window_end (0),
+      wordChars      (wChars),
       separatorChars (tChars),
       blankspaceChars(bChars),
       controlChars   (cChars),
@@ -60,7 +61,7 @@ void ContextChangeDetector::set_sliding_window_size(const std::string& str)
     }
 }
 
-void ContextChangeDetector::update_sliding_window(const std::string& str)
+void ContextChangeDetector::update_sliding_window(const std::string& str, const size_t offset)
 {
     if (str.size() <= SLIDING_WINDOW_SIZE) {
 	// past stream fits in sliding window
@@ -70,9 +71,27 @@ void ContextChangeDetector::update_sliding_window(const std::string& str)
 	sliding_window = str.substr(str.size() - SLIDING_WINDOW_SIZE);
 	assert(sliding_window.size() == SLIDING_WINDOW_SIZE);
     }
+    sliding_window_end = offset + str.size();
 }
 
-bool ContextChangeDetector::context_change(const std::string& past_stream) const
+std::string::size_type ContextChangeDetector::find_sliding_window(const std::string& past_stream,
+								  const size_t offset) const
+{
+    if (sliding_window_end >= offset + sliding_window.size()) {
+	// look for the sliding window where it was last seen, then
+	// make sure it does not occur again in the text that followed
+	std::string::size_type anchor = sliding_window_end - offset - sliding_window.size();
+	if (anchor + sliding_window.size() <= past_stream.size()
+	    && past_stream.compare(anchor, sliding_window.size(), sliding_window) == 0
+	    && past_stream.find(sliding_window, anchor + 1) == std::string::npos) {
+	    return anchor;
+	}
+    }
+
+    return past_stream.rfind(sliding_window);
+}
+
+bool ContextChangeDetector::context_change(const std::string& past_stream, const size_t offset) const
 {
     // Here's how this is going to be implemented...  We'll keep a
     // sliding window on the last few chars seen by presage; the
@@ -92,12 +111,15 @@ bool ContextChangeDetector::context_change(const std::string& past_stream) const
     // The sliding window is never implicitly updated as part of
     // invoking this method.
 
-    return context_change_helper(sliding_window, past_stream);
+    return context_change_helper(past_stream, offset);
 }
 
 
-bool ContextChangeDetector::context_change_helper(const std::string& prev_context, const std::string& curr_context) const
+bool ContextChangeDetector::context_change_helper(const std::string& past_stream, const size_t offset) const
 {
+    const std::string& prev_context = sliding_window;
+    const std::string& curr_context = past_stream;
+
     bool result = false;
     
     if (prev_context.empty()) {
@@ -114,7 +136,7 @@ bool ContextChangeDetector::context_change_helper(const std::string& prev_contex
 	// find position of previous context in current context
 	// i.e. find index pointing to last char of last occurence of
 	// prev_context in curr_context
-	std::string::size_type ctx_idx = curr_context.rfind(prev_context);
+	std::string::size_type ctx_idx = find_sliding_window(curr_context, offset);
 	
 	if (ctx_idx == std::string::npos) {
 	    // prev_context could not be found in curr_context, a lot
@@ -122,18 +144,23 @@ bool ContextChangeDetector::context_change_helper(const std::string& prev_contex
 	    result = true;
 	} else {
 	    // found prev_context, examine remainder string.
-	    // remainder string is substr(ctx_idx +
-	    // prev_context.size()); i.e. substring given by index
-	    // returned by rfind (which points at beginning of
+	    // remainder string starts at ctx_idx +
+	    // prev_context.size(); i.e. index returned by
+	    // find_sliding_window (which points at beginning of
 	    // prev_context string found in curr_context) plus size of
 	    // prev_context: this index points at end of prev_context
 	    // substring found in curr_context
 
-	    std::string remainder = curr_context.substr(ctx_idx + prev_context.size());
+	    std::string::size_type remainder = ctx_idx + prev_context.size();
 
-	    std::string::size_type idx = remainder.find_last_of(wordChars);
-	    if (idx == std::string::npos) {
-		if (remainder.empty()) {
+	    // find last word char in remainder, without looking past
+	    // its beginning
+	    std::string::size_type idx = curr_context.size();
+	    while (idx > remainder && wordChars.find(curr_context[idx - 1]) == std::string::npos) {
+		idx--;
+	    }
+	    if (idx == remainder) {
+		if (remainder == curr_context.size()) {
 		    result = false;
 		} else {
 		    char last_char = curr_context[ctx_idx + prev_context.size() - 1];
@@ -145,7 +172,7 @@ bool ContextChangeDetector::context_change_helper(const std::string& prev_contex
 		    }
 		}
 	    } else {
-		if (idx == remainder.size() - 1) {
+		if (idx == curr_context.size()) {
 		    result = false;
 		} else {
 		    result = true;
@@ -200,7 +227,7 @@ bool ContextChangeDetector::context_change_helper(const std::string& prev_contex
     return result;
 }
 
-std::string ContextChangeDetector::change(const std::string& past_stream) const
+std::string ContextChangeDetector::change(const std::string& past_stream, const size_t offset) const
 {
     const std::string& prev_context = sliding_window;  // let's rename these
     const std::string& curr_context = past_stream;     // for clarity's sake
@@ -213,7 +240,7 @@ std::string ContextChangeDetector::change(const std::string& past_stream) const
 	// find position of previous context in current context
 	// i.e. find index pointing to last char of last occurence of
 	// prev_context in curr_context
-	std::string::size_type ctx_idx = curr_context.rfind(prev_context);
+	std::string::size_type ctx_idx = find_sliding_window(curr_context, offset);
 	
 	if (ctx_idx == std::string::npos) {
 	    // prev_context could not be found in curr_context, a lot
@@ -223,10 +250,10 @@ std::string ContextChangeDetector::change(const std::string& past_stream) const
 	    // found prev_context, examine remainder string.
 	    // remainder string is substr(ctx_idx +
 	    // prev_context.size()); i.e. substring given by index
-	    // returned by rfind (which points at beginning of
-	    // prev_context string found in curr_context) plus size of
-	    // prev_context: this index points at end of prev_context
-	    // substring found in curr_context
+	    // returned by find_sliding_window (which points at
+	    // beginning of prev_context string found in curr_context)
+	    // plus size of prev_context: this index points at end of
+	    // prev_context substring found in curr_context
 
 	    result = curr_context.substr(ctx_idx + prev_context.size());
 
@@ -241,7 +268,7 @@ std::string ContextChangeDetector::change(const std::string& past_stream) const
 	    // the last token in the sliding window must be prepended
 	    // to the change to be learnt
 	    //
-	    if (context_change(past_stream)) {
+	    if (context_change(past_stream, offset)) {
 		// prepend partially entered token to change if it
 		// exists, need to look into sliding_window to get
 		// previously partially entered token if it exists
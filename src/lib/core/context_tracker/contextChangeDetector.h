@@ -42,20 +42,42 @@ public:
 			  bool);
     ~ContextChangeDetector();
 
-    bool context_change(const std::string& past_stream) const;
-    std::string change(const std::string& past_stream) const;
+    /** Tells whether the context changed since the sliding window
+     *  was last updated.
+     *
+     * past_stream may be just the end of the past stream, in which
+     * case offset is its position in the whole past stream. The same
+     * holds for the other methods taking an offset.
+     */
+    bool context_change(const std::string& past_stream, const size_t offset = 0) const;
+    std::string change(const std::string& past_stream, const size_t offset = 0) const;
 
     std::string get_sliding_window() const;
 
+    /** Returns the position in past_stream of the last occurrence of
+     *  the sliding window, or std::string::npos.
+     *
+     * The sliding window is first looked for where it ended when it
+     * was last updated. If it is still there, only the text that
+     * followed it is searched for a later occurrence, so appending
+     * to the past stream costs time proportional to the text
+     * appended. Otherwise the whole of past_stream is searched.
+     */
+    std::string::size_type find_sliding_window(const std::string& past_stream,
+					       const size_t offset = 0) const;
+
     void set_sliding_window_size(const std::string& str);
-    void update_sliding_window(const std::string& str);
+    void update_sliding_window(const std::string& str, const size_t offset = 0);
     
 private:
-    bool context_change_helper(const std::string& str1, const std::string& str2) const;
+    bool context_change_helper(const std::string& past_stream, const size_t offset) const;
 
     static const std::string::size_type DEFAULT_SLIDING_WINDOW_SIZE;
     std::string::size_type              SLIDING_WINDOW_SIZE;
     std::string                         sliding_window;
+    // past stream offset one past the end of the sliding window when
+    // it was last updated
+    std::string::size_type              sliding_window_end;
 
     const std::string wordChars;
     const std::string separatorChars;
@@ -25,15 +25,23 @@
 #include "contextTracker.h"
 #include "../utility.h"
 #include "../predictorRegistry.h"
+#include "../learner.h"
 #include "../tokenizer/forwardTokenizer.h"
 
 #include <stdlib.h>  // for atoi()
+#include <ctype.h>   // for tolower()
+
+#include <algorithm>
 
 const char* ContextTracker::LOGGER = "Presage.ContextTracker.LOGGER";
 const char* ContextTracker::SLIDING_WINDOW_SIZE = "Presage.ContextTracker.SLIDING_WINDOW_SIZE";
 const char* ContextTracker::LOWERCASE_MODE = "Presage.ContextTracker.LOWERCASE_MODE";
 const char* ContextTracker::ONLINE_LEARNING = "Presage.ContextTracker.ONLINE_LEARNING";
 
+const size_t ContextTracker::DEFAULT_PAST_STREAM_WINDOW = 1024;
+
+thread_local bool ContextTracker::worker_thread = false;
+
 ContextTracker::ContextTracker(Configuration* config,
 			       PredictorRegistry* registry,
 			       PresageCallback* callback,
@@ -45,10 +53,20 @@ ContextTracker::ContextTracker(Configuration* config,
       separatorChars (tChars),
       blankspaceChars(bChars),
       controlChars   (cChars),
+      scanner        (bChars, tChars),
+      lowercase_mode (true),
+      //tokenizer      (pastStream, blankspaceChars, separatorChars),
+      past_stream_window (DEFAULT_PAST_STREAM_WINDOW),
+      token_cache_depth (0),
+      token_cache_offset (0),
+      token_cache_next_serial (1),
+      token_cache_valid (false),
+      token_snapshot_depth (0),
+      learning_context (0),
+      learn_count    (0),
+      learner        (0),
       predictorRegistry (registry),
       logger         ("ContextTracker", std::cerr),
-      //tokenizer      (pastStream, blankspaceChars, separatorChars),
-      lowercase_mode (true),
       dispatcher     (this)
 {
     if (callback) {
@@ -85,25 +103,26 @@ ContextTracker::~ContextTracker()
 void ContextTracker::set_logger (const std::string& value)
 {
     logger << setlevel (value);
-    logger << INFO << "LOGGER: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "LOGGER: " << value << endl;
 }
 
 void ContextTracker::set_sliding_window_size (const std::string& value)
 {
     contextChangeDetector->set_sliding_window_size (value);
-    logger << INFO << "SLIDING_WINDOWS_SIZE: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "SLIDING_WINDOWS_SIZE: " << value << endl;
 }
 
 void ContextTracker::set_lowercase_mode (const std::string& value)
 {
     lowercase_mode = Utility::isYes(value);
-    logger << INFO << "LOWERCASE_MODE: " << value << endl;
+    invalidate_token_cache();
+    PRESAGE_LOG(logger, INFO) << "LOWERCASE_MODE: " << value << endl;
 }
 
 void ContextTracker::set_online_learning(const std::string& value)
 {
     online_learning = Utility::isYes(value);
-    logger << INFO << "ONLINE_LEARNING: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "ONLINE_LEARNING: " << value << endl;
 }
 
 const PresageCallback* ContextTracker::callback(const PresageCallback* new_callback)
@@ -111,6 +130,7 @@ const PresageCallback* ContextTracker::callback(const PresageCallback* new_callb
     const PresageCallback* result = context_tracker_callback;
     if (new_callback) {
 	context_tracker_callback = new_callback;
+	invalidate_token_cache();
     }
     return result;
 }
@@ -120,27 +140,67 @@ const PresageCallback* ContextTracker::callback(const PresageCallback* new_callb
  */
 bool ContextTracker::contextChange()
 {
-    return contextChangeDetector->context_change(getPastStream());
+    size_t offset = 0;
+    std::string past_stream = getRecentPastStream(offset);
+    return contextChangeDetector->context_change(past_stream, offset);
 }
 
 void ContextTracker::update()
 {
+    size_t offset = 0;
+    std::string past_stream = getRecentPastStream(offset);
+
     // detect change that needs to be learned
-    std::string change = contextChangeDetector->change(getPastStream());
+    std::string change = contextChangeDetector->change(past_stream, offset);
 
     if (online_learning)
     {
-	learn (change);
+	if (learner) {
+	    learner->enqueue (change);
+	} else {
+	    learn (change);
+	}
     }
 
     // update sliding window
-    contextChangeDetector->update_sliding_window(getPastStream());
+    contextChangeDetector->update_sliding_window(past_stream, offset);
+}
+
+void ContextTracker::setLearner(Learner* value)
+{
+    learner = value;
 }
 
 void ContextTracker::learn(const std::string& text) const
 {
-    logger << INFO << "learn(): text: " << text << endl;
+    PRESAGE_LOG(logger, INFO) << "learn(): text: " << text << endl;
+
+    learn_tokens(tokenize(text));
+}
+
+void ContextTracker::learn(const std::vector<std::string>& tokens,
+			   const std::vector<std::string>& context) const
+{
+    {
+	std::lock_guard<std::mutex> lock(token_cache_mutex);
+	learning_context = &context;
+	learning_thread = std::this_thread::get_id();
+    }
+
+    try {
+	learn_tokens(tokens);
+    } catch (...) {
+	std::lock_guard<std::mutex> lock(token_cache_mutex);
+	learning_context = 0;
+	throw;
+    }
 
+    std::lock_guard<std::mutex> lock(token_cache_mutex);
+    learning_context = 0;
+}
+
+std::vector<std::string> ContextTracker::tokenize(const std::string& text) const
+{
     std::stringstream stream_to_learn(text);
 
     // split stream up into tokens
@@ -149,13 +209,13 @@ void ContextTracker::learn(const std::string& text) const
 			 blankspaceChars,
 			 separatorChars);
     tok.lowercaseMode(lowercase_mode);
-    logger << INFO << "learn(): tokenized change: ";
+    PRESAGE_LOG(logger, INFO) << "learn(): tokenized change: ";
     while (tok.hasMoreTokens()) {
 	std::string token = tok.nextToken();
 	tokens.push_back(token);
-	logger << INFO << token << '|';
+	PRESAGE_LOG(logger, INFO) << token << '|';
     }
-    logger << INFO << endl;
+    PRESAGE_LOG(logger, INFO) << endl;
 
     if (! tokens.empty()) {
 	// remove prefix (partially entered token or empty token)
@@ -173,27 +233,47 @@ void ContextTracker::learn(const std::string& text) const
 	logger << endl;
     }
 
+    return tokens;
+}
+
+void ContextTracker::learn_tokens(const std::vector<std::string>& tokens) const
+{
+    // may run on the learner thread, hence no logging here
+
     // time to learn
     PredictorRegistry::Iterator it = predictorRegistry->iterator();
     Predictor* predictor = 0;
 
     while (it.hasNext()) {
 	predictor = it.next();
+	std::lock_guard<std::mutex> lock(predictor->get_mutex());
 	predictor->learn(tokens);
     }
+
+    if (! tokens.empty()) {
+	learn_count++;
+    }
 }
 
 void ContextTracker::forget(const std::string& word) const
 {
-    logger << INFO << "forget(): word: " << word << endl;
+    PRESAGE_LOG(logger, INFO) << "forget(): word: " << word << endl;
 
     PredictorRegistry::Iterator it = predictorRegistry->iterator();
     Predictor* predictor = 0;
 
     while (it.hasNext()) {
 	predictor = it.next();
+	std::lock_guard<std::mutex> lock(predictor->get_mutex());
 	predictor->forget(word);
     }
+
+    learn_count++;
+}
+
+unsigned long ContextTracker::getLearnCount() const
+{
+    return learn_count;
 }
 
 std::string ContextTracker::getPrefix() const
@@ -203,42 +283,231 @@ std::string ContextTracker::getPrefix() const
 
 std::string ContextTracker::getToken(const int index) const
 {
-    std::stringstream pastStringStream(context_tracker_callback->get_past_stream());
-    ReverseTokenizer tokenizer(pastStringStream, blankspaceChars, separatorChars);
-    tokenizer.lowercaseMode(lowercase_mode);
+    unsigned long serial;
+    return getToken(index, serial);
+}
+
+std::string ContextTracker::getToken(const int index, unsigned long& serial) const
+{
+    serial = 0;
+
+    // predictors may query tokens from PredictorActivator worker threads
+    std::lock_guard<std::mutex> lock(token_cache_mutex);
+
+    if (learning_context && std::this_thread::get_id() == learning_thread) {
+	if (index < 0 || static_cast<size_t>(index) >= learning_context->size()) {
+	    return "";
+	}
+	return (*learning_context)[index];
+    }
+
+    const bool refresh = (token_snapshot_depth == 0 && ! worker_thread);
+    if (refresh) {
+	refresh_token_cache();
+    }
 
-    std::string token;
-    int i = 0;
-    while (tokenizer.hasMoreTokens() && i <= index) {
-        token = tokenizer.nextToken();
-        i++;
+    // tokens are indexed backwards from the end of the past stream;
+    // token 0 is the prefix, which is empty when the past stream ends
+    // with a blankspace or separator character
+    //
+    //    "a b c"    "a b c "
+    //     2 1 0      3 2 1 0
+    //
+    size_t index_from_end = index;
+    if (! token_cache_stream.empty()) {
+	char last = token_cache_stream[token_cache_stream.size() - 1];
+	if (isBlankspaceChar(last) || isSeparatorChar(last)) {
+	    if (index_from_end == 0) {
+		return "";
+	    }
+	    index_from_end--;
+	}
     }
-    if (i <= index) {
+
+    // the token may lie before the end of the past stream held in
+    // the cache, in which case more of the past stream is requested,
+    // right away if the callback may be queried, or else when the
+    // next snapshot begins
+    if (index >= 0) {
+	token_cache_depth = std::max(token_cache_depth, index_from_end + 1);
+	if (refresh) {
+	    grow_token_cache(index_from_end + 1);
+	}
+    }
+
+    if (index < 0 || index_from_end >= token_cache.size()) {
 	// in case the index points too far back
-	token = "";
+	return "";
     }
-    return token;
-
-//// Using ForwardTokenizer
-//    "a b c"
-//     2 1 0
-//     0 1 2
-//     1 2 3
-//
-//    ForwardTokenizer tokenizer(pastStream, blankspaceChars, separatorChars);
-//    tokenizer.lowercaseMode(lowercase_mode);
-//    std::string result;
-//    int tokens = tokenizer.countTokens();
-//    // why oh why is this clear() required to get it to work???
-//    pastStream.clear();
-//    int j = 0;
-//    while (tokenizer.hasMoreTokens() && j < tokens - index) {
-//	result = tokenizer.nextToken();
-//	j++;
-//
-//	std::cerr << "ContextTracker::getToken() current token: " << result << std::endl;
-//    }
-//    return result;
+    serial = token_cache_serials[token_cache.size() - 1 - index_from_end];
+    return token_cache[token_cache.size() - 1 - index_from_end];
+}
+
+void ContextTracker::beginTokenSnapshot()
+{
+    std::lock_guard<std::mutex> lock(token_cache_mutex);
+
+    if (token_snapshot_depth++ == 0) {
+	// size the window to the tokens requested since the previous
+	// snapshot began: go back to the default window once they lie
+	// within it again, or request more of the past stream if they
+	// were not all available
+	const size_t end = token_cache_offset + token_cache_stream.size();
+	if (past_stream_window > DEFAULT_PAST_STREAM_WINDOW
+	    && token_cache_depth <= token_cache.size()
+	    && (token_cache_depth == 0
+		|| token_cache_begins[token_cache.size() - token_cache_depth] + DEFAULT_PAST_STREAM_WINDOW > end)) {
+	    past_stream_window = DEFAULT_PAST_STREAM_WINDOW;
+	}
+	refresh_token_cache();
+	grow_token_cache(token_cache_depth);
+	token_cache_depth = 0;
+    }
+}
+
+void ContextTracker::endTokenSnapshot()
+{
+    std::lock_guard<std::mutex> lock(token_cache_mutex);
+
+    if (token_snapshot_depth > 0) {
+	token_snapshot_depth--;
+    }
+}
+
+void ContextTracker::setWorkerThread()
+{
+    worker_thread = true;
+}
+
+void ContextTracker::refresh_token_cache() const
+{
+    size_t offset = 0;
+    const std::string past_stream =
+	context_tracker_callback->get_past_stream_tail(past_stream_window, offset);
+
+    if (token_cache_valid
+	&& offset == token_cache_offset
+	&& past_stream == token_cache_stream) {
+	return;
+    }
+
+    const char* text = past_stream.data();
+    const size_t length = past_stream.size();
+
+    // find first past stream offset at which the text differs from
+    // the previously tokenized window
+    size_t common = offset;
+    if (token_cache_valid) {
+	common = std::max(offset, token_cache_offset);
+	size_t overlap_end = std::min(offset + length,
+				      token_cache_offset + token_cache_stream.size());
+	while (common < overlap_end
+	       && text[common - offset] == token_cache_stream[common - token_cache_offset]) {
+	    common++;
+	}
+    }
+
+    // a token is still valid if it and the character that ended it
+    // are unchanged, otherwise it could have been altered or extended
+    while (! token_cache_ends.empty() && token_cache_ends.back() >= common) {
+	token_cache.pop_back();
+	token_cache_begins.pop_back();
+	token_cache_ends.pop_back();
+	token_cache_serials.pop_back();
+    }
+
+    // unless the window starts at the beginning of the past stream,
+    // its first token may be cut short, and so may be any token
+    // starting right at the window
+    size_t first = 0;
+    if (offset > 0) {
+	while (first < token_cache_begins.size() && token_cache_begins[first] <= offset) {
+	    first++;
+	}
+	token_cache.erase(token_cache.begin(), token_cache.begin() + first);
+	token_cache_begins.erase(token_cache_begins.begin(), token_cache_begins.begin() + first);
+	token_cache_ends.erase(token_cache_ends.begin(), token_cache_ends.begin() + first);
+	token_cache_serials.erase(token_cache_serials.begin(), token_cache_serials.begin() + first);
+    }
+    size_t start = (offset > 0 ? scanner.findDelimiter(text, length, 0) : 0);
+
+    if (! token_cache.empty()) {
+	// tokens preceding the cached ones, if the window grew back
+	std::vector<std::string> tokens;
+	std::vector<size_t> begins;
+	std::vector<size_t> ends;
+	size_t pos = start;
+	while (pos < length) {
+	    BufferTokenizer::Token token = scanner.forward(text, length, pos);
+	    size_t begin = offset + (token.data - text);
+	    if (token.empty() || begin >= token_cache_begins.front()) {
+		break;
+	    }
+	    tokens.push_back(token.str());
+	    begins.push_back(begin);
+	    ends.push_back(offset + pos);
+	}
+	if (! tokens.empty()) {
+	    std::vector<unsigned long> serials;
+	    for (size_t i = 0; i < tokens.size(); i++) {
+		if (lowercase_mode) {
+		    BufferTokenizer::lowercase(tokens[i]);
+		}
+		serials.push_back(token_cache_next_serial++);
+	    }
+	    token_cache.insert(token_cache.begin(), tokens.begin(), tokens.end());
+	    token_cache_begins.insert(token_cache_begins.begin(), begins.begin(), begins.end());
+	    token_cache_ends.insert(token_cache_ends.begin(), ends.begin(), ends.end());
+	    token_cache_serials.insert(token_cache_serials.begin(), serials.begin(), serials.end());
+	}
+    }
+
+    // tokenize the rest of the window
+    size_t pos = (token_cache_ends.empty() ? start : token_cache_ends.back() - offset);
+    while (pos < length) {
+	BufferTokenizer::Token token = scanner.forward(text, length, pos);
+	if (token.empty()) {
+	    break;
+	}
+
+	token_cache.push_back(token.str());
+	if (lowercase_mode) {
+	    BufferTokenizer::lowercase(token_cache.back());
+	}
+	token_cache_begins.push_back(offset + (token.data - text));
+	token_cache_ends.push_back(offset + pos);
+	token_cache_serials.push_back(token_cache_next_serial++);
+    }
+
+    token_cache_stream = past_stream;
+    token_cache_offset = offset;
+    token_cache_valid = true;
+
+    PRESAGE_LOG(logger, DEBUG) << "refresh_token_cache(): " << token_cache.size() << " tokens, "
+	   << offset + length - common << " characters changed" << endl;
+}
+
+void ContextTracker::grow_token_cache(size_t tokens) const
+{
+    while (token_cache.size() < tokens
+	   && token_cache_offset > 0
+	   && token_cache_stream.size() >= past_stream_window) {
+	past_stream_window *= 2;
+	refresh_token_cache();
+    }
+}
+
+void ContextTracker::invalidate_token_cache()
+{
+    std::lock_guard<std::mutex> lock(token_cache_mutex);
+
+    token_cache_stream.clear();
+    token_cache_offset = 0;
+    token_cache.clear();
+    token_cache_begins.clear();
+    token_cache_ends.clear();
+    token_cache_serials.clear();
+    token_cache_valid = false;
 }
 
 std::string ContextTracker::getExtraTokenToLearn(const int index, const std::vector<std::string>& change) const
@@ -281,6 +550,26 @@ std::string ContextTracker::getPastStream() const
     return result;
 }
 
+std::string ContextTracker::getRecentPastStream(size_t& offset) const
+{
+    // the last occurrence of the sliding window in the end of the
+    // past stream is its last occurrence in the whole past stream, so
+    // the context change detector tells the same change from either
+    std::string sliding_window = contextChangeDetector->get_sliding_window();
+    if (! sliding_window.empty()) {
+	std::string past_stream =
+	    context_tracker_callback->get_past_stream_tail(std::max(DEFAULT_PAST_STREAM_WINDOW,
+								    4 * sliding_window.size()),
+							   offset);
+	if (offset == 0
+	    || contextChangeDetector->find_sliding_window(past_stream, offset) != std::string::npos) {
+	    return past_stream;
+	}
+    }
+    offset = 0;
+    return getPastStream();
+}
+
 bool ContextTracker::isCompletionValid(const std::string& completion) const
 {
     bool result = false;
@@ -304,18 +593,12 @@ bool ContextTracker::isWordChar(const char c) const
 
 bool ContextTracker::isSeparatorChar(const char c) const
 {
-    if(separatorChars.find(c, 0) != std::string::npos)
-        return true;
-    else
-        return false;
+    return scanner.isSeparator(c);
 }
 
 bool ContextTracker::isBlankspaceChar(const char c) const
 {
-    if(blankspaceChars.find(c, 0) != std::string::npos)
-        return true;
-    else
-        return false;
+    return scanner.isBlankspace(c);
 }
 
 bool ContextTracker::isControlChar(const char c) const
@@ -353,7 +636,7 @@ std::string ContextTracker::toString() const
 
 void ContextTracker::update (const Observable* variable)
 {
-    logger << DEBUG << "Notification received: "
+    PRESAGE_LOG(logger, DEBUG) << "Notification received: "
 	   << variable->get_name () << " - " << variable->get_value () << endl;
 
     dispatcher.dispatch (variable);
@@ -33,11 +33,15 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
 #include <assert.h>
 
 #include "contextChangeDetector.h"
 
 #include "../tokenizer/reverseTokenizer.h"
+#include "../tokenizer/bufferTokenizer.h"
 #include "../charsets.h"
 #include "../configuration.h"
 #include "../logger.h"
@@ -46,6 +50,7 @@
 #include "../../presageCallback.h"
 
 class PredictorRegistry;
+class Learner;
 
 /** \brief Tracks user interaction and context.
  *
@@ -170,6 +175,40 @@ public:
     std::string getPrefix() const;
     std::string getToken (const int) const;
 
+    /** \brief Returns the token at index and a serial number identifying it.
+     *
+     * A token keeps its serial number for as long as neither it nor
+     * any token before it in the past stream changes, so callers can
+     * tell which tokens were added since they last looked. Serial
+     * number zero means there is no such token.
+     */
+    std::string getToken (const int index, unsigned long& serial) const;
+
+    /** \brief Pins the cached tokens of the current past stream.
+     *
+     * Between beginTokenSnapshot() and endTokenSnapshot(), getToken()
+     * and getPrefix() are answered from the token cache, without
+     * querying the callback for the past stream. Presage holds a
+     * snapshot for the duration of each prediction, during which the
+     * past stream cannot change. Tokens requested during a snapshot
+     * that lie before the cached end of the past stream are read
+     * from the callback when the next snapshot begins.
+     *
+     * Snapshots may be nested.
+     */
+    void beginTokenSnapshot();
+    void endTokenSnapshot();
+
+    /** \brief Marks the calling thread as a prediction worker thread.
+     *
+     * Worker threads never query the callback: outside of a token
+     * snapshot, getToken() answers them from the token cache as it
+     * stands. A predictor that missed the prediction deadline can
+     * thus run on after the snapshot without calling into the host
+     * application from a thread it does not expect.
+     */
+    static void setWorkerThread();
+
     std::string getExtraTokenToLearn(const int index,
 				     const std::vector<std::string>& change) const;
 
@@ -197,8 +236,43 @@ public:
      */
     void learn(const std::string& text) const;
 
+    /** \brief Learn tokens in a past context
+     *
+     * Train the predictors on the \param tokens of a change detected
+     * earlier. While the predictors learn, getToken(i) answers
+     * \param context[i] to the calling thread, so that context is
+     * the past stream as it was when the change was detected.
+     *
+     */
+    void learn(const std::vector<std::string>& tokens,
+	       const std::vector<std::string>& context) const;
+
+    /** \brief Splits text into the tokens to learn
+     *
+     * The last token is dropped, as it may be partially entered.
+     *
+     */
+    std::vector<std::string> tokenize(const std::string& text) const;
+
+    /** \brief Hands online learning over to learner.
+     *
+     * Changes detected by update() are queued to learner rather than
+     * learnt straight away. Passing a null pointer restores
+     * synchronous learning.
+     *
+     */
+    void setLearner(Learner* learner);
+
     void forget(const std::string& word) const;
 
+    /** \brief Number of times the predictors learnt or forgot.
+     *
+     * Incremented by learn() and forget() whenever they pass a change
+     * on to the predictors, so that results computed from the
+     * predictors can be recognised as stale.
+     */
+    unsigned long getLearnCount() const;
+
     virtual void update (const Observable* variable);
 
     void set_logger (const std::string& value);
@@ -217,6 +291,8 @@ private:
     std::string blankspaceChars;
     std::string controlChars;
 
+    BufferTokenizer scanner;
+
     bool lowercase_mode;
     bool online_learning;
 
@@ -224,6 +300,65 @@ private:
     // each method invocation that needs it
     //ReverseTokenizer tokenizer;
 
+    /** Brings the token cache in sync with the past stream.
+     *
+     * Only the last past_stream_window characters of the past stream
+     * are requested from the callback. Only the tokens following the
+     * first character that differs from the previously tokenized
+     * window are rebuilt, so appending or deleting characters at the
+     * end of a long stream retokenizes just the last token.
+     */
+    void refresh_token_cache() const;
+    void invalidate_token_cache();
+
+    /** Requests more of the past stream until the token cache holds
+     *  at least the given number of tokens, or the whole past stream.
+     */
+    void grow_token_cache(size_t tokens) const;
+
+    /** Returns the end of the past stream the context change
+     *  detector needs to relate it to its sliding window, falling
+     *  back to the whole past stream, and sets offset to its
+     *  position in the past stream.
+     */
+    std::string getRecentPastStream(size_t& offset) const;
+
+    static const size_t DEFAULT_PAST_STREAM_WINDOW;
+    // number of characters requested from the end of the past
+    // stream for the token cache, doubled whenever they hold too few
+    // tokens, and reset when a snapshot begins if the default window
+    // holds all the tokens requested since the previous one
+    mutable size_t past_stream_window;
+    // number of tokens from the end of the past stream requested
+    // since the last snapshot began
+    mutable size_t token_cache_depth;
+
+    // end of the past stream the token cache was built from and its
+    // offset in the past stream
+    mutable std::string token_cache_stream;
+    mutable size_t token_cache_offset;
+    // tokens lying wholly within token_cache_stream in forward order,
+    // past stream offsets of their first character and one past
+    // their last character, and their serial numbers
+    mutable std::vector<std::string> token_cache;
+    mutable std::vector<std::string::size_type> token_cache_begins;
+    mutable std::vector<std::string::size_type> token_cache_ends;
+    mutable std::vector<unsigned long> token_cache_serials;
+    mutable unsigned long token_cache_next_serial;
+    mutable bool token_cache_valid;
+    int token_snapshot_depth;
+    static thread_local bool worker_thread;
+    mutable std::mutex token_cache_mutex;
+
+    // past stream tokens seen by the thread learning a past change
+    mutable const std::vector<std::string>* learning_context;
+    mutable std::thread::id learning_thread;
+
+    void learn_tokens(const std::vector<std::string>& tokens) const;
+
+    mutable std::atomic<unsigned long> learn_count;
+    Learner* learner;
+
     // utility functions
     bool isWordChar      (const char) const;
     bool isSeparatorChar (const char) const;
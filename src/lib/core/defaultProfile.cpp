@@ -90,7 +90,9 @@ void DefaultProfile::build_xml_document (const std::string& filename)
 "    <PredictorActivator>"
 "        <LOGGER>ERROR</LOGGER>"
 "        <!-- PREDICT_TIME"
-"          Maximum time allowed for predictors to return their prediction."
+"          Maximum time allowed for predictors to return their prediction,"
+"          in milliseconds. Predictions returned later are discarded."
+"          Set to 0 to wait for all predictors."
 "        -->"
 "        <PREDICT_TIME>1000</PREDICT_TIME>"
 "        <!-- MAX_PARTIAL_PREDICTION_SIZE"
@@ -103,6 +105,46 @@ void DefaultProfile::build_xml_document (const std::string& filename)
 "        -->"
 "        <COMBINATION_POLICY>Meritocracy</COMBINATION_POLICY>"
 "    </PredictorActivator>"
+"    <PredictionCache>"
+"        <LOGGER>ERROR</LOGGER>"
+"        <!-- SIZE"
+"          Maximum number of predictions remembered, so that asking"
+"          again for a prediction in the same context does not run"
+"          the predictors. Set to 0 to disable the cache."
+"        -->"
+"        <SIZE>32</SIZE>"
+"        <!-- CONTEXT_TOKENS"
+"          Number of tokens preceding the prefix that identify the"
+"          context of a cached prediction."
+"        -->"
+"        <CONTEXT_TOKENS>3</CONTEXT_TOKENS>"
+"    </PredictionCache>"
+"    <Learner>"
+"        <LOGGER>ERROR</LOGGER>"
+"        <!-- QUEUE_SIZE"
+"          Maximum number of changes waiting to be learnt online in"
+"          the background. Set to 0 to learn them as soon as they"
+"          are detected, before predict() returns."
+"        -->"
+"        <QUEUE_SIZE>64</QUEUE_SIZE>"
+"        <!-- IDLE_DELAY"
+"          Time without typing after which queued changes are"
+"          learnt, in milliseconds."
+"        -->"
+"        <IDLE_DELAY>1000</IDLE_DELAY>"
+"        <!-- CONTEXT_TOKENS"
+"          Number of tokens preceding a change kept to learn the"
+"          n-grams that straddle it. Should be no lower than the"
+"          largest n-gram cardinality minus one."
+"        -->"
+"        <CONTEXT_TOKENS>4</CONTEXT_TOKENS>"
+"        <!-- JOURNAL"
+"          File queued changes are saved to until they are learnt,"
+"          so that they are not lost if the application exits"
+"          abruptly. Leave empty to disable the journal."
+"        -->"
+"        <JOURNAL>${HOME}/.presage/learner.journal</JOURNAL>"
+"    </Learner>"
 "    <ProfileManager>"
 "        <LOGGER>ERROR</LOGGER>"
 "        <!-- AUTOPERSIST"
@@ -166,7 +208,7 @@ void DefaultProfile::build_xml_document (const std::string& filename)
 "        <DefaultARPAPredictor>"
 "            <PREDICTOR>ARPAPredictor</PREDICTOR>"
 "            <LOGGER>ERROR</LOGGER>"
-"            <ARPAFILENAME>" pkgdatadir "/arpa_en.arpa</ARPAFILENAME>"
+"            <ARPAFILENAME>" pkgdatadir "/arpa_en.bin</ARPAFILENAME>"
 "            <VOCABFILENAME>" pkgdatadir "/arpa_en.vocab</VOCABFILENAME>"
 "            <TIMEOUT>100</TIMEOUT>"
 "        </DefaultARPAPredictor>"
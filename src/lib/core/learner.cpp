@@ -0,0 +1,496 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#include "learner.h"
+#include "utility.h"
+
+#include <sstream>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef HAVE_SYS_FILE_H
+# include <sys/file.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+const char* Learner::QUEUE_SIZE = "Presage.Learner.QUEUE_SIZE";
+const char* Learner::IDLE_DELAY = "Presage.Learner.IDLE_DELAY";
+const char* Learner::CONTEXT_TOKENS = "Presage.Learner.CONTEXT_TOKENS";
+const char* Learner::JOURNAL = "Presage.Learner.JOURNAL";
+
+const char* Learner::LOGGER = "Presage.Learner.LOGGER";
+
+Learner::Learner(Configuration* configuration, ContextTracker* ct)
+    : queue_size(0),
+      idle_delay(0),
+      context_tokens(0),
+      rewriting(false),
+      journal_lock(-1),
+      learning(false),
+      flushing(false),
+      stopping(false),
+      contextTracker(ct),
+      config(configuration),
+      logger("Learner", std::cerr),
+      dispatcher(this)
+{
+    // build notification dispatch map
+    dispatcher.map (config->find (LOGGER), & Learner::set_logger);
+    dispatcher.map (config->find (QUEUE_SIZE), & Learner::set_queue_size);
+    dispatcher.map (config->find (IDLE_DELAY), & Learner::set_idle_delay);
+    dispatcher.map (config->find (CONTEXT_TOKENS), & Learner::set_context_tokens);
+    dispatcher.map (config->find (JOURNAL), & Learner::set_journal);
+
+    worker = std::thread(&Learner::execute, this);
+
+    contextTracker->setLearner(this);
+}
+
+Learner::~Learner()
+{
+    contextTracker->setLearner(0);
+
+    // learn what is left in the queue
+    {
+	std::lock_guard<std::mutex> lock(mutex);
+	stopping = true;
+    }
+    queue_condition.notify_all();
+    worker.join();
+
+    journal.close();
+    unlock_journal();
+}
+
+void Learner::enqueue(const std::string& text)
+{
+    if (queue_size == 0) {
+	contextTracker->learn(text);
+	return;
+    }
+
+    Change change;
+    change.tokens = contextTracker->tokenize(text);
+    if (change.tokens.empty()) {
+	return;
+    }
+
+    // the past stream will have moved on by the time the change is
+    // learnt, keep the tokens the predictors may ask for
+    size_t count = change.tokens.size() + 1 + context_tokens;
+    for (size_t i = 0; i < count; i++) {
+	change.context.push_back(contextTracker->getToken(i));
+    }
+    // only the prefix may be an empty token, the others are past the
+    // beginning of the stream
+    while (change.context.size() > 1 && change.context.back().empty()) {
+	change.context.pop_back();
+    }
+
+    push(change);
+}
+
+void Learner::push(const Change& change)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (journal.is_open()) {
+	write_journal_entry(journal, change);
+	journal.flush();
+	if (rewriting) {
+	    rewrite_backlog.push_back(change);
+	}
+    }
+
+    last_change = std::chrono::steady_clock::now();
+    if (queue.empty() || ! merge(queue.back(), change)) {
+	queue_condition.wait(lock, [this]() { return queue.size() < queue_size || stopping; });
+	queue.push_back(change);
+    }
+    queue_condition.notify_all();
+}
+
+bool Learner::merge(Change& change, const Change& next) const
+{
+    // next continues change if the tokens preceding next, as far as
+    // both contexts go, are those of change and the tokens that
+    // preceded it
+    size_t offset = next.tokens.size() + 1;
+    if (next.context.size() <= offset || change.context.size() <= 1) {
+	return false;
+    }
+    size_t overlap = std::min(next.context.size() - offset, change.context.size() - 1);
+    if (! std::equal(next.context.begin() + offset,
+		     next.context.begin() + offset + overlap,
+		     change.context.begin() + 1)) {
+	return false;
+    }
+
+    std::vector<std::string> context(next.context.begin(), next.context.begin() + offset);
+    context.insert(context.end(), change.context.begin() + 1, change.context.end());
+
+    change.tokens.insert(change.tokens.end(), next.tokens.begin(), next.tokens.end());
+    change.context.swap(context);
+    if (change.context.size() > change.tokens.size() + 1 + context_tokens) {
+	change.context.resize(change.tokens.size() + 1 + context_tokens);
+    }
+
+    return true;
+}
+
+void Learner::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    flushing = true;
+    queue_condition.notify_all();
+    idle_condition.wait(lock, [this]() { return queue.empty() && ! learning; });
+    flushing = false;
+}
+
+size_t Learner::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return queue.size() + (learning ? 1 : 0);
+}
+
+void Learner::execute()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;) {
+	// changes are learnt once the user stops typing, unless the
+	// queue is full or has to be emptied
+	while (! queue.empty()
+	       && ! flushing
+	       && ! stopping
+	       && queue.size() < queue_size
+	       && std::chrono::steady_clock::now() < last_change + idle_delay) {
+	    queue_condition.wait_until(lock, last_change + idle_delay);
+	}
+
+	if (queue.empty()) {
+	    if (stopping) {
+		break;
+	    }
+	    queue_condition.wait(lock);
+	    continue;
+	}
+
+	std::deque<Change> batch;
+	batch.swap(queue);
+	learning = true;
+	lock.unlock();
+	queue_condition.notify_all();
+
+	for (std::deque<Change>::const_iterator it = batch.begin(); it != batch.end(); it++) {
+	    try {
+		contextTracker->learn(it->tokens, it->context);
+	    } catch (std::exception& ex) {
+		logger << ERROR << "Error learning change: " << ex.what() << endl;
+	    }
+	}
+
+	lock.lock();
+	// flush() returns once the journal no longer holds the batch
+	rewrite_journal(lock);
+	learning = false;
+	if (queue.empty()) {
+	    idle_condition.notify_all();
+	}
+    }
+}
+
+void Learner::write_journal_entry(std::ostream& out, const Change& change) const
+{
+    out << change.tokens.size();
+    for (size_t i = 0; i < change.tokens.size(); i++) {
+	out << '\t' << change.tokens[i];
+    }
+    for (size_t i = 0; i < change.context.size(); i++) {
+	out << '\t' << change.context[i];
+    }
+    out << '\n';
+}
+
+bool Learner::read_journal_entry(const std::string& line, Change& change) const
+{
+    std::vector<std::string> fields;
+    std::string::size_type begin = 0;
+    std::string::size_type tab;
+    while ((tab = line.find('\t', begin)) != std::string::npos) {
+	fields.push_back(line.substr(begin, tab - begin));
+	begin = tab + 1;
+    }
+    fields.push_back(line.substr(begin));
+
+    int count = Utility::toInt(fields[0]);
+    if (count <= 0 || static_cast<size_t>(count) >= fields.size()) {
+	return false;
+    }
+
+    change.tokens.assign(fields.begin() + 1, fields.begin() + 1 + count);
+    change.context.assign(fields.begin() + 1 + count, fields.end());
+    return true;
+}
+
+/** Learns the changes left in the journal, then appends to it.
+ *
+ * Called with no changes queued.
+ */
+void Learner::open_journal()
+{
+    if (journal.is_open()) {
+	journal.close();
+    }
+    unlock_journal();
+    if (journal_filename.empty()) {
+	return;
+    }
+
+    std::string dir = Utility::dirname (journal_filename);
+    if (! dir.empty() && ! Utility::is_directory_usable (dir)) {
+	Utility::create_directory (dir);
+    }
+
+    // the changes left in the journal of a running process are its
+    // own to learn
+    if (! lock_journal()) {
+	PRESAGE_LOG(logger, WARN) << "Journal " << journal_filename
+				  << " is in use by another process, changes are not journaled" << endl;
+	return;
+    }
+
+    size_t replayed = 0;
+    {
+	std::ifstream in(journal_filename.c_str());
+	std::string line;
+	std::lock_guard<std::mutex> lock(mutex);
+	while (std::getline(in, line)) {
+	    Change change;
+	    if (read_journal_entry(line, change)) {
+		if (queue.empty() || ! merge(queue.back(), change)) {
+		    queue.push_back(change);
+		}
+		replayed++;
+	    }
+	}
+	last_change = std::chrono::steady_clock::now();
+    }
+    queue_condition.notify_all();
+
+    if (replayed > 0) {
+	PRESAGE_LOG(logger, INFO) << "Replaying " << replayed << " changes from journal " << journal_filename << endl;
+    }
+
+    journal.open(journal_filename.c_str(), std::ios::out | std::ios::app);
+    if (! journal) {
+	logger << ERROR << "Error opening journal " << journal_filename
+	       << ", changes are not journaled" << endl;
+	journal.close();
+	unlock_journal();
+    }
+}
+
+/** Rewrites the journal with the changes still queued.
+ *
+ * Called with the mutex held, which is released while the new journal
+ * is written. Changes pushed meanwhile are appended to both journals.
+ */
+void Learner::rewrite_journal(std::unique_lock<std::mutex>& lock)
+{
+    if (! journal.is_open()) {
+	return;
+    }
+
+    std::string tmp = journal_filename + ".tmp";
+    std::deque<Change> changes(queue);
+    rewriting = true;
+
+    lock.unlock();
+    std::ofstream out(tmp.c_str(), std::ios::out | std::ios::trunc);
+    for (;;) {
+	for (std::deque<Change>::const_iterator it = changes.begin(); it != changes.end(); it++) {
+	    write_journal_entry(out, *it);
+	}
+	out.flush();
+
+	lock.lock();
+	changes.clear();
+	changes.swap(rewrite_backlog);
+	if (changes.empty()) {
+	    break;
+	}
+	lock.unlock();
+    }
+    rewriting = false;
+    out.close();
+
+    // the previous journal holds every queued change, keep it on failure
+    journal.close();
+    if (! out) {
+	logger << ERROR << "Error writing journal " << tmp << endl;
+	remove(tmp.c_str());
+    } else if (rename(tmp.c_str(), journal_filename.c_str()) != 0) {
+	logger << ERROR << "Error renaming journal " << tmp << " to "
+	       << journal_filename << ": " << strerror(errno) << endl;
+	remove(tmp.c_str());
+    }
+
+    journal.open(journal_filename.c_str(), std::ios::out | std::ios::app);
+}
+
+
+/** Locks the journal against other processes.
+ *
+ * The lock is held on a file next to the journal, as rewriting the
+ * journal replaces it. A lock file that cannot be opened leaves the
+ * journal to fail on its own.
+ *
+ * @return false if another process holds the lock
+ */
+bool Learner::lock_journal()
+{
+#ifdef HAVE_SYS_FILE_H
+    std::string filename = journal_filename + ".lock";
+    journal_lock = open(filename.c_str(), O_RDWR | O_CREAT, 0600);
+    if (journal_lock >= 0 && flock(journal_lock, LOCK_EX | LOCK_NB) != 0) {
+	close(journal_lock);
+	journal_lock = -1;
+	return false;
+    }
+#endif
+    return true;
+}
+
+void Learner::unlock_journal()
+{
+#ifdef HAVE_SYS_FILE_H
+    if (journal_lock >= 0) {
+	close(journal_lock);
+	journal_lock = -1;
+    }
+#endif
+}
+
+
+/** Set LOGGER option.
+ *
+ */
+void Learner::set_logger (const std::string& value)
+{
+    logger << setlevel (value);
+    PRESAGE_LOG(logger, INFO) << "LOGGER: " << value << endl;
+}
+
+
+/** Set QUEUE_SIZE option.
+ *
+ */
+void Learner::set_queue_size (const std::string& value)
+{
+    int result = Utility::toInt (value);
+    if (result < 0) {
+	logger << ERROR << "Error: attempted to set QUEUE_SIZE option to "
+	       << "a negative integer value. Please make sure that "
+	       << "QUEUE_SIZE option is set to a value greater "
+	       << "than or equal to zero.\a" << endl;
+    } else {
+	PRESAGE_LOG(logger, INFO) << "QUEUE_SIZE: " << result << endl;
+	if (result == 0 && worker.joinable()) {
+	    // changes are learnt synchronously from now on
+	    flush();
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	queue_size = result;
+	queue_condition.notify_all();
+    }
+}
+
+
+/** Set IDLE_DELAY option.
+ *
+ */
+void Learner::set_idle_delay (const std::string& value)
+{
+    int result = Utility::toInt (value);
+    if (result < 0) {
+	logger << ERROR << "Error: attempted to set IDLE_DELAY option to "
+	       << "a negative integer value. Please make sure that "
+	       << "IDLE_DELAY option is set to a value greater "
+	       << "than or equal to zero.\a" << endl;
+    } else {
+	PRESAGE_LOG(logger, INFO) << "IDLE_DELAY: " << result << endl;
+	std::lock_guard<std::mutex> lock(mutex);
+	idle_delay = std::chrono::milliseconds(result);
+	queue_condition.notify_all();
+    }
+}
+
+
+/** Set CONTEXT_TOKENS option.
+ *
+ */
+void Learner::set_context_tokens (const std::string& value)
+{
+    int result = Utility::toInt (value);
+    if (result < 0) {
+	logger << ERROR << "Error: attempted to set CONTEXT_TOKENS option to "
+	       << "a negative integer value. Please make sure that "
+	       << "CONTEXT_TOKENS option is set to a value greater "
+	       << "than or equal to zero.\a" << endl;
+    } else {
+	PRESAGE_LOG(logger, INFO) << "CONTEXT_TOKENS: " << result << endl;
+	std::lock_guard<std::mutex> lock(mutex);
+	context_tokens = result;
+    }
+}
+
+
+/** Set JOURNAL option.
+ *
+ */
+void Learner::set_journal (const std::string& value)
+{
+    PRESAGE_LOG(logger, INFO) << "JOURNAL: " << value << endl;
+
+    // changes queued so far are in the previous journal
+    if (worker.joinable()) {
+	flush();
+    }
+
+    journal_filename = Utility::expand_variables (value);
+    open_journal();
+}
+
+void Learner::update (const Observable* variable)
+{
+    PRESAGE_LOG(logger, DEBUG) << "update(" << variable->get_name () << ") called" << endl;
+
+    dispatcher.dispatch (variable);
+}
@@ -0,0 +1,180 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#ifndef PRESAGE_LEARNER
+#define PRESAGE_LEARNER
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "configuration.h"
+#include "context_tracker/contextTracker.h"
+#include "logger.h"
+#include "dispatcher.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+
+/** Learner takes online learning off the prediction path.
+ *
+ * When online learning is on, every prediction ends with the
+ * predictors learning the text entered since the previous one, which
+ * may involve database transactions. Learner queues these changes
+ * instead, together with the tokens that preceded them, and a
+ * background thread has the predictors learn them once the user
+ * stops typing.
+ *
+ * A change that continues the text of the change queued before it is
+ * merged into it, so that the text typed over many keystrokes is
+ * learnt in a single transaction by each predictor.
+ *
+ * Queued changes are appended to a journal file, which is emptied
+ * once they have been learnt. Changes left in the journal by a
+ * process that did not shut down cleanly are learnt when the journal
+ * is opened again.
+ *
+ * Customisable settings:
+ *
+ * QUEUE_SIZE: integer, maximum number of changes waiting to be
+ * learnt. Setting it to zero learns changes synchronously.
+ *
+ * IDLE_DELAY: integer, milliseconds without new changes after which
+ * queued changes are learnt.
+ *
+ * CONTEXT_TOKENS: integer, number of tokens preceding a change that
+ * are kept with it, for the predictors to learn the n-grams that
+ * straddle the change. It should be no lower than the largest n-gram
+ * cardinality minus one.
+ *
+ * JOURNAL: filename of the journal, no journal is kept if empty. A
+ * journal is used by one process at a time: a process finding it in
+ * use by another does not keep a journal.
+ *
+ */
+class Learner : public Observer {
+public:
+    Learner(Configuration*, ContextTracker*);
+
+    /** Learns the queued changes before returning. */
+    ~Learner();
+
+    /** Queues the change for learning.
+     *
+     * Only blocks when the queue is full and the change cannot be
+     * merged with the last queued change.
+     */
+    void enqueue(const std::string& change);
+
+    /** Waits until all queued changes have been learnt. */
+    void flush();
+
+    /** Number of changes waiting to be learnt. */
+    size_t pending() const;
+
+    void set_logger(const std::string& value);
+    void set_queue_size(const std::string& value);
+    void set_idle_delay(const std::string& value);
+    void set_context_tokens(const std::string& value);
+    void set_journal(const std::string& value);
+
+    static const char* LOGGER;
+    static const char* QUEUE_SIZE;
+    static const char* IDLE_DELAY;
+    static const char* CONTEXT_TOKENS;
+    static const char* JOURNAL;
+
+    virtual void update (const Observable* variable);
+
+private:
+    /** Tokens of a change and the past stream tokens it was detected
+     *  in, as returned by ContextTracker::getToken().
+     */
+    struct Change {
+	std::vector<std::string> tokens;
+	std::vector<std::string> context;
+    };
+
+    /** Appends next to change if next continues it. */
+    bool merge(Change& change, const Change& next) const;
+
+    void push(const Change& change);
+
+    // execute queued changes (invoked in thread)
+    void execute();
+
+    void open_journal();
+
+    /** Journal entries are lines of tab separated fields: the number
+     *  of tokens of the change, its tokens, then its context tokens.
+     *  Blankspace characters never occur within tokens.
+     *
+     *  write_journal_entry() writes change as one entry,
+     *  read_journal_entry() parses line into change and returns false
+     *  if line is not an entry.
+     */
+    void write_journal_entry(std::ostream& out, const Change& change) const;
+    bool read_journal_entry(const std::string& line, Change& change) const;
+
+    void rewrite_journal(std::unique_lock<std::mutex>& lock);
+    bool lock_journal();
+    void unlock_journal();
+
+    std::deque<Change> queue;
+    size_t queue_size;
+    std::chrono::milliseconds idle_delay;
+    size_t context_tokens;
+
+    std::string journal_filename;
+    std::ofstream journal;
+    // changes journaled while the journal is being rewritten
+    std::deque<Change> rewrite_backlog;
+    bool rewriting;
+    // descriptor of the file locked while the journal is in use
+    int journal_lock;
+
+    mutable std::mutex mutex;
+    std::condition_variable queue_condition;
+    std::condition_variable idle_condition;
+    std::chrono::steady_clock::time_point last_change;
+    bool learning;
+    bool flushing;
+    bool stopping;
+    std::thread worker;
+
+    ContextTracker* contextTracker;
+    Configuration*  config;
+    Logger<char> logger;
+
+    Dispatcher<Learner> dispatcher;
+};
+
+#endif // PRESAGE_LEARNER
@@ -148,7 +148,24 @@ public:
     bool
     shouldLog() const
 	{
-	    return (state->loggerLevel >= state->currentLevel);
+	    return (state->currentLevel <= COMPILED_LEVEL
+		    && state->loggerLevel >= state->currentLevel);
+	}
+
+    // most verbose level messages are compiled in for, see
+    // PRESAGE_LOG()
+#if DISABLE_DEBUG_LOGGING
+    static const Level COMPILED_LEVEL = INFO;
+#else
+    static const Level COMPILED_LEVEL = ALL;
+#endif
+
+    /** Returns true if messages of level lvl would be written. */
+    inline
+    bool
+    isLoggable(Level lvl) const
+	{
+	    return (lvl <= COMPILED_LEVEL && state->loggerLevel >= lvl);
 	}
 
     // logging method
@@ -282,4 +299,25 @@ endl (const Logger<_charT, _Traits>& lgr)
 }
 
 
+/** Starts a log message of level LEVEL, whose remaining operands are
+ *  evaluated only if the logger would write it:
+ *
+ *    PRESAGE_LOG(logger, DEBUG) << "count ngram: " << ngram_to_string (ngram) << endl;
+ *
+ * Messages built by several statements are guarded by setting the
+ * level first:
+ *
+ *    if ((logger << DEBUG).shouldLog()) {
+ *        logger << "tokens: ";
+ *        for (...) logger << token << ' ';
+ *        logger << endl;
+ *    }
+ *
+ * When configured with --disable-debug-logging, DEBUG and ALL level
+ * messages are never written and the compiler drops them.
+ */
+#define PRESAGE_LOG(lgr, LEVEL)					\
+    if (! (lgr).isLoggable((lgr).LEVEL)) ; else (lgr) << LEVEL
+
+
 #endif // PRESAGE_LOGGER
@@ -24,8 +24,10 @@
 
 #include "prediction.h"
 #include <assert.h>
+#include <algorithm>
 
 Prediction::Prediction()
+    : sorted(0)
 {}
 
 Prediction::~Prediction()
@@ -35,6 +37,7 @@ const Prediction &Prediction::operator=( const Prediction &right )
 {
     if( &right != this ) {
 	suggestions = right.suggestions;
+	sorted = right.sorted;
 
 	//assert( ( suggestions == right.suggestions ) );
     }
@@ -52,6 +55,8 @@ bool Prediction::operator== (const Prediction& right) const
 	    return false;
 	} else {
 	    // need to compare each suggestion
+	    sort(size());
+	    right.sort(right.size());
 	    bool result = true;
 	    size_t i = 0;
 	    while (i < size() && result) {
@@ -74,37 +79,68 @@ Suggestion Prediction::getSuggestion(int i) const
 {
     assert( i >= 0 && static_cast<unsigned int>(i) < suggestions.size() );
 
+    sort(i + 1);
     return suggestions[i];
 }
 
 Suggestion Prediction::getSuggestion(std::string token) const
 {
+    // the most probable suggestion with given token, i.e. the first
+    // one in prediction order
+    const Suggestion* result = 0;
     for (size_t i = 0; i < suggestions.size(); i++) {
-	if (suggestions[i].getWord() == token) {
-	    return suggestions[i];
+	if (suggestions[i].getWord() == token
+	    && (result == 0 || *result < suggestions[i])) {
+	    result = &suggestions[i];
 	}
     }
-    return Suggestion();
+    return (result ? *result : Suggestion());
 }
 
 void Prediction::addSuggestion(Suggestion s)
 {
-    // insert s so that suggestions vector is sorted
+    // append s, ordering is deferred until suggestions are accessed
+    if (sorted > 0 && suggestions[sorted - 1] < s) {
+	// s belongs in the already sorted range
+	sorted = 0;
+    }
+    suggestions.push_back( s );
+}
 
-    // handle empty vector first
-    if( suggestions.empty() ) {
-	suggestions.push_back( s );
-    } else {
-	std::vector< Suggestion >::iterator i = suggestions.begin();
-	while( i != suggestions.end() && s < *i ) {
-	    ++i;
-	}
-	suggestions.insert( i, s );
+// orders suggestions by decreasing probability
+static bool more_probable(const Suggestion& left, const Suggestion& right)
+{
+    return right < left;
+}
+
+void Prediction::sort(size_t count) const
+{
+    if (count <= sorted) {
+	return;
+    }
+
+    // sort at least twice as many suggestions as are sorted already,
+    // so that reading suggestions one by one does not repeatedly
+    // scan the unsorted tail
+    const size_t MIN_SORTED = 8;
+    count = std::max(count, std::max(2 * sorted, MIN_SORTED));
+    if (count > suggestions.size()) {
+	count = suggestions.size();
     }
+
+    // suggestions past the sorted range are never more probable than
+    // those within it, so only the tail needs to be considered
+    std::partial_sort(suggestions.begin() + sorted,
+		      suggestions.begin() + count,
+		      suggestions.end(),
+		      more_probable);
+    sorted = count;
 }
 
 std::string Prediction::toString() const
 {
+    sort(size());
+
     std::string str;
     std::vector<Suggestion>::const_iterator i;
     for( i=suggestions.begin(); i!=suggestions.end(); ++i ) {
@@ -115,6 +151,8 @@ std::string Prediction::toString() const
 
 std::ostream &operator<<( std::ostream &output, const Prediction &p )
 {
+    p.sort(p.size());
+
     std::vector<Suggestion>::const_iterator i;
     for( i=p.suggestions.begin(); i!=p.suggestions.end(); ++i ) {
 	output << *i << std::endl;
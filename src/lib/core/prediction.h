@@ -40,6 +40,11 @@
  * a Prediction is a list of Suggestion object, ordered by decreasing
  * probability.
  *
+ * Suggestions are appended unsorted and ordered lazily, when they are
+ * read: only the leading suggestions that are actually accessed are
+ * sorted, so building a prediction of n suggestions and reading the
+ * k most probable ones costs O(n log k).
+ *
  * A Prediction object is returned by the predictors and by a combiner
  * object.
  * 
@@ -71,9 +76,8 @@ public:
 
     /** Inserts a new suggestion, preserves the ordering.
      * 
-     * The suggestion object to be inserted is compared against the
-     * suggestions already contained in the prediction and inserted in an
-     * ordered fashion.
+     * The suggestion object is appended in constant time; the
+     * ordering is established when suggestions are next accessed.
      *
      * Comparison between suggestion objects uses the overloaded operator<
      *
@@ -84,8 +88,15 @@ public:
      */
     std::string toString() const;
 private:
-    std::vector<Suggestion> suggestions;
+    /** Ensures that the first count suggestions are the most
+     *  probable ones, in decreasing order.
+     */
+    void sort(size_t count) const;
+
+    mutable std::vector<Suggestion> suggestions;
 
+    // number of leading suggestions already in their final position
+    mutable size_t sorted;
 };
 
 
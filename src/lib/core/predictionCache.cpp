@@ -0,0 +1,240 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#include "predictionCache.h"
+#include "utility.h"
+
+#include <sstream>
+
+const char* PredictionCache::SIZE = "Presage.PredictionCache.SIZE";
+const char* PredictionCache::CONTEXT_TOKENS = "Presage.PredictionCache.CONTEXT_TOKENS";
+
+const char* PredictionCache::LOGGER = "Presage.PredictionCache.LOGGER";
+
+PredictionCache::PredictionCache(Configuration* configuration, ContextTracker* ct)
+    : size(0),
+      context_tokens(0),
+      hits(0),
+      misses(0),
+      learn_count(ct->getLearnCount()),
+      contextTracker(ct),
+      config(configuration),
+      logger("PredictionCache", std::cerr),
+      dispatcher(this)
+{
+    // build notification dispatch map
+    dispatcher.map (config->find (LOGGER), & PredictionCache::set_logger);
+    dispatcher.map (config->find (SIZE), & PredictionCache::set_size);
+    dispatcher.map (config->find (CONTEXT_TOKENS), & PredictionCache::set_context_tokens);
+}
+
+PredictionCache::~PredictionCache()
+{
+    // nothing to do here, move along
+}
+
+bool PredictionCache::lookup(const unsigned int multiplier, const char** filter, Prediction& prediction)
+{
+    if (size == 0) {
+	return false;
+    }
+
+    check_learn_count();
+
+    std::string key = build_key(multiplier, filter);
+    std::unordered_map<std::string, std::list<Entry>::iterator>::iterator it = index.find(key);
+    if (it == index.end()) {
+	misses++;
+	PRESAGE_LOG(logger, DEBUG) << "Cache miss, multiplier: " << multiplier << endl;
+	return false;
+    }
+
+    // move entry to the front of the recently used list
+    entries.splice(entries.begin(), entries, it->second);
+    prediction = it->second->second;
+
+    hits++;
+    PRESAGE_LOG(logger, DEBUG) << "Cache hit, multiplier: " << multiplier << endl;
+    return true;
+}
+
+void PredictionCache::insert(const unsigned int multiplier, const char** filter, const Prediction& prediction)
+{
+    if (size == 0) {
+	return;
+    }
+
+    check_learn_count();
+
+    std::string key = build_key(multiplier, filter);
+    std::unordered_map<std::string, std::list<Entry>::iterator>::iterator it = index.find(key);
+    if (it != index.end()) {
+	it->second->second = prediction;
+	entries.splice(entries.begin(), entries, it->second);
+	return;
+    }
+
+    entries.push_front(Entry(key, prediction));
+    index[key] = entries.begin();
+
+    evict();
+}
+
+void PredictionCache::clear()
+{
+    PRESAGE_LOG(logger, DEBUG) << "Clearing " << entries.size() << " cached predictions" << endl;
+
+    entries.clear();
+    index.clear();
+    learn_count = contextTracker->getLearnCount();
+}
+
+/** Builds the key identifying the current context.
+ *
+ * The key holds the multiplier, the serial number of the last
+ * complete token, the context tokens and the prefix, and the filter
+ * strings, each terminated by a null character. No filter and an
+ * empty filter are told apart by a leading marker.
+ */
+std::string PredictionCache::build_key(const unsigned int multiplier, const char** filter) const
+{
+    // the serial number tells this occurrence of the context tokens
+    // from earlier ones, which predictors looking further back, such
+    // as RecencyPredictor, may have ranked differently
+    unsigned long serial;
+    contextTracker->getToken(1, serial);
+
+    std::stringstream ss;
+    ss << multiplier << '\0' << serial << '\0';
+    for (int i = static_cast<int>(context_tokens); i >= 0; i--) {
+	ss << contextTracker->getToken(i) << '\0';
+    }
+    if (filter) {
+	ss << 'f';
+	for (size_t i = 0; filter[i] != 0; i++) {
+	    ss << filter[i] << '\0';
+	}
+    } else {
+	ss << 'n';
+    }
+
+    return ss.str();
+}
+
+/** Discards cached predictions if the predictors learnt since they
+ *  were computed.
+ */
+void PredictionCache::check_learn_count()
+{
+    if (learn_count != contextTracker->getLearnCount()) {
+	PRESAGE_LOG(logger, DEBUG) << "Predictors have learnt, cached predictions are stale" << endl;
+	clear();
+    }
+}
+
+/** Evicts the least recently used predictions in excess of SIZE.
+ */
+void PredictionCache::evict()
+{
+    while (entries.size() > size) {
+	index.erase(entries.back().first);
+	entries.pop_back();
+    }
+}
+
+
+/** Set LOGGER option.
+ *
+ */
+void PredictionCache::set_logger (const std::string& value)
+{
+    logger << setlevel (value);
+    PRESAGE_LOG(logger, INFO) << "LOGGER: " << value << endl;
+}
+
+
+/** Set SIZE option.
+ *
+ */
+void PredictionCache::set_size (const std::string& value)
+{
+    int result = Utility::toInt (value);
+    if (result < 0) {
+	logger << ERROR << "Error: attempted to set SIZE option to "
+	       << "a negative integer value. Please make sure that "
+	       << "SIZE option is set to a value greater "
+	       << "than or equal to zero.\a" << endl;
+    } else {
+	PRESAGE_LOG(logger, INFO) << "SIZE: " << result << endl;
+	size = result;
+	evict();
+    }
+}
+
+
+/** Set CONTEXT_TOKENS option.
+ *
+ */
+void PredictionCache::set_context_tokens (const std::string& value)
+{
+    int result = Utility::toInt (value);
+    if (result < 0) {
+	logger << ERROR << "Error: attempted to set CONTEXT_TOKENS option to "
+	       << "a negative integer value. Please make sure that "
+	       << "CONTEXT_TOKENS option is set to a value greater "
+	       << "than or equal to zero.\a" << endl;
+    } else {
+	PRESAGE_LOG(logger, INFO) << "CONTEXT_TOKENS: " << result << endl;
+	context_tokens = result;
+	// keys built with a different number of tokens never match
+	clear();
+    }
+}
+
+size_t PredictionCache::get_size () const
+{
+    return size;
+}
+
+size_t PredictionCache::get_context_tokens () const
+{
+    return context_tokens;
+}
+
+unsigned long PredictionCache::get_hits () const
+{
+    return hits;
+}
+
+unsigned long PredictionCache::get_misses () const
+{
+    return misses;
+}
+
+void PredictionCache::update (const Observable* variable)
+{
+    PRESAGE_LOG(logger, DEBUG) << "update(" << variable->get_name () << ") called" << endl;
+
+    dispatcher.dispatch (variable);
+}
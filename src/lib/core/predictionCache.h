@@ -0,0 +1,133 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#ifndef PRESAGE_PREDICTIONCACHE
+#define PRESAGE_PREDICTIONCACHE
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "configuration.h"
+#include "prediction.h"
+#include "context_tracker/contextTracker.h"
+#include "logger.h"
+#include "dispatcher.h"
+
+#include <string>
+#include <list>
+#include <unordered_map>
+
+
+/** PredictionCache remembers the most recently computed predictions.
+ *
+ * Applications often ask for a prediction in the same context over
+ * and over, for instance when the cursor is moved around or a
+ * character is deleted and typed again. PredictionCache maps the
+ * tokens preceding the prefix, the prefix, the filter and the size
+ * multiplier to the combined Prediction returned by
+ * PredictorActivator, so that such requests are answered without
+ * running the predictors. Predictions are only reused until another
+ * token is completed, even if the same tokens occur again, as the
+ * serial number of the last complete token is part of the key.
+ *
+ * When the cache is full, the least recently used prediction is
+ * evicted. All cached predictions are discarded whenever the
+ * predictors learn or forget, and when clear() is called.
+ *
+ * Customisable settings:
+ *
+ * SIZE: integer, maximum number of cached predictions. Setting it to
+ * zero disables the cache.
+ *
+ * CONTEXT_TOKENS: integer, number of tokens preceding the prefix that
+ * identify a context.
+ *
+ * get_hits() and get_misses() count the lookups answered from the
+ * cache and those that required running the predictors, since the
+ * cache was created.
+ *
+ */
+class PredictionCache : public Observer {
+public:
+    PredictionCache(Configuration*, ContextTracker*);
+    ~PredictionCache();
+
+    /** Looks up the prediction for the current context.
+     *
+     * \return true and sets prediction if a prediction computed for
+     * the current context, filter and multiplier is cached.
+     */
+    bool lookup(const unsigned int multiplier, const char** filter, Prediction& prediction);
+
+    /** Caches the prediction computed for the current context.
+     */
+    void insert(const unsigned int multiplier, const char** filter, const Prediction& prediction);
+
+    /** Discards all cached predictions.
+     */
+    void clear();
+
+    void set_logger(const std::string& value);
+    void set_size(const std::string& value);
+    void set_context_tokens(const std::string& value);
+
+    size_t get_size () const;
+    size_t get_context_tokens () const;
+    unsigned long get_hits () const;
+    unsigned long get_misses () const;
+
+    static const char* LOGGER;
+    static const char* SIZE;
+    static const char* CONTEXT_TOKENS;
+
+    virtual void update (const Observable* variable);
+
+private:
+    std::string build_key(const unsigned int multiplier, const char** filter) const;
+    void check_learn_count();
+    void evict();
+
+    typedef std::pair<std::string, Prediction> Entry;
+
+    // cached predictions, most recently used first
+    std::list<Entry> entries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+    size_t size;
+    size_t context_tokens;
+    unsigned long hits;
+    unsigned long misses;
+
+    // ContextTracker learn count the cached predictions were computed at
+    unsigned long learn_count;
+
+    ContextTracker* contextTracker;
+    Configuration*  config;
+    Logger<char> logger;
+
+    Dispatcher<PredictionCache> dispatcher;
+};
+
+#endif // PRESAGE_PREDICTIONCACHE
@@ -25,6 +25,52 @@
 #include "predictorActivator.h"
 #include "utility.h"
 
+#include <chrono>
+#include <exception>
+
+/** State of one predict() invocation shared with the worker threads.
+ *
+ * Jobs are reference counted, since a predictor that misses the
+ * deadline keeps running, and writing its result, after predict()
+ * has returned. The filter is copied for the same reason.
+ */
+struct PredictorActivator::PredictJob {
+    PredictJob(const char** filter, const size_t predictors)
+	: predictions(predictors),
+	  done(predictors, false),
+	  partial(predictors, false),
+	  errors(predictors),
+	  pending(0),
+	  has_filter(filter != 0)
+    {
+	if (filter) {
+	    for (int i = 0; filter[i] != 0; i++) {
+		filter_strings.push_back(filter[i]);
+	    }
+	    for (size_t i = 0; i < filter_strings.size(); i++) {
+		filter_pointers.push_back(filter_strings[i].c_str());
+	    }
+	    filter_pointers.push_back(0);
+	}
+    }
+
+    const char** filter() { return (has_filter ? &filter_pointers[0] : 0); }
+
+    std::vector<Prediction> predictions;
+    std::vector<bool> done;
+    std::vector<bool> partial;
+    std::vector<std::exception_ptr> errors;
+    size_t pending;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+
+private:
+    bool has_filter;
+    std::vector<std::string> filter_strings;
+    std::vector<const char*> filter_pointers;
+};
+
 const char* PredictorActivator::LOGGER = "Presage.PredictorActivator.LOGGER";
 const char* PredictorActivator::PREDICT_TIME = "Presage.PredictorActivator.PREDICT_TIME";
 const char* PredictorActivator::MAX_PARTIAL_PREDICTION_SIZE = "Presage.PredictorActivator.MAX_PARTIAL_PREDICTION_SIZE";
@@ -37,6 +83,8 @@ PredictorActivator::PredictorActivator(Configuration* configuration,
       predictorRegistry(registry),
       contextTracker(ct),
       logger("PredictorActivator", std::cerr),
+      predict_time(0),
+      stopping(false),
       dispatcher(this)
 {
     combiner = 0;
@@ -51,6 +99,17 @@ PredictorActivator::PredictorActivator(Configuration* configuration,
 
 PredictorActivator::~PredictorActivator()
 {
+    // let predictors that are still running complete, they must not
+    // outlive the predictor registry
+    {
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	stopping = true;
+    }
+    pool_condition.notify_all();
+    for (size_t i = 0; i < workers.size(); i++) {
+	workers[i].join();
+    }
+
     delete combiner;
 }
 
@@ -58,26 +117,107 @@ Prediction PredictorActivator::predict(unsigned int multiplier, const char** fil
 {
     Prediction result;
 
-    // Here goes code to instantiate a separate thread for each Predictor
-    //
+    std::vector<Predictor*> active;
+    PredictorRegistry::Iterator it = predictorRegistry->iterator();
+    while (it.hasNext()) {
+	active.push_back(it.next());
+    }
 
-    // All threads need to be synched together. One thread makes sure that
-    // we are not exceeding the maximum time allowed.
+    std::shared_ptr<PredictJob> job = std::make_shared<PredictJob>(filter, active.size());
+    const size_t size = max_partial_prediction_size * multiplier;
+
+    // Start a task for each predictor, except for those still busy
+    // with a prediction that missed an earlier deadline.
     //
+    for (size_t i = 0; i < active.size(); i++) {
+	Predictor* predictor = active[i];
+	{
+	    std::lock_guard<std::mutex> lock(pool_mutex);
+	    if (busy_predictors.count(predictor)) {
+		continue;
+	    }
+	    busy_predictors.insert(predictor);
+	}
+	{
+	    std::lock_guard<std::mutex> lock(job->mutex);
+	    job->pending++;
+	}
+	predictor->begin_task();
+
+	PRESAGE_LOG(logger, DEBUG) << "Invoking predictor: " << predictor->getName() << endl;
+	schedule([this, job, i, predictor, size]() {
+		Prediction prediction;
+		bool partial = false;
+		std::exception_ptr error;
+		try {
+		    std::lock_guard<std::mutex> lock(predictor->get_mutex());
+		    prediction = predictor->predict(size, job->filter());
+		    partial = predictor->is_partial();
+		} catch (...) {
+		    error = std::current_exception();
+		}
+
+		// release the predictor before reporting completion, so
+		// that it can be scheduled by the next predict() call
+		{
+		    std::lock_guard<std::mutex> lock(pool_mutex);
+		    busy_predictors.erase(predictor);
+		}
+
+		{
+		    std::lock_guard<std::mutex> lock(job->mutex);
+		    job->predictions[i] = prediction;
+		    job->partial[i] = partial;
+		    job->errors[i] = error;
+		    job->done[i] = true;
+		    job->pending--;
+		}
+		job->condition.notify_all();
+
+		// last touch of the predictor, which may be deleted as
+		// soon as it is released
+		predictor->end_task();
+	    });
+    }
 
-    // Now that the all threads have exited or have been cancelled,
-    // the predictions returned by each of them are combined.
+    // Wait until all predictors have returned, or the maximum time
+    // allowed has elapsed...
     //
+    {
+	std::unique_lock<std::mutex> lock(job->mutex);
+	if (predict_time > 0) {
+	    job->condition.wait_for(lock,
+				    std::chrono::milliseconds(predict_time),
+				    [&job]() { return job->pending == 0; });
+	} else {
+	    job->condition.wait(lock, [&job]() { return job->pending == 0; });
+	}
 
-    // clear out previous predictions
-    predictions.clear();
+	// ...collect the predictions that made it in time, partial
+	// ones being reported as late...
+	predictions.clear();
+	late_predictors.clear();
+	for (size_t i = 0; i < active.size(); i++) {
+	    if (job->done[i]) {
+		if (job->errors[i]) {
+		    std::rethrow_exception(job->errors[i]);
+		}
+		predictions.push_back(job->predictions[i]);
+		if (job->partial[i]) {
+		    late_predictors.push_back(active[i]->getName());
+		}
+	    } else {
+		late_predictors.push_back(active[i]->getName());
+	    }
+	}
+    }
 
-    PredictorRegistry::Iterator it = predictorRegistry->iterator();
-    Predictor* predictor = 0;
-    while (it.hasNext()) {
-	predictor = it.next();
-	logger << DEBUG << "Invoking predictor: " << predictor->getName() << endl;
-	predictions.push_back(predictor->predict(max_partial_prediction_size * multiplier, filter));
+    if (! late_predictors.empty() && (logger << WARN).shouldLog()) {
+	logger << "Predictors exceeding PREDICT_TIME (" << predict_time << " ms) or partial: ";
+	for (size_t i = 0; i < late_predictors.size(); i++) {
+	    logger << late_predictors[i] << ' ';
+	}
+	logger << endl;
     }
 
     // ...then merge predictions into a single one...
@@ -91,10 +231,52 @@ Prediction PredictorActivator::predict(unsigned int multiplier, const char** fil
 }
 
 
+std::vector<std::string> PredictorActivator::getLatePredictors() const
+{
+    return late_predictors;
+}
+
+
+void PredictorActivator::schedule(const std::function<void()>& task)
+{
+    {
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	tasks.push_back(task);
+	while (workers.size() < busy_predictors.size()) {
+	    workers.push_back(std::thread(&PredictorActivator::execute, this));
+	}
+    }
+    pool_condition.notify_one();
+}
+
+
+void PredictorActivator::execute()
+{
+    // predictors that miss the deadline run on past the token
+    // snapshot, they must not query the callback
+    ContextTracker::setWorkerThread();
+
+    for (;;) {
+	std::function<void()> task;
+	{
+	    std::unique_lock<std::mutex> lock(pool_mutex);
+	    pool_condition.wait(lock, [this]() { return stopping || ! tasks.empty(); });
+	    if (tasks.empty()) {
+		// stopping and nothing left to do
+		return;
+	    }
+	    task = tasks.front();
+	    tasks.pop_front();
+	}
+	task();
+    }
+}
+
+
 void PredictorActivator::setLogger (const std::string& value)
 {
     logger << setlevel (value);
-    logger << INFO << "LOGGER: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "LOGGER: " << value << endl;
 }
 
 
@@ -108,7 +290,7 @@ void PredictorActivator::setPredictTime (const std::string& value)
 	       << "PREDICT_TIME option is set to a value greater "
 	       << "than or equal to zero.\a" << endl;
     } else {
-	logger << INFO << "PREDICT_TIME: " << result << endl;
+	PRESAGE_LOG(logger, INFO) << "PREDICT_TIME: " << result << endl;
         predict_time = result;
     }
 }
@@ -122,7 +304,7 @@ int PredictorActivator::getPredictTime() const
 
 void PredictorActivator::setCombinationPolicy(const std::string& cp)
 {
-    logger << INFO << "Setting COMBINATION_POLICY to " << cp << endl;
+    PRESAGE_LOG(logger, INFO) << "Setting COMBINATION_POLICY to " << cp << endl;
     delete combiner;
     combinationPolicy = cp;
 
@@ -146,13 +328,13 @@ std::string PredictorActivator::getCombinationPolicy() const
 void PredictorActivator::setMaxPartialPredictionSize (const std::string& size)
 {
     max_partial_prediction_size = Utility::toInt(size);
-    logger << INFO << "MAX_PARTIAL_PREDICTION_SIZE: " << max_partial_prediction_size << endl;
+    PRESAGE_LOG(logger, INFO) << "MAX_PARTIAL_PREDICTION_SIZE: " << max_partial_prediction_size << endl;
 }
 
 
 void PredictorActivator::update (const Observable* variable)
 {
-    logger << DEBUG << "About to invoke dispatcher: " << variable->get_name () << " - " << variable->get_value() << endl;
+    PRESAGE_LOG(logger, DEBUG) << "About to invoke dispatcher: " << variable->get_name () << " - " << variable->get_value() << endl;
 
     dispatcher.dispatch (variable);
 }
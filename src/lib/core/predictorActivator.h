@@ -46,6 +46,14 @@
 # include <stdlib.h>  // needed for abort function
 #endif
 
+#include <set>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
 
 /** PredictorActivator, the heart of Presage system, coordinates the execution of predictors and returns the combination of their predictions.
  *
@@ -85,12 +93,22 @@ public:
      *
      * This is the heart of Presage.
      * 
-     * Plump will eventually provide the implementation of sequential or parallel execution of predictors.
+     * Each active predictor runs concurrently on a worker thread.
+     * Predictions that are not returned within PREDICT_TIME
+     * milliseconds are left out of the combined prediction, and the
+     * predictors that produced them are reported by
+     * getLatePredictors(). A late predictor is not invoked again
+     * until it has completed its pending prediction.
      *
      * @return prediction produced by the active predictors and combined by the active combiner
      */
     Prediction predict(unsigned int multiplier, const char** filter);
 
+    /** Gets the names of the predictors that missed the deadline in
+     *  the last call to predict(), or returned a partial prediction.
+     */
+    std::vector<std::string> getLatePredictors() const;
+
     /** Gets PREDICT_TIME option value.
      *
      * Returns the maximum time predictors are allowed to execute before
@@ -101,6 +119,8 @@ public:
     int getPredictTime() const;
     
     /** Sets PREDICT_TIME option, the maximum time allowed for a predictor to return its prediction.
+     *
+     * A value of zero waits for all predictors to return.
      *
      * @param predictTime expressed in milliseconds
      * @return true if the supplied value is valid, false otherwise
@@ -152,8 +172,14 @@ public:
     static const char* COMBINATION_POLICY;
 
 private:
-    // execute predictor function (invoked in thread)
-    void *execute(void *);
+    struct PredictJob;
+
+    // queue a task for the worker threads, growing the pool so that
+    // a thread is available for each busy predictor
+    void schedule(const std::function<void()>& task);
+
+    // execute predictor tasks (invoked in thread)
+    void execute();
 
 
     Configuration*  config;
@@ -171,6 +197,17 @@ private:
 
     int predict_time;
 
+    std::vector<std::string> late_predictors;
+
+    // worker pool; busy_predictors holds the predictors with a
+    // prediction in flight, including those that missed the deadline
+    std::vector<std::thread> workers;
+    std::deque< std::function<void()> > tasks;
+    std::set<const Predictor*> busy_predictors;
+    std::mutex pool_mutex;
+    std::condition_variable pool_condition;
+    bool stopping;
+
     Dispatcher<PredictorActivator> dispatcher;
 };
 
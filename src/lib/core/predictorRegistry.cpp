@@ -219,6 +219,7 @@ void PredictorRegistry::removePredictor(const std::string& predictor_name)
     {
 	if ((*it)->getName() == predictor_name)
 	{
+	    (*it)->wait_for_tasks();
 	    delete *it;
 	    it = predictors.erase(it);
 	    logger << DEBUG << "Removed predictor: " << predictor_name << endl;
@@ -234,6 +235,7 @@ void PredictorRegistry::removePredictors()
 {
     for (size_t i = 0; i < predictors.size(); i++) {
 	logger << DEBUG << "Removing predictor: " << predictors[i]->getName() << endl;
+	predictors[i]->wait_for_tasks();
 	delete predictors[i];
     }
     predictors.clear();
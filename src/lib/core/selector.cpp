@@ -60,15 +60,15 @@ std::vector<std::string> Selector::select( Prediction p )
     for (size_t i=0 ; i<p.size() ; i++) {
 	token =  p.getSuggestion(i).getWord();
 	result.push_back(token);
-	logger << DEBUG << "Added token to selector consideration set: " << token << endl;
+	PRESAGE_LOG(logger, DEBUG) << "Added token to selector consideration set: " << token << endl;
     }
 	
     // check whether user has not moved on to a new word
     if (contextTracker->contextChange()) {
-	logger << DEBUG << "Context change detected." << endl;
+	PRESAGE_LOG(logger, DEBUG) << "Context change detected." << endl;
 	clearSuggestedWords();
     } else {
-	logger << DEBUG << "No context change detected." << endl;
+	PRESAGE_LOG(logger, DEBUG) << "No context change detected." << endl;
     }
 
     // filter out suggestions that do not satisfy repetition constraint
@@ -110,18 +110,20 @@ void Selector::updateSuggestedWords( const std::vector<std::string>& v )
 {
     std::vector<std::string>::const_iterator i = v.begin();
     while( i != v.end() ) {
-	logger << DEBUG << "Adding token to suggested token set: " << *i << endl; 
+	PRESAGE_LOG(logger, DEBUG) << "Adding token to suggested token set: " << *i << endl; 
 	suggestedWords.insert( *i );
 	i++;
     }
 
-    logger << DEBUG << "Suggested words: ";
-    for (StringSet::const_iterator it = suggestedWords.begin();
-	 it != suggestedWords.end();
-	 it++) {
-	logger << *it << ' ';
+    if ((logger << DEBUG).shouldLog()) {
+	logger << "Suggested words: ";
+	for (StringSet::const_iterator it = suggestedWords.begin();
+	     it != suggestedWords.end();
+	     it++) {
+	    logger << *it << ' ';
+	}
+	logger << endl;
     }
-    logger << endl;
 }
 
 
@@ -130,7 +132,7 @@ void Selector::updateSuggestedWords( const std::vector<std::string>& v )
  */
 void Selector::clearSuggestedWords()
 {
-    logger << DEBUG << "Clearing previously suggested tokens set." << endl;
+    PRESAGE_LOG(logger, DEBUG) << "Clearing previously suggested tokens set." << endl;
     suggestedWords.clear();
 }
 
@@ -151,9 +153,9 @@ void Selector::repetitionFilter( std::vector<std::string>& v )
 	 i++ ) {
 	if( suggestedWords.find( *i ) == suggestedWords.end() ) {
 	    temp.push_back( *i );
-	    logger << DEBUG << "Token passed repetition filter: " << *i << endl;
+	    PRESAGE_LOG(logger, DEBUG) << "Token passed repetition filter: " << *i << endl;
 	} else {
-	    logger << DEBUG << "Token failed repetition filter: " << *i << endl;
+	    PRESAGE_LOG(logger, DEBUG) << "Token failed repetition filter: " << *i << endl;
 	}
     }
 
@@ -178,7 +180,7 @@ void Selector::thresholdFilter( std::vector<std::string>& v )
 	std::vector<std::string>::iterator i = v.begin();
 	while (i != v.end()) {
 	    if( (i->size()-length) < greedy_suggestion_threshold) {
-		logger << INFO << "Removing token: " << *i << endl;
+		PRESAGE_LOG(logger, INFO) << "Removing token: " << *i << endl;
 		i = v.erase( i );
 	    } else {
 		i++;
@@ -194,7 +196,7 @@ void Selector::thresholdFilter( std::vector<std::string>& v )
 void Selector::set_logger (const std::string& value)
 {
     logger << setlevel (value);
-    logger << INFO << "LOGGER: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "LOGGER: " << value << endl;
 }
 
 
@@ -203,7 +205,7 @@ void Selector::set_logger (const std::string& value)
  */
 void Selector::set_suggestions(const std::string& value)
 {
-    logger << INFO << "SUGGESTIONS: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "SUGGESTIONS: " << value << endl;
     int result = Utility::toInt(value);
     if (result < 0) {
 	logger << ERROR << "Presage.Selector.SUGGESTIONS value out of range!/a" << endl;
@@ -220,7 +222,7 @@ void Selector::set_suggestions(const std::string& value)
  */
 void Selector::set_repeat_suggestions(const std::string& value)
 {
-    logger << INFO << "REPEAT_SUGGESTIONS: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "REPEAT_SUGGESTIONS: " << value << endl;
     bool result = Utility::isYes(value);
 
     repeat_suggestions = result;
@@ -232,7 +234,7 @@ void Selector::set_repeat_suggestions(const std::string& value)
  */
 void Selector::set_greedy_suggestion_threshold(const std::string& value)
 {
-    logger << INFO << "GREEDY_SUGGESTION_THRESHOLD: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "GREEDY_SUGGESTION_THRESHOLD: " << value << endl;
     int result = Utility::toInt(value);
     if( result < 0 ) {
 	logger << ERROR << "GREEDY_SUGGESTION_THRESHOLD value out of range." << value << endl;
@@ -260,7 +262,7 @@ size_t Selector::get_greedy_suggestion_threshold () const
 
 void Selector::update (const Observable* variable)
 {
-    logger << DEBUG << "update(" << variable->get_name () << ") called" << endl;
+    PRESAGE_LOG(logger, DEBUG) << "update(" << variable->get_name () << ") called" << endl;
 
     dispatcher.dispatch (variable);
 }
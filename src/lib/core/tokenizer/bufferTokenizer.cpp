@@ -0,0 +1,119 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#include "bufferTokenizer.h"
+
+#include <ctype.h>
+#include <string.h>
+
+BufferTokenizer::BufferTokenizer(const std::string& blankspaces,
+				 const std::string& separators)
+{
+    memset(table, 0, sizeof(table));
+    mark(blankspaces, BLANKSPACE);
+    mark(separators,  SEPARATOR);
+}
+
+void BufferTokenizer::blankspaceChars(const std::string& chars)
+{
+    for (size_t i = 0; i < sizeof(table); i++) {
+	table[i] &= ~BLANKSPACE;
+    }
+    mark(chars, BLANKSPACE);
+}
+
+void BufferTokenizer::separatorChars(const std::string& chars)
+{
+    for (size_t i = 0; i < sizeof(table); i++) {
+	table[i] &= ~SEPARATOR;
+    }
+    mark(chars, SEPARATOR);
+}
+
+void BufferTokenizer::mark(const std::string& chars, const unsigned char flag)
+{
+    for (std::string::const_iterator it = chars.begin(); it != chars.end(); it++) {
+	table[static_cast<unsigned char>(*it)] |= flag;
+    }
+}
+
+BufferTokenizer::Token BufferTokenizer::forward(const char* text,
+						const size_t size,
+						size_t& pos) const
+{
+    if (pos < size) {
+	pos = skipDelimiters(text, size, pos);
+    }
+    Token token = { text + pos, 0 };
+    if (pos < size) {
+	pos = findDelimiter(text, size, pos);
+	token.size = text + pos - token.data;
+    }
+    return token;
+}
+
+BufferTokenizer::Token BufferTokenizer::reverse(const char* text,
+						const size_t size,
+						size_t& pos) const
+{
+    if (pos == size && pos > 0 && isDelimiter(text[pos - 1])) {
+	// the empty token following the last delimiter
+	pos--;
+	Token token = { text + size, 0 };
+	return token;
+    }
+
+    while (pos > 0 && isDelimiter(text[pos - 1])) {
+	pos--;
+    }
+    size_t end = pos;
+    while (pos > 0 && ! isDelimiter(text[pos - 1])) {
+	pos--;
+    }
+    Token token = { text + pos, end - pos };
+    return token;
+}
+
+size_t BufferTokenizer::findDelimiter(const char* text, const size_t size, size_t pos) const
+{
+    while (pos < size && ! isDelimiter(text[pos])) {
+	pos++;
+    }
+    return pos;
+}
+
+size_t BufferTokenizer::skipDelimiters(const char* text, const size_t size, size_t pos) const
+{
+    while (pos < size && isDelimiter(text[pos])) {
+	pos++;
+    }
+    return pos;
+}
+
+void BufferTokenizer::lowercase(std::string& str)
+{
+    for (std::string::iterator it = str.begin(); it != str.end(); it++) {
+	*it = tolower(static_cast<unsigned char>(*it));
+    }
+}
@@ -0,0 +1,102 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#ifndef PRESAGE_BUFFERTOKENIZER
+#define PRESAGE_BUFFERTOKENIZER
+
+#include <string>
+#include <stddef.h>
+
+/** Splits a contiguous character buffer into tokens.
+ *
+ * Characters are classified by looking them up in a 256 entry table
+ * built from the blankspace and separator characters, so the cost
+ * of classifying a character does not depend on the size of the
+ * character sets.
+ *
+ * Tokens are returned as views of the buffer; no characters are
+ * copied until Token::str() is called. The buffer must outlive the
+ * tokens taken from it.
+ *
+ * forward() and reverse() scan the buffer the way ForwardTokenizer
+ * and ReverseTokenizer scan a stream, which are built on them. In
+ * particular, a buffer ending with a blankspace or separator
+ * character has an empty last token.
+ */
+class BufferTokenizer {
+public:
+    /** A token, as a view of the tokenized buffer. */
+    struct Token {
+	const char* data;
+	size_t      size;
+
+	bool empty() const { return size == 0; }
+	std::string str() const { return std::string(data, size); }
+    };
+
+    BufferTokenizer(const std::string& blankspaces,
+		    const std::string& separators);
+
+    void blankspaceChars(const std::string& chars);
+    void separatorChars (const std::string& chars);
+
+    bool isBlankspace(const char c) const { return table[static_cast<unsigned char>(c)] & BLANKSPACE; }
+    bool isSeparator (const char c) const { return table[static_cast<unsigned char>(c)] & SEPARATOR;  }
+    bool isDelimiter (const char c) const { return table[static_cast<unsigned char>(c)] != 0;         }
+
+    /** Returns the first token starting at or after pos and moves
+     *  pos to the character following it.
+     */
+    Token forward(const char* text, const size_t size, size_t& pos) const;
+
+    /** Returns the last token ending at or before pos and moves pos
+     *  to its first character.
+     */
+    Token reverse(const char* text, const size_t size, size_t& pos) const;
+
+    /** Returns the position of the first delimiter at or after pos,
+     *  or size if there is none.
+     */
+    size_t findDelimiter(const char* text, const size_t size, size_t pos) const;
+
+    /** Returns the position of the first character at or after pos
+     *  that is not a delimiter, or size if there is none.
+     */
+    size_t skipDelimiters(const char* text, const size_t size, size_t pos) const;
+
+    /** Converts str to lowercase in place. */
+    static void lowercase(std::string& str);
+
+private:
+    void mark(const std::string& chars, const unsigned char flag);
+
+    enum {
+	BLANKSPACE = 1,
+	SEPARATOR  = 2
+    };
+
+    unsigned char table[256];
+};
+
+#endif // PRESAGE_BUFFERTOKENIZER
@@ -33,35 +33,33 @@ ForwardTokenizer::ForwardTokenizer(std::istream& stream,
     offset = offbeg;
 }
 
+ForwardTokenizer::ForwardTokenizer(const std::string& str,
+				   const std::string blankspaces,
+				   const std::string separators)
+    : Tokenizer(str, blankspaces, separators)
+{
+    offset = offbeg;
+}
+
 ForwardTokenizer::~ForwardTokenizer()
 {}
 
 int ForwardTokenizer::countTokens()
 {
-    StreamGuard guard(stream, offset);
-
-    // store current seek pointer position
-    std::streamoff curroff = offset;
-
-    // position get pointer at beginning of stream
-    offset = offbeg;
+    // count tokens from the beginning of the buffer
+    size_t pos = offbeg;
 
     int count = 0;
-    while (hasMoreTokens()) {
+    while (pos < offend) {
 	count++;
-	nextToken();
+	scanner.forward(text.data(), offend, pos);
     }
 
-    // reposition seek get pointer to original position
-    offset = curroff;
-    
     return count;
 }
 
 bool ForwardTokenizer::hasMoreTokens() const
 {
-    //StreamGuard guard(stream, offset);
-
     if (offset >= offend) {
 	return false;
     } else {
@@ -71,85 +69,10 @@ bool ForwardTokenizer::hasMoreTokens() const
     
 std::string ForwardTokenizer::nextToken()
 {
-    StreamGuard guard(stream, offset);
-
-    int current;
-    std::string str;
-
-    if (stream.good()) { // good() if bad,fail and eof bit are not set
-	current = stream.peek();
-	if (offset < offend) {
-	    
-	    while (isBlankspace(current)
-		   || isSeparator(current)) {
-		offset++;
-		stream.seekg(offset);
-		current = stream.peek();
-	    }
-
-	    while (!isBlankspace(current)
-		   && !isSeparator(current)
-		   && offset < offend) {
-
-		//std::cerr << "[DEBUG] read: "
-		//	  << static_cast<char>(current)
-		//	  << std::endl;
-		
-		if( lowercaseMode() ) {
-		    current = tolower( current );
-		}
-
-		str.push_back(current);
-		
-		//std::cerr << "[DEBUG] pushed: "
-		//          << static_cast<char>(current)
-		//          << std::endl;
-
-		offset++;
-		stream.seekg(offset);
-		current = stream.peek();
-	    }
-	}
-		
-//	do {
-//	    do {
-//		current = stream.peek();
-//		offset++;
-//		stream.seekg(offset);
-//
-//		//std::cerr << "[DEBUG] read: "
-//		//	  << static_cast<char>(current)
-//		//	  << std::endl;
-//		
-//		if (   !isBlankspace(current)
-//		    && !isSeparator(current)
-//		    && offset <= offend) {
-//					
-//		    if( lowercaseMode() ) {
-//		        current = tolower( current );
-//		    }
-//
-//		    str.push_back(current);
-//
-//		    //std::cerr << "[DEBUG] pushed: "
-//		    //          << static_cast<char>(current)
-//		    //          << std::endl;
-//		}
-//	    } while (   !isBlankspace(current)
-//			&& !isSeparator(current)
-//			&& offset < offend);
-//	} while (str.empty() && (offset < offend));
-    } else {
-	std::cerr << "stream is NOT good!" << std::endl;
-    }
-
-    //std::cerr << "[DEBUG] token: " << str << std::endl;
-    
-    return str;
+    return toString(scanner.forward(text.data(), offend, offset));
 }
 
 double ForwardTokenizer::progress() const
 {
     return static_cast<double>(offset) / offend;
 }
-
@@ -60,6 +60,9 @@ public:
     virtual double progress() const;
 
 protected:
+    ForwardTokenizer(const std::string& str,
+		     const std::string blankspaces,
+		     const std::string separators);
 
 private:
 
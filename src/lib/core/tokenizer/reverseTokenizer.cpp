@@ -30,15 +30,6 @@ ReverseTokenizer::ReverseTokenizer(std::istream& stream,
     : Tokenizer(stream, blanks, separs)
 {
     offset = offend;
-    //assert( stream.good());
-    //assert(!stream.fail());
-    //assert(!stream.bad() );
-    //assert(!stream.eof() );
-    // stream clearing needed because offset is positioned at end
-    stream.clear();
-
-    //std::cerr << "ReverseTokenizer::ReverseTokenizer() offbeg: " << offbeg 
-    //          << " offset: " << offset << " offend: " << offend << std::endl;
 }
 
 ReverseTokenizer::~ReverseTokenizer()
@@ -46,30 +37,20 @@ ReverseTokenizer::~ReverseTokenizer()
 
 int ReverseTokenizer::countTokens()
 {
-    StreamGuard guard(stream, offset);
-
-    // store current seek pointer position
-    std::streamoff curroff = offset;
-
-    // position get pointer at end of stream
-    offset = offend;
+    // count tokens from the end of the buffer
+    size_t pos = offend;
 
     int count = 0;
-    while (hasMoreTokens()) {
-	nextToken();
+    while (offbeg < pos) {
+	scanner.reverse(text.data(), offend, pos);
 	count++;
     }
 
-    // reposition seek get pointer to original position
-    offset = curroff;
-
     return count;
 }
 
 bool ReverseTokenizer::hasMoreTokens() const
 {
-    //std::cerr << "ReverseTokenizer::hasMoreTokens() offbeg: " << offbeg 
-    //          << " offset: " << offset << " offend: " << offend << std::endl;
     if (offbeg < offset) {
 	return true;
     } else {
@@ -79,96 +60,7 @@ bool ReverseTokenizer::hasMoreTokens() const
     
 std::string ReverseTokenizer::nextToken()
 {
-    StreamGuard guard(stream, offset);
-
-    int current;
-    std::string str;
-
-    if (stream.good()) {
-	while (offbeg < offset
-	       && str.empty()) {
-	    stream.seekg(offset - 1);
-	    current = stream.peek();
-
-	    if (offset == offend &&
-		(isSeparator(current) || isBlankspace(current))) {
-		offset--;
-		return str;
-	    }
-
-	    while ((isBlankspace(current) || isSeparator(current))
-		   && offbeg < offset ) {
-		offset--;
-		stream.seekg(offset - 1);
-		current = stream.peek();
-	    }
-
-	    while (!isBlankspace(current)
-		   && !isSeparator(current)
-		   && offbeg < offset) {
-		
-		if( lowercaseMode() ) {
-		    current = tolower( current );
-		}
-
-		// since the token is read backwards, the string
-		// needs to be reversed by inserting the char at
-		// the front
-		str.insert(str.begin(), current);
-
-		offset--;
-		stream.seekg(offset - 1);
-		current = stream.peek();
-	    }
-	}
-    }
-
-//    if (stream.good()) {
-//	do {
-//	    do {
-//		current = stream.peek();
-//		offset--;
-//		stream.seekg(offset);
-//
-//		// handle case where last character is a separator by
-//		// returning an empty token
-//                if (offset == offend - 2
-//                    && isSeparator(current)) {
-//                    return "";
-//                }
-//                
-//		//std::cerr << "[DEBUG] read: "
-//                //  << static_cast<char>(current)
-//                //  << std::endl;
-//
-//		if (!isBlankspace(current)
-//                    && !isSeparator(current)
-//                    && offset >= offbeg - 1) {
-//                    
-//		    if( lowercaseMode() ) {
-//		        current = tolower( current );
-//		    }
-//
-//                    // since the token is read backwards, the string
-//                    // needs to be reversed by inserting the char at
-//                    // the front
-//		    str.insert(str.begin(), current);
-//
-//		    //std::cerr << "[DEBUG] pushed: "
-//                    //  << static_cast<char>(current)
-//                    //  << std::endl;
-//                    //std::cerr << "[DEBUG] partial string: "
-//                    //          << str << std::endl;
-//		}
-//	    } while (!isBlankspace(current)
-//                     && !isSeparator(current)
-//                     && (offset >= offbeg));
-//	} while (str.empty() && (offset >= offbeg));
-//    }
-
-    //std::cerr << "[DEBUG] token: " << str << std::endl;
-
-    return str;
+    return toString(scanner.reverse(text.data(), offend, offset));
 }
 
 double ReverseTokenizer::progress() const
@@ -24,12 +24,10 @@
 
 #include "stringForwardTokenizer.h"
 
-#include <sstream>
-
 StringForwardTokenizer::StringForwardTokenizer(std::string& str,
 					       const std::string blankspaces,
 					       const std::string separators  )
-    : ForwardTokenizer(*(new std::stringstream(str)), blankspaces, separators)
+    : ForwardTokenizer(str, blankspaces, separators)
 {}
 
 StringForwardTokenizer::~StringForwardTokenizer()
@@ -30,21 +30,39 @@ Tokenizer::Tokenizer(
     const std::string   separators
 )
     : stream(is),
+      scanner(blankspaces, separators),
       lowercase(false)
 {
     // this should be changed to deal with a !good() stream
     // appropriately
     //assert(stream.good());
 
-    offset = stream.tellg();
     sstate = stream.rdstate();
+    readStream();
 
-    StreamGuard(stream, offset);
+    offbeg = 0;
+    offend = text.size();
+    offset = offbeg;
 
-    stream.seekg(0, std::ios::end);
-    offend = stream.tellg();
-    stream.seekg(0, std::ios::beg);
-    offbeg = stream.tellg();
+    blankspaceChars(blankspaces);
+    separatorChars (separators );
+}
+
+Tokenizer::Tokenizer(
+    const std::string& str,
+    const std::string   blankspaces,
+    const std::string   separators
+)
+    : stream(own_stream),
+      text(str),
+      scanner(blankspaces, separators),
+      lowercase(false)
+{
+    sstate = stream.rdstate();
+
+    offbeg = 0;
+    offend = text.size();
+    offset = offbeg;
 
     blankspaceChars(blankspaces);
     separatorChars (separators );
@@ -58,9 +76,32 @@ Tokenizer::~Tokenizer()
     stream.clear();
 }
 
+void Tokenizer::readStream()
+{
+    // read the whole stream, leaving its position and state as they
+    // were found
+    std::ios::iostate state = stream.rdstate();
+    stream.clear();
+    std::streamoff curroff = stream.tellg();
+
+    stream.seekg(0, std::ios::end);
+    std::streamoff size = stream.tellg();
+    stream.seekg(0, std::ios::beg);
+    if (size > 0) {
+	text.resize(size);
+	stream.read(&text[0], size);
+	text.resize(stream.gcount());
+    }
+
+    stream.clear();
+    stream.seekg(curroff);
+    stream.setstate(state);
+}
+
 void Tokenizer::blankspaceChars(const std::string chars)
 {
     blankspaces = chars;
+    scanner.blankspaceChars(chars);
 }
 
 std::string Tokenizer::blankspaceChars() const
@@ -71,6 +112,7 @@ std::string Tokenizer::blankspaceChars() const
 void Tokenizer::separatorChars(const std::string chars)
 {
     separators = chars;
+    scanner.separatorChars(chars);
 }
 
 std::string Tokenizer::separatorChars() const
@@ -90,20 +132,19 @@ bool Tokenizer::lowercaseMode() const
 
 bool Tokenizer::isBlankspace(const int character) const
 {
-    std::string::size_type ret = blankspaces.find(character);
-    if (ret == std::string::npos) {
-	return false;
-    } else {
-	return true;
-    }
+    return scanner.isBlankspace(static_cast<char>(character));
 }
 
 bool Tokenizer::isSeparator(const int character) const
 {
-    std::string::size_type ret = separators.find(character);
-    if (ret == std::string::npos) {
-	return false;
-    } else {
-	return true;
+    return scanner.isSeparator(static_cast<char>(character));
+}
+
+std::string Tokenizer::toString(const BufferTokenizer::Token& token) const
+{
+    std::string str = token.str();
+    if (lowercase) {
+	BufferTokenizer::lowercase(str);
     }
+    return str;
 }
@@ -29,8 +29,11 @@
 #include "config.h"
 #endif
 
+#include "bufferTokenizer.h"
+
 #include <iostream>
 #include <istream>
+#include <sstream>
 #include <string>
 #include <assert.h>
 
@@ -51,6 +54,10 @@
  * Each byte read from the input stream is regarded as a character in
  * the range '\\u0000' through '\\u00FF'.
  *
+ * The whole stream is read into a buffer when the tokenizer is
+ * constructed and tokens are then scanned by a BufferTokenizer, so
+ * the stream is not sought or peeked at character by character.
+ *
  * In addition, an instance has flags that control:
  *
  * - whether the characters of tokens are converted to lowercase. 
@@ -107,50 +114,37 @@ public:
     bool lowercaseMode() const;
 
     std::string streamToString() const {
-	std::streamoff offbackup = stream.tellg();
-	std::string str;
-	std::streamoff curroff = offbeg;
-	stream.seekg(curroff);
-	while (curroff < offend) {
-            stream.clear();
-	    str.push_back(stream.peek());
-	    curroff++;
-	    stream.seekg(curroff);
-	}
-	stream.seekg(offbackup);
-	return str;
+	return text;
     }
     
 protected:
-    class StreamGuard {
-    public:
-	StreamGuard(std::istream& so, std::streamoff& of) 
-	    : guardedStream(so) {
-            currstate = guardedStream.rdstate();
-	    curroff   = guardedStream.tellg();
-	    guardedStream.seekg   (of       );
-	}
-	~StreamGuard() {
-	    guardedStream.seekg   (curroff  );
-            guardedStream.setstate(currstate);
-	}
-
-    private:
-	std::istream&     guardedStream;
-        std::ios::iostate currstate;
-	std::streamoff    curroff;
-    };
+    /** Tokenizes a copy of str, without an input stream of its own.
+     */
+    Tokenizer(const std::string& str,
+	      const std::string   blankspaces,
+	      const std::string   separators  );
 
     std::istream&     stream;
     std::ios::iostate sstate;
-    std::streamoff    offbeg;
-    std::streamoff    offend;
-    std::streamoff    offset;
+    size_t            offbeg;
+    size_t            offend;
+    size_t            offset;
+
+    std::string       text;
+    BufferTokenizer   scanner;
 
     bool isBlankspace(const int character) const;
     bool isSeparator (const int character) const;
 
+    /** Returns the token as a string, lowercased in lowercase mode.
+     */
+    std::string toString(const BufferTokenizer::Token& token) const;
+
 private:
+    void readStream();
+
+    std::stringstream own_stream;
+
     std::string blankspaces;
     std::string separators;
 
@@ -39,6 +39,7 @@
 // use istringstream for conversion of string to double
 // in locale independent manner
 #include <sstream>
+#include <list>
 #include <locale>
 
 
@@ -348,3 +349,79 @@ void Utility::create_directory (const std::string& dir)
 	   );
 #endif
 }
+
+
+/** Expand ${VARIABLE} references to environment variables
+ *
+ */
+std::string Utility::expand_variables (std::string filepath)
+{
+    // scan the filepath for variables, which follow the same pattern
+    // as shell variables - strings enclosed in '${' and '}'
+    //
+    const std::string start_marker = "${";
+    const std::string   end_marker = "}";
+
+    std::list<std::string> variables;
+
+    std::string::size_type pos_start = filepath.find (start_marker);
+    while (pos_start != std::string::npos)
+    {
+	std::string::size_type pos_end = filepath.find (end_marker, pos_start);
+	if (pos_end != std::string::npos) {
+	    variables.push_back (filepath.substr(pos_start + start_marker.size(), pos_end - end_marker.size() - pos_start - 1));
+	}
+
+	pos_start = filepath.find (start_marker, pos_end);
+    }
+
+    for (std::list<std::string>::const_iterator it = variables.begin();
+	 it != variables.end();
+	 it++)
+    {
+	substitute_variable_in_string(*it, filepath);
+    }
+
+    return filepath;
+}
+
+void Utility::substitute_variable_in_string (const std::string& variable_name, std::string& filepath)
+{
+    std::string variable_token = "${" + variable_name + "}";
+
+    for (std::string::size_type pos = filepath.find (variable_token);
+         pos != std::string::npos;
+         pos = filepath.find (variable_token, pos))
+    {
+        const char* value = getenv(variable_name.c_str());
+        if (value)
+        {
+            filepath.replace (pos,
+                              variable_token.size(),
+                              value);
+        }
+        else
+        {
+	    // handle "special" variables
+	    if (variable_name == "HOME")
+	    {
+		value = getenv("USERPROFILE");
+		if (value)
+		{
+		    filepath.replace (pos,
+				      variable_token.size(),
+				      value);
+		}
+	    }
+	    else
+	    {
+		// FIXME: maybe throw exception instead of leaving
+		// variable name in string?
+		//
+		filepath.replace (pos,
+				  variable_token.size(),
+				  variable_name);
+	    }
+	}
+    }
+}
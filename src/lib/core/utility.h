@@ -67,6 +67,11 @@ public:
     static bool is_directory_usable (const std::string& dir);
     static void create_directory (const std::string& dir);
 
+    static std::string expand_variables (std::string filepath);
+
+private:
+    static void substitute_variable_in_string (const std::string& variable_name, std::string& filepath);
+
 };
 
 #endif // PRESAGE_UTILITY
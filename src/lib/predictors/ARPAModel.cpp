@@ -0,0 +1,624 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#include "ARPAModel.h"
+#include "../core/progress.h"
+#include "../presageException.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+#include <memory>
+#include <cstring>
+#include <cstdlib>
+
+#define OOV "<UNK>"
+
+// log10 probability of vocabulary words missing from the unigrams
+static const float MISSING_LOG_PROB = -99.0;
+
+// marks an empty slot of an n-gram hash table
+static const uint32_t EMPTY_SLOT = 0xffffffff;
+
+const char     ARPAModel::FORMAT_MAGIC[8]   = { 'P', 'R', 'E', 'S', 'A', 'R', 'P', 'A' };
+const uint32_t ARPAModel::FORMAT_BYTE_ORDER = 0x01020304;
+const uint32_t ARPAModel::FORMAT_VERSION    = 3;
+
+namespace {
+
+/** Splits an ARPA line into its whitespace separated fields. */
+void splitFields(const std::string& line, std::vector<std::string>& fields)
+{
+    fields.clear();
+    std::string::size_type i = 0;
+    while (i < line.size()) {
+	while (i < line.size() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')) {
+	    i++;
+	}
+	std::string::size_type begin = i;
+	while (i < line.size() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r') {
+	    i++;
+	}
+	if (i > begin) {
+	    fields.push_back(line.substr(begin, i - begin));
+	}
+    }
+}
+
+/** Hashes the key of an n-gram record. */
+uint64_t hashKey(const uint32_t context, const uint32_t word)
+{
+    // 64 bit finalizer of MurmurHash3
+    uint64_t key = (static_cast<uint64_t>(context) << 32) | word;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+/** Returns the number of bytes needed to pad size to eight bytes. */
+size_t padding(const size_t size)
+{
+    return (8 - size % 8) % 8;
+}
+
+}
+
+ARPAModel::ARPAModel()
+    : mapping(0),
+      mapping_size(0)
+{
+    clear();
+}
+
+ARPAModel::~ARPAModel()
+{
+    clear();
+}
+
+void ARPAModel::clear()
+{
+    if (mapping) {
+	munmap(mapping, mapping_size);
+	mapping = 0;
+	mapping_size = 0;
+    }
+
+    words = 0;
+    strings = 0;
+    strings_size = 0;
+    offsets = 0;
+    sorted = 0;
+    likeliest = 0;
+    unigrams = 0;
+    records.assign(2, 0);
+    tables.assign(2, 0);
+    counts.assign(2, 0);
+
+    own_strings.clear();
+    own_offsets.clear();
+    own_sorted.clear();
+    own_likeliest.clear();
+    own_unigrams.clear();
+    own_records.clear();
+    own_tables.clear();
+}
+
+void ARPAModel::compile(const std::string& arpa,
+			const std::string& vocab,
+			const size_t max_order,
+			std::ostream* progress)
+{
+    clear();
+
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::string> vocabulary;
+
+    if (! vocab.empty()) {
+	std::ifstream vocabFile(vocab.c_str());
+	if (! vocabFile) {
+	    throw PresageException(PRESAGE_ERROR, "ARPAModel: Error opening vocabulary file " + vocab);
+	}
+	std::string row;
+	while (std::getline(vocabFile, row)) {
+	    if (row.empty() || row[0] == '#') {
+		continue;
+	    }
+	    if (ids.insert(std::make_pair(row, static_cast<uint32_t>(vocabulary.size()))).second) {
+		vocabulary.push_back(row);
+	    }
+	}
+	Unigram missing = { MISSING_LOG_PROB, 0 };
+	own_unigrams.assign(vocabulary.size(), missing);
+    }
+
+    std::ifstream arpaFile(arpa.c_str());
+    if (! arpaFile) {
+	throw PresageException(PRESAGE_ERROR, "ARPAModel: Error opening ARPA model file " + arpa);
+    }
+
+    // n-gram counts announced in the data section, indexed by order
+    std::vector<size_t> announced(1, 0);
+    std::unique_ptr< ProgressBar<char> > bar;
+    size_t parsed = 0;
+
+    size_t section = 0;
+    bool data = false;
+    std::string row;
+    std::vector<std::string> fields;
+    std::vector<int> key;
+    while (std::getline(arpaFile, row)) {
+	if (! row.empty() && row[row.size() - 1] == '\r') {
+	    row.erase(row.size() - 1);
+	}
+	if (row.empty()) {
+	    continue;
+	}
+
+	if (row == "\\end\\") {
+	    break;
+	}
+
+	if (row == "\\data\\") {
+	    data = true;
+	    continue;
+	}
+
+	if (row[0] == '\\') {
+	    // n-gram section header, i.e. \N-grams:
+	    char* end = 0;
+	    size_t n = strtoul(row.c_str() + 1, &end, 10);
+	    if (n > 0 && std::string(end) == "-grams:") {
+		finishOrder(section);
+		section = n;
+		parsed = 0;
+		bar.reset();
+		if (max_order == 0 || section <= max_order) {
+		    if (own_records.size() <= section) {
+			own_records.resize(section + 1);
+		    }
+		    if (section < announced.size()) {
+			own_records[section].reserve(announced[section]);
+		    }
+		    if (progress) {
+			*progress << std::endl << "ARPA loading " << section << "-grams:" << std::endl;
+			bar.reset(new ProgressBar<char>(*progress));
+		    }
+		    attachOwned();
+		}
+	    }
+	    continue;
+	}
+
+	if (section == 0) {
+	    // data section, i.e. ngram N=COUNT
+	    if (data && row.compare(0, 6, "ngram ") == 0) {
+		char* end = 0;
+		size_t n = strtoul(row.c_str() + 6, &end, 10);
+		if (n > 0 && *end == '=') {
+		    if (announced.size() <= n) {
+			announced.resize(n + 1, 0);
+		    }
+		    announced[n] = strtoul(end + 1, 0, 10);
+		}
+	    }
+	    continue;
+	}
+
+	if (max_order > 0 && section > max_order) {
+	    continue;
+	}
+
+	parsed++;
+	if (bar && section < announced.size() && announced[section] > 0) {
+	    bar->update(static_cast<double>(parsed) / announced[section]);
+	}
+
+	splitFields(row, fields);
+	if (fields.size() < section + 1) {
+	    continue;
+	}
+	float logProb = strtof(fields[0].c_str(), 0);
+	float backoff = (fields.size() > section + 1 ? strtof(fields[section + 1].c_str(), 0) : 0);
+
+	key.clear();
+	for (size_t i = 1; i <= section; i++) {
+	    if (fields[i] == OOV) {
+		break;
+	    }
+	    std::unordered_map<std::string, uint32_t>::const_iterator it = ids.find(fields[i]);
+	    if (it != ids.end()) {
+		key.push_back(it->second);
+	    } else if (vocab.empty() && section == 1) {
+		// no vocabulary given, unigrams make up the vocabulary
+		uint32_t id = vocabulary.size();
+		ids[fields[i]] = id;
+		vocabulary.push_back(fields[i]);
+		own_unigrams.resize(vocabulary.size());
+		key.push_back(id);
+	    } else {
+		break;
+	    }
+	}
+	if (key.size() != section) {
+	    continue;
+	}
+
+	if (section == 1) {
+	    Unigram unigram = { logProb, backoff };
+	    own_unigrams[key[0]] = unigram;
+	} else {
+	    long context = find(&key[0], section - 1);
+	    if (context < 0) {
+		continue;
+	    }
+	    Record record = { static_cast<uint32_t>(context), static_cast<uint32_t>(key.back()), logProb, backoff };
+	    own_records[section].push_back(record);
+	}
+    }
+    finishOrder(section);
+    bar.reset();
+
+    // vocabulary strings, and word ids sorted by word
+    own_offsets.reserve(vocabulary.size());
+    for (size_t i = 0; i < vocabulary.size(); i++) {
+	own_offsets.push_back(own_strings.size());
+	own_strings += vocabulary[i];
+	own_strings += '\0';
+    }
+    own_sorted.resize(vocabulary.size());
+    for (size_t i = 0; i < own_sorted.size(); i++) {
+	own_sorted[i] = i;
+    }
+    std::sort(own_sorted.begin(), own_sorted.end(),
+	      [&vocabulary](uint32_t a, uint32_t b) { return vocabulary[a] < vocabulary[b]; });
+    own_likeliest.assign(own_sorted.begin(), own_sorted.end());
+    std::sort(own_likeliest.begin(), own_likeliest.end(),
+	      [this](uint32_t a, uint32_t b) {
+		  return own_unigrams[a].logProb > own_unigrams[b].logProb
+		      || (own_unigrams[a].logProb == own_unigrams[b].logProb && a < b);
+	      });
+
+    if (own_records.size() < 2) {
+	own_records.resize(2);
+    }
+    for (size_t n = 2; n < own_records.size(); n++) {
+	if (n >= own_tables.size() || own_tables[n].empty()) {
+	    // order without a section of its own
+	    finishOrder(n);
+	}
+    }
+    attachOwned();
+}
+
+void ARPAModel::finishOrder(const size_t n)
+{
+    if (n >= 2 && n < own_records.size()) {
+	std::vector<Record>& table = own_records[n];
+	std::stable_sort(table.begin(), table.end());
+	table.erase(std::unique(table.begin(), table.end(),
+				[](const Record& a, const Record& b) {
+				    return a.context == b.context && a.word == b.word;
+				}),
+		    table.end());
+
+	// index the records by key, linear probing
+	if (own_tables.size() <= n) {
+	    own_tables.resize(n + 1);
+	}
+	std::vector<uint32_t>& slots = own_tables[n];
+	slots.assign(tableSize(table.size()), EMPTY_SLOT);
+	const uint64_t mask = slots.size() - 1;
+	for (size_t i = 0; i < table.size(); i++) {
+	    uint64_t slot = hashKey(table[i].context, table[i].word) & mask;
+	    while (slots[slot] != EMPTY_SLOT) {
+		slot = (slot + 1) & mask;
+	    }
+	    slots[slot] = i;
+	}
+    }
+    attachOwned();
+}
+
+size_t ARPAModel::tableSize(const size_t count)
+{
+    // power of two, at most three quarters full
+    size_t size = 1;
+    while (size * 3 < count * 4 + 1) {
+	size <<= 1;
+    }
+    return size;
+}
+
+void ARPAModel::attachOwned()
+{
+    words = own_unigrams.size();
+    strings = own_strings.data();
+    strings_size = own_strings.size();
+    offsets = own_offsets.data();
+    sorted = own_sorted.data();
+    likeliest = own_likeliest.data();
+    unigrams = own_unigrams.data();
+
+    size_t order = std::max<size_t>(own_records.size(), 2) - 1;
+    records.assign(order + 1, 0);
+    tables.assign(order + 1, 0);
+    counts.assign(order + 1, 0);
+    counts[1] = words;
+    for (size_t n = 2; n <= order; n++) {
+	records[n] = own_records[n].data();
+	tables[n] = (n < own_tables.size() && ! own_tables[n].empty() ? own_tables[n].data() : 0);
+	counts[n] = own_records[n].size();
+    }
+}
+
+void ARPAModel::save(const std::string& filename) const
+{
+    std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+    if (! out) {
+	throw PresageException(PRESAGE_ERROR, "ARPAModel: Error creating file " + filename);
+    }
+
+    const char zeros[8] = { 0 };
+    auto write = [&out, &zeros](const void* data, const size_t size) {
+	out.write(static_cast<const char*>(data), size);
+	out.write(zeros, padding(size));
+    };
+
+    Header header;
+    memcpy(header.magic, FORMAT_MAGIC, sizeof(FORMAT_MAGIC));
+    header.byte_order = FORMAT_BYTE_ORDER;
+    header.version = FORMAT_VERSION;
+    header.order = order();
+    header.words = words;
+    header.strings = strings_size;
+    write(&header, sizeof(header));
+
+    std::vector<uint64_t> sizes(counts.begin() + 1, counts.end());
+    write(sizes.data(), sizes.size() * sizeof(uint64_t));
+
+    write(strings, strings_size);
+    write(offsets, words * sizeof(uint32_t));
+    write(sorted, words * sizeof(uint32_t));
+    write(likeliest, words * sizeof(uint32_t));
+    write(unigrams, words * sizeof(Unigram));
+    for (size_t n = 2; n <= order(); n++) {
+	write(records[n], counts[n] * sizeof(Record));
+	write(tables[n], tableSize(counts[n]) * sizeof(uint32_t));
+    }
+
+    out.close();
+    if (out.fail()) {
+	throw PresageException(PRESAGE_ERROR, "ARPAModel: Error writing file " + filename);
+    }
+}
+
+void ARPAModel::load(const std::string& filename)
+{
+    clear();
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+	throw PresageException(PRESAGE_ERROR, "ARPAModel: Error opening compiled model " + filename);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+	close(fd);
+	throw PresageException(PRESAGE_ERROR, "ARPAModel: Invalid compiled model " + filename);
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping stays valid after the descriptor is closed
+    if (data == MAP_FAILED) {
+	throw PresageException(PRESAGE_ERROR, "ARPAModel: Error mapping compiled model " + filename);
+    }
+    mapping = data;
+    mapping_size = st.st_size;
+
+    const char* base = static_cast<const char*>(data);
+    const Header* header = reinterpret_cast<const Header*>(base);
+    if (memcmp(header->magic, FORMAT_MAGIC, sizeof(FORMAT_MAGIC)) != 0
+	|| header->byte_order != FORMAT_BYTE_ORDER
+	|| header->version != FORMAT_VERSION
+	|| header->order < 1) {
+	clear();
+	throw PresageException(PRESAGE_ERROR, "ARPAModel: Unsupported compiled model " + filename);
+    }
+
+    // walk the sections in the order save() wrote them, checking
+    // that each one fits in the file
+    size_t position = 0;
+    auto section = [&position, this](const size_t size) -> const char* {
+	size_t begin = position;
+	position += size + padding(size);
+	if (position > mapping_size) {
+	    return 0;
+	}
+	return static_cast<const char*>(mapping) + begin;
+    };
+
+    section(sizeof(Header));
+    const uint64_t* sizes = reinterpret_cast<const uint64_t*>(section(header->order * sizeof(uint64_t)));
+    bool valid = (sizes != 0 && sizes[0] == header->words);
+
+    if (valid) {
+	words = header->words;
+	strings_size = header->strings;
+	strings = section(strings_size);
+	offsets = reinterpret_cast<const uint32_t*>(section(words * sizeof(uint32_t)));
+	sorted = reinterpret_cast<const uint32_t*>(section(words * sizeof(uint32_t)));
+	likeliest = reinterpret_cast<const uint32_t*>(section(words * sizeof(uint32_t)));
+	unigrams = reinterpret_cast<const Unigram*>(section(words * sizeof(Unigram)));
+	valid = (strings && offsets && sorted && likeliest && unigrams);
+
+	records.assign(header->order + 1, 0);
+	tables.assign(header->order + 1, 0);
+	counts.assign(header->order + 1, 0);
+	counts[1] = words;
+	for (size_t n = 2; valid && n <= header->order; n++) {
+	    counts[n] = sizes[n - 1];
+	    records[n] = reinterpret_cast<const Record*>(section(counts[n] * sizeof(Record)));
+	    tables[n] = reinterpret_cast<const uint32_t*>(section(tableSize(counts[n]) * sizeof(uint32_t)));
+	    valid = (records[n] != 0 && tables[n] != 0);
+	}
+    }
+
+    if (! valid) {
+	clear();
+	throw PresageException(PRESAGE_ERROR, "ARPAModel: Truncated compiled model " + filename);
+    }
+}
+
+bool ARPAModel::isCompiled(const std::string& filename)
+{
+    std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+    char magic[sizeof(FORMAT_MAGIC)];
+    return in.read(magic, sizeof(magic)) && memcmp(magic, FORMAT_MAGIC, sizeof(FORMAT_MAGIC)) == 0;
+}
+
+size_t ARPAModel::order() const
+{
+    return counts.size() - 1;
+}
+
+size_t ARPAModel::size(const size_t n) const
+{
+    return (n < counts.size() ? counts[n] : 0);
+}
+
+const char* ARPAModel::word(const int id) const
+{
+    return strings + offsets[id];
+}
+
+int ARPAModel::find(const std::string& word) const
+{
+    const uint32_t* end = sorted + words;
+    const uint32_t* it = std::lower_bound(sorted, end, word,
+					  [this](uint32_t id, const std::string& w) {
+					      return strcmp(strings + offsets[id], w.c_str()) < 0;
+					  });
+    if (it != end && word == strings + offsets[*it]) {
+	return *it;
+    }
+    return -1;
+}
+
+long ARPAModel::find(const int* ids, const size_t n) const
+{
+    if (n == 0 || n > order() || ids[0] < 0 || static_cast<size_t>(ids[0]) >= words) {
+	return -1;
+    }
+
+    long index = ids[0];
+    for (size_t k = 2; k <= n && index >= 0; k++) {
+	if (ids[k - 1] < 0) {
+	    return -1;
+	}
+	index = lookup(k, index, ids[k - 1]);
+    }
+    return index;
+}
+
+long ARPAModel::lookup(const size_t n, const uint32_t context, const uint32_t word) const
+{
+    const uint32_t* slots = tables[n];
+    if (slots == 0 || counts[n] == 0) {
+	return -1;
+    }
+
+    const uint64_t mask = tableSize(counts[n]) - 1;
+    for (uint64_t slot = hashKey(context, word) & mask; slots[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+	const Record& record = records[n][slots[slot]];
+	if (record.context == context && record.word == word) {
+	    return slots[slot];
+	}
+    }
+    return -1;
+}
+
+void ARPAModel::prefixRange(const std::string& prefix, size_t& begin, size_t& end) const
+{
+    const uint32_t* last = sorted + words;
+    const uint32_t* first = std::lower_bound(sorted, last, prefix,
+					     [this](uint32_t id, const std::string& p) {
+						 return strcmp(strings + offsets[id], p.c_str()) < 0;
+					     });
+    // words starting with prefix compare equal to it on its length
+    last = std::upper_bound(first, last, prefix,
+			    [this](const std::string& p, uint32_t id) {
+				return strncmp(p.c_str(), strings + offsets[id], p.size()) < 0;
+			    });
+    begin = first - sorted;
+    end = last - sorted;
+}
+
+int ARPAModel::sortedId(const size_t position) const
+{
+    return sorted[position];
+}
+
+int ARPAModel::likeliestId(const size_t rank) const
+{
+    return likeliest[rank];
+}
+
+void ARPAModel::successors(const size_t n, const long context, long& begin, long& end) const
+{
+    begin = end = 0;
+    if (n < 2 || n > order() || context < 0) {
+	return;
+    }
+
+    const Record* first = records[n];
+    const Record* last = first + counts[n];
+    std::pair<const Record*, const Record*> range =
+	std::equal_range(first, last, static_cast<uint32_t>(context), ContextLess());
+    begin = range.first - first;
+    end = range.second - first;
+}
+
+int ARPAModel::lastWord(const size_t n, const long index) const
+{
+    return (n == 1 ? index : records[n][index].word);
+}
+
+float ARPAModel::logProb(const size_t n, const long index) const
+{
+    return (n == 1 ? unigrams[index].logProb : records[n][index].logProb);
+}
+
+float ARPAModel::backoff(const size_t n, const long index) const
+{
+    return (n == 1 ? unigrams[index].backoff : records[n][index].backoff);
+}
@@ -0,0 +1,228 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#ifndef PRESAGE_ARPAMODEL
+#define PRESAGE_ARPAMODEL
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/** Backoff n-gram language model read from an ARPA file.
+ *
+ * The model is kept in a compact layout made of the vocabulary, the
+ * unigrams indexed by word id and, for each higher order, an array of
+ * n-gram records sorted by context and word. The context of a bigram
+ * is the id of its first word, the context of a longer n-gram is the
+ * index of the record of its first n-1 words in the array of the
+ * previous order.
+ *
+ * Each table of n-grams is indexed by an open addressing hash table
+ * of record indexes, keyed by context and word, so that looking up an
+ * n-gram takes n hash probes whatever the size of the model.
+ *
+ * Two more indexes of the vocabulary serve candidate generation: the
+ * word ids sorted by word, giving the range of words starting with a
+ * prefix, and the word ids sorted by decreasing unigram probability.
+ *
+ * A text ARPA file is compiled into this layout in memory. The
+ * layout can be saved to a file, which load() later maps into memory
+ * as it is: startup time no longer depends on the size of the model
+ * and the pages are shared by all processes using it.
+ */
+class ARPAModel {
+public:
+    ARPAModel();
+    ~ARPAModel();
+
+    /** Compiles a text ARPA model.
+     *
+     * \param arpa ARPA file name
+     * \param vocab vocabulary file name, one word per line, where
+     * lines starting with # are skipped; when empty, the unigrams
+     * make up the vocabulary
+     * \param max_order n-grams of higher order are skipped, zero
+     * keeps all orders
+     * \param progress if not null, loading progress is shown on it
+     *
+     * N-grams containing the unknown word or words outside the
+     * vocabulary are skipped.
+     *
+     * Throws PresageException if the files cannot be read.
+     */
+    void compile(const std::string& arpa,
+		 const std::string& vocab,
+		 const size_t max_order,
+		 std::ostream* progress = 0);
+
+    /** Maps a model saved by save() into memory.
+     *
+     * Throws PresageException if the file is not a valid model.
+     */
+    void load(const std::string& filename);
+
+    /** Writes the model to file in the layout read by load().
+     *
+     * Throws PresageException on error.
+     */
+    void save(const std::string& filename) const;
+
+    /** Returns true if filename starts like a file written by save().
+     */
+    static bool isCompiled(const std::string& filename);
+
+    /** Returns the highest n-gram order in the model. */
+    size_t order() const;
+
+    /** Returns the number of n-grams of order n, which is the
+     ** vocabulary size for n equal to one.
+     */
+    size_t size(const size_t n) const;
+
+    /** Returns the word with the given id. */
+    const char* word(const int id) const;
+
+    /** Returns the id of word, or -1 if it is not in the vocabulary. */
+    int find(const std::string& word) const;
+
+    /** Returns the index of the n-gram made of the n word ids in the
+     ** table of order n, or -1 if it is not in the model.
+     *
+     * The index of a unigram is its word id.
+     */
+    long find(const int* ids, const size_t n) const;
+
+    /** Returns the range [begin, end) of positions in the sorted
+     ** vocabulary of the words starting with prefix.
+     */
+    void prefixRange(const std::string& prefix, size_t& begin, size_t& end) const;
+
+    /** Returns the id of the word at position in the sorted vocabulary. */
+    int sortedId(const size_t position) const;
+
+    /** Returns the id of the word ranking rank by unigram probability,
+     ** the likeliest word ranking zero. Words of equal probability
+     ** rank by id.
+     */
+    int likeliestId(const size_t rank) const;
+
+    /** Returns the range [begin, end) of indexes in the table of
+     ** order n of the n-grams extending the context found at index
+     ** context in the table of order n-1, sorted by their last word.
+     */
+    void successors(const size_t n, const long context, long& begin, long& end) const;
+
+    /** Returns the last word id of the n-gram found at index in the
+     ** table of order n.
+     */
+    int lastWord(const size_t n, const long index) const;
+
+    /** Return the log10 probability and the log10 backoff weight of
+     ** the n-gram found at index in the table of order n.
+     */
+    float logProb(const size_t n, const long index) const;
+    float backoff(const size_t n, const long index) const;
+
+private:
+    struct Header {
+	char     magic[8];
+	uint32_t byte_order;
+	uint32_t version;
+	uint32_t order;
+	uint32_t words;
+	uint64_t strings;
+    };
+
+    struct Unigram {
+	float logProb;
+	float backoff;
+    };
+
+    struct Record {
+	uint32_t context;
+	uint32_t word;
+	float    logProb;
+	float    backoff;
+
+	bool operator<(const Record& right) const
+	{
+	    return context < right.context
+		|| (context == right.context && word < right.word);
+	}
+    };
+
+    /** Compares records by context only. */
+    struct ContextLess {
+	bool operator()(const Record& record, uint32_t context) const { return record.context < context; }
+	bool operator()(uint32_t context, const Record& record) const { return context < record.context; }
+    };
+
+    void clear();
+
+    /** Returns the number of slots of the hash table of count records. */
+    static size_t tableSize(const size_t count);
+
+    /** Returns the index of the record with the given key in the table
+     ** of order n, or -1.
+     */
+    long lookup(const size_t n, const uint32_t context, const uint32_t word) const;
+
+    /** Points the tables at the owned vectors. */
+    void attachOwned();
+
+    /** Sorts the n-grams of order n, and drops repeated ones. */
+    void finishOrder(const size_t n);
+
+    // tables, either owned or in the mapped file
+    size_t                        words;
+    const char*                   strings;
+    size_t                        strings_size;
+    const uint32_t*               offsets;
+    const uint32_t*               sorted;
+    const uint32_t*               likeliest;
+    const Unigram*                unigrams;
+    std::vector<const Record*>    records; // indexed by order
+    std::vector<const uint32_t*>  tables;  // indexed by order
+    std::vector<size_t>           counts;  // indexed by order
+
+    // storage of a compiled model
+    std::string                   own_strings;
+    std::vector<uint32_t>         own_offsets;
+    std::vector<uint32_t>         own_sorted;
+    std::vector<uint32_t>         own_likeliest;
+    std::vector<Unigram>          own_unigrams;
+    std::vector< std::vector<Record> > own_records;
+    std::vector< std::vector<uint32_t> > own_tables;
+
+    // mapping of a loaded model
+    void*                         mapping;
+    size_t                        mapping_size;
+
+    static const char     FORMAT_MAGIC[8];
+    static const uint32_t FORMAT_BYTE_ORDER;
+    static const uint32_t FORMAT_VERSION;
+};
+
+#endif // PRESAGE_ARPAMODEL
@@ -23,14 +23,13 @@
 
 
 #include "ARPAPredictor.h"
+#include "../presageException.h"
 
 
 #include <sstream>
 #include <algorithm>
 #include <cmath>
-
-
-#define OOV "<UNK>"
+#include <cstring>
 
 
 
@@ -54,402 +53,230 @@ ARPAPredictor::ARPAPredictor(Configuration* config, ContextTracker* ct, const ch
     dispatcher.map (config->find (ARPAFILENAME), & ARPAPredictor::set_arpa_filename);
     dispatcher.map (config->find (TIMEOUT), & ARPAPredictor::set_timeout);
 
-    loadVocabulary();
-    createARPATable();
+    loadModel();
 }
 
 void ARPAPredictor::set_vocab_filename (const std::string& value)
 {
-    logger << INFO << "VOCABFILENAME: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "VOCABFILENAME: " << value << endl;
     vocabFilename = value;
 }
 
 void ARPAPredictor::set_arpa_filename (const std::string& value)
 {
-    logger << INFO << "ARPAFILENAME: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "ARPAFILENAME: " << value << endl;
     arpaFilename = value;
 }
 
 void ARPAPredictor::set_timeout (const std::string& value)
 {
-    logger << INFO << "TIMEOUT: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "TIMEOUT: " << value << endl;
     timeout = atoi(value.c_str());
 }
 
-void ARPAPredictor::loadVocabulary()
-{
-    std::ifstream vocabFile;
-    vocabFile.open(vocabFilename.c_str());
-    if(!vocabFile)
-	logger << ERROR << "Error opening vocabulary file: " << vocabFilename << endl;
-
-    assert(vocabFile);
-    std::string row;
-    int code = 0;
-    while(std::getline(vocabFile,row))
-    {
-	if(row[0]=='#')
-	    continue;
-
-	vocabCode[row]=code;
-	vocabDecode[code]=row;
-
-	logger << DEBUG << "["<<row<<"] -> "<< code<<endl;
-
-	code++;
-    }
-
-    logger << DEBUG << "Loaded "<<code<<" words from vocabulary" <<endl;
-
-}
-
-void ARPAPredictor::createARPATable()
+void ARPAPredictor::loadModel()
 {
-    std::ifstream arpaFile;
-    arpaFile.open(arpaFilename.c_str());
-
-    if(!arpaFile)
-	logger << ERROR << "Error opening ARPA model file: " << arpaFilename << endl;
-
-    assert(arpaFile);
-    std::string row;
-
-    int currOrder = 0;
-
-    unigramCount = 0;
-    bigramCount  = 0;
-    trigramCount = 0;
-
-    int lineNum =0;
-    bool startData = false;
-
-    while(std::getline(arpaFile,row))
-    {
-	lineNum++;
-	if(row.empty())
-	    continue;
-
-	if(row == "\\end\\")
-	    break;
-
-	if(row == "\\data\\")
-	{
-	    startData = true;
-	    continue;
+    try {
+	if (ARPAModel::isCompiled(arpaFilename)) {
+	    model.load(arpaFilename);
+	    PRESAGE_LOG(logger, DEBUG) << "Mapped compiled ARPA model: " << arpaFilename << endl;
+	} else {
+	    model.compile(arpaFilename, vocabFilename, 0, &std::cerr);
+	    std::cerr << std::endl << std::endl;
 	}
-
-
-	if( startData == true && currOrder == 0)
-	{
-	    if( row.find("ngram 1")==0 )
-	    {
-		unigramTot = atoi(row.substr(8).c_str());
-		logger << DEBUG << "tot unigram = "<<unigramTot<<endl;
-		continue;
-	    }
-
-	    if( row.find("ngram 2")==0)
-	    {
-		bigramTot = atoi(row.substr(8).c_str());
-		logger << DEBUG << "tot bigram = "<<bigramTot<<endl;
-		continue;
-	    }
-
-	    if( row.find("ngram 3")==0)
-	    {
-		trigramTot = atoi(row.substr(8).c_str());
-		logger << DEBUG << "tot trigram = "<<trigramTot<<endl;
-		continue;
-	    }
-	}
-
-	if( row == "\\1-grams:" && startData)
-	{
-	    currOrder = 1;
-	    std::cerr << std::endl << "ARPA loading unigrams:" << std::endl;
-	    unigramProg = new ProgressBar<char>(std::cerr);
-	    continue;
-	}
-
-	if( row == "\\2-grams:" && startData)
-	{
-	    currOrder = 2;
-	    std::cerr << std::endl << std::endl << "ARPA loading bigrams:" << std::endl;
-	    bigramProg = new ProgressBar<char>(std::cerr);
-	    continue;
-	}
-
-	if( row == "\\3-grams:" && startData)
-	{
-	    currOrder = 3;
-	    std::cerr << std::endl << std::endl << "ARPA loading trigrams:" << std::endl;
-	    trigramProg = new ProgressBar<char>(std::cerr);
-	    continue;
-	}
-
-	if(currOrder == 0)
-	    continue;
-
-	switch(currOrder)
-	{
-	case 1:   addUnigram(row);
-	    break;
-
-	case 2:   addBigram(row);
-	    break;
-
-	case 3:   addTrigram(row);
-	    break;
-	}
-
+    } catch (PresageException& ex) {
+	logger << ERROR << ex.what() << endl;
+	throw;
     }
 
-    std::cerr << std::endl << std::endl;
-
-    logger << DEBUG << "loaded unigrams: "<< unigramCount << endl;
-    logger << DEBUG << "loaded bigrams: " << bigramCount << endl;
-    logger << DEBUG << "loaded trigrams: "<< trigramCount << endl;
+    PRESAGE_LOG(logger, DEBUG) << "Loaded " << model.size(1) << " words from vocabulary" << endl;
+    for (size_t n = 2; n <= model.order(); n++) {
+	PRESAGE_LOG(logger, DEBUG) << "loaded " << n << "-grams: " << model.size(n) << endl;
+    }
 }
 
-void ARPAPredictor::addUnigram(std::string row)
+ARPAPredictor::~ARPAPredictor()
 {
-    std::stringstream str(row);
-    float logProb = 0;
-    float logAlfa = 0;
-    std::string wd1Str;
-
-    str >> logProb;
-    str >> wd1Str;
-    str >> logAlfa;
-
-
-    if(wd1Str != OOV )
-    {
-	int wd1 = vocabCode[wd1Str];
-
-	unigramMap[wd1]= ARPAData(logProb,logAlfa);
-
-	logger << DEBUG << "adding unigram ["<<wd1Str<< "] -> "<<logProb<<" "<<logAlfa<<endl;
-    }
-
-
-    unigramCount++;
-
-    unigramProg->update((float)unigramCount/(float)unigramTot);
 }
 
-void ARPAPredictor::addBigram(std::string row)
+void ARPAPredictor::offer(std::vector<Candidate>& best, const size_t size, const Candidate& candidate)
 {
-    std::stringstream str(row);
-    float logProb = 0;
-    float logAlfa = 0;
-    std::string wd1Str;
-    std::string wd2Str;
-
-    str >> logProb;
-    str >> wd1Str;
-    str >> wd2Str;
-    str >> logAlfa;
-
-    if(wd1Str != OOV && wd2Str != OOV)
-    {
-	int wd1 = vocabCode[wd1Str];
-	int wd2 = vocabCode[wd2Str];
-
-	bigramMap[BigramKey(wd1,wd2)]=ARPAData(logProb,logAlfa);
-
-	logger << DEBUG << "adding bigram ["<<wd1Str<< "] ["<<wd2Str<< "] -> "<<logProb<<" "<<logAlfa<<endl;
+    if (best.size() < size) {
+	best.push_back(candidate);
+	std::push_heap(best.begin(), best.end());
+    } else if (candidate < best.front()) {
+	std::pop_heap(best.begin(), best.end());
+	best.back() = candidate;
+	std::push_heap(best.begin(), best.end());
     }
-
-    bigramCount++;
-    bigramProg->update((float)bigramCount/(float)bigramTot);
 }
 
-void ARPAPredictor::addTrigram(std::string row)
+bool ARPAPredictor::matches(const char* word, const std::vector<std::string>& patterns)
 {
-    std::stringstream str(row);
-    float logProb = 0;
-
-    std::string wd1Str;
-    std::string wd2Str;
-    std::string wd3Str;
-
-    str >> logProb;
-    str >> wd1Str;
-    str >> wd2Str;
-    str >> wd3Str;
-
-    if(wd1Str != OOV && wd2Str != OOV && wd3Str != OOV)
-    {
-	int wd1 = vocabCode[wd1Str];
-	int wd2 = vocabCode[wd2Str];
-	int wd3 = vocabCode[wd3Str];
-
-	trigramMap[TrigramKey(wd1,wd2,wd3)]=logProb;
-	logger << DEBUG << "adding trigram ["<<wd1Str<< "] ["<<wd2Str<< "] ["<<wd3Str<< "] -> "<<logProb <<endl;
-
+    for (size_t i = 0; i < patterns.size(); i++) {
+	if (strncmp(word, patterns[i].c_str(), patterns[i].size()) == 0) {
+	    return true;
+	}
     }
-
-    trigramCount++;
-    trigramProg->update((float)trigramCount/(float)trigramTot);
+    return false;
 }
 
-
-ARPAPredictor::~ARPAPredictor()
+float ARPAPredictor::score(std::vector<int>& ngram, int word) const
 {
-    delete unigramProg;
-    delete bigramProg;
-    delete trigramProg;
+    ngram.back() = word;
+    return computeBackoff(&ngram[0], ngram.size());
 }
 
-bool ARPAPredictor::matchesPrefixAndFilter(std::string word, std::string prefix, const char** filter ) const
+bool ARPAPredictor::isSuccessor(std::vector<int>& ngram, int word) const
 {
-    if(filter == 0)
-	return word.find(prefix)==0;
-
-    for(int j = 0; filter[j] != 0; j++)
-    {
-	std::string pattern = prefix+std::string(filter[j]);
-	if(word.find(pattern)==0)
+    ngram.back() = word;
+    for (size_t start = 0; start + 1 < ngram.size(); start++) {
+	if (model.find(&ngram[start], ngram.size() - start) >= 0) {
 	    return true;
+	}
     }
-
     return false;
 }
 
 Prediction ARPAPredictor::predict(const size_t max_partial_prediction_size, const char** filter) const
 {
-    logger << DEBUG << "predict()" << endl;
+    PRESAGE_LOG(logger, DEBUG) << "predict()" << endl;
     Prediction prediction;
 
-    int cardinality = 3;
-    std::vector<std::string> tokens(cardinality);
-
     std::string prefix = Utility::strtolower(contextTracker->getToken(0));
-    std::string wd2Str = Utility::strtolower(contextTracker->getToken(1));
-    std::string wd1Str = Utility::strtolower(contextTracker->getToken(2));
-
-    std::multimap< float, std::string, cmp > result;
-
-    logger << DEBUG << "["<<wd1Str<<"]"<<" ["<<wd2Str<<"] "<<"["<<prefix<<"]"<<endl;
-
-    //search for the past tokens in the vocabulary
-    std::map<std::string,int>::const_iterator wd1It,wd2It;
-    wd1It = vocabCode.find(wd1Str);
-    wd2It = vocabCode.find(wd2Str);
-
-    /**
-     * note if we have not tokens to compute 3-gram probabilities we compute 2-gram or 1-gram probabilities.
-     * the following code might be repetitive but more efficient than having the main loop outside.
-     */
-
-    //we have two valid past tokens available
-    if(wd1It!=vocabCode.end() && wd2It!=vocabCode.end())
-    {
-	//iterate over all vocab words
-	for(std::map<int,std::string>::const_iterator it = vocabDecode.begin(); it!=vocabDecode.end(); ++it)  //cppcheck: Prefer prefix ++/-- operators for non-primitive types.
-	{
-	    //if wd3 matches prefix and filter -> compute its backoff probability and add to the result set
-	    if(matchesPrefixAndFilter(it->second,prefix,filter))
-	    {
-                std::pair<const float,std::string> p (computeTrigramBackoff(wd1It->second,wd2It->second,it->first),
-						      it->second);
-		result.insert(p);
-	    }
+
+    // context words known to the model, oldest first, followed by a
+    // slot for the candidate word
+    std::vector<int> ngram;
+    for (size_t i = 1; i < model.order(); i++) {
+	std::string token = Utility::strtolower(contextTracker->getToken(i));
+	int id = model.find(token);
+	PRESAGE_LOG(logger, DEBUG) << "context token " << i << ": [" << token << "] " << id << endl;
+	if (id < 0) {
+	    // no shorter context, hence no longer one either
+	    break;
+	}
+	ngram.insert(ngram.begin(), id);
+    }
+    const size_t context = ngram.size();
+    ngram.push_back(-1);
+
+    // candidates must start with one of these
+    std::vector<std::string> patterns;
+    if (filter == 0) {
+	patterns.push_back(prefix);
+    } else {
+	for (int j = 0; filter[j] != 0; j++) {
+	    patterns.push_back(prefix + filter[j]);
 	}
     }
 
-    //we have one valid past token available
-    else if(wd2It!=vocabCode.end())
-    {
-	//iterate over all vocab words
-	for(std::map<int,std::string>::const_iterator it = vocabDecode.begin(); it!=vocabDecode.end(); ++it)
-	{
-	    //if wd3 matches prefix and filter -> compute its backoff probability and add to the result set
-	    if(matchesPrefixAndFilter(it->second,prefix,filter))
-	    {
-	        std::pair<const float,std::string> p(computeBigramBackoff(wd2It->second,it->first),
-						     it->second);
-		result.insert(p);
-	    }
+    // ranges of the sorted vocabulary starting with a pattern, merged
+    // since a pattern may extend another one
+    std::vector< std::pair<size_t, size_t> > ranges;
+    for (size_t i = 0; i < patterns.size(); i++) {
+	std::pair<size_t, size_t> range;
+	model.prefixRange(patterns[i], range.first, range.second);
+	if (range.first < range.second) {
+	    ranges.push_back(range);
+	}
+    }
+    std::sort(ranges.begin(), ranges.end());
+    size_t matching = 0;
+    for (size_t i = 0; i < ranges.size(); i++) {
+	if (i > 0 && ranges[i].first < ranges[i - 1].second) {
+	    ranges[i].first = ranges[i - 1].second;
+	    ranges[i].second = std::max(ranges[i].first, ranges[i].second);
 	}
+	matching += ranges[i].second - ranges[i].first;
     }
 
-    //we have no valid past token available
-    else
-    {
-	//iterate over all vocab words
-	for(std::map<int,std::string>::const_iterator it = vocabDecode.begin(); it!=vocabDecode.end(); ++it)
-	{
-	    //if wd3 matches prefix and filter -> compute its backoff probability and add to the result set
-	    if(matchesPrefixAndFilter(it->second,prefix,filter))
-	    {
-	        std::pair<const float,std::string> p (unigramMap.find(it->first)->second.logProb,
-						      it->second);
-		result.insert(p);
+    std::vector<Candidate> best;
+    const size_t size = max_partial_prediction_size;
+    const size_t words = model.size(1);
+
+    if (size == 0 || matching == 0) {
+	// nothing to do
+    } else if (static_cast<double>(matching) * matching <= static_cast<double>(words) * size) {
+	// few words match: scoring them all is cheaper than looking
+	// for the likeliest ones among the whole vocabulary
+	for (size_t i = 0; i < ranges.size(); i++) {
+	    for (size_t position = ranges[i].first; position < ranges[i].second; position++) {
+		int word = model.sortedId(position);
+		Candidate candidate = { score(ngram, word), word };
+		offer(best, size, candidate);
 	    }
 	}
-    }
+    } else {
+	// the explicit continuations of the context, or of its
+	// suffixes, have their own scores...
+	std::vector<int> successors;
+	for (size_t start = 0; start < context; start++) {
+	    long index = model.find(&ngram[start], context - start);
+	    long begin, end;
+	    model.successors(context - start + 1, index, begin, end);
+	    for (; begin < end; begin++) {
+		int word = model.lastWord(context - start + 1, begin);
+		if (matches(model.word(word), patterns)) {
+		    successors.push_back(word);
+		}
+	    }
+	}
+	std::sort(successors.begin(), successors.end());
+	successors.erase(std::unique(successors.begin(), successors.end()), successors.end());
+	for (size_t i = 0; i < successors.size(); i++) {
+	    Candidate candidate = { score(ngram, successors[i]), successors[i] };
+	    offer(best, size, candidate);
+	}
 
+	// ...every other word backs off to its unigram probability
+	// through the same weights, hence scores in unigram
+	// probability order
+	for (size_t rank = 0; rank < words; rank++) {
+	    int word = model.likeliestId(rank);
+	    if (! matches(model.word(word), patterns) || isSuccessor(ngram, word)) {
+		continue;
+	    }
+	    Candidate candidate = { score(ngram, word), word };
+	    if (best.size() == size && best.front().score > candidate.score) {
+		break;
+	    }
+	    offer(best, size, candidate);
+	}
+    }
 
-    size_t numSuggestions = 0;
-    for(std::multimap< float, std::string, cmp >::const_iterator it = result.begin();
-	it != result.end() && numSuggestions < max_partial_prediction_size;
-	++it)
-    {
-	prediction.addSuggestion(Suggestion(it->second,exp(it->first)));
-	numSuggestions++;
+    std::sort_heap(best.begin(), best.end());
+    for (size_t i = 0; i < best.size(); i++) {
+	prediction.addSuggestion(Suggestion(model.word(best[i].id), exp(best[i].score)));
     }
 
     return prediction;
 }
+
 /**
- * Computes P(wd3 | wd1 wd2)
+ * Computes P( wn | w1 ... wn-1 ) of the n word ids in ngram, backing
+ * off to shorter contexts as long as the n-gram is not in the model
  */
-float ARPAPredictor::computeTrigramBackoff(int wd1,int wd2,int wd3) const
+float ARPAPredictor::computeBackoff(const int* ngram, const size_t n) const
 {
-    logger << DEBUG << "computing P( ["<<vocabDecode.find(wd3)->second<< "] | ["<<vocabDecode.find(wd1)->second<<"] ["<<vocabDecode.find(wd2)->second<<"] )"<<endl;
-
-    //trigram exist
-    std::map<TrigramKey,float>::const_iterator trigramIt =trigramMap.find(TrigramKey(wd1,wd2,wd3));
-    if(trigramIt!=trigramMap.end())
-    {
-	logger << DEBUG << "trigram ["<<vocabDecode.find(wd1)->second<< "] ["<<vocabDecode.find(wd2)->second<< "] ["<<vocabDecode.find(wd3)->second<< "] exists" <<endl;
-	logger << DEBUG << "returning "<<trigramIt->second <<endl;
-	return trigramIt->second;
+    if (n == 1) {
+	return model.logProb(1, ngram[0]);
     }
 
-    //bigram exist
-    std::map<BigramKey,ARPAData>::const_iterator bigramIt =bigramMap.find(BigramKey(wd1,wd2));
-    if(bigramIt!=bigramMap.end())
-    {
-	logger << DEBUG << "bigram ["<<vocabDecode.find(wd1)->second<< "] ["<<vocabDecode.find(wd2)->second<< "] exists" <<endl;
-	float prob = bigramIt->second.logAlfa + computeBigramBackoff(wd2,wd3);
-	logger << DEBUG << "returning "<<prob<<endl;
-	return prob;
+    //n-gram exists
+    long index = model.find(ngram, n);
+    if (index >= 0) {
+	return model.logProb(n, index);
     }
 
-    //else
-    logger << DEBUG << "no bigram w1,w2 exist" <<endl;
-    float prob = computeBigramBackoff(wd2,wd3);
-    logger << DEBUG << "returning "<<prob<<endl;
-    return prob;
-
-}
-
-/**
- * Computes P( wd2 | wd1 )
- */
-float ARPAPredictor::computeBigramBackoff(int wd1, int wd2) const
-{
-    //bigram exist
-    std::map<BigramKey,ARPAData>::const_iterator bigramIt =bigramMap.find(BigramKey(wd1,wd2));
-    if(bigramIt!=bigramMap.end())
-	return bigramIt->second.logProb;
+    //context exists, weight the shorter context probability
+    index = model.find(ngram, n - 1);
+    if (index >= 0) {
+	return model.backoff(n - 1, index) + computeBackoff(ngram + 1, n - 1);
+    }
 
     //else
-    return unigramMap.find(wd1)->second.logAlfa +unigramMap.find(wd2)->second.logProb;
-
+    return computeBackoff(ngram + 1, n - 1);
 }
 
 void ARPAPredictor::learn(const std::vector<std::string>& change)
@@ -462,6 +289,5 @@ void ARPAPredictor::forget(const std::string& word)
 
 void ARPAPredictor::update (const Observable* var)
 {
-    logger << DEBUG << "About to invoke dispatcher: " << var->get_name () << " - " << var->get_value() << endl;
-    dispatcher.dispatch (var);
+    dispatch (dispatcher, var);
 }
@@ -26,86 +26,16 @@
 #define PRESAGE_ARPAPREDICTOR
 
 #include "predictor.h"
+#include "ARPAModel.h"
 #include "../core/logger.h"
-#include "../core/progress.h"
 #include "../core/dispatcher.h"
 
 #include <assert.h>
 #include <fstream>
 #include <iomanip>
+#include <vector>
 
 
-class cmp {
- public:
-  bool operator() (const float& f1, const float& f2 ) const {
-    return f2 < f1;
-  }
-};
-
-class ARPAData
-{
-  public:
-    ARPAData() {};
-    ARPAData(float lp,float la) : logProb(lp), logAlfa(la) {};
-    float logProb;
-    float logAlfa;
-};
-
-class TrigramKey
-{
-  public:
-    TrigramKey(int wd1, int wd2, int wd3) : key1(wd1), key2(wd2), key3(wd3) {};
-
-    bool operator<(const TrigramKey &right) const
-    {
-      if(key1 < right.key1)
-        return true;
-
-      if(key1 == right.key1)
-        if(key2 < right.key2 )
-          return true;
-
-      if(key1 == right.key1 && key2 == right.key2)
-        if(key3 < right.key3)
-          return true;
-
-      return false;
-    }
-
-    bool operator==(const TrigramKey &right) const
-    {
-      return (key1 == right.key1 && key2 == right.key2 && key3 == right.key3 );
-    }
-    int key1;
-    int key2;
-    int key3;
-};
-
-class BigramKey
-{
-  public:
-    BigramKey(int wd1, int wd2) : key1(wd1), key2(wd2) {};
-
-    bool operator<(const BigramKey &right) const
-    {
-      if(key1 < right.key1)
-        return true;
-
-      if(key1 == right.key1)
-        if(key2 < right.key2 )
-          return true;
-
-      return false;
-    }
-
-    bool operator==(const TrigramKey &right) const
-    {
-      return (key1 == right.key1 && key2 == right.key2);
-    }
-    int key1;
-    int key2;
-};
-
 /** Smoothed n-gram statistical predictor.
  *
  */
@@ -137,35 +67,46 @@ private:
     std::string vocabFilename;
     int timeout;
 
-    std::map<std::string,int> vocabCode;
-    std::map<int,std::string> vocabDecode;
-
-    std::map<int,ARPAData> unigramMap;
-    std::map<BigramKey,ARPAData>bigramMap;
-    std::map<TrigramKey,float>trigramMap;
-
-    void loadVocabulary();
-    void createARPATable();
-    bool matchesPrefixAndFilter(std::string , std::string , const char**  ) const;
-
-    void addUnigram(std::string);
-    void addBigram(std::string);
-    void addTrigram(std::string);
-
-    inline float computeTrigramBackoff(int,int,int) const;
-    inline float computeBigramBackoff(int,int) const;
-
-    int unigramCount;
-    int bigramCount;
-    int trigramCount;
-
-    int unigramTot;
-    int bigramTot;
-    int trigramTot;
-
-    ProgressBar<char>* unigramProg;
-    ProgressBar<char>* bigramProg;
-    ProgressBar<char>* trigramProg;
+    /** Language model, either compiled from the text ARPA file
+     ** and vocabulary, or mapped from a file written by arpa2bin.
+     */
+    ARPAModel model;
+
+    /** A scored candidate word. */
+    struct Candidate {
+	float score;
+	int   id;
+
+	/** Better candidates score higher, ties go to the lower id. */
+	bool operator<(const Candidate& right) const
+	{
+	    return score > right.score
+		|| (score == right.score && id < right.id);
+	}
+    };
+
+    void loadModel();
+
+    /** Keeps the best size candidates in best, a heap whose top is
+     ** the worst of them.
+     */
+    static void offer(std::vector<Candidate>& best, const size_t size, const Candidate& candidate);
+
+    /** Returns true if word starts with one of the patterns. */
+    static bool matches(const char* word, const std::vector<std::string>& patterns);
+
+    /** Scores word given ngram, the context word ids followed by a
+     ** slot where word is stored.
+     */
+    float score(std::vector<int>& ngram, int word) const;
+
+    /** Returns true if word explicitly follows the context words in
+     ** ngram, or a suffix of them, that is its score is not a backoff
+     ** to its unigram probability.
+     */
+    bool isSuccessor(std::vector<int>& ngram, int word) const;
+
+    float computeBackoff(const int* ngram, const size_t n) const;
 
     Dispatcher<ARPAPredictor> dispatcher;
 };
@@ -53,7 +53,7 @@ AbbreviationExpansionPredictor::~AbbreviationExpansionPredictor()
 void AbbreviationExpansionPredictor::set_abbreviations (const std::string& filename)
 {
     abbreviations = filename;
-    logger << INFO << "ABBREVIATIONS: " << abbreviations << endl;
+    PRESAGE_LOG(logger, INFO) << "ABBREVIATIONS: " << abbreviations << endl;
 
     cacheAbbreviationsExpansions();
 }
@@ -105,7 +105,7 @@ void AbbreviationExpansionPredictor::cacheAbbreviationsExpansions()
         //
 
     } else {
-        logger << INFO << "Caching abbreviations/expansions from file: " << abbreviations << endl;
+        PRESAGE_LOG(logger, INFO) << "Caching abbreviations/expansions from file: " << abbreviations << endl;
     
         std::string buffer;
         std::string abbreviation;
@@ -119,7 +119,7 @@ void AbbreviationExpansionPredictor::cacheAbbreviationsExpansions()
                 abbreviation = buffer.substr(0, tab_pos);
                 expansion    = buffer.substr(tab_pos + 1, std::string::npos);
 
-                logger << INFO << "Caching abbreviation: " << abbreviation << " - expansion: " << expansion << endl;
+                PRESAGE_LOG(logger, INFO) << "Caching abbreviation: " << abbreviation << " - expansion: " << expansion << endl;
                 cache[abbreviation] = expansion;
             }
         }
@@ -130,6 +130,5 @@ void AbbreviationExpansionPredictor::cacheAbbreviationsExpansions()
 
 void AbbreviationExpansionPredictor::update (const Observable* var)
 {
-    logger << DEBUG << "About to invoke dispatcher: " << var->get_name () << " - " << var->get_value() << endl;
-    dispatcher.dispatch (var);
+    dispatch (dispatcher, var);
 }
@@ -28,9 +28,12 @@
 
 #include <list>
 #include <sstream>
+#include <algorithm>
 #include <stdlib.h>
 #include <assert.h>
 
+std::atomic<unsigned long> DatabaseConnector::query_count(0);
+
 DatabaseConnector::DatabaseConnector(const std::string database_name,
 				     const size_t cardinality,
 				     const bool read_write)
@@ -57,6 +60,16 @@ DatabaseConnector::DatabaseConnector(const std::string database_name,
 DatabaseConnector::~DatabaseConnector()
 {}
 
+unsigned long DatabaseConnector::getQueryCount()
+{
+    return query_count;
+}
+
+void DatabaseConnector::count_query()
+{
+    query_count++;
+}
+
 void DatabaseConnector::createNgramTable(const size_t n) const
 {
     if (n > 0) {
@@ -95,12 +108,12 @@ int DatabaseConnector::getUnigramCountsSum()
 
     NgramTable result = executeSql(query);
 
-    logger << DEBUG << "NgramTable:";
+    PRESAGE_LOG(logger, DEBUG) << "NgramTable:";
     for (size_t i = 0; i < result.size(); i++) {
         for (size_t j = 0; j < result[i].size(); j++) {
-            logger << DEBUG << result[i][j] << '\t';
+            PRESAGE_LOG(logger, DEBUG) << result[i][j] << '\t';
         }
-    logger << DEBUG << endl;
+    PRESAGE_LOG(logger, DEBUG) << endl;
     }
 
     unigram_counts_sum = extractFirstInteger(result);
@@ -116,17 +129,33 @@ int DatabaseConnector::getNgramCount(const Ngram ngram) const
 
     NgramTable result = executeSql(query.str());
 
-    logger << DEBUG << "NgramTable:";
+    PRESAGE_LOG(logger, DEBUG) << "NgramTable:";
     for (size_t i = 0; i < result.size(); i++) {
         for (size_t j = 0; j < result[i].size(); j++) {
-            logger << DEBUG << result[i][j] << '\t';
+            PRESAGE_LOG(logger, DEBUG) << result[i][j] << '\t';
         }
-        logger << DEBUG << endl;
+        PRESAGE_LOG(logger, DEBUG) << endl;
     }
 
     return extractFirstInteger(result);
 }
 
+std::vector<int> DatabaseConnector::getNgramCounts(const Ngram& context,
+						   const std::vector<std::string>& words) const
+{
+    std::vector<int> counts;
+    counts.reserve(words.size());
+
+    Ngram ngram(context);
+    ngram.push_back("");
+    for (size_t i = 0; i < words.size(); i++) {
+	ngram.back() = words[i];
+	counts.push_back(getNgramCount(ngram));
+    }
+
+    return counts;
+}
+
 NgramTable DatabaseConnector::getNgramLikeTable(const Ngram ngram, const char** filter, const int count_threshold, int limit) const
 {
     std::stringstream query;
@@ -143,34 +172,91 @@ NgramTable DatabaseConnector::getNgramLikeTable(const Ngram ngram, const char**
     return executeSql(query.str());
 }
 
+std::vector<std::string> DatabaseConnector::getPredictedWords(const Ngram ngram, const char** filter, const int count_threshold, int limit, int offset) const
+{
+    if (offset < 0) {
+	offset = 0;
+    }
+
+    NgramTable table = getNgramLikeTable(ngram, filter, count_threshold, (limit < 0 ? limit : limit + offset));
+
+    // each row holds the ngram followed by its count, the predicted
+    // word is the second to last column
+    std::vector<std::string> result;
+    for (NgramTable::const_iterator it = table.begin() + std::min(static_cast<size_t>(offset), table.size());
+	 it != table.end();
+	 it++) {
+	result.push_back(*(it->end() - 2));
+    }
+
+    return result;
+}
+
 int DatabaseConnector::incrementNgramCount(const Ngram ngram)
 {
     int count = getNgramCount(ngram);
 
     // invalidate cached sum
-    unigram_counts_sum = -1;
+    invalidate_unigram_counts_sum();
     
     if (count > 0) {
         // the ngram was found in the database
         updateNgram(ngram, ++count);
 
-        logger << DEBUG << "Updated ngram to " << count << endl;
+        PRESAGE_LOG(logger, DEBUG) << "Updated ngram to " << count << endl;
 
     } else {
         // the ngram was not found in the database
         count = 1;
         insertNgram(ngram, count);
 
-        logger << DEBUG << "Inserted ngram" << endl;
+        PRESAGE_LOG(logger, DEBUG) << "Inserted ngram" << endl;
 
     }
     return count;
 }
 
+void DatabaseConnector::addNgramCounts(NgramCounts::const_iterator begin,
+				       NgramCounts::const_iterator end)
+{
+    for (NgramCounts::const_iterator it = begin; it != end; it++) {
+	int count = getNgramCount(it->first);
+	if (count > 0) {
+	    updateNgram(it->first, count + it->second);
+	} else {
+	    insertNgram(it->first, it->second);
+	}
+    }
+}
+
+void DatabaseConnector::raisePrefixCounts(const NgramCounts& ngrams)
+{
+    // walk down the chain of prefixes of each ngram, raising each
+    // prefix to the count of the one it was cut from
+    for (NgramCounts::const_iterator it = ngrams.begin(); it != ngrams.end(); it++) {
+	Ngram prefix(it->first);
+	int count = getNgramCount(prefix);
+	while (prefix.size() > 1) {
+	    prefix.pop_back();
+	    int prefix_count = getNgramCount(prefix);
+	    if (prefix_count < count) {
+		PRESAGE_LOG(logger, INFO) << "consistency adjustment needed!" << endl;
+		if (prefix_count > 0) {
+		    updateNgram(prefix, count);
+		} else {
+		    insertNgram(prefix, count);
+		}
+	    } else {
+		count = prefix_count;
+	    }
+	}
+    }
+}
+
 void DatabaseConnector::removeNgram(const Ngram ngram)
 {
     // invalidate cached sum
-    unigram_counts_sum = -1;
+    invalidate_unigram_counts_sum();
 }
 
 void DatabaseConnector::insertNgram(const Ngram ngram, const int count)
@@ -178,7 +264,7 @@ void DatabaseConnector::insertNgram(const Ngram ngram, const int count)
     std::stringstream query;
 
     // invalidate cached sum
-    unigram_counts_sum = -1;
+    invalidate_unigram_counts_sum();
     
     query << "INSERT INTO _" << ngram.size() << "_gram "
           << buildValuesClause(ngram, count)
@@ -192,7 +278,7 @@ void DatabaseConnector::updateNgram(const Ngram ngram, const int count)
     std::stringstream query;
 
     // invalidate cached sum
-    unigram_counts_sum = -1;
+    invalidate_unigram_counts_sum();
     
     query << "UPDATE _" << ngram.size() << "_gram "
           << "SET count = " << count
@@ -204,7 +290,7 @@ void DatabaseConnector::updateNgram(const Ngram ngram, const int count)
 void DatabaseConnector::dropNgramsWithWord(const std::string &word)
 {
     // invalidate cached sum
-    unigram_counts_sum = -1;
+    invalidate_unigram_counts_sum();
 
     std::string sanitized = sanitizeString(word);
     for (size_t table = 1; table <= cardinality; ++table) {
@@ -248,7 +334,8 @@ std::string DatabaseConnector::buildWhereLikeClause(const Ngram ngram,
             where_clause << " word_" << ngram.size() - i - 1 << " = '"
                          << sanitizeString(ngram[i]) << "' AND";
         } else {
-            if(filter == 0)
+            // an empty filter is no filter
+            if(filter == 0 || filter[0] == 0)
                 where_clause << " word LIKE '" << sanitizeString(ngram[ngram.size() - 1]) << "%'";
             else {
                 std::string true_prefix = sanitizeString(ngram[ngram.size() - 1]);
@@ -302,12 +389,19 @@ std::string DatabaseConnector::buildValuesClause(const Ngram ngram, const int co
 
 std::string DatabaseConnector::sanitizeString(const std::string str) const
 {
-    // TODO
-    // just return the string for the time being
-    // REVISIT
-    // TO BE DONE
-    // TBD
-    return str;
+    // escape single quotes by doubling them, so that the string can
+    // be safely embedded in a quoted SQL literal
+    std::string result;
+    result.reserve(str.size());
+    for (std::string::const_iterator it = str.begin();
+	 it != str.end();
+	 it++) {
+	if (*it == '\'') {
+	    result += '\'';
+	}
+	result += *it;
+    }
+    return result;
 }
 
 int DatabaseConnector::extractFirstInteger(const NgramTable& table) const
@@ -326,12 +420,12 @@ int DatabaseConnector::extractFirstInteger(const NgramTable& table) const
         }
     }
 
-    logger << DEBUG << "table: ";
+    PRESAGE_LOG(logger, DEBUG) << "table: ";
     for (size_t i = 0; i < table.size(); i++) {
         for (size_t j = 0; j < table[i].size(); j++) {
-            logger << DEBUG << table[i][j] << '\t';
+            PRESAGE_LOG(logger, DEBUG) << table[i][j] << '\t';
         }
-        logger << DEBUG << endl;
+        PRESAGE_LOG(logger, DEBUG) << endl;
     }
 
     return (count > 0 ? count : 0);
@@ -361,7 +455,7 @@ std::string DatabaseConnector::set_database_filename (const std::string& filenam
 {
     std::string prev_filename = database_filename;
 
-    database_filename = expand_variables (filename);
+    database_filename = Utility::expand_variables (filename);
 
     // make an attempt at determining whether directory where language
     // model database is located exists and try to create it if it
@@ -379,78 +473,6 @@ std::string DatabaseConnector::set_database_filename (const std::string& filenam
     return prev_filename;
 }
 
-std::string DatabaseConnector::expand_variables (std::string filepath) const
-{
-    // scan the filepath for variables, which follow the same pattern
-    // as shell variables - strings enclosed in '${' and '}'
-    //
-    const std::string start_marker = "${";
-    const std::string   end_marker = "}";
-
-    std::list<std::string> variables;
-
-    std::string::size_type pos_start = filepath.find (start_marker);
-    while (pos_start != std::string::npos)
-    {
-	std::string::size_type pos_end = filepath.find (end_marker, pos_start);
-	if (pos_end != std::string::npos) {
-	    variables.push_back (filepath.substr(pos_start + start_marker.size(), pos_end - end_marker.size() - pos_start - 1));
-	}
-
-	pos_start = filepath.find (start_marker, pos_end);
-    }
-
-    for (std::list<std::string>::const_iterator it = variables.begin();
-	 it != variables.end();
-	 it++)
-    {
-	substitute_variable_in_string(*it, filepath);
-    }
-
-    return filepath;
-}
-
-void DatabaseConnector::substitute_variable_in_string (const std::string& variable_name, std::string& filepath) const
-{
-    std::string variable_token = "${" + variable_name + "}";
-
-    for (std::string::size_type pos = filepath.find (variable_token);
-         pos != std::string::npos;
-         pos = filepath.find (variable_token, pos))
-    {
-        const char* value = getenv(variable_name.c_str());
-        if (value)
-        {
-            filepath.replace (pos,
-                              variable_token.size(),
-                              value);
-        }
-        else
-        {
-	    // handle "special" variables
-	    if (variable_name == "HOME")
-	    {
-		value = getenv("USERPROFILE");
-		if (value)
-		{
-		    filepath.replace (pos,
-				      variable_token.size(),
-				      value);
-		}
-	    }
-	    else
-	    {
-		// FIXME: maybe throw exception instead of leaving
-		// variable name in string?
-		//
-		filepath.replace (pos,
-				  variable_token.size(),
-				  variable_name);
-	    }
-	}
-    }
-}
-
 void DatabaseConnector::set_cardinality (const size_t card)
 {
     cardinality = card;
@@ -470,3 +492,8 @@ bool DatabaseConnector::get_read_write_mode () const
 {
     return read_write_mode;
 }
+
+void DatabaseConnector::invalidate_unigram_counts_sum ()
+{
+    unigram_counts_sum = -1;
+}
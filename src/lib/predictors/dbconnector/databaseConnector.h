@@ -31,12 +31,15 @@
 
 #include "../../core/logger.h"
 
+#include <atomic>
 #include <map>
 #include <vector>
 #include <string>
+#include <utility>
 
 typedef std::vector<std::string> Ngram;
 typedef std::vector<Ngram> NgramTable;
+typedef std::vector< std::pair<Ngram, int> > NgramCounts;
 
 /** Provides the interface to database creation, updating and querying operations.
  *
@@ -65,15 +68,39 @@ public:
 
     /** Returns an integer equal to the specified ngram count.
      */
-    int getNgramCount(const Ngram ngram) const;
+    virtual int getNgramCount(const Ngram ngram) const;
+
+    /** Returns the counts of the ngrams obtained by appending each
+     ** of the words to the context ngram.
+     *
+     * The i-th element of the returned vector is the count of ngram
+     * context + words[i]. Connectors override this to fetch all the
+     * counts in a single pass over the database.
+     */
+    virtual std::vector<int> getNgramCounts(const Ngram& context,
+					    const std::vector<std::string>& words) const;
 
     /** Returns a table of ngrams matching the specified ngram-like
      ** query, satisfying the given filter and count threshold.
      */
-    NgramTable getNgramLikeTable(const Ngram ngram,
-				 const char** filter,
-				 const int count_threshold,
-				 int limit = -1) const;
+    virtual NgramTable getNgramLikeTable(const Ngram ngram,
+					 const char** filter,
+					 const int count_threshold,
+					 int limit = -1) const;
+
+    /** Returns the words completing the specified ngram-like query,
+     ** ordered by decreasing count.
+     *
+     * Same query as getNgramLikeTable(), but only the last word of
+     * each matching ngram is returned. The first offset words are
+     * skipped, so that a query can be continued where a previous
+     * one with the same arguments left off.
+     */
+    virtual std::vector<std::string> getPredictedWords(const Ngram ngram,
+						       const char** filter,
+						       const int count_threshold,
+						       int limit = -1,
+						       int offset = 0) const;
 
     /** Increments the specified ngram count and returns the updated count.
      *
@@ -84,11 +111,30 @@ public:
 
     /** Insert ngram into database and sets its count.
      */
-    void insertNgram(const Ngram ngram, const int count);
+    virtual void insertNgram(const Ngram ngram, const int count);
 
     /** Updates ngram count.
      */
-    void updateNgram(const Ngram ngram, const int count);
+    virtual void updateNgram(const Ngram ngram, const int count);
+
+    /** Adds each count to its ngram, inserting the ngrams not yet in
+     ** the database.
+     *
+     * The default implementation looks up each ngram and then
+     * updates or inserts it. Connectors override this to apply all
+     * the counts in bulk.
+     */
+    virtual void addNgramCounts(NgramCounts::const_iterator begin,
+				NgramCounts::const_iterator end);
+
+    /** Raises the count of every proper prefix of the ngrams to at
+     ** least the count of the ngrams extending it by one word.
+     *
+     * Prefixes not yet in the database are created. Longer prefixes
+     * are raised first, so that raised counts carry over to shorter
+     * prefixes. The counts in ngrams are not used.
+     */
+    virtual void raisePrefixCounts(const NgramCounts& ngrams);
 
     /** Removes the ngram from the database
      */
@@ -113,6 +159,11 @@ public:
      */
     virtual void rollbackTransaction() const;
 
+    /** Returns the number of queries run by the database connectors
+     *  of this process so far.
+     */
+    static unsigned long getQueryCount();
+
 protected:
     // Following functions to be overridden by derived classes.
     virtual void openDatabase()                                  = 0;
@@ -128,6 +179,16 @@ protected:
     void set_read_write_mode (const bool read_write);
     bool get_read_write_mode () const;
 
+    /** Drops the cached sum of unigram counts.
+     *
+     * Must be called by any method that modifies ngram counts.
+     */
+    void invalidate_unigram_counts_sum ();
+
+    /** Counts a query run against the database.
+     */
+    static void count_query ();
+
     Logger<char> logger;
 
 private:
@@ -162,15 +223,14 @@ private:
     int extractFirstInteger(const NgramTable&) const;
 
 
-    std::string expand_variables (std::string filename) const;
-    void substitute_variable_in_string (const std::string& variable_name, std::string& filepath) const;
-
     std::string database_filename;
     size_t cardinality;
     bool read_write_mode;
 
     int unigram_counts_sum;
 
+    static std::atomic<unsigned long> query_count;
+
 };
 
 #endif // DATABASECONNECTOR_H
@@ -28,6 +28,60 @@
 # include <stdlib.h> // for free()
 #endif
 
+#include <sstream>
+
+#if defined(HAVE_SQLITE3_H)
+namespace {
+
+/** Resets a cached statement when going out of scope.
+ *
+ * A statement that is left half-stepped keeps a read transaction
+ * open on the database, and one that keeps its bindings would
+ * reference strings that no longer exist.
+ */
+class StatementReset {
+public:
+    StatementReset(sqlite3_stmt* stmt) : m_stmt(stmt) { }
+    ~StatementReset() {
+	sqlite3_reset(m_stmt);
+	sqlite3_clear_bindings(m_stmt);
+    }
+
+private:
+    sqlite3_stmt* m_stmt;
+};
+
+// Returns " WHERE word_n-1 = ? AND ... AND word_1 = ?", with an
+// empty AND list for unigrams. The last word comparison is left to
+// the caller.
+std::string buildContextWhereClause(const size_t cardinality)
+{
+    std::stringstream where_clause;
+    where_clause << " WHERE";
+    for (size_t i = cardinality - 1; i > 0; i--) {
+	where_clause << " word_" << i << " = ? AND";
+    }
+    return where_clause.str();
+}
+
+// Returns "word_n-1, ..., word_1, word", each column name preceded
+// by prefix.
+std::string buildColumnList(const size_t cardinality, const std::string& prefix = "")
+{
+    std::stringstream columns;
+    for (size_t i = cardinality - 1; i > 0; i--) {
+	columns << prefix << "word_" << i << ", ";
+    }
+    columns << prefix << "word";
+    return columns.str();
+}
+
+// first SQLite release supporting INSERT ... ON CONFLICT DO UPDATE
+const int SQLITE_UPSERT_VERSION = 3024000;
+
+}
+#endif
+
 SqliteDatabaseConnector::SqliteDatabaseConnector(const std::string database_name,
 						 const size_t cardinality,
 						 const bool read_write)
@@ -123,6 +177,9 @@ void SqliteDatabaseConnector::closeDatabase()
 {
     if (db) {
 #if defined(HAVE_SQLITE3_H)
+	// cached statements must be finalized before the connection
+	// can be closed
+	finalizeStatements();
 	sqlite3_close(db);
 #elif defined(HAVE_SQLITE_H)
 	sqlite_close(db);
@@ -136,7 +193,8 @@ NgramTable SqliteDatabaseConnector::executeSql(const std::string query) const
     
     char* sqlite_error_msg = 0;
 
-    logger << DEBUG << "executing query: " << query << endl;
+    PRESAGE_LOG(logger, DEBUG) << "executing query: " << query << endl;
+    count_query();
 #if defined(HAVE_SQLITE3_H)
     int result = sqlite3_exec(
 #elif defined(HAVE_SQLITE_H)
@@ -197,3 +255,504 @@ int SqliteDatabaseConnector::callback(
 
     return SQLITE_OK;
 }
+
+#if defined(HAVE_SQLITE3_H)
+int SqliteDatabaseConnector::getNgramCount(const Ngram ngram) const
+{
+    size_t n = ngram.size();
+
+    sqlite3_stmt* stmt = countStatement(n);
+    StatementReset reset(stmt);
+
+    for (size_t i = 0; i < n; i++) {
+	bindText(stmt, i + 1, ngram[i]);
+    }
+
+    int count = 0;
+    if (step(stmt)) {
+	count = sqlite3_column_int(stmt, 0);
+    }
+
+    PRESAGE_LOG(logger, DEBUG) << "getNgramCount: " << count << endl;
+
+    return (count > 0 ? count : 0);
+}
+
+std::vector<int> SqliteDatabaseConnector::getNgramCounts(const Ngram& context,
+							 const std::vector<std::string>& words) const
+{
+    size_t n = context.size() + 1;
+
+    // word -> count of context + word, for ngrams present in the table
+    std::map<std::string, int> found;
+
+    // words are looked up in chunks, so that the number of host
+    // parameters stays well below SQLITE_MAX_VARIABLE_NUMBER and the
+    // number of distinct cached statements stays small
+    for (size_t first = 0; first < words.size(); first += MAX_BATCH_SIZE) {
+	size_t batch_size = words.size() - first;
+	if (batch_size > MAX_BATCH_SIZE) {
+	    batch_size = MAX_BATCH_SIZE;
+	}
+
+	std::stringstream query;
+	query << "SELECT word, count FROM _" << n << "_gram"
+	      << buildContextWhereClause(n) << " word IN (";
+	for (size_t i = 0; i < batch_size; i++) {
+	    query << (i ? ", ?" : "?");
+	}
+	query << ");";
+
+	sqlite3_stmt* stmt = prepareStatement(query.str());
+	StatementReset reset(stmt);
+
+	int index = 1;
+	for (size_t i = 0; i < context.size(); i++) {
+	    bindText(stmt, index++, context[i]);
+	}
+	for (size_t i = 0; i < batch_size; i++) {
+	    bindText(stmt, index++, words[first + i]);
+	}
+
+	while (step(stmt)) {
+	    const unsigned char* text = sqlite3_column_text(stmt, 0);
+	    int count = sqlite3_column_int(stmt, 1);
+	    found[text ? reinterpret_cast<const char*>(text) : ""] = (count > 0 ? count : 0);
+	}
+    }
+
+    std::vector<int> counts;
+    counts.reserve(words.size());
+    for (size_t i = 0; i < words.size(); i++) {
+	std::map<std::string, int>::const_iterator it = found.find(words[i]);
+	counts.push_back(it != found.end() ? it->second : 0);
+    }
+
+    PRESAGE_LOG(logger, DEBUG) << "getNgramCounts: " << words.size() << " words, " << found.size() << " found" << endl;
+
+    return counts;
+}
+
+NgramTable SqliteDatabaseConnector::getNgramLikeTable(const Ngram ngram,
+						      const char** filter,
+						      const int count_threshold,
+						      int limit) const
+{
+    std::stringstream columns;
+    for (size_t i = ngram.size() - 1; i > 0; i--) {
+	columns << "word_" << i << ", ";
+    }
+    columns << "word, count";
+
+    std::vector<std::string> patterns;
+    sqlite3_stmt* stmt = bindLikeStatement(columns.str(),
+					   ngram,
+					   filter,
+					   count_threshold,
+					   limit,
+					   0,
+					   patterns);
+    StatementReset reset(stmt);
+
+    NgramTable result;
+    int columns_count = sqlite3_column_count(stmt);
+    while (step(stmt)) {
+	Ngram row;
+	for (int i = 0; i < columns_count; i++) {
+	    const unsigned char* text = sqlite3_column_text(stmt, i);
+	    // empty string to represent NULL value
+	    row.push_back(text ? reinterpret_cast<const char*>(text) : "");
+	}
+	result.push_back(row);
+    }
+
+    return result;
+}
+
+std::vector<std::string> SqliteDatabaseConnector::getPredictedWords(const Ngram ngram,
+								    const char** filter,
+								    const int count_threshold,
+								    int limit,
+								    int offset) const
+{
+    std::vector<std::string> patterns;
+    sqlite3_stmt* stmt = bindLikeStatement("word",
+					   ngram,
+					   filter,
+					   count_threshold,
+					   limit,
+					   offset,
+					   patterns);
+    StatementReset reset(stmt);
+
+    std::vector<std::string> result;
+    while (step(stmt)) {
+	const unsigned char* text = sqlite3_column_text(stmt, 0);
+	result.push_back(text ? reinterpret_cast<const char*>(text) : "");
+    }
+
+    return result;
+}
+
+void SqliteDatabaseConnector::insertNgram(const Ngram ngram, const int count)
+{
+    size_t n = ngram.size();
+
+    // invalidate cached sum
+    invalidate_unigram_counts_sum();
+
+    sqlite3_stmt* stmt = insertStatement(n);
+    StatementReset reset(stmt);
+
+    for (size_t i = 0; i < n; i++) {
+	bindText(stmt, i + 1, ngram[i]);
+    }
+    bindInt(stmt, n + 1, count);
+
+    step(stmt);
+}
+
+void SqliteDatabaseConnector::updateNgram(const Ngram ngram, const int count)
+{
+    size_t n = ngram.size();
+
+    // invalidate cached sum
+    invalidate_unigram_counts_sum();
+
+    sqlite3_stmt* stmt = updateStatement(n);
+    StatementReset reset(stmt);
+
+    bindInt(stmt, 1, count);
+    for (size_t i = 0; i < n; i++) {
+	bindText(stmt, i + 2, ngram[i]);
+    }
+
+    step(stmt);
+}
+
+void SqliteDatabaseConnector::addNgramCounts(NgramCounts::const_iterator begin,
+					     NgramCounts::const_iterator end)
+{
+    if (sqlite3_libversion_number() < SQLITE_UPSERT_VERSION) {
+	DatabaseConnector::addNgramCounts(begin, end);
+	return;
+    }
+
+    // invalidate cached sum
+    invalidate_unigram_counts_sum();
+
+    for (NgramCounts::const_iterator it = begin; it != end; it++) {
+	size_t n = it->first.size();
+
+	sqlite3_stmt* stmt = upsertStatement(n);
+	StatementReset reset(stmt);
+
+	for (size_t i = 0; i < n; i++) {
+	    bindText(stmt, i + 1, it->first[i]);
+	}
+	bindInt(stmt, n + 1, it->second);
+
+	step(stmt);
+    }
+}
+
+void SqliteDatabaseConnector::raisePrefixCounts(const NgramCounts& ngrams)
+{
+    if (sqlite3_libversion_number() < SQLITE_UPSERT_VERSION) {
+	DatabaseConnector::raisePrefixCounts(ngrams);
+	return;
+    }
+
+    // proper prefixes of the ngrams, indexed by cardinality
+    std::vector< std::set<Ngram> > prefixes;
+    for (NgramCounts::const_iterator it = ngrams.begin(); it != ngrams.end(); it++) {
+	const Ngram& ngram = it->first;
+	if (prefixes.size() < ngram.size()) {
+	    prefixes.resize(ngram.size());
+	}
+	for (size_t n = 1; n < ngram.size(); n++) {
+	    prefixes[n].insert(Ngram(ngram.begin(), ngram.begin() + n));
+	}
+    }
+
+    // invalidate cached sum
+    invalidate_unigram_counts_sum();
+
+    // the prefixes of each cardinality are copied to a temporary
+    // table, then raised to the highest count of the ngrams extending
+    // them in a single statement
+    for (size_t n = prefixes.size(); n-- > 1; ) {
+	if (prefixes[n].empty()) {
+	    continue;
+	}
+
+	std::stringstream table;
+	table << "temp._" << n << "_prefix";
+
+	std::stringstream create;
+	create << "CREATE TEMP TABLE IF NOT EXISTS _" << n << "_prefix ("
+	       << buildColumnList(n) << ");";
+	executeSql(create.str());
+
+	std::stringstream insert;
+	insert << "INSERT INTO " << table.str() << " VALUES(";
+	for (size_t i = 1; i < n; i++) {
+	    insert << "?, ";
+	}
+	insert << "?);";
+	sqlite3_stmt* stmt = prepareStatement(insert.str());
+	for (std::set<Ngram>::const_iterator it = prefixes[n].begin(); it != prefixes[n].end(); it++) {
+	    StatementReset reset(stmt);
+	    for (size_t i = 0; i < n; i++) {
+		bindText(stmt, i + 1, (*it)[i]);
+	    }
+	    step(stmt);
+	}
+
+	// the prefix column word_i matches column word_i+1 of the
+	// extending ngrams, and the prefix column word matches word_1
+	std::stringstream raise;
+	raise << "INSERT INTO _" << n << "_gram SELECT "
+	      << buildColumnList(n, "p.") << ", MAX(e.count) FROM "
+	      << table.str() << " AS p, _" << n + 1 << "_gram AS e WHERE";
+	for (size_t i = n - 1; i > 0; i--) {
+	    raise << " e.word_" << i + 1 << " = p.word_" << i << " AND";
+	}
+	raise << " e.word_1 = p.word GROUP BY " << buildColumnList(n, "p.")
+	      << " ON CONFLICT(" << buildColumnList(n) << ")"
+	      << " DO UPDATE SET count = excluded.count WHERE excluded.count > count;";
+	executeSql(raise.str());
+
+	executeSql("DELETE FROM " + table.str() + ";");
+    }
+}
+
+sqlite3_stmt* SqliteDatabaseConnector::bindLikeStatement(const std::string& columns,
+							 const Ngram& ngram,
+							 const char** filter,
+							 const int count_threshold,
+							 const int limit,
+							 const int offset,
+							 std::vector<std::string>& patterns) const
+{
+    size_t n = ngram.size();
+    const std::string& prefix = ngram[n - 1];
+
+    // one LIKE pattern per filter entry, or just the prefix, an empty
+    // filter being no filter
+    bool filtered = (filter != 0 && filter[0] != 0);
+    if (! filtered) {
+	patterns.push_back(prefix + '%');
+    } else {
+	for (int j = 0; filter[j] != 0; j++) {
+	    patterns.push_back(prefix + filter[j] + '%');
+	}
+    }
+
+    std::stringstream query;
+    query << "SELECT " << columns << " FROM _" << n << "_gram"
+	  << buildContextWhereClause(n);
+    if (! filtered) {
+	query << " word LIKE ?";
+    } else {
+	query << " (";
+	for (size_t j = 0; j < patterns.size(); j++) {
+	    if (j) {
+		query << " OR ";
+	    }
+	    query << " word LIKE ?";
+	}
+	query << ')';
+    }
+    if (count_threshold > 0) {
+	query << " AND count >= ?";
+    }
+    // ties are broken by word, so that the order is stable across
+    // queries that only differ in their limit and offset
+    query << " ORDER BY count DESC, word";
+    if (limit >= 0 || offset > 0) {
+	// a negative limit means no limit
+	query << " LIMIT ?";
+    }
+    if (offset > 0) {
+	query << " OFFSET ?";
+    }
+    query << ';';
+
+    sqlite3_stmt* stmt = prepareStatement(query.str());
+
+    try {
+	int index = 1;
+	for (size_t i = 0; i < n - 1; i++) {
+	    bindText(stmt, index++, ngram[i]);
+	}
+	for (size_t j = 0; j < patterns.size(); j++) {
+	    bindText(stmt, index++, patterns[j]);
+	}
+	if (count_threshold > 0) {
+	    bindInt(stmt, index++, count_threshold);
+	}
+	if (limit >= 0 || offset > 0) {
+	    bindInt(stmt, index++, limit);
+	}
+	if (offset > 0) {
+	    bindInt(stmt, index++, offset);
+	}
+    } catch (SqliteDatabaseConnectorException&) {
+	StatementReset reset(stmt);
+	throw;
+    }
+
+    return stmt;
+}
+
+sqlite3_stmt* SqliteDatabaseConnector::prepareStatement(const std::string& query) const
+{
+    std::map<std::string, sqlite3_stmt*>::const_iterator it = keyed_statements.find(query);
+    if (it != keyed_statements.end()) {
+	return it->second;
+    }
+
+    sqlite3_stmt* stmt = 0;
+    prepareInto(stmt, query);
+
+    keyed_statements[query] = stmt;
+    return stmt;
+}
+
+sqlite3_stmt* SqliteDatabaseConnector::countStatement(const size_t n) const
+{
+    sqlite3_stmt*& stmt = statementSlot(count_statements, n);
+    if (stmt == 0) {
+	std::stringstream query;
+	query << "SELECT count FROM _" << n << "_gram"
+	      << buildContextWhereClause(n) << " word = ?;";
+	prepareInto(stmt, query.str());
+    }
+    return stmt;
+}
+
+sqlite3_stmt* SqliteDatabaseConnector::insertStatement(const size_t n) const
+{
+    sqlite3_stmt*& stmt = statementSlot(insert_statements, n);
+    if (stmt == 0) {
+	std::stringstream query;
+	query << "INSERT INTO _" << n << "_gram VALUES(";
+	for (size_t i = 0; i < n; i++) {
+	    query << "?, ";
+	}
+	query << "?);";
+	prepareInto(stmt, query.str());
+    }
+    return stmt;
+}
+
+sqlite3_stmt* SqliteDatabaseConnector::updateStatement(const size_t n) const
+{
+    sqlite3_stmt*& stmt = statementSlot(update_statements, n);
+    if (stmt == 0) {
+	std::stringstream query;
+	query << "UPDATE _" << n << "_gram SET count = ?"
+	      << buildContextWhereClause(n) << " word = ?;";
+	prepareInto(stmt, query.str());
+    }
+    return stmt;
+}
+
+sqlite3_stmt* SqliteDatabaseConnector::upsertStatement(const size_t n) const
+{
+    sqlite3_stmt*& stmt = statementSlot(upsert_statements, n);
+    if (stmt == 0) {
+	std::stringstream query;
+	query << "INSERT INTO _" << n << "_gram VALUES(";
+	for (size_t i = 0; i < n; i++) {
+	    query << "?, ";
+	}
+	query << "?) ON CONFLICT(" << buildColumnList(n) << ")"
+	      << " DO UPDATE SET count = count + excluded.count;";
+	prepareInto(stmt, query.str());
+    }
+    return stmt;
+}
+
+sqlite3_stmt*& SqliteDatabaseConnector::statementSlot(std::vector<sqlite3_stmt*>& cache,
+						      const size_t cardinality) const
+{
+    if (cache.size() <= cardinality) {
+	cache.resize(cardinality + 1, 0);
+    }
+    return cache[cardinality];
+}
+
+void SqliteDatabaseConnector::prepareInto(sqlite3_stmt*& stmt, const std::string& query) const
+{
+    PRESAGE_LOG(logger, DEBUG) << "preparing statement: " << query << endl;
+
+    checkResult(sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, NULL),
+		query);
+}
+
+void SqliteDatabaseConnector::bindText(sqlite3_stmt* stmt, const int index, const std::string& text) const
+{
+    // SQLITE_STATIC: text is guaranteed to be alive until the
+    // statement is reset
+    checkResult(sqlite3_bind_text(stmt, index, text.c_str(), text.size(), SQLITE_STATIC),
+		sqlite3_sql(stmt));
+}
+
+void SqliteDatabaseConnector::bindInt(sqlite3_stmt* stmt, const int index, const int value) const
+{
+    checkResult(sqlite3_bind_int(stmt, index, value),
+		sqlite3_sql(stmt));
+}
+
+bool SqliteDatabaseConnector::step(sqlite3_stmt* stmt) const
+{
+    if (! sqlite3_stmt_busy(stmt)) {
+	// first step since the statement was reset
+	count_query();
+    }
+
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+	return true;
+    } else if (rc == SQLITE_DONE) {
+	return false;
+    }
+
+    checkResult(rc, sqlite3_sql(stmt));
+    return false;
+}
+
+void SqliteDatabaseConnector::checkResult(const int rc, const std::string& context) const
+{
+    if (rc != SQLITE_OK) {
+	std::string error = sqlite3_errmsg(db);
+	logger << ERROR << "Error executing SQL: '"
+	       << context << "' on database: '" << get_database_filename()
+	       << "' : " << error << endl;
+	throw SqliteDatabaseConnectorException(PRESAGE_SQLITE_EXECUTE_SQL_ERROR, error);
+    }
+}
+
+void SqliteDatabaseConnector::finalizeStatements()
+{
+    std::vector<sqlite3_stmt*>* caches[] = { &count_statements,
+					     &insert_statements,
+					     &update_statements,
+					     &upsert_statements };
+    for (size_t c = 0; c < sizeof(caches) / sizeof(caches[0]); c++) {
+	for (size_t i = 0; i < caches[c]->size(); i++) {
+	    sqlite3_finalize((*caches[c])[i]);
+	}
+	caches[c]->clear();
+    }
+
+    for (std::map<std::string, sqlite3_stmt*>::iterator it = keyed_statements.begin();
+	 it != keyed_statements.end();
+	 it++) {
+	sqlite3_finalize(it->second);
+    }
+    keyed_statements.clear();
+}
+#endif
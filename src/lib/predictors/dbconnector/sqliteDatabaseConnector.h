@@ -40,6 +40,9 @@
 #include "databaseConnector.h"
 #include "../../presageException.h"
 
+#include <map>
+#include <set>
+
 class SqliteDatabaseConnector : public DatabaseConnector {
   public:
     SqliteDatabaseConnector(const std::string db,
@@ -55,6 +58,34 @@ class SqliteDatabaseConnector : public DatabaseConnector {
     virtual void closeDatabase();
     virtual NgramTable executeSql(const std::string query) const;
 
+#if defined(HAVE_SQLITE3_H)
+    // Queries on the prediction and learning paths are run through
+    // cached prepared statements with bound parameters, instead of
+    // building and parsing a new SQL string for each invocation.
+    virtual int getNgramCount(const Ngram ngram) const;
+    virtual std::vector<int> getNgramCounts(const Ngram& context,
+					    const std::vector<std::string>& words) const;
+    virtual NgramTable getNgramLikeTable(const Ngram ngram,
+					 const char** filter,
+					 const int count_threshold,
+					 int limit = -1) const;
+    virtual std::vector<std::string> getPredictedWords(const Ngram ngram,
+						       const char** filter,
+						       const int count_threshold,
+						       int limit = -1,
+						       int offset = 0) const;
+    virtual void insertNgram(const Ngram ngram, const int count);
+    virtual void updateNgram(const Ngram ngram, const int count);
+
+    // Counts are added with INSERT ... ON CONFLICT DO UPDATE and
+    // prefixes are raised with one statement per cardinality, which
+    // needs SQLite 3.24 or later; older libraries fall back to the
+    // generic implementation.
+    virtual void addNgramCounts(NgramCounts::const_iterator begin,
+				NgramCounts::const_iterator end);
+    virtual void raisePrefixCounts(const NgramCounts& ngrams);
+#endif
+
     class SqliteDatabaseConnectorException : public PresageException {
     public:
 	SqliteDatabaseConnectorException(presage_error_code_t code, const std::string& errormsg) throw() : PresageException(code, errormsg) { }
@@ -70,6 +101,66 @@ class SqliteDatabaseConnector : public DatabaseConnector {
   private:
     static int callback(void *pArg, int argc, char **argv, char **columnNames);
 
+#if defined(HAVE_SQLITE3_H)
+    /** Returns the compiled statement for query.
+     *
+     * Statements are prepared on first use and cached, keyed by the
+     * query string, until the database is closed. Used for queries
+     * whose shape depends on their arguments (filters, IN lists).
+     */
+    sqlite3_stmt* prepareStatement(const std::string& query) const;
+
+    /** Return the cached count, insert and update statements for
+     *  ngrams of cardinality n, preparing them on first use.
+     */
+    sqlite3_stmt* countStatement(const size_t n) const;
+    sqlite3_stmt* insertStatement(const size_t n) const;
+    sqlite3_stmt* updateStatement(const size_t n) const;
+    sqlite3_stmt* upsertStatement(const size_t n) const;
+
+    sqlite3_stmt*& statementSlot(std::vector<sqlite3_stmt*>& cache,
+				 const size_t cardinality) const;
+    void prepareInto(sqlite3_stmt*& stmt, const std::string& query) const;
+
+    /** Returns a statement selecting columns from the ngram-like
+     *  query, with all parameters bound.
+     *
+     * LIKE patterns are bound without copying, so patterns must
+     * outlive the execution of the statement.
+     */
+    sqlite3_stmt* bindLikeStatement(const std::string& columns,
+				    const Ngram& ngram,
+				    const char** filter,
+				    const int count_threshold,
+				    const int limit,
+				    const int offset,
+				    std::vector<std::string>& patterns) const;
+
+    void bindText(sqlite3_stmt* stmt, const int index, const std::string& text) const;
+    void bindInt(sqlite3_stmt* stmt, const int index, const int value) const;
+
+    /** Steps statement, returns true if a row is available and false
+     *  when the statement has run to completion.
+     */
+    bool step(sqlite3_stmt* stmt) const;
+
+    void checkResult(const int rc, const std::string& context) const;
+
+    void finalizeStatements();
+
+    // maximum number of words bound in a single batched count query
+    static const size_t MAX_BATCH_SIZE = 64;
+
+    // statements indexed by ngram cardinality
+    mutable std::vector<sqlite3_stmt*> count_statements;
+    mutable std::vector<sqlite3_stmt*> insert_statements;
+    mutable std::vector<sqlite3_stmt*> update_statements;
+    mutable std::vector<sqlite3_stmt*> upsert_statements;
+
+    // ngram-like and batched count statements, keyed by query string
+    mutable std::map<std::string, sqlite3_stmt*> keyed_statements;
+#endif
+
 #if defined(HAVE_SQLITE3_H)
     sqlite3* db;
 #elif defined(HAVE_SQLITE_H)
@@ -34,19 +34,56 @@
 
 #include <set>
 #include <deque>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+// number of learnt n-grams that starts a background compaction
+static const size_t DEFAULT_COMPACTION_THRESHOLD = 10000;
+
+// log lines recording a dropped word start with this prefix, n-gram
+// keys always start with their cardinality
+static const std::string DROPPED_WORD_PREFIX = "- ";
+
+// keys are "<n> <word_1> ... <word_n>", returns true if one of the
+// words is accepted by match
+template <class Match>
+static bool containsWord(const char* key, const size_t length, Match match)
+{
+  const char* end = key + length;
+  const char* w = std::find(key, end, ' ');
+  while (w != end)
+    {
+      const char* next = std::find(w + 1, end, ' ');
+      if (match(w + 1, next))
+        return true;
+      w = next;
+    }
+  return false;
+}
+
+static bool containsWord(const char* key, const size_t length, const std::string& word)
+{
+  return containsWord(key, length, [&word](const char* begin, const char* end) {
+      return size_t(end - begin) == word.length() && std::equal(begin, end, word.begin());
+    });
+}
+
+static bool containsWord(const char* key, const size_t length,
+                         const std::map<std::string, unsigned>& words)
+{
+  return containsWord(key, length, [&words](const char* begin, const char* end) {
+      return words.count(std::string(begin, end)) > 0;
+    });
+}
 
 
 TrieDatabaseConnector::TrieDatabaseConnector(const std::string database_name,
                                                            const size_t cardinality,
                                                            const bool read_write)
-  : DatabaseConnector(database_name, cardinality, read_write)
+  : DatabaseConnector(database_name, cardinality, read_write),
+    compaction_threshold(DEFAULT_COMPACTION_THRESHOLD)
 {
-  if (read_write)
-    {
-      logger << ERROR << "TrieDatabaseConnector accessed in read-write mode" << endl;
-      throw PresageException(PRESAGE_ERROR, "TrieDatabaseConnector accessed in read-write mode");
-    }
-  
   openDatabase();
 }
 
@@ -54,14 +91,9 @@ TrieDatabaseConnector::TrieDatabaseConnector(const std::string database_name,
                                                            const size_t cardinality,
                                                            const bool read_write,
                                                            const std::string logger_level)
-  : DatabaseConnector(database_name, cardinality, read_write, logger_level)
+  : DatabaseConnector(database_name, cardinality, read_write, logger_level),
+    compaction_threshold(DEFAULT_COMPACTION_THRESHOLD)
 {
-  if (read_write)
-    {
-      logger << ERROR << "TrieDatabaseConnector accessed in read-write mode" << endl;
-      throw PresageException(PRESAGE_ERROR, "TrieDatabaseConnector accessed in read-write mode");
-    }
-  
   openDatabase();
 }
 
@@ -82,12 +114,53 @@ void TrieDatabaseConnector::openDatabase()
 {
   // close database if it has been open earlier
   closeDatabase();
-  
+
+  loadTrie();
+  openLog();
+}
+
+void TrieDatabaseConnector::closeDatabase()
+{
+  // keep the work of a running compaction
+  finishCompaction(true);
+
+  if (learnt_log.is_open())
+    learnt_log.close();
+  learnt.clear();
+  unigram_sum_delta = 0;
+
+  unloadTrie();
+}
+
+void TrieDatabaseConnector::loadTrie()
+{
   std::string basename = get_database_filename();
   std::string triename = basename + "/ngrams.trie";
   std::string countsname = basename + "/ngrams.counts";
 
-  logger << DEBUG << "Loading database: " << triename << " / " << countsname << endl;
+  // a compacted trie left without its counts was interrupted while
+  // being renamed into place, after the counts were. One left with
+  // its counts was interrupted before, and is dropped as the learnt
+  // counts are still in the log
+  std::string trie_compact = triename + ".compact";
+  std::string counts_compact = countsname + ".compact";
+  remove((trie_compact + ".part").c_str());
+  if (access(trie_compact.c_str(), F_OK) == 0)
+    {
+      if (access(counts_compact.c_str(), F_OK) != 0)
+        {
+          if (rename(trie_compact.c_str(), triename.c_str()) != 0)
+            throw PresageException(PRESAGE_ERROR,
+                                   "TrieDatabaseConnector: Error renaming " + trie_compact + " to " + triename);
+        }
+      else
+        {
+          remove(trie_compact.c_str());
+          remove(counts_compact.c_str());
+        }
+    }
+
+  PRESAGE_LOG(logger, DEBUG) << "Loading database: " << triename << " / " << countsname << endl;
 
   // load marisa trie
   try {
@@ -135,7 +208,7 @@ void TrieDatabaseConnector::openDatabase()
   }
 }
 
-void TrieDatabaseConnector::closeDatabase()
+void TrieDatabaseConnector::unloadTrie()
 {
   if (count_data)
     {
@@ -150,22 +223,72 @@ void TrieDatabaseConnector::closeDatabase()
 int TrieDatabaseConnector::getNgramCount(const Ngram ngram) const
 {
   std::string search = buildSearchString(ngram);
+  count_query();
 
-  marisa::Agent agent;
-  agent.set_query(search.c_str());
+  std::lock_guard<std::mutex> lock(mutex);
+  std::map<std::string, int>::const_iterator it = learnt.find(search);
   int count = 0;
-  if (db_trie.lookup(agent))
-    count = getCount( agent.key().id() );
+  if (it != learnt.end())
+    count = it->second;
+  else if (! isDropped(search.c_str(), search.length()))
+    count = getTrieCount(search);
 
-  logger << DEBUG << "TrieDatabaseConnector:getNgramCount: " << search << " : " << count << endl;
+  PRESAGE_LOG(logger, DEBUG) << "TrieDatabaseConnector:getNgramCount: " << search << " : " << count << endl;
   
   return count; // ngram not found
 }
 
+std::vector<int> TrieDatabaseConnector::getNgramCounts(const Ngram& context,
+                                                       const std::vector<std::string>& words) const
+{
+  count_query();
+
+  // all keys share the "<n> <context> " prefix, only the last word
+  // is replaced for each lookup
+  std::stringstream ss;
+  ss << context.size() + 1 << " ";
+  for (size_t i = 0; i < context.size(); i++)
+    ss << context[i] << " ";
+  std::string search = ss.str();
+  const size_t prefix_length = search.length();
+
+  std::vector<int> counts;
+  counts.reserve(words.size());
+
+  std::lock_guard<std::mutex> lock(mutex);
+  marisa::Agent agent;
+  for (std::vector<std::string>::const_iterator w = words.begin(); w != words.end(); ++w)
+    {
+      search.resize(prefix_length);
+      search += *w;
+
+      std::map<std::string, int>::const_iterator it = learnt.find(search);
+      if (it != learnt.end())
+        {
+          counts.push_back(it->second);
+          continue;
+        }
+      if (isDropped(search.c_str(), search.length()))
+        {
+          counts.push_back(0);
+          continue;
+        }
+
+      agent.set_query(search.c_str(), search.length());
+      counts.push_back( db_trie.lookup(agent) ? getCount( agent.key().id() ) : 0 );
+    }
+
+  PRESAGE_LOG(logger, DEBUG) << "TrieDatabaseConnector:getNgramCounts: " << search.substr(0, prefix_length)
+         << "* : " << words.size() << " lookups" << endl;
+
+  return counts;
+}
+
 std::vector<std::string> TrieDatabaseConnector::getPredictedWords(const Ngram ngram,
                                                                   const char** filter,
                                                                   const int count_threshold,
-                                                                  int limit) const
+                                                                  int limit,
+                                                                  int offset) const
 {
   // helper struct used to keep intermediate result
   struct Result {
@@ -176,61 +299,108 @@ std::vector<std::string> TrieDatabaseConnector::getPredictedWords(const Ngram ng
     }
   };
 
+  // results, ordered by increasing count
   std::set<Result> results;
-  Result curr_min;
+
+  // keep the rows that are going to be skipped as well
+  if (offset < 0)
+    offset = 0;
+  const size_t kept = (limit < 0 ? results.max_size() : size_t(limit) + offset);
+  if (kept == 0)
+    return std::vector<std::string>();
+
+  count_query();
 
   // form search strings
   std::string search_base = buildSearchString(ngram);
   std::deque<std::string> searches;
-  if (filter == NULL)
+  // an empty filter is no filter
+  if (filter == NULL || filter[0] == NULL)
     searches.push_back(search_base);
   else
     for (int j = 0; filter[j] != 0; j++)
       searches.push_back(search_base + filter[j]);
 
+  // keeps r if it belongs to the top kept results
+  auto consider = [&results, kept, this](const Result& r) {
+    if (results.size() >= kept && ! (*(results.begin()) < r))
+      return;
+
+    results.insert(r);
+
+    PRESAGE_LOG(logger, DEBUG) << "insert into tmp results: " << r.txt << " -> " << r.count << endl;
+
+    if (results.size() > kept)
+      {
+        PRESAGE_LOG(logger, DEBUG) << "drop from tmp results: " << results.begin()->txt << " -> " << results.begin()->count << endl;
+
+        results.erase(results.begin());
+      }
+  };
+
+  std::lock_guard<std::mutex> lock(mutex);
   for (std::deque<std::string>::const_iterator i = searches.cbegin(); i!=searches.cend(); ++i)
     {
+      // learnt n-grams matching the search, which override those in
+      // the trie
+      std::map<std::string, int>::const_iterator learnt_begin = learnt.lower_bound(*i);
+      std::map<std::string, int>::const_iterator learnt_end = learnt_begin;
+      while (learnt_end != learnt.end() && learnt_end->first.compare(0, i->length(), *i) == 0)
+        ++learnt_end;
+
       marisa::Agent agent;
       agent.set_query((*i).c_str());
 
-      logger << DEBUG << "TrieDatabaseConnector:getNgramLikeTable: search string: " << (*i) << endl;
+      PRESAGE_LOG(logger, DEBUG) << "TrieDatabaseConnector:getNgramLikeTable: search string: " << (*i) << endl;
       
       while (db_trie.predictive_search(agent))
         {
           int c = getCount( agent.key().id() );
-          if (c > curr_min.count)
-            {
-              Result r;
-              r.count = c;
-              r.txt = std::string(agent.key().ptr(), agent.key().length());
-              results.insert(r);
-
-              logger << DEBUG << "insert into tmp results: " << r.txt << " -> " << r.count << endl;
-
-              if (results.size() > limit)
-                {
-                  logger << DEBUG << "drop from tmp results: " << curr_min.txt << " -> " << curr_min.count << endl;
-                  
-                  results.erase(curr_min);
-                  curr_min = *(results.begin());
-                }
-            }
+          // skip keys that cannot make it into a full results set
+          // before building their string
+          if (learnt_begin == learnt_end
+              && (c <= 0 || (results.size() >= kept && c < results.begin()->count)))
+            continue;
+
+          Result r;
+          r.count = c;
+          r.txt = std::string(agent.key().ptr(), agent.key().length());
+          if (learnt_begin != learnt_end && learnt.count(r.txt))
+            continue;
+          if (c <= 0 || isDropped(r.txt.c_str(), r.txt.length()))
+            continue;
+
+          consider(r);
+        }
+
+      for (std::map<std::string, int>::const_iterator it = learnt_begin; it != learnt_end; ++it)
+        {
+          if (it->second <= 0)
+            continue;
+
+          Result r;
+          r.count = it->second;
+          r.txt = it->first;
+          consider(r);
         }
     }
 
-  logger << DEBUG << "Found words:\n";
+  PRESAGE_LOG(logger, DEBUG) << "Found words:\n";
 
   std::string last_word = ngram[ ngram.size() - 1 ];
   std::vector<std::string> table;
-  for (std::set<Result>::const_reverse_iterator i = results.crbegin(); i != results.crend(); ++i)
+  std::set<Result>::const_reverse_iterator i = results.crbegin();
+  for (int skipped = 0; skipped < offset && i != results.crend(); ++skipped)
+    ++i;
+  for (; i != results.crend(); ++i)
     {
       std::string last_ngram = last_word + i->txt.substr( search_base.length() );
       table.push_back(last_ngram);
 
-      logger << DEBUG << last_ngram << " ";
+      PRESAGE_LOG(logger, DEBUG) << last_ngram << " ";
     }
 
-  logger << DEBUG << endl;
+  PRESAGE_LOG(logger, DEBUG) << endl;
   
   return table;
 }
@@ -256,8 +426,9 @@ std::string TrieDatabaseConnector::buildSearchString(const Ngram &ngram) const
 // sync with the counts data file format
 int TrieDatabaseConnector::getUnigramCountsSum()
 {
+  std::lock_guard<std::mutex> lock(mutex);
   if (count_data == nullptr) return 0;
-  return count_data[0];
+  return count_data[0] + unigram_sum_delta;
 }
 
 int TrieDatabaseConnector::getCount(const size_t id) const
@@ -269,3 +440,372 @@ int TrieDatabaseConnector::getCount(const size_t id) const
 
   return count_data[idx];
 }
+
+
+///////////////////////////////////////////////////////////////
+// Learnt n-grams. These are kept in memory on top of the trie and
+// logged, until folded into a new trie by compaction
+int TrieDatabaseConnector::getTrieCount(const std::string& key) const
+{
+  marisa::Agent agent;
+  agent.set_query(key.c_str(), key.length());
+  return db_trie.lookup(agent) ? getCount( agent.key().id() ) : 0;
+}
+
+bool TrieDatabaseConnector::isDropped(const char* key, const size_t length) const
+{
+  return ! dropped.empty() && containsWord(key, length, dropped);
+}
+
+void TrieDatabaseConnector::setLearntCount(const std::string& key, const int count)
+{
+  if (! get_read_write_mode())
+    throw PresageException(PRESAGE_ERROR,
+                           "TrieDatabaseConnector: Cannot modify database opened in read-only mode");
+
+  // swap in the trie built in the background, if it is ready
+  finishCompaction(false);
+
+  bool compact;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::map<std::string, int>::iterator it = learnt.find(key);
+    int previous = 0;
+    if (it != learnt.end())
+      previous = it->second;
+    else if (! isDropped(key.c_str(), key.length()))
+      previous = getTrieCount(key);
+    learnt[key] = count;
+    if (key.compare(0, 2, "1 ") == 0)
+      unigram_sum_delta += count - previous;
+
+    learnt_log << key << '\t' << count << '\n';
+
+    compact = (compaction_threshold > 0 && learnt.size() >= compaction_threshold);
+  }
+
+  PRESAGE_LOG(logger, DEBUG) << "TrieDatabaseConnector:setLearntCount: " << key << " : " << count << endl;
+
+  if (compact && ! compaction.joinable())
+    startCompaction();
+}
+
+void TrieDatabaseConnector::dropWord(const std::string& word)
+{
+  for (std::map<std::string, int>::iterator it = learnt.begin(); it != learnt.end(); )
+    {
+      if (containsWord(it->first.c_str(), it->first.length(), word))
+        it = learnt.erase(it);
+      else
+        ++it;
+    }
+  dropped[word] = ++drop_serial;
+}
+
+void TrieDatabaseConnector::insertNgram(const Ngram ngram, const int count)
+{
+  invalidate_unigram_counts_sum();
+  setLearntCount(buildSearchString(ngram), count);
+}
+
+void TrieDatabaseConnector::updateNgram(const Ngram ngram, const int count)
+{
+  invalidate_unigram_counts_sum();
+  setLearntCount(buildSearchString(ngram), count);
+}
+
+void TrieDatabaseConnector::removeNgram(const Ngram ngram)
+{
+  invalidate_unigram_counts_sum();
+  setLearntCount(buildSearchString(ngram), 0);
+}
+
+void TrieDatabaseConnector::dropNgramsWithWord(const std::string &word)
+{
+  if (! get_read_write_mode())
+    throw PresageException(PRESAGE_ERROR,
+                           "TrieDatabaseConnector: Cannot modify database opened in read-only mode");
+
+  invalidate_unigram_counts_sum();
+
+  // swap in the trie built in the background, if it is ready
+  finishCompaction(false);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    dropWord(word);
+    computeUnigramSumDelta();
+
+    learnt_log << DROPPED_WORD_PREFIX << word << '\n';
+  }
+
+  PRESAGE_LOG(logger, DEBUG) << "TrieDatabaseConnector:dropNgramsWithWord: " << word << endl;
+}
+
+void TrieDatabaseConnector::beginTransaction() const
+{
+  // nothing to do, changes are applied as they are made
+}
+
+void TrieDatabaseConnector::endTransaction() const
+{
+  if (learnt_log.is_open())
+    learnt_log.flush();
+}
+
+void TrieDatabaseConnector::rollbackTransaction() const
+{
+  logger << WARN << "TrieDatabaseConnector: rollback not supported, changes are kept" << endl;
+  endTransaction();
+}
+
+void TrieDatabaseConnector::openLog()
+{
+  std::string logname = get_database_filename() + "/ngrams.log";
+
+  // replay counts learnt in earlier sessions, later lines override
+  // earlier ones
+  {
+    std::ifstream in(logname.c_str());
+    std::string line;
+    while (std::getline(in, line))
+      {
+        if (line.compare(0, DROPPED_WORD_PREFIX.length(), DROPPED_WORD_PREFIX) == 0)
+          {
+            dropWord(line.substr(DROPPED_WORD_PREFIX.length()));
+            continue;
+          }
+        std::string::size_type tab = line.rfind('\t');
+        if (tab != std::string::npos)
+          learnt[line.substr(0, tab)] = atoi(line.c_str() + tab + 1);
+      }
+  }
+  computeUnigramSumDelta();
+
+  PRESAGE_LOG(logger, DEBUG) << "Loaded " << learnt.size() << " learnt ngrams and "
+                             << dropped.size() << " dropped words from " << logname << endl;
+
+  if (! get_read_write_mode())
+    return;
+
+  learnt_log.open(logname.c_str(), std::ios::out | std::ios::app);
+  if (! learnt_log)
+    throw PresageException(PRESAGE_ERROR,
+                           "TrieDatabaseConnector: Error opening learnt NGrams log " + logname);
+}
+
+void TrieDatabaseConnector::computeUnigramSumDelta()
+{
+  unigram_sum_delta = 0;
+  for (std::map<std::string, int>::const_iterator it = learnt.begin(); it != learnt.end(); ++it)
+    if (it->first.compare(0, 2, "1 ") == 0)
+      unigram_sum_delta += it->second - getTrieCount(it->first);
+
+  // unigrams of dropped words, unless learnt again
+  for (std::map<std::string, unsigned>::const_iterator it = dropped.begin(); it != dropped.end(); ++it)
+    if (! learnt.count("1 " + it->first))
+      unigram_sum_delta -= getTrieCount("1 " + it->first);
+}
+
+void TrieDatabaseConnector::setCompactionThreshold(const size_t threshold)
+{
+  compaction_threshold = threshold;
+}
+
+void TrieDatabaseConnector::compact()
+{
+  finishCompaction(true);
+
+  bool pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending = (! learnt.empty() || ! dropped.empty());
+  }
+  if (pending)
+    {
+      startCompaction();
+      finishCompaction(true);
+    }
+}
+
+void TrieDatabaseConnector::startCompaction()
+{
+  // the trie and counts are not modified until the compaction is
+  // finished, the learnt counts are copied as they change meanwhile
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    compacting = learnt;
+    compacting_dropped = dropped;
+  }
+
+  PRESAGE_LOG(logger, INFO) << "Compacting " << compacting.size() << " learnt ngrams and "
+                            << compacting_dropped.size() << " dropped words into new trie" << endl;
+
+  compaction_done = false;
+  compaction_failed = false;
+  compaction = std::thread([this]() {
+      try {
+        buildCompactedTrie(compacting, compacting_dropped);
+      }
+      catch (...) {
+        compaction_failed = true;
+      }
+      compaction_done = true;
+    });
+}
+
+void TrieDatabaseConnector::buildCompactedTrie(const std::map<std::string, int>& snapshot,
+                                               const std::map<std::string, unsigned>& dropped_words) const
+{
+  std::string basename = get_database_filename();
+
+  marisa::Keyset keyset;
+  std::vector<count_type> counts;
+  long unigram_sum = (count_data ? count_data[0] : 0);
+
+  // n-grams in the trie, with their learnt counts if any
+  marisa::Agent agent;
+  agent.set_query("", 0);
+  while (db_trie.predictive_search(agent))
+    {
+      std::string key(agent.key().ptr(), agent.key().length());
+      int c = getCount( agent.key().id() );
+      std::map<std::string, int>::const_iterator it = snapshot.find(key);
+      int learnt_count = c;
+      if (it != snapshot.end())
+        learnt_count = it->second;
+      else if (! dropped_words.empty() && containsWord(key.c_str(), key.length(), dropped_words))
+        learnt_count = 0;
+      if (key.compare(0, 2, "1 ") == 0)
+        unigram_sum += learnt_count - c;
+      c = learnt_count;
+      if (c > 0)
+        {
+          keyset.push_back(key.c_str(), key.length());
+          counts.push_back(c);
+        }
+    }
+
+  // learnt n-grams that are new
+  for (std::map<std::string, int>::const_iterator it = snapshot.begin(); it != snapshot.end(); ++it)
+    {
+      agent.set_query(it->first.c_str(), it->first.length());
+      if (it->second > 0 && ! db_trie.lookup(agent))
+        {
+          if (it->first.compare(0, 2, "1 ") == 0)
+            unigram_sum += it->second;
+          keyset.push_back(it->first.c_str(), it->first.length());
+          counts.push_back(it->second);
+        }
+    }
+
+  // the trie gets its final name once its counts are written
+  std::string triename = basename + "/ngrams.trie.compact";
+  marisa::Trie trie;
+  trie.build(keyset);
+  trie.save((triename + ".part").c_str());
+
+  // key ids are assigned to the keyset by build
+  std::vector<count_type> data(trie.num_keys() + 1, 0);
+  data[0] = static_cast<count_type>(std::max(unigram_sum, 1L));
+  for (size_t i = 0; i < keyset.size(); i++)
+    data[keyset[i].id() + 1] = counts[i];
+
+  std::string countsname = basename + "/ngrams.counts.compact";
+  std::ofstream out(countsname.c_str(), std::ios::out | std::ios::binary);
+  out.write(reinterpret_cast<const char*>(&data[0]), data.size() * sizeof(count_type));
+  out.close();
+  if (out.fail())
+    throw PresageException(PRESAGE_ERROR,
+                           "TrieDatabaseConnector: Error writing " + countsname);
+  if (rename((triename + ".part").c_str(), triename.c_str()) != 0)
+    throw PresageException(PRESAGE_ERROR,
+                           "TrieDatabaseConnector: Error renaming " + triename + ".part to " + triename);
+}
+
+void TrieDatabaseConnector::finishCompaction(const bool wait)
+{
+  if (! compaction.joinable() || (! wait && ! compaction_done))
+    return;
+
+  compaction.join();
+
+  std::string basename = get_database_filename();
+  std::string triename = basename + "/ngrams.trie";
+  std::string countsname = basename + "/ngrams.counts";
+  std::string logname = basename + "/ngrams.log";
+
+  if (compaction_failed)
+    {
+      logger << ERROR << "TrieDatabaseConnector: Compaction failed, learnt ngrams are kept in " << logname << endl;
+      remove((triename + ".compact.part").c_str());
+      remove((triename + ".compact").c_str());
+      remove((countsname + ".compact").c_str());
+      compacting.clear();
+      compacting_dropped.clear();
+      return;
+    }
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // counts are renamed first, so that a trie left behind tells that
+  // its counts are in place already
+  unloadTrie();
+  if (rename((countsname + ".compact").c_str(), countsname.c_str()) != 0)
+    {
+      logger << ERROR << "TrieDatabaseConnector: Error renaming " << countsname << ".compact, learnt ngrams are kept in " << logname << endl;
+      remove((triename + ".compact").c_str());
+      remove((countsname + ".compact").c_str());
+      compacting.clear();
+      compacting_dropped.clear();
+      loadTrie();
+      return;
+    }
+  // loading renames a trie left behind, or throws if it cannot
+  if (rename((triename + ".compact").c_str(), triename.c_str()) != 0)
+    logger << ERROR << "TrieDatabaseConnector: Error renaming " << triename << ".compact" << endl;
+  loadTrie();
+
+  // drop learnt counts folded into the new trie, keeping those that
+  // changed meanwhile
+  for (std::map<std::string, int>::const_iterator it = compacting.begin(); it != compacting.end(); ++it)
+    {
+      std::map<std::string, int>::iterator l = learnt.find(it->first);
+      if (l != learnt.end() && l->second == it->second)
+        learnt.erase(l);
+    }
+  compacting.clear();
+
+  // words left out of the new trie need no longer be dropped, unless
+  // they were dropped again meanwhile
+  for (std::map<std::string, unsigned>::const_iterator it = compacting_dropped.begin(); it != compacting_dropped.end(); ++it)
+    {
+      std::map<std::string, unsigned>::iterator d = dropped.find(it->first);
+      if (d != dropped.end() && d->second == it->second)
+        dropped.erase(d);
+    }
+  compacting_dropped.clear();
+  computeUnigramSumDelta();
+
+  // rewrite the log with the remaining dropped words and learnt
+  // counts, in this order as replaying a dropped word forgets the
+  // counts learnt before it
+  learnt_log.close();
+  {
+    std::ofstream out((logname + ".compact").c_str(), std::ios::out | std::ios::trunc);
+    for (std::map<std::string, unsigned>::const_iterator it = dropped.begin(); it != dropped.end(); ++it)
+      out << DROPPED_WORD_PREFIX << it->first << '\n';
+    for (std::map<std::string, int>::const_iterator it = learnt.begin(); it != learnt.end(); ++it)
+      out << it->first << '\t' << it->second << '\n';
+  }
+  if (rename((logname + ".compact").c_str(), logname.c_str()) != 0)
+    {
+      logger << ERROR << "TrieDatabaseConnector: Error renaming " << logname << ".compact, keeping " << logname << endl;
+      remove((logname + ".compact").c_str());
+    }
+  learnt_log.open(logname.c_str(), std::ios::out | std::ios::app);
+
+  PRESAGE_LOG(logger, INFO) << "Compaction finished, " << learnt.size() << " learnt ngrams left" << endl;
+}
@@ -37,13 +37,30 @@
 
 #include <marisa.h>
 
+#include <map>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <atomic>
 
-// Read only database based on Marisa Trie (for keeping n-gram words)
-// and counts file (integers stored as a binary array)
+
+// Database based on Marisa Trie (for keeping n-gram words) and counts
+// file (integers stored as a binary array)
 //
 // Interface is based on DatabaseConnector with some important differences in
 // data retrieval to optimize the performance. 
 //
+// The trie and counts files are never modified in place. When opened
+// in read-write mode, learnt n-gram counts are kept in memory on top
+// of them and appended to a log file (ngrams.log) in the database
+// directory, which is replayed when the database is opened. Queries
+// merge both. Once enough n-grams have been learnt, a background
+// thread folds them into a new trie that replaces the old one.
+//
+// Forgetting a word does not touch the n-grams that contain it. The
+// word is recorded as dropped, and n-grams containing it are skipped
+// by queries until compaction leaves them out of the new trie.
+//
 // Note that this class should not be used via pointer to DatabaseConnector
 
 class TrieDatabaseConnector: public DatabaseConnector {
@@ -61,17 +78,60 @@ public:
    */
   int getUnigramCountsSum();
 
+  /** Insert ngram into database and sets its count.
+   */
+  virtual void insertNgram(const Ngram ngram, const int count);
+
+  /** Updates ngram count.
+   */
+  virtual void updateNgram(const Ngram ngram, const int count);
+
+  /** Removes the ngram from the database
+   */
+  void removeNgram(const Ngram ngram);
+
+  /** Removes ngrams containing the word from the database
+   *
+   * The word is logged once, the n-grams are left out of the trie by
+   * the next compaction.
+   */
+  void dropNgramsWithWord(const std::string &word);
+
+  /** Transactions are not supported, learnt counts are written to
+   ** the log when a transaction ends.
+   */
+  virtual void beginTransaction() const;
+  virtual void endTransaction() const;
+  virtual void rollbackTransaction() const;
+
+  /** Folds learnt n-grams into a new trie, waiting for it to be
+   ** built.
+   */
+  void compact();
+
+  /** Sets the number of learnt n-grams that starts a background
+   ** compaction, zero disables it.
+   */
+  void setCompactionThreshold(const size_t threshold);
+
   /** Returns an integer equal to the specified ngram count.
    */
-  int getNgramCount(const Ngram ngram) const;
+  virtual int getNgramCount(const Ngram ngram) const;
+
+  /** Returns counts of context + words[i] ngrams, sharing the
+   ** search prefix and trie agent between lookups.
+   */
+  virtual std::vector<int> getNgramCounts(const Ngram& context,
+                                          const std::vector<std::string>& words) const;
 
   /** Returns predicted words matching the specified ngram-like
    ** query, satisfying the given filter and count threshold.
    */
-  std::vector<std::string> getPredictedWords(const Ngram ngram,
-                                             const char** filter,
-                                             const int count_threshold,
-                                             int limit = -1) const;
+  virtual std::vector<std::string> getPredictedWords(const Ngram ngram,
+                                                     const char** filter,
+                                                     const int count_threshold,
+                                                     int limit = -1,
+                                                     int offset = 0) const;
 
 protected:
   virtual void openDatabase();
@@ -84,11 +144,58 @@ protected:
   virtual NgramTable executeSql(const std::string query) const;
 
 private:
+  /** Returns the count of the key in the trie, ignoring learnt counts. */
+  int getTrieCount(const std::string& key) const;
+
+  /** Records the learnt count of the key. */
+  void setLearntCount(const std::string& key, const int count);
+
+  /** Forgets the learnt counts of n-grams containing the word and
+   ** hides those in the trie.
+   */
+  void dropWord(const std::string& word);
+
+  /** Returns true if the key contains a dropped word. */
+  bool isDropped(const char* key, const size_t length) const;
+
+  void loadTrie();
+  void unloadTrie();
+
+  void openLog();
+  void computeUnigramSumDelta();
+
+  void startCompaction();
+  void finishCompaction(const bool wait);
+  void buildCompactedTrie(const std::map<std::string, int>& learnt,
+                          const std::map<std::string, unsigned>& dropped) const;
+
   marisa::Trie db_trie;
 
   typedef int32_t count_type;
   count_type *count_data{nullptr};
   size_t count_size{0};
+
+  // counts learnt since the trie was built, zero for forgotten
+  // n-grams, and their effect on the sum of the unigram counts
+  std::map<std::string, int> learnt;
+  int unigram_sum_delta{0};
+  mutable std::ofstream learnt_log;
+
+  // words forgotten since the trie was built, and the order in which
+  // they were dropped
+  std::map<std::string, unsigned> dropped;
+  unsigned drop_serial{0};
+
+  // guards the trie and learnt counts against queries running while
+  // a compacted trie is swapped in
+  mutable std::mutex mutex;
+
+  size_t compaction_threshold;
+  std::map<std::string, int> compacting;
+  std::map<std::string, unsigned> compacting_dropped;
+  std::thread compaction;
+  std::atomic<bool> compaction_done{false};
+  std::atomic<bool> compaction_failed{false};
 };
 
 
@@ -24,7 +24,7 @@
 
 #include "dejavuPredictor.h"
 
-#include <algorithm>
+#include <sstream>
 
 /*
  * Implementation idea: predictor remembers previously entered text (by
@@ -41,6 +41,8 @@ DejavuPredictor::DejavuPredictor(Configuration* config, ContextTracker* ct, cons
                 "DejavuPredictor, a parrot predictor",
                 "DejavuPredictor is a parrot predictor.\n"
                 "It always returns what it has heard before.\n"),
+      trigger (0),
+      loaded (false),
       dispatcher (this)
 {
     LOGGER = PREDICTORS + name + ".LOGGER";
@@ -54,166 +56,150 @@ DejavuPredictor::DejavuPredictor(Configuration* config, ContextTracker* ct, cons
 }
 
 DejavuPredictor::~DejavuPredictor()
-{}
+{
+    writer.close();
+}
 
 void DejavuPredictor::set_memory (const std::string& filename)
 {
     memory = filename;
-    logger << INFO << "MEMORY: " << filename << endl;
+    PRESAGE_LOG(logger, INFO) << "MEMORY: " << filename << endl;
+
+    // memory is read again from the new file on next use
+    writer.close();
+    loaded = false;
+    tokens.clear();
+    words.clear();
+    ids.clear();
+    followers.clear();
 }
 
 void DejavuPredictor::set_trigger (const std::string& number)
 {
     trigger = Utility::toInt (number);
-    logger << INFO << "TRIGGER: " << number << endl;
+    PRESAGE_LOG(logger, INFO) << "TRIGGER: " << number << endl;
+
+    // memory is indexed by trigger sequences, index it again
+    followers.clear();
+    for (size_t position = 0; loaded && position < tokens.size(); position++) {
+        index_token(position);
+    }
 }
 
-Prediction DejavuPredictor::predict(const size_t max_partial_predictions_size, const char** filter) const
+void DejavuPredictor::load_memory() const
 {
-    Prediction result;
+    if (loaded) {
+        return;
+    }
+    loaded = true;
 
-    std::list<std::string> memory_trigger;
-    
     std::ifstream memory_file(memory.c_str());
     if (!memory_file) {
         logger << ERROR << "Error opening memory file: " << memory << endl;
-    } else {
-        if (init_memory_trigger(memory_trigger)) {
-            logger << INFO << "Memory trigger init'ed" << endl;
-
-            std::list<std::string> rolling_window;
-            if (init_rolling_window(rolling_window, memory_file)) {
-                logger << INFO << "Rolling window init'ed" << endl;
-
-                std::string token;
-                while (memory_file >> token) {
-                    logger << INFO << "Analyzing token: " << token << endl;
-
-                    if (match(memory_trigger, rolling_window)) {
-                        logger << INFO << "Token triggered memory: " << token << endl;
-                        if (token_satisfies_filter (token, contextTracker->getPrefix(), filter)) {
-                            logger << INFO << "Adding suggestion: " << token << endl;
-                            result.addSuggestion(Suggestion(token, 1.0));
-                        }
-                    }
-
-                    update_rolling_window(rolling_window, token);
-                }
-
-            } else {
-                logger << INFO << "Rolling window initialization failed." << endl;
-            }
-        } else {
-            logger << INFO << "Memory trigger initialization failed." << endl;
-        }
-
-        memory_file.close();
+        return;
     }
 
-    return result;
+    std::string token;
+    while (memory_file >> token) {
+        remember(token);
+    }
+    PRESAGE_LOG(logger, INFO) << "Loaded " << tokens.size() << " tokens from memory file: " << memory << endl;
 }
 
-void DejavuPredictor::learn(const std::vector<std::string>& change)
+void DejavuPredictor::remember(const std::string& token) const
 {
-    // loop through all tokens in change vector
-    for (std::vector<std::string>::const_iterator it = change.begin();
-         it != change.end();
-         ++it)
-    {
-        std::string new_token = *it;
-        logger << INFO << "Committing new token to memory: " << new_token << endl;
-        std::ofstream memory_file(memory.c_str(), std::ios::app);
-        if (!memory_file) {
-            logger << ERROR << "Error opening memory file: " << memory << endl;
-        } else {
-            memory_file << new_token << std::endl;
-            memory_file.close();
-        }
+    std::unordered_map<std::string, char32_t>::const_iterator it = ids.find(token);
+    if (it == ids.end()) {
+        it = ids.insert(std::make_pair(token, static_cast<char32_t>(words.size()))).first;
+        words.push_back(token);
     }
+    tokens.push_back(it->second);
+    index_token(tokens.size() - 1);
 }
 
-void DejavuPredictor::forget(const std::string& word)
+void DejavuPredictor::index_token(const size_t position) const
 {
-    // not implemented
+    if (trigger >= 0 && position >= static_cast<size_t>(trigger)) {
+        Key key(tokens.begin() + position - trigger, tokens.begin() + position);
+        followers[key].push_back(position);
+    }
 }
 
-/** Tests two list arguments match.
- *
- * @return true if lists contain the same tokens in the same order,
- * false otherwise
- */
-bool DejavuPredictor::match(const std::list<std::string>& l1, const std::list<std::string>& l2) const
+Prediction DejavuPredictor::predict(const size_t max_partial_predictions_size, const char** filter) const
 {
-    return equal(l1.begin(), l1.end(), l2.begin());
-}
+    Prediction result;
 
-/** Initialize memory trigger.
- *
- * @param memory_trigger contains tokens that will trigger a memory
- * recollection
- * 
- * @return true if memory trigger has been populated with enough
- * tokens to trigger a memory recollection, false otherwise
- *
- */
-bool DejavuPredictor::init_memory_trigger(std::list<std::string>& memory_trigger) const
-{
-    bool result = false;
+    load_memory();
 
-    // fill up the token window list that contains the tokens that
-    // will trigger a recollection
+    // the tokens that will trigger a recollection, the current
+    // context must be rich enough to fill them
+    Key key;
     for (int i = trigger; i > 0; i--) {
-        logger << INFO << "Memory trigger list: " << contextTracker->getToken(i) << endl;
-        memory_trigger.push_back(contextTracker->getToken(i));
+        std::string token = contextTracker->getToken(i);
+        std::unordered_map<std::string, char32_t>::const_iterator it = ids.find(token);
+        if (token.empty() || it == ids.end()) {
+            PRESAGE_LOG(logger, INFO) << "Memory not triggered by token: " << token << endl;
+            return result;
+        }
+        key.push_back(it->second);
     }
 
-    // check that the current context is rich enough to trigger a
-    // recollection
-    if (memory_trigger.end() == find(memory_trigger.begin(), memory_trigger.end(), "")) {
-        result = true;
+    std::unordered_map<Key, std::vector<size_t> >::const_iterator recollection = followers.find(key);
+    if (recollection != followers.end()) {
+        const std::vector<size_t>& positions = recollection->second;
+        for (size_t i = 0; i < positions.size(); i++) {
+            const std::string& token = words[tokens[positions[i]]];
+            if (token_satisfies_filter (token, contextTracker->getPrefix(), filter)) {
+                PRESAGE_LOG(logger, INFO) << "Adding suggestion: " << token << endl;
+                result.addSuggestion(Suggestion(token, 1.0));
+            }
+        }
     }
 
-    logger << INFO << "Memory trigger valid: " << result << endl;
-
     return result;
 }
 
-/** Initialize rolling window.
- *
- * @return true if initialized rolling window has been populated with
- * enough tokens to trigger a memory recollection, false otherwise
- *
- */
-bool DejavuPredictor::init_rolling_window(std::list<std::string>& rolling_window, std::ifstream& memory_file) const
+void DejavuPredictor::learn(const std::vector<std::string>& change)
 {
-    std::string token;
-    int count = 0;
-    // following while test relies on the fact that if first condition
-    // is true, then the second condition will not be evaluated: in
-    // other words, a token will not be read from file if count is not
-    // less than trigger.
-    while (count < trigger && memory_file >> token) {
-        logger << INFO << "Rolling window list: " << token << endl;
-        rolling_window.push_back(token);
-        count++;
+    load_memory();
+
+    if (!writer.is_open()) {
+        writer.open(memory.c_str(), std::ios::app);
+        if (!writer) {
+            logger << ERROR << "Error opening memory file: " << memory << endl;
+        }
     }
 
-    return (count == trigger);
+    // loop through all tokens in change vector
+    for (std::vector<std::string>::const_iterator it = change.begin();
+         it != change.end();
+         ++it)
+    {
+        PRESAGE_LOG(logger, INFO) << "Committing new token to memory: " << *it << endl;
+        if (writer.is_open()) {
+            writer << *it << '\n';
+        }
+
+        // split the token the way the memory file is read back
+        std::istringstream pieces(*it);
+        std::string piece;
+        while (pieces >> piece) {
+            remember(piece);
+        }
+    }
+
+    // write the whole change at once
+    if (writer.is_open()) {
+        writer.flush();
+    }
 }
 
-/** Update rolling window.
- *
- * Pop front token and push back new token to list.
- */
-void DejavuPredictor::update_rolling_window(std::list<std::string>& rolling_window, const std::string& token) const
+void DejavuPredictor::forget(const std::string& word)
 {
-    rolling_window.pop_front();
-    logger << INFO << "Pushing back on memory list: " << token << endl;
-    rolling_window.push_back(token);
+    // not implemented
 }
 
 void DejavuPredictor::update (const Observable* var)
 {
-    logger << DEBUG << "About to invoke dispatcher: " << var->get_name () << " - " << var->get_value() << endl;
-    dispatcher.dispatch (var);
+    dispatch (dispatcher, var);
 }
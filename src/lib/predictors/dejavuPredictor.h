@@ -27,9 +27,10 @@
 #include "predictor.h"
 #include "../core/dispatcher.h"
 
-#include <list>
 #include <string>
+#include <vector>
 #include <fstream>
+#include <unordered_map>
 
 
 /** Dejavu predictor learns and reproduces previously seen text tokens, once its memory is triggered by a known token sequence.
@@ -40,6 +41,12 @@
  * presage system and exposes what functionality is required for
  * learning predictors to work within the presage framework.
  *
+ * The memory file is read once, into an array of token ids and a hash
+ * index from each sequence of TRIGGER tokens to the positions of the
+ * tokens that followed it, so that a prediction takes a single
+ * lookup. Learnt tokens are added to the index and appended to the
+ * memory file through a stream kept open.
+ *
  */
 class DejavuPredictor : public Predictor, public Observer {
 public:
@@ -55,13 +62,16 @@ public:
     virtual void update (const Observable* variable);
 
 private:
-    typedef void (DejavuPredictor::* mbr_func_ptr_t) (const std::string& value);
-    std::map<std::string, mbr_func_ptr_t> dispatch_map;
+    typedef std::u32string Key;
+
+    /** Reads the memory file into the index, unless already done. */
+    void load_memory() const;
+
+    /** Appends token to the memory held in the index. */
+    void remember(const std::string& token) const;
 
-    bool init_memory_trigger(std::list<std::string>&) const;
-    bool match(const std::list<std::string>&, const std::list<std::string>&) const;
-    bool init_rolling_window(std::list<std::string>&, std::ifstream&) const;
-    void update_rolling_window(std::list<std::string>&, const std::string&) const;
+    /** Indexes the token at position under the tokens preceding it. */
+    void index_token(const size_t position) const;
 
     void set_memory  (const std::string& filename);
     void set_trigger (const std::string& number);
@@ -73,6 +83,16 @@ private:
     std::string memory;
     int trigger;
 
+    // memory index, loaded on first use
+    mutable bool loaded;
+    mutable std::vector<char32_t> tokens;
+    mutable std::vector<std::string> words;
+    mutable std::unordered_map<std::string, char32_t> ids;
+    mutable std::unordered_map<Key, std::vector<size_t> > followers;
+
+    // appends learnt tokens to the memory file
+    std::ofstream writer;
+
     Dispatcher<DejavuPredictor> dispatcher;
 };
 
@@ -24,7 +24,11 @@
 
 #include "dictionaryPredictor.h"
 
-#include <assert.h>
+#include <sstream>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <cstdlib>
 
 
 DictionaryPredictor::DictionaryPredictor (Configuration* config, ContextTracker* ht, const char* name)
@@ -34,6 +38,7 @@ DictionaryPredictor::DictionaryPredictor (Configuration* config, ContextTracker*
 	     "DictionaryPredictor, dictionary lookup",
 	     "DictionaryPredictor, a dictionary based predictor that generates a prediction by extracting tokens that start with the current prefix from a given dictionary"
 	     ),
+      loaded (false),
       dispatcher (this)
 {
     LOGGER      = PREDICTORS + name + ".LOGGER";
@@ -54,47 +59,182 @@ DictionaryPredictor::~DictionaryPredictor()
 void DictionaryPredictor::set_dictionary (const std::string& value)
 {
     dictionary_path = value;
-    logger << INFO << "DICTIONARY: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "DICTIONARY: " << value << endl;
+
+    // read the new dictionary on next use
+    loaded = false;
 }
 
 
 void DictionaryPredictor::set_probability (const std::string& value)
 {
     probability = Utility::toDouble (value);
-    logger << INFO << "PROBABILITY: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "PROBABILITY: " << value << endl;
+}
+
+void DictionaryPredictor::load_dictionary() const
+{
+    if (loaded) {
+	return;
+    }
+    loaded = true;
+
+    words.clear();
+    offsets.clear();
+    sorted.clear();
+    frequencies.clear();
+
+    std::ifstream dictionary_file(dictionary_path.c_str());
+    if (!dictionary_file) {
+	logger << ERROR << "Error opening dictionary: " << dictionary_path << endl;
+	return;
+    }
+
+    // words in dictionary order, repeated words are skipped
+    std::vector<std::string> entries;
+    std::vector<double> entry_frequencies;
+    std::unordered_map<std::string, size_t> seen;
+    bool has_frequencies = false;
+
+    std::string line;
+    std::vector<std::string> fields;
+    while (std::getline(dictionary_file, line)) {
+	fields.clear();
+	std::istringstream stream(line);
+	std::string field;
+	while (stream >> field) {
+	    fields.push_back(field);
+	}
+
+	double frequency = 0;
+	if (fields.size() == 2) {
+	    char* end = 0;
+	    frequency = strtod(fields[1].c_str(), &end);
+	    if (*end == '\0') {
+		// word and frequency
+		has_frequencies = true;
+		fields.pop_back();
+	    } else {
+		frequency = 0;
+	    }
+	}
+
+	for (size_t i = 0; i < fields.size(); i++) {
+	    if (seen.insert(std::make_pair(fields[i], entries.size())).second) {
+		entries.push_back(fields[i]);
+		entry_frequencies.push_back(frequency);
+	    }
+	}
+    }
+
+    std::vector<uint32_t> order(entries.size());
+    for (size_t i = 0; i < order.size(); i++) {
+	order[i] = i;
+    }
+    if (has_frequencies) {
+	std::stable_sort(order.begin(), order.end(),
+			 [&entry_frequencies](uint32_t a, uint32_t b) {
+			     return entry_frequencies[a] > entry_frequencies[b];
+			 });
+    }
+
+    offsets.reserve(order.size());
+    for (size_t rank = 0; rank < order.size(); rank++) {
+	offsets.push_back(words.size());
+	words += entries[order[rank]];
+	words += '\0';
+	if (has_frequencies) {
+	    frequencies.push_back(entry_frequencies[order[rank]]);
+	}
+    }
+
+    sorted.resize(order.size());
+    for (size_t rank = 0; rank < sorted.size(); rank++) {
+	sorted[rank] = rank;
+    }
+    const char* arena = words.c_str();
+    const uint32_t* word_offsets = offsets.data();
+    std::sort(sorted.begin(), sorted.end(),
+	      [arena, word_offsets](uint32_t a, uint32_t b) {
+		  return strcmp(arena + word_offsets[a], arena + word_offsets[b]) < 0;
+	      });
+
+    PRESAGE_LOG(logger, INFO) << "Loaded " << offsets.size() << " words from dictionary: " << dictionary_path << endl;
 }
 
 Prediction DictionaryPredictor::predict(const size_t max_partial_predictions_size, const char** filter) const
 {
     Prediction result;
 
-    std::string candidate;
+    load_dictionary();
+
     std::string prefix = contextTracker->getPrefix();
 
-    std::ifstream dictionary_file;
-    dictionary_file.open(dictionary_path.c_str());
-    if(!dictionary_file)
-        logger << ERROR << "Error opening dictionary: " << dictionary_path << endl;
-    assert(dictionary_file); // REVISIT: handle with exceptions
-
-    // scan file entries until we get enough suggestions
-    unsigned int count = 0;
-    while(dictionary_file >> candidate && count < max_partial_predictions_size) {
-	if(candidate.find(prefix) == 0) {  // candidate starts with prefix
-	    logger << NOTICE << "Found valid token: " << candidate << endl;
-	    if (token_satisfies_filter (candidate, prefix, filter)) {
-		logger << NOTICE << "Filter check satisfied by token: " << candidate << endl;
-		result.addSuggestion(Suggestion(candidate,probability));
-		count++;
-	    } else {
-		logger << NOTICE << "Filter check failed, discarding token: " << candidate << endl;
+    // candidates must start with one of these
+    std::vector<std::string> patterns;
+    if (filter == 0) {
+	patterns.push_back(prefix);
+    } else {
+	for (int i = 0; filter[i] != 0; i++) {
+	    patterns.push_back(prefix + filter[i]);
+	}
+    }
+
+    // ranges of the sorted words starting with a pattern
+    const char* arena = words.c_str();
+    std::vector<uint32_t> ranks;
+    size_t matching = 0;
+    std::vector< std::pair<size_t, size_t> > ranges;
+    for (size_t i = 0; i < patterns.size(); i++) {
+	const std::string& pattern = patterns[i];
+	std::vector<uint32_t>::const_iterator first =
+	    std::lower_bound(sorted.cbegin(), sorted.cend(), pattern,
+			     [this, arena](uint32_t rank, const std::string& p) {
+				 return strcmp(arena + offsets[rank], p.c_str()) < 0;
+			     });
+	std::vector<uint32_t>::const_iterator last =
+	    std::upper_bound(first, sorted.cend(), pattern,
+			     [this, arena](const std::string& p, uint32_t rank) {
+				 return strncmp(p.c_str(), arena + offsets[rank], p.size()) < 0;
+			     });
+	ranges.push_back(std::make_pair(first - sorted.cbegin(), last - sorted.cbegin()));
+	matching += last - first;
+    }
+
+    const size_t size = max_partial_predictions_size;
+    if (static_cast<double>(matching) * matching <= static_cast<double>(offsets.size()) * size) {
+	// few words match: pick the best ranked among them
+	for (size_t i = 0; i < ranges.size(); i++) {
+	    for (size_t position = ranges[i].first; position < ranges[i].second; position++) {
+		ranks.push_back(sorted[position]);
+	    }
+	}
+	// patterns may overlap
+	std::sort(ranks.begin(), ranks.end());
+	ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+	if (ranks.size() > size) {
+	    ranks.resize(size);
+	}
+    } else {
+	// many words match: the first matching words in rank order
+	// come soon
+	for (size_t rank = 0; rank < offsets.size() && ranks.size() < size; rank++) {
+	    if (token_satisfies_filter (arena + offsets[rank], prefix, filter)
+		&& strncmp(arena + offsets[rank], prefix.c_str(), prefix.size()) == 0) {
+		ranks.push_back(rank);
 	    }
-	} else {
-	    logger << INFO << "Discarding invalid token: " << candidate << endl;
 	}
     }
 
-    dictionary_file.close();
+    for (size_t i = 0; i < ranks.size(); i++) {
+	std::string candidate = arena + offsets[ranks[i]];
+	logger << NOTICE << "Found valid token: " << candidate << endl;
+	if (frequencies.empty() || frequencies[0] <= 0) {
+	    result.addSuggestion(Suggestion(candidate, probability));
+	} else {
+	    result.addSuggestion(Suggestion(candidate, probability * frequencies[ranks[i]] / frequencies[0]));
+	}
+    }
 
     return result;
 }
@@ -109,6 +249,5 @@ void DictionaryPredictor::forget(const std::string& word)
 
 void DictionaryPredictor::update (const Observable* var)
 {
-    logger << DEBUG << "About to invoke dispatcher: " << var->get_name () << " - " << var->get_value() << endl;
-    dispatcher.dispatch (var);
+    dispatch (dispatcher, var);
 }
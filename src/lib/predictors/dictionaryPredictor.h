@@ -29,6 +29,9 @@
 #include "../core/dispatcher.h"
 
 #include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
 
 
 /** Dictionary predictive predictor.
@@ -36,6 +39,18 @@
  * Generates a prediction by extracting tokens that start with the
  * current prefix from a given dictionary.
  *
+ * The dictionary lists words separated by blanks. A line made of a
+ * word followed by a number gives the frequency of the word, in which
+ * case words are suggested from the most to the least frequent, with
+ * PROBABILITY scaled by their frequency relative to the most frequent
+ * word. Otherwise words are suggested in dictionary order, with
+ * PROBABILITY.
+ *
+ * The dictionary is read once, and again when DICTIONARY changes,
+ * into a string arena of the words in suggestion order and an index of
+ * the words sorted alphabetically, where the words starting with a
+ * prefix make up a range.
+ *
  */
 class DictionaryPredictor : public Predictor, public Observer {
 public:
@@ -61,6 +76,17 @@ private:
     std::string dictionary_path;
     double probability;
 
+    /** Reads the dictionary, unless already done. */
+    void load_dictionary() const;
+
+    // dictionary, loaded on first use; words are identified by their
+    // rank in suggestion order
+    mutable bool loaded;
+    mutable std::string words;               // NUL terminated words, by rank
+    mutable std::vector<uint32_t> offsets;   // offset of each word in words
+    mutable std::vector<uint32_t> sorted;    // ranks sorted by word
+    mutable std::vector<double> frequencies; // by rank, empty when not given
+
     Dispatcher<DictionaryPredictor> dispatcher;
 };
 
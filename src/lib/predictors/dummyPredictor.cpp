@@ -24,6 +24,9 @@
 
 #include "dummyPredictor.h"
 
+#include <chrono>
+#include <thread>
+
 
 DummyPredictor::DummyPredictor(Configuration* config, ContextTracker* ct, const char* name)
     : Predictor(config,
@@ -32,8 +35,17 @@ DummyPredictor::DummyPredictor(Configuration* config, ContextTracker* ct, const
 		"DummyPredictor, a fake predictor",
 		"DummyPredictor is a fake predictor.\n"
 		"It does not perform any actual computation nor implement any prediction mechanism.\n"
-		"It always returns the same sample prediction.\n")
-{}
+		"It always returns the same sample prediction.\n"),
+      delay (0),
+      dispatcher (this)
+{
+    // DELAY is optional
+    try {
+	dispatcher.map (config->find (PREDICTORS + name + ".DELAY"), & DummyPredictor::set_delay);
+    } catch (Configuration::ConfigurationException& ex) {
+	// no delay
+    }
+}
 
 DummyPredictor::~DummyPredictor()
 {}
@@ -46,6 +58,10 @@ Prediction DummyPredictor::predict(const size_t max_partial_predictions_size, co
     //
     Prediction result;
 
+    if (delay > 0) {
+	std::this_thread::sleep_for (std::chrono::milliseconds (delay));
+    }
+
     result.addSuggestion (Suggestion("foo1", 0.99));
     result.addSuggestion (Suggestion("foo2", 0.98));
     result.addSuggestion (Suggestion("foo3", 0.97));
@@ -77,3 +93,13 @@ void DummyPredictor::learn(const std::vector<std::string>& change)
 void DummyPredictor::forget(const std::string& word)
 {
 }
+
+void DummyPredictor::set_delay (const std::string& value)
+{
+    delay = Utility::toInt (value);
+}
+
+void DummyPredictor::update (const Observable* var)
+{
+    dispatch (dispatcher, var);
+}
@@ -26,12 +26,16 @@
 #define PRESAGE_DUMMYPREDICTOR
 
 #include "predictor.h"
+#include "../core/dispatcher.h"
 
 
 /** Dummy predictor is provided here to show how to implement real predictors.
+ *
+ * The optional DELAY variable makes predict() take the given number
+ * of milliseconds, to test how slow predictors are handled.
  *
  */
-class DummyPredictor : public Predictor {
+class DummyPredictor : public Predictor, public Observer {
 public:
     DummyPredictor(Configuration*, ContextTracker*, const char*);
     ~DummyPredictor();
@@ -42,8 +46,14 @@ public:
 
     virtual void forget(const std::string& word);
 
+    virtual void update (const Observable* variable);
+
 private:
-	
+    void set_delay (const std::string& value);
+
+    int delay;
+
+    Dispatcher<DummyPredictor> dispatcher;
 };
 
 #endif // PRESAGE_DUMMYPREDICTOR
@@ -26,7 +26,7 @@
 
 #include "hunspellPredictor.h"
 
-#include <assert.h>
+#include <chrono>
 
 
 HunspellPredictor::HunspellPredictor (Configuration* config, ContextTracker* ht, const char* name)
@@ -36,21 +36,37 @@ HunspellPredictor::HunspellPredictor (Configuration* config, ContextTracker* ht,
 	     "HunspellPredictor, Hunspell predictor",
 	     "HunspellPredictor, Hunspell based predictor"
 	     ),
+      cache_size (1),
+      timeout (0),
+      requested (false),
+      busy (false),
+      stopping (false),
       dispatcher (this)
 {
     LOGGER          = PREDICTORS + name + ".LOGGER";
     DICTIONARYBASE  = PREDICTORS + name + ".DICTIONARYBASE";
     PROBABILITY     = PREDICTORS + name + ".PROBABILITY";
+    CACHE_SIZE      = PREDICTORS + name + ".CACHE_SIZE";
+    TIMEOUT         = PREDICTORS + name + ".TIMEOUT";
 
     // build notification dispatch map
     dispatcher.map (config->find (LOGGER), & HunspellPredictor::set_logger);
     dispatcher.map (config->find (DICTIONARYBASE), & HunspellPredictor::set_dictionary_base);
     dispatcher.map (config->find (PROBABILITY), & HunspellPredictor::set_probability);
+    dispatcher.map (config->find (CACHE_SIZE), & HunspellPredictor::set_cache_size);
+    dispatcher.map (config->find (TIMEOUT), & HunspellPredictor::set_timeout);
 }
 
 HunspellPredictor::~HunspellPredictor()
 {
-    // intentionally empty
+    {
+        std::lock_guard<std::mutex> lock(speller_mutex);
+        stopping = true;
+    }
+    speller_condition.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
 }
 
 void HunspellPredictor::set_dictionary_base (const std::string& value)
@@ -63,65 +79,202 @@ void HunspellPredictor::set_dictionary_base (const std::string& value)
       dictionary_path = value + ".dic";
     }
     
-    logger << INFO << "DICTIONARY: " << affix_path << " | "  << dictionary_path << endl;
+    PRESAGE_LOG(logger, INFO) << "DICTIONARY: " << affix_path << " | "  << dictionary_path << endl;
     load_speller();
 }
 
 void HunspellPredictor::set_probability (const std::string& value)
 {
     probability = Utility::toDouble (value);
-    logger << INFO << "PROBABILITY: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "PROBABILITY: " << value << endl;
+}
+
+void HunspellPredictor::set_cache_size (const std::string& value)
+{
+    int size = Utility::toInt (value);
+    PRESAGE_LOG(logger, INFO) << "CACHE_SIZE: " << value << endl;
+
+    std::lock_guard<std::mutex> lock(speller_mutex);
+    // late suggestions are handed over through the cache
+    cache_size = (size > 1 ? size : 1);
+    while (cache.size() > cache_size) {
+        cache_index.erase(cache.back().first);
+        cache.pop_back();
+    }
+}
+
+void HunspellPredictor::set_timeout (const std::string& value)
+{
+    timeout = Utility::toInt (value);
+    PRESAGE_LOG(logger, INFO) << "TIMEOUT: " << value << endl;
 }
 
 void HunspellPredictor::load_speller()
 {
+    // the worker must not be using the speller
+    std::unique_lock<std::mutex> lock(speller_mutex);
+    speller_condition.wait(lock, [this] { return ! busy; });
+    requested = false;
+    cache.clear();
+    cache_index.clear();
+
     hunspell.reset();
     if (affix_path.empty() ||  dictionary_path.empty())
       return;
     hunspell.reset(new Hunspell(affix_path.c_str(), dictionary_path.c_str()));
 }
 
+bool HunspellPredictor::lookup(const std::string& prefix, Spelling& spelling) const
+{
+    std::unordered_map<std::string, Cache::iterator>::const_iterator it = cache_index.find(prefix);
+    if (it == cache_index.end()) {
+        return false;
+    }
+    cache.splice(cache.begin(), cache, it->second);
+    spelling = it->second->second;
+    return true;
+}
+
+void HunspellPredictor::store(const std::string& prefix, const Spelling& spelling) const
+{
+    std::unordered_map<std::string, Cache::iterator>::iterator it = cache_index.find(prefix);
+    if (it != cache_index.end()) {
+        cache.erase(it->second);
+    }
+    cache.push_front(std::make_pair(prefix, spelling));
+    cache_index[prefix] = cache.begin();
+    while (cache.size() > cache_size) {
+        cache_index.erase(cache.back().first);
+        cache.pop_back();
+    }
+}
+
+bool HunspellPredictor::spell(const std::string& prefix, Spelling& spelling) const
+{
+    std::unique_lock<std::mutex> lock(speller_mutex);
+    if (lookup(prefix, spelling)) {
+        PRESAGE_LOG(logger, DEBUG) << prefix << " found in cache" << endl;
+        return true;
+    }
+
+    if (! worker.joinable()) {
+        worker = std::thread(&HunspellPredictor::run, this);
+    }
+    // a prefix still waiting for the speller is dropped
+    request = prefix;
+    requested = true;
+    speller_condition.notify_all();
+
+    auto answered = [this, &prefix, &spelling] { return lookup(prefix, spelling); };
+    if (timeout <= 0) {
+        speller_condition.wait(lock, answered);
+        return true;
+    }
+    return speller_condition.wait_for(lock, std::chrono::milliseconds(timeout), answered);
+}
+
+bool HunspellPredictor::extend(const std::string& prefix, Spelling& spelling) const
+{
+    std::lock_guard<std::mutex> lock(speller_mutex);
+    for (size_t length = prefix.size() - 1; length > 0; length--) {
+        std::unordered_map<std::string, Cache::iterator>::const_iterator it =
+            cache_index.find(prefix.substr(0, length));
+        if (it != cache_index.end() && it->second->second.correct) {
+            const std::vector<std::string>& suffixes = it->second->second.words;
+            spelling.correct = false;
+            spelling.words.clear();
+            for (size_t i = 0; i < suffixes.size(); i++) {
+                if (suffixes[i].compare(0, prefix.size(), prefix) == 0) {
+                    spelling.words.push_back(suffixes[i]);
+                }
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void HunspellPredictor::run() const
+{
+    std::unique_lock<std::mutex> lock(speller_mutex);
+    while (true) {
+        speller_condition.wait(lock, [this] { return requested || stopping; });
+        if (stopping) {
+            break;
+        }
+
+        std::string prefix = request;
+        requested = false;
+        busy = true;
+        lock.unlock();
+
+        Spelling spelling;
+        spelling.correct = (hunspell && hunspell->spell(prefix));
+        if (spelling.correct) {
+            spelling.words = hunspell->suffix_suggest(prefix);
+        } else if (hunspell) {
+            spelling.words = hunspell->suggest(prefix);
+        }
+
+        lock.lock();
+        busy = false;
+        store(prefix, spelling);
+        speller_condition.notify_all();
+    }
+}
+
 Prediction HunspellPredictor::predict(const size_t max_partial_predictions_size, const char** filter) const
 {
     Prediction result;
+    set_partial(false);
 
     std::string prefix = contextTracker->getPrefix();
 
     if (!hunspell || prefix.empty())
       return result;
 
+    Spelling spelling;
+    if (!spell(prefix, spelling))
+      {
+        // the answer of the speller is cached for a later prediction
+        PRESAGE_LOG(logger, DEBUG) << "speller late on " << prefix << endl;
+        set_partial(true);
+        if (!extend(prefix, spelling))
+          return result;
+      }
+
     unsigned int count = 0;
-    if (hunspell->spell(prefix))
+    if (spelling.correct)
       {
-        logger << DEBUG << prefix << " is correct" << endl;
+        PRESAGE_LOG(logger, DEBUG) << prefix << " is correct" << endl;
         
         // correct spelling, let's add available suffixes
         result.addSuggestion(Suggestion(prefix,probability)); // add the word itself
         count += 1;
                 
-        std::vector<std::string> wlst = hunspell->suffix_suggest(prefix);
+        const std::vector<std::string>& wlst = spelling.words;
         double dprob = probability / (wlst.size() + 2);
         double cprob = probability - dprob;
 
         std::vector<std::string>::const_iterator it = wlst.cbegin();
         for ( ; count < max_partial_predictions_size && it != wlst.cend(); ++count, ++it, cprob -= dprob) {
           result.addSuggestion(Suggestion(*it, cprob));
-          logger << DEBUG << "suffix suggestion: " << *it << endl;
+          PRESAGE_LOG(logger, DEBUG) << "suffix suggestion: " << *it << endl;
         }
       }
     else
       {
-        logger << DEBUG << prefix << " misspelled" << endl;
+        PRESAGE_LOG(logger, DEBUG) << prefix << " misspelled" << endl;
 
         // incorrect spelling, let's suggest correct words
-        std::vector<std::string> wlst = hunspell->suggest(prefix);
+        const std::vector<std::string>& wlst = spelling.words;
         double dprob = probability / (wlst.size() + 1);
         double cprob = probability - dprob;
         
         std::vector<std::string>::const_iterator it = wlst.cbegin();
         for ( ; count < max_partial_predictions_size && it != wlst.cend(); ++count, ++it, cprob -= dprob) {
           result.addSuggestion(Suggestion(*it, cprob));
-          logger << DEBUG << "speller suggestion: " << *it << endl;
+          PRESAGE_LOG(logger, DEBUG) << "speller suggestion: " << *it << endl;
         }
       }
     
@@ -138,6 +291,5 @@ void HunspellPredictor::forget(const std::string& word)
 
 void HunspellPredictor::update (const Observable* var)
 {
-    logger << DEBUG << "About to invoke dispatcher: " << var->get_name () << " - " << var->get_value() << endl;
-    dispatcher.dispatch (var);
+    dispatch (dispatcher, var);
 }
@@ -33,12 +33,30 @@
 #include <fstream>
 #include <hunspell/hunspell.hxx>
 #include <memory>
+#include <list>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 
 /** Hunspell based predictive predictor.
  *
  * Generates a prediction by running them through speller.
  *
+ * Hunspell can take hundreds of milliseconds to suggest corrections
+ * of a long word, hence the speller runs on a worker thread and the
+ * prediction waits for it at most TIMEOUT milliseconds. A late
+ * speller is not interrupted: its suggestions are cached and used if
+ * the prefix is still the same on a later prediction, unless a new
+ * prefix has been handed to the speller in the meantime. Predictions
+ * made without the answer of the speller are flagged as partial, so
+ * that they are not cached by Presage.
+ *
+ * The suggestions of the last CACHE_SIZE prefixes are cached. While
+ * the speller is busy with a prefix that extends a correct word found
+ * in the cache, the cached suffixes of that word are suggested.
+ *
  */
 class HunspellPredictor : public Predictor, public Observer {
 public:
@@ -55,18 +73,67 @@ public:
 
     void set_dictionary_base (const std::string& value);
     void set_probability (const std::string& value);
+    void set_cache_size (const std::string& value);
+    void set_timeout (const std::string& value);
 
 private:
+    /** Speller verdict on a prefix. */
+    struct Spelling {
+        bool correct;
+        std::vector<std::string> words; // suffixes if correct, corrections otherwise
+    };
+
+    typedef std::list< std::pair<std::string, Spelling> > Cache;
+
     void load_speller();
-    
+
+    /** Gets the spelling of prefix from the cache or the speller.
+     *
+     * @return false if the speller did not answer in time
+     */
+    bool spell(const std::string& prefix, Spelling& spelling) const;
+
+    /** Gets the cached suffixes of the longest correct word that
+     *  prefix extends, which start with prefix.
+     */
+    bool extend(const std::string& prefix, Spelling& spelling) const;
+
+    /** Looks prefix up in the cache, making it the most recent entry.
+     *  Requires speller_mutex to be held.
+     */
+    bool lookup(const std::string& prefix, Spelling& spelling) const;
+
+    /** Caches spelling, dropping the least recent entries.
+     *  Requires speller_mutex to be held.
+     */
+    void store(const std::string& prefix, const Spelling& spelling) const;
+
+    // worker thread
+    void run() const;
+
 private:
     std::string LOGGER;
     std::string DICTIONARYBASE;
     std::string PROBABILITY;
+    std::string CACHE_SIZE;
+    std::string TIMEOUT;
 
     std::string affix_path;
     std::string dictionary_path;
     double probability;
+    size_t cache_size;
+    int timeout;
+
+    // speller state, shared with the worker thread
+    mutable std::mutex speller_mutex;
+    mutable std::condition_variable speller_condition;
+    mutable std::string request;
+    mutable bool requested;
+    mutable bool busy;
+    mutable bool stopping;
+    mutable Cache cache;
+    mutable std::unordered_map<std::string, Cache::iterator> cache_index;
+    mutable std::thread worker;
 
     Dispatcher<HunspellPredictor> dispatcher;
     std::unique_ptr<Hunspell> hunspell;
@@ -47,7 +47,9 @@ Predictor::Predictor(Configuration* config,
       contextTracker  (ct        ),
       configuration   (config    ),
       PREDICTORS      ("Presage.Predictors."),
-      logger          (predictorName, std::cerr)
+      logger          (predictorName, std::cerr),
+      pending_tasks   (0),
+      partial         (false)
 {
     // NOTE: predictor implementations deriving from this class should
     // use profile to query the value of needed configuration
@@ -85,10 +87,52 @@ const std::string Predictor::getLongDescription() const
 }
 
 
+/** Get mutex serializing calls into the predictor.
+ *
+ */
+std::mutex& Predictor::get_mutex() const
+{
+    return mutex;
+}
+
+void Predictor::begin_task() const
+{
+    std::lock_guard<std::mutex> lock(task_mutex);
+    pending_tasks++;
+}
+
+void Predictor::end_task() const
+{
+    {
+	std::lock_guard<std::mutex> lock(task_mutex);
+	pending_tasks--;
+    }
+    task_condition.notify_all();
+}
+
+/** Blocks until no prediction is pending on a worker thread.
+ *
+ */
+void Predictor::wait_for_tasks() const
+{
+    std::unique_lock<std::mutex> lock(task_mutex);
+    task_condition.wait(lock, [this]() { return pending_tasks == 0; });
+}
+
+bool Predictor::is_partial() const
+{
+    return partial;
+}
+
+void Predictor::set_partial (bool value) const
+{
+    partial = value;
+}
+
 void Predictor::set_logger (const std::string& level)
 {
     logger << setlevel (level);
-    logger << INFO << "LOGGER: " << level << endl;
+    PRESAGE_LOG(logger, INFO) << "LOGGER: " << level << endl;
 }
 
 
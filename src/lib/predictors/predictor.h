@@ -29,9 +29,12 @@
 #include "../core/context_tracker/contextTracker.h"
 #include "../core/configuration.h"
 #include "../core/utility.h"
+#include "../core/dispatcher.h"
 
 #include <string>
 #include <vector>
+#include <mutex>
+#include <condition_variable>
 
 /** Predictor is an abstract class that defines the interface implemented by concrete predictors.
  * 
@@ -68,6 +71,39 @@ public:
     const std::string getShortDescription() const;
     const std::string getLongDescription() const;
 
+    /** \brief Mutex serializing calls into the predictor.
+     *
+     * PredictorActivator computes predictions on worker threads, and
+     * a predictor that missed the prediction deadline may still be
+     * running when control returns to the caller. Code invoking
+     * predict(), learn() or forget() outside of PredictorActivator
+     * must hold this mutex.
+     */
+    std::mutex& get_mutex() const;
+
+    /** \brief Tracks predictions pending on worker threads.
+     *
+     * PredictorActivator calls begin_task() when it queues a
+     * prediction and end_task() once the prediction has completed,
+     * whether or not it met the deadline. A predictor must not be
+     * destroyed while a prediction is pending, hence
+     * PredictorRegistry calls wait_for_tasks() before deleting it.
+     */
+    void begin_task() const;
+    void end_task() const;
+    void wait_for_tasks() const;
+
+    /** \brief Whether the last prediction is missing results that are
+     *         still being computed.
+     *
+     * A predictor that may return before its prediction is complete,
+     * as HunspellPredictor does when the speller is late, calls
+     * set_partial() on each prediction. PredictorActivator reports
+     * partial predictions along with late ones, so that they are not
+     * cached.
+     */
+    bool is_partial() const;
+
 
 protected:
     virtual bool token_satisfies_filter (const std::string& token,
@@ -76,6 +112,22 @@ protected:
 
     virtual void set_logger (const std::string& level);
 
+    void set_partial (bool value) const;
+
+    /** \brief Dispatch a configuration change to the predictor.
+     *
+     * Concrete predictors forward their update() notifications here,
+     * so that the handler runs under the predictor mutex while a
+     * prediction that missed the deadline may still be running.
+     */
+    template <class predictor_t>
+    void dispatch (Dispatcher<predictor_t>& dispatcher, const Observable* var)
+    {
+	std::lock_guard<std::mutex> lock(mutex);
+	PRESAGE_LOG(logger, DEBUG) << "About to invoke dispatcher: " << var->get_name () << " - " << var->get_value() << endl;
+	dispatcher.dispatch (var);
+    }
+
     const std::string name;
     const std::string shortDescription; // predictor's descriptive name
     const std::string longDescription;  // predictor's exhaustive description
@@ -89,7 +141,13 @@ protected:
     Logger<char> logger;
 
 private:
+    mutable std::mutex mutex;
+
+    mutable std::mutex task_mutex;
+    mutable std::condition_variable task_condition;
+    mutable int pending_tasks;
 
+    mutable bool partial;
 };
 
 
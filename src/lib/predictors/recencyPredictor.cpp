@@ -32,6 +32,10 @@ RecencyPredictor::RecencyPredictor(Configuration* config, ContextTracker* ct, co
 		name,
 		"RecencyPredictor, a statistical recency promotion predictor",
 		"RecencyPredictor, based on a recency promotion principle, generates predictions by assigning exponentially decaying probability values to previously encountered tokens. Tokens are assigned a probability value that decays exponentially with their distance from the current token, thereby promoting context recency." ),
+      recent_count (0),
+      recent_size (0),
+      recent_serial (0),
+      initials (256),
       dispatcher (this)
 {
     // RecencyPredictor config variables
@@ -59,20 +63,90 @@ RecencyPredictor::~RecencyPredictor()
 void RecencyPredictor::set_lambda (const std::string& value)
 {
     lambda = Utility::toDouble(value);
-    logger << INFO << "LAMBDA: " << value << endl;
+    compute_decay();
+    PRESAGE_LOG(logger, INFO) << "LAMBDA: " << value << endl;
 }
 
 void RecencyPredictor::set_n_0 (const std::string& value)
 {
     n_0 = Utility::toDouble (value);
-    logger << INFO << "N_0: " << value << endl;
+    compute_decay();
+    PRESAGE_LOG(logger, INFO) << "N_0: " << value << endl;
 }
 
 
 void RecencyPredictor::set_cutoff_threshold (const std::string& value)
 {
     cutoff_threshold = Utility::toInt (value);
-    logger << INFO << "CUTOFF_THRESHOLD: " << value << endl;
+    compute_decay();
+    clear_recent_tokens();
+    recent.assign(cutoff_threshold, std::string());
+    PRESAGE_LOG(logger, INFO) << "CUTOFF_THRESHOLD: " << value << endl;
+}
+
+void RecencyPredictor::compute_decay()
+{
+    // exponential decay formula
+    decay.resize(cutoff_threshold);
+    for (size_t i = 0; i < decay.size(); i++) {
+	decay[i] = n_0 * exp(-(lambda * i));
+    }
+}
+
+void RecencyPredictor::update_recent_tokens() const
+{
+    // collect the tokens more recent than the last one in the ring,
+    // most recent first
+    std::vector<std::string> added;
+    unsigned long newest;
+    unsigned long serial;
+    std::string token = contextTracker->getToken(1, newest);
+    serial = newest;
+    while (serial != 0
+	   && serial != recent_serial
+	   && added.size() < cutoff_threshold) {
+	added.push_back(token);
+	token = contextTracker->getToken(added.size() + 1, serial);
+    }
+
+    if (serial != recent_serial) {
+	// tokens in the ring were changed or pushed out
+	clear_recent_tokens();
+    }
+    for (std::vector<std::string>::reverse_iterator it = added.rbegin(); it != added.rend(); it++) {
+	push_recent_token(*it);
+    }
+    recent_serial = newest;
+
+    PRESAGE_LOG(logger, DEBUG) << "update_recent_tokens(): " << added.size() << " tokens added" << endl;
+}
+
+void RecencyPredictor::push_recent_token(const std::string& token) const
+{
+    if (cutoff_threshold == 0) {
+	return;
+    }
+
+    std::string& slot = recent[recent_count % cutoff_threshold];
+    if (recent_size == cutoff_threshold) {
+	// the oldest token is always first among those sharing its
+	// first character
+	initials[static_cast<unsigned char>(slot[0])].pop_front();
+    } else {
+	recent_size++;
+    }
+    slot = token;
+    initials[static_cast<unsigned char>(token[0])].push_back(recent_count);
+    recent_count++;
+}
+
+void RecencyPredictor::clear_recent_tokens() const
+{
+    for (size_t i = 0; i < initials.size(); i++) {
+	initials[i].clear();
+    }
+    recent_size = 0;
+    recent_serial = 0;
 }
 
 
@@ -81,7 +155,7 @@ Prediction RecencyPredictor::predict (const size_t max, const char** filter) con
     Prediction result;
 
     std::string prefix = contextTracker->getPrefix();
-    logger << INFO << "prefix: " << prefix << endl;
+    PRESAGE_LOG(logger, INFO) << "prefix: " << prefix << endl;
     if (!prefix.empty()) {
         // Only build recency prediction if prefix is not empty: when
         // prefix is empty, all previosly seen tokens are candidates
@@ -90,33 +164,24 @@ Prediction RecencyPredictor::predict (const size_t max, const char** filter) con
         // tokens (i.e. the prediction would contain the most recent
         // tokens in reverse order).
         //
-        Suggestion  suggestion;
-        size_t      index = 1;
-        std::string token = contextTracker->getToken(index);
-	double      prob = 0;
-        while (!token.empty()                // context history exhausted
-	       && result.size() < max        // need only max suggestions
-	       && index <= cutoff_threshold  // look back only as far as cutoff
-	    ) {
-	    logger << INFO << "token: " << token << endl;
-
-            if (token.find(prefix) == 0) { // if token starts with prefix
-
-		if (token_satisfies_filter (token, prefix, filter)) {
-		    // compute probability according to exponential decay
-		    // formula
-		    //
-		    prob = n_0 * exp(-(lambda * (index - 1)));
-		    logger << INFO << "probability: " << prob << endl;
-		    suggestion.setWord(token);
-		    suggestion.setProbability(prob);
-		    result.addSuggestion(suggestion);
-		}
-
+        update_recent_tokens();
+
+        const std::deque<unsigned long>& candidates = initials[static_cast<unsigned char>(prefix[0])];
+        Suggestion suggestion;
+        for (std::deque<unsigned long>::const_reverse_iterator it = candidates.rbegin();
+             it != candidates.rend() && result.size() < max;
+             it++) {
+            const std::string& token = recent[*it % cutoff_threshold];
+            size_t index = recent_count - *it;
+	    PRESAGE_LOG(logger, INFO) << "token: " << token << endl;
+
+            if (token.compare(0, prefix.size(), prefix) == 0
+                && token_satisfies_filter (token, prefix, filter)) {
+		PRESAGE_LOG(logger, INFO) << "probability: " << decay[index - 1] << endl;
+		suggestion.setWord(token);
+		suggestion.setProbability(decay[index - 1]);
+		result.addSuggestion(suggestion);
             }
-
-            index++;
-            token = contextTracker->getToken(index);
         }
     }
 
@@ -133,6 +198,5 @@ void RecencyPredictor::forget(const std::string& word)
 
 void RecencyPredictor::update (const Observable* var)
 {
-    logger << DEBUG << "About to invoke dispatcher: " << var->get_name () << " - " << var->get_value() << endl;
-    dispatcher.dispatch (var);
+    dispatch (dispatcher, var);
 }
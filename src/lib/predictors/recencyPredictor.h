@@ -29,6 +29,9 @@
 #include "../core/logger.h"
 #include "../core/dispatcher.h"
 
+#include <deque>
+#include <vector>
+
 /** Recency predictor, a recency promotion statistical predictor.
  *
  * RecencyPredictor, based on recency promotion principle, generates
@@ -60,6 +63,13 @@
  * differentiation operator with N(t) as the corresponding
  * eigenfunction).
  *
+ * The last CUTOFF_THRESHOLD tokens are kept in a ring buffer, which
+ * is brought up to date by reading only the tokens added to the
+ * context since the previous prediction. Tokens in the ring are
+ * indexed by their first character, and the decay of each distance
+ * is computed once into a table, so the cost of a prediction does
+ * not grow with the cutoff.
+ *
  */
 class RecencyPredictor : public Predictor, public Observer {
 public:
@@ -79,6 +89,14 @@ private:
     void set_n_0              (const std::string& value);
     void set_cutoff_threshold (const std::string& value);
 
+    void compute_decay();
+
+    /** Adds the tokens entered since the last call to the ring, or
+     *  refills it if earlier tokens changed. */
+    void update_recent_tokens() const;
+    void push_recent_token(const std::string& token) const;
+    void clear_recent_tokens() const;
+
     std::string LOGGER;
     std::string LAMBDA;
     std::string N_0;
@@ -88,6 +106,19 @@ private:
     double n_0;
     size_t cutoff_threshold;
 
+    // decay[i] is the probability of a token i tokens before the last
+    std::vector<double> decay;
+
+    // ring of the last cutoff_threshold tokens; the token pushed as
+    // the n-th one lives in slot n % cutoff_threshold
+    mutable std::vector<std::string> recent;
+    mutable unsigned long recent_count;
+    mutable size_t recent_size;
+    // serial number of the most recent token in the ring
+    mutable unsigned long recent_serial;
+    // numbers of the tokens in the ring by first character, oldest first
+    mutable std::vector< std::deque<unsigned long> > initials;
+
     Dispatcher<RecencyPredictor> dispatcher;
 
 };
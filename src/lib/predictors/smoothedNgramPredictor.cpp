@@ -25,9 +25,20 @@
 #include "smoothedNgramPredictor.h"
 
 #include "../core/utility.h"
+#include "../core/progress.h"
 
 #include <sstream>
 #include <algorithm>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <ctype.h>
+
+// number of ngrams written to the database at once while learning
+static const size_t LEARN_BATCH_SIZE = 1024;
+
+// learning updates of at least this many ngrams report their progress
+static const size_t LEARN_PROGRESS_THRESHOLD = 16 * LEARN_BATCH_SIZE;
 
 
 SmoothedNgramPredictor::SmoothedNgramPredictor(Configuration* config, ContextTracker* ct, const char* name)
@@ -42,6 +53,8 @@ SmoothedNgramPredictor::SmoothedNgramPredictor(Configuration* config, ContextTra
       learn_mode_set (false),
       dispatcher (this)
 {
+    state.valid = false;
+
     LOGGER          = PREDICTORS + name + ".LOGGER";
     DBFILENAME      = PREDICTORS + name + ".DBFILENAME";
     DELTAS          = PREDICTORS + name + ".DELTAS";
@@ -69,7 +82,7 @@ SmoothedNgramPredictor::~SmoothedNgramPredictor()
 void SmoothedNgramPredictor::set_dbfilename (const std::string& filename)
 {
     dbfilename = filename;
-    logger << INFO << "DBFILENAME: " << dbfilename << endl;
+    PRESAGE_LOG(logger, INFO) << "DBFILENAME: " << dbfilename << endl;
 
     init_database_connector_if_ready ();
 }
@@ -87,12 +100,14 @@ void SmoothedNgramPredictor::set_deltas (const std::string& value)
     cardinality = 0;
     std::string delta;
     while (ss_deltas >> delta) {
-        logger << DEBUG << "Pushing delta: " << delta << endl;
+        PRESAGE_LOG(logger, DEBUG) << "Pushing delta: " << delta << endl;
 	deltas.push_back (Utility::toDouble (delta));
 	cardinality++;
     }
-    logger << INFO << "DELTAS: " << value << endl;
-    logger << INFO << "CARDINALITY: " << cardinality << endl;
+    PRESAGE_LOG(logger, INFO) << "DELTAS: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "CARDINALITY: " << cardinality << endl;
+
+    invalidate_prediction_state ();
 
     init_database_connector_if_ready ();
 }
@@ -101,14 +116,14 @@ void SmoothedNgramPredictor::set_deltas (const std::string& value)
 void SmoothedNgramPredictor::set_count_threshold (const std::string& value)
 {
     count_threshold = Utility::toInt (value);
-    logger << INFO << "COUNT_THRESHOLD: " << count_threshold << endl;
+    PRESAGE_LOG(logger, INFO) << "COUNT_THRESHOLD: " << count_threshold << endl;
 }
 
 
 void SmoothedNgramPredictor::set_learn (const std::string& value)
 {
     learn_mode = Utility::isYes (value);
-    logger << INFO << "LEARN: " << value << endl;
+    PRESAGE_LOG(logger, INFO) << "LEARN: " << value << endl;
 
     learn_mode_set = true;
 
@@ -130,6 +145,7 @@ void SmoothedNgramPredictor::init_database_connector_if_ready ()
         && learn_mode_set ) {
 
         delete db;
+        invalidate_prediction_state ();
 
         if (dbloglevel.empty ()) {
 	    // open database connector
@@ -147,6 +163,156 @@ void SmoothedNgramPredictor::init_database_connector_if_ready ()
 }
 
 
+// SQLite LIKE operator is case insensitive for ASCII characters
+//
+static bool like_prefix(const std::string& word, const std::string& prefix)
+{
+    if (word.size() < prefix.size()) {
+	return false;
+    }
+    for (size_t i = 0; i < prefix.size(); i++) {
+	unsigned char w = word[i];
+	unsigned char p = prefix[i];
+	if (w != p && (w >= 0x80 || p >= 0x80 || tolower(w) != tolower(p))) {
+	    return false;
+	}
+    }
+    return true;
+}
+
+
+bool SmoothedNgramPredictor::is_prediction_state_valid (const std::vector<std::string>& tokens, const char** filter) const
+{
+    if (! state.valid
+	|| state.tokens != tokens
+	|| state.count_threshold != count_threshold
+	|| state.filtered != (filter != 0)) {
+	return false;
+    }
+
+    if (filter) {
+	size_t i = 0;
+	for (; filter[i] != 0; i++) {
+	    if (i >= state.filter.size() || state.filter[i] != filter[i]) {
+		return false;
+	    }
+	}
+	if (i != state.filter.size()) {
+	    return false;
+	}
+    }
+
+    return true;
+}
+
+
+/** Narrows the candidates of the previous prediction down to the ones
+ *  matching a longer prefix.
+ *
+ * When one more character of the same word has been entered, the words
+ * matching the new prefix are a subset of those that matched the
+ * previous one, in the same order, and their probabilities do not
+ * depend on the prefix. The words read from each n-gram table are
+ * filtered, so that only those that were not read yet need to be
+ * fetched from the database.
+ *
+ * \return false if the context does not extend the previous one
+ */
+bool SmoothedNgramPredictor::narrow_prediction_state (const std::vector<std::string>& tokens, const char** filter) const
+{
+    // filter strings are appended to the prefix in the query, so a
+    // longer prefix would not select a subset of the previous words
+    if (! state.valid
+	|| tokens.empty()
+	|| filter != 0
+	|| state.filtered
+	|| state.count_threshold != count_threshold
+	|| state.tokens.size() != tokens.size()
+	|| state.probabilities.size() != state.candidates.size()
+	|| ! std::equal(tokens.begin(), tokens.end() - 1, state.tokens.begin())) {
+	return false;
+    }
+
+    const std::string& prefix = tokens.back();
+    const std::string& previous_prefix = state.tokens.back();
+    if (prefix.size() <= previous_prefix.size()
+	|| prefix.find_first_of("%_") != std::string::npos
+	|| ! like_prefix(prefix, previous_prefix)) {
+	return false;
+    }
+
+    PRESAGE_LOG(logger, DEBUG) << "Narrowing candidates from prefix " << previous_prefix << " to " << prefix << endl;
+
+    std::map<std::string, double> probabilities;
+    for (size_t j = 0; j < state.candidates.size(); j++) {
+	probabilities[state.candidates[j]] = state.probabilities[j];
+    }
+
+    state.tokens = tokens;
+    state.candidates.clear();
+    state.known.clear();
+    state.probabilities.clear();
+
+    // words from a lower order table are only candidates once all the
+    // words from the higher order tables have been read
+    bool complete = true;
+    for (size_t k = cardinality; k > 0; k--) {
+	std::vector<std::string>& rows = state.rows[k - 1];
+	if (! complete) {
+	    rows.clear();
+	    state.exhausted[k - 1] = false;
+	    continue;
+	}
+
+	std::vector<std::string> narrowed;
+	for (std::vector<std::string>::const_iterator it = rows.begin();
+	     it != rows.end();
+	     it++) {
+	    if (like_prefix(*it, prefix)) {
+		narrowed.push_back(*it);
+		if (state.known.insert(*it).second) {
+		    state.candidates.push_back(*it);
+		    state.probabilities.push_back(probabilities[*it]);
+		}
+	    }
+	}
+	rows.swap(narrowed);
+
+	complete = state.exhausted[k - 1];
+    }
+
+    return true;
+}
+
+
+void SmoothedNgramPredictor::reset_prediction_state (const std::vector<std::string>& tokens, const char** filter) const
+{
+    state.valid = true;
+    state.tokens = tokens;
+    state.filter.clear();
+    state.filtered = (filter != 0);
+    if (filter) {
+	for (size_t i = 0; filter[i] != 0; i++) {
+	    state.filter.push_back(filter[i]);
+	}
+    }
+    state.count_threshold = count_threshold;
+
+    state.candidates.clear();
+    state.known.clear();
+    state.probabilities.clear();
+    state.rows.assign(cardinality, std::vector<std::string>());
+    state.exhausted.assign(cardinality, false);
+    state.denominators.clear();
+}
+
+
+void SmoothedNgramPredictor::invalidate_prediction_state ()
+{
+    state.valid = false;
+}
+
+
 // convenience function to convert ngram to string
 //
 static std::string ngram_to_string(const Ngram& ngram)
@@ -191,10 +357,10 @@ unsigned int SmoothedNgramPredictor::count(const std::vector<std::string>& token
 	Ngram ngram(ngram_size);
 	copy(tokens.end() - ngram_size + offset , tokens.end() + offset, ngram.begin());
 	result = db->getNgramCount(ngram);
-	logger << DEBUG << "count ngram: " << ngram_to_string (ngram) << " : " << result << endl;
+	PRESAGE_LOG(logger, DEBUG) << "count ngram: " << ngram_to_string (ngram) << " : " << result << endl;
     } else {
 	result = db->getUnigramCountsSum();
-	logger << DEBUG << "unigram counts sum: " << result << endl;
+	PRESAGE_LOG(logger, DEBUG) << "unigram counts sum: " << result << endl;
     }
 
     return result;
@@ -202,7 +368,7 @@ unsigned int SmoothedNgramPredictor::count(const std::vector<std::string>& token
 
 Prediction SmoothedNgramPredictor::predict(const size_t max_partial_prediction_size, const char** filter) const
 {
-    logger << DEBUG << "predict()" << endl;
+    PRESAGE_LOG(logger, DEBUG) << "predict()" << endl;
 
     // Result prediction
     Prediction prediction;
@@ -214,7 +380,7 @@ Prediction SmoothedNgramPredictor::predict(const size_t max_partial_prediction_s
     std::vector<std::string> tokens(cardinality);
     for (int i = 0; i < cardinality; i++) {
 	tokens[cardinality - 1 - i] = contextTracker->getToken(i);
-	logger << DEBUG << "Cached tokens[" << cardinality - 1 - i << "] = " << tokens[cardinality - 1 - i] << endl;
+	PRESAGE_LOG(logger, DEBUG) << "Cached tokens[" << cardinality - 1 - i << "] = " << tokens[cardinality - 1 - i] << endl;
     }
 
     // Generate list of prefix completition candidates.
@@ -229,293 +395,355 @@ Prediction SmoothedNgramPredictor::predict(const size_t max_partial_prediction_s
     // n-gram table, falling back on lower order n-gram tables if
     // initial completion set is smaller than required.
     //
-    std::vector<std::string> prefixCompletionCandidates;
-    for (size_t k = cardinality; (k > 0 && prefixCompletionCandidates.size() < max_partial_prediction_size); k--) {
-        logger << DEBUG << "Building partial prefix completion table of cardinality: " << k << endl;
+    // Candidates found by the previous call are reused if the context
+    // has not changed since, so that asking for more suggestions only
+    // fetches the ones that are missing, or narrowed down if the prefix
+    // has grown.
+    //
+    if (! is_prediction_state_valid(tokens, filter)
+	&& ! narrow_prediction_state(tokens, filter)) {
+	reset_prediction_state(tokens, filter);
+    }
+    std::vector<std::string>& prefixCompletionCandidates = state.candidates;
+    const size_t known_candidates = prefixCompletionCandidates.size();
+
+    // Duplicates may leave room for more candidates after a table
+    // has been queried, in which case it is read further until it
+    // is exhausted.
+    //
+    size_t k = cardinality;
+    while (k > 0 && prefixCompletionCandidates.size() < max_partial_prediction_size) {
+	if (state.exhausted[k - 1]) {
+	    // all matching k-grams have been read, fall back on
+	    // lower order n-gram table
+	    k--;
+	    continue;
+	}
+
+        PRESAGE_LOG(logger, DEBUG) << "Building partial prefix completion table of cardinality: " << k << endl;
         // create n-gram used to retrieve initial prefix completion table
         Ngram prefix_ngram(k);
         copy(tokens.end() - k, tokens.end(), prefix_ngram.begin());
 
-	if (logger.shouldLog()) {
-	    logger << DEBUG << "prefix_ngram: ";
+	if ((logger << DEBUG).shouldLog()) {
+	    logger << "prefix_ngram: ";
 	    for (size_t r = 0; r < prefix_ngram.size(); r++) {
-		logger << DEBUG << prefix_ngram[r] << ' ';
+		logger << prefix_ngram[r] << ' ';
 	    }
-	    logger << DEBUG << endl;
+	    logger << endl;
 	}
 
-        // obtain initial prefix completion candidates
+        // obtain initial prefix completion candidates, skipping the
+        // rows read by previous calls
         db->beginTransaction();
 
-        NgramTable partial;
+        std::vector<std::string> partial;
+	size_t limit = max_partial_prediction_size - prefixCompletionCandidates.size();
 
-	partial = db->getNgramLikeTable(prefix_ngram,
+	partial = db->getPredictedWords(prefix_ngram,
 					filter,
 					count_threshold,
-					max_partial_prediction_size - prefixCompletionCandidates.size());
+					limit,
+					state.rows[k - 1].size());
 
         db->endTransaction();
 
-	if (logger.shouldLog()) {
-	    logger << DEBUG << "partial prefixCompletionCandidates" << endl
-	           << DEBUG << "----------------------------------" << endl;
+	if (partial.size() < limit) {
+	    state.exhausted[k - 1] = true;
+	}
+
+	if ((logger << DEBUG).shouldLog()) {
+	    logger << "partial prefixCompletionCandidates" << endl
+		   << "----------------------------------" << endl;
 	    for (size_t j = 0; j < partial.size(); j++) {
-		for (size_t k = 0; k < partial[j].size(); k++) {
-		    logger << DEBUG << partial[j][k] << " ";
-		}
-		logger << endl;
+		logger << partial[j] << endl;
 	    }
 	}
 
-        logger << DEBUG << "Partial prefix completion table contains " << partial.size() << " potential completions." << endl;
+        PRESAGE_LOG(logger, DEBUG) << "Partial prefix completion table contains " << partial.size() << " potential completions." << endl;
 
         // append newly discovered potential completions to prefix
         // completion candidates array to fill it up to
         // max_partial_prediction_size
         //
-        std::vector<Ngram>::const_iterator it = partial.begin();
+        std::vector<std::string>::const_iterator it = partial.begin();
         while (it != partial.end() && prefixCompletionCandidates.size() < max_partial_prediction_size) {
-            // only add new candidates, iterator it points to Ngram,
-            // it->end() - 2 points to the token candidate
+            // only add new candidates
             //
-            std::string candidate = *(it->end() - 2);
-            if (find(prefixCompletionCandidates.begin(),
-                     prefixCompletionCandidates.end(),
-                     candidate) == prefixCompletionCandidates.end()) {
+            const std::string& candidate = *it;
+            if (state.known.insert(candidate).second) {
                 prefixCompletionCandidates.push_back(candidate);
             }
             it++;
         }
+	state.rows[k - 1].insert(state.rows[k - 1].end(), partial.cbegin(), it);
     }
 
-    if (logger.shouldLog()) {
-	logger << DEBUG << "prefixCompletionCandidates" << endl
-	       << DEBUG << "--------------------------" << endl;
+    if ((logger << DEBUG).shouldLog()) {
+	logger << "prefixCompletionCandidates" << endl
+	       << "--------------------------" << endl;
 	for (size_t j = 0; j < prefixCompletionCandidates.size(); j++) {
-	    logger << DEBUG << prefixCompletionCandidates[j] << endl;
+	    logger << prefixCompletionCandidates[j] << endl;
 	}
     }
 
-    // compute smoothed probabilities for all candidates
+    // compute smoothed probabilities for the new candidates
     //
-    db->beginTransaction();
-    // getUnigramCountsSum is an expensive SQL query
-    // caching it here saves much time later inside the loop
-    int unigrams_counts_sum = db->getUnigramCountsSum(); 
-    for (size_t j = 0; (j < prefixCompletionCandidates.size() && j < max_partial_prediction_size); j++) {
-        // store w_i candidate at end of tokens
-        tokens[cardinality - 1] = prefixCompletionCandidates[j];
+    if (prefixCompletionCandidates.size() > known_candidates) {
+	db->beginTransaction();
 
-	logger << DEBUG << "------------------" << endl;
-	logger << DEBUG << "w_i: " << tokens[cardinality - 1] << endl;
+	// denominators do not depend on the candidate w_i, so they
+	// are only looked up once per context.
+	//
+	// denominators[k] is the count of the k-gram context of the
+	// (k+1)-gram ending with the candidate
+	if (state.denominators.empty()) {
+	    // getUnigramCountsSum is an expensive SQL query
+	    // caching it here saves much time later inside the loop
+	    int unigrams_counts_sum = db->getUnigramCountsSum();
+
+	    state.denominators.resize(cardinality);
+	    for (int k = 0; k < cardinality; k++) {
+		// reuse cached unigrams_counts_sum to speed things up
+		state.denominators[k] = (k == 0 ? unigrams_counts_sum : count(tokens, -1, k));
+	    }
+	}
 
-	double probability = 0;
+	// fetch the counts for all new candidates at once, one batch
+	// per order.
+	//
+	// numerators[k][j] is the count of the (k+1)-gram ending with
+	// new candidate j
+	std::vector<std::string> candidates(prefixCompletionCandidates.begin() + known_candidates,
+					    prefixCompletionCandidates.end());
+	std::vector< std::vector<int> > numerators(cardinality);
 	for (int k = 0; k < cardinality; k++) {
-	    double numerator = count(tokens, 0, k+1);
-	    // reuse cached unigrams_counts_sum to speed things up
-	    double denominator = (k == 0 ? unigrams_counts_sum : count(tokens, -1, k));
-            // probably not a proper fix, but done to go around some cases where denominator < numerator
-	    // double frequency = ((denominator > 0) ? (numerator / denominator) : 0);
-	    double frequency = ((denominator > 0 && denominator >= numerator) ? (numerator / denominator) : 0);
-	    probability += deltas[k] * frequency;
-
-	    logger << DEBUG << "numerator:   " << numerator << endl;
-	    logger << DEBUG << "denominator: " << denominator << endl;
-	    logger << DEBUG << "frequency:   " << frequency << endl;
-	    logger << DEBUG << "delta:       " << deltas[k] << endl;
-
-            // for some sanity checks
-            // these assertions fail occasionally. to fix, the calculation of frequency was adjusted above
-	    //assert(numerator <= denominator);
-	    assert(frequency <= 1);
+	    Ngram context(k);
+	    copy(tokens.end() - 1 - k, tokens.end() - 1, context.begin());
+	    numerators[k] = db->getNgramCounts(context, candidates);
 	}
 
-        logger << DEBUG << "____________" << endl;
-        logger << DEBUG << "probability: " << probability << endl;
+	for (size_t j = 0; j < candidates.size(); j++) {
+	    PRESAGE_LOG(logger, DEBUG) << "------------------" << endl;
+	    PRESAGE_LOG(logger, DEBUG) << "w_i: " << candidates[j] << endl;
+
+	    double probability = 0;
+	    for (int k = 0; k < cardinality; k++) {
+		double numerator = numerators[k][j];
+		double denominator = state.denominators[k];
+		// probably not a proper fix, but done to go around some cases where denominator < numerator
+		// double frequency = ((denominator > 0) ? (numerator / denominator) : 0);
+		double frequency = ((denominator > 0 && denominator >= numerator) ? (numerator / denominator) : 0);
+		probability += deltas[k] * frequency;
+
+		PRESAGE_LOG(logger, DEBUG) << "numerator:   " << numerator << endl;
+		PRESAGE_LOG(logger, DEBUG) << "denominator: " << denominator << endl;
+		PRESAGE_LOG(logger, DEBUG) << "frequency:   " << frequency << endl;
+		PRESAGE_LOG(logger, DEBUG) << "delta:       " << deltas[k] << endl;
+
+		// for some sanity checks
+		// these assertions fail occasionally. to fix, the calculation of frequency was adjusted above
+		//assert(numerator <= denominator);
+		assert(frequency <= 1);
+	    }
+
+	    PRESAGE_LOG(logger, DEBUG) << "____________" << endl;
+	    PRESAGE_LOG(logger, DEBUG) << "probability: " << probability << endl;
 
-	if (probability > 0) {
-	    prediction.addSuggestion(Suggestion(tokens[cardinality - 1], probability));
+	    state.probabilities.push_back(probability);
 	}
+	db->endTransaction();
     }
-    db->endTransaction();
 
-    logger << DEBUG << "Prediction:" << endl;
-    logger << DEBUG << "-----------" << endl;
-    logger << DEBUG << prediction << endl;
+    for (size_t j = 0; (j < prefixCompletionCandidates.size() && j < max_partial_prediction_size); j++) {
+	if (state.probabilities[j] > 0) {
+	    prediction.addSuggestion(Suggestion(prefixCompletionCandidates[j], state.probabilities[j]));
+	}
+    }
+
+    PRESAGE_LOG(logger, DEBUG) << "Prediction:" << endl;
+    PRESAGE_LOG(logger, DEBUG) << "-----------" << endl;
+    PRESAGE_LOG(logger, DEBUG) << prediction << endl;
 
     return prediction;
 }
 
 void SmoothedNgramPredictor::learn(const std::vector<std::string>& change)
 {
-    logger << INFO << "learn(\"" << ngram_to_string(change) << "\")" << endl;
+    PRESAGE_LOG(logger, INFO) << "learn(\"" << ngram_to_string(change) << "\")" << endl;
 
     if (learn_mode) {
 	// learning is turned on
+	invalidate_prediction_state();
 
-	std::map<std::list<std::string>, int> ngramMap;
+	commit_ngram_counts(db, count_ngrams(change, cardinality, contextTracker, logger), logger);
+    }
 
-	// build up ngram map for all cardinalities
-	// i.e. learn all ngrams and counts in memory
-	for (size_t curr_cardinality = 1;
-	     curr_cardinality < cardinality + 1;
-	     curr_cardinality++)
-	{
-	    int change_idx = 0;
-	    int change_size = change.size();
+    PRESAGE_LOG(logger, DEBUG) << "end learn()" << endl;
+}
+
+NgramCounts SmoothedNgramPredictor::count_ngrams(const std::vector<std::string>& change,
+						 const size_t cardinality,
+						 const ContextTracker* contextTracker,
+						 const Logger<char>& logger)
+{
+    // tokens are interned to integer ids, so that ngrams are
+    // counted by hashing strings of ids
+    std::unordered_map<std::string, char32_t> vocabulary;
+    std::vector<std::string> words;
+    auto intern = [&vocabulary, &words](const std::string& token) {
+	std::pair<std::unordered_map<std::string, char32_t>::iterator, bool> result =
+	    vocabulary.insert(std::make_pair(token, static_cast<char32_t>(words.size())));
+	if (result.second) {
+	    words.push_back(token);
+	}
+	return result.first->second;
+    };
 
-	    std::list<std::string> ngram_list;
+    std::u32string ids;
+    ids.reserve(change.size());
+    for (size_t i = 0; i < change.size(); i++) {
+	ids.push_back(intern(change[i]));
+    }
 
-	    // take care of first N-1 tokens
-	    for (int i = 0;
-		 (i < curr_cardinality - 1 && change_idx < change_size);
-		 i++)
-	    {
-		ngram_list.push_back(change[change_idx]);
-		change_idx++;
-	    }
+    std::unordered_map<std::u32string, int> ngramMap;
 
-	    while (change_idx < change_size)
-	    {
-		ngram_list.push_back(change[change_idx++]);
-		ngramMap[ngram_list] = ngramMap[ngram_list] + 1;
-		ngram_list.pop_front();
-	    }
+    // build up ngram map for all cardinalities
+    // i.e. learn all ngrams and counts in memory
+    for (size_t curr_cardinality = 1;
+	 curr_cardinality < cardinality + 1;
+	 curr_cardinality++)
+    {
+	for (size_t i = 0; i + curr_cardinality <= ids.size(); i++) {
+	    ngramMap[ids.substr(i, curr_cardinality)]++;
 	}
+    }
 
-	// use (past stream - change) to learn token at the boundary
-	// change, i.e.
-	//
+    // use (past stream - change) to learn token at the boundary
+    // change, i.e.
+    //
 
-	// if change is "bar foobar", then "bar" will only occur in a
-	// 1-gram, since there are no token before it. By dipping in
-	// the past stream, we additional context to learn a 2-gram by
-	// getting extra tokens (assuming past stream ends with token
-	// "foo":
-	//
-	// <"foo", "bar"> will be learnt
-	//
-	// We do this till we build up to n equal to cardinality.
-	//
-	// First check that change is not empty (nothing to learn) and
-	// that change and past stream match by sampling first and
-	// last token in change and comparing them with corresponding
-	// tokens from past stream
+    // if change is "bar foobar", then "bar" will only occur in a
+    // 1-gram, since there are no token before it. By dipping in
+    // the past stream, we additional context to learn a 2-gram by
+    // getting extra tokens (assuming past stream ends with token
+    // "foo":
+    //
+    // <"foo", "bar"> will be learnt
+    //
+    // We do this till we build up to n equal to cardinality.
+    //
+    // First check that change is not empty (nothing to learn) and
+    // that change and past stream match by sampling first and
+    // last token in change and comparing them with corresponding
+    // tokens from past stream
+    //
+    if (change.size() > 0 &&
+	change.back() == contextTracker->getToken(1) &&
+	change.front() == contextTracker->getToken(change.size()))
+    {
+	// create ngram with first (oldest) token from change
+	std::u32string ngram(1, ids[0]);
+
+	// prepend token to ngram by grabbing extra tokens from
+	// past stream (if there are any) till we have built up to
+	// n==cardinality ngrams, and commit them to ngramMap
 	//
-	if (change.size() > 0 &&
-	    change.back() == contextTracker->getToken(1) &&
-	    change.front() == contextTracker->getToken(change.size()))
+	for (int tk_idx = 1;
+	     ngram.size() < cardinality;
+	     tk_idx++)
 	{
-	    // create ngram list with first (oldest) token from change
-	    std::list<std::string> ngram_list(change.begin(), change.begin() + 1);
-
-	    // prepend token to ngram list by grabbing extra tokens
-	    // from past stream (if there are any) till we have built
-	    // up to n==cardinality ngrams, and commit them to
-	    // ngramMap
+	    // getExtraTokenToLearn returns tokens from
+	    // past stream that come before and are not in
+	    // change vector
 	    //
-	    for (int tk_idx = 1;
-		 ngram_list.size() < cardinality;
-		 tk_idx++)
-	    {
-		// getExtraTokenToLearn returns tokens from
-		// past stream that come before and are not in
-		// change vector
-		//
-		std::string extra_token = contextTracker->getExtraTokenToLearn(tk_idx, change);
-		logger << DEBUG << "Adding extra token: " << extra_token << endl;
-
-		if (extra_token.empty())
-		{
-		    break;
-		}
-		ngram_list.push_front(extra_token);
-
-		ngramMap[ngram_list] = ngramMap[ngram_list] + 1;
-	    }
-	}
-
-	// then write out to language model database
-	try
-	{
-	    db->beginTransaction();
+	    std::string extra_token = contextTracker->getExtraTokenToLearn(tk_idx, change);
+	    PRESAGE_LOG(logger, DEBUG) << "Adding extra token: " << extra_token << endl;
 
-	    std::map<std::list<std::string>, int>::const_iterator it;
-	    for (it = ngramMap.begin(); it != ngramMap.end(); it++)
+	    if (extra_token.empty())
 	    {
-		// convert ngram from list to vector based Ngram
-		Ngram ngram((it->first).begin(), (it->first).end());
-
-		// update the counts
-		int count = db->getNgramCount(ngram);
-		if (count > 0)
-		{
-		    // ngram already in database, update count
-		    db->updateNgram(ngram, count + it->second);
-		    check_learn_consistency(ngram);
-		}
-		else
-		{
-		    // ngram not in database, insert it
-		    db->insertNgram(ngram, it->second);
-		}
+		break;
 	    }
+	    ngram.insert(ngram.begin(), intern(extra_token));
 
-	    db->endTransaction();
-	    logger << INFO << "Committed learning update to database" << endl;
-	}
-	catch (SqliteDatabaseConnector::SqliteDatabaseConnectorException& ex)
-	{
-	    db->rollbackTransaction();
-	    logger << ERROR << "Rolling back learning update : " << ex.what() << endl;
-	    throw;
+	    ngramMap[ngram]++;
 	}
     }
 
-    logger << DEBUG << "end learn()" << endl;
+    // convert ngrams back to tokens, sorted by cardinality and
+    // then by tokens, so that each table is updated in index order
+    NgramCounts ngrams;
+    ngrams.reserve(ngramMap.size());
+    for (std::unordered_map<std::u32string, int>::const_iterator it = ngramMap.begin();
+	 it != ngramMap.end();
+	 it++) {
+	Ngram ngram;
+	ngram.reserve(it->first.size());
+	for (size_t i = 0; i < it->first.size(); i++) {
+	    ngram.push_back(words[it->first[i]]);
+	}
+	ngrams.push_back(std::make_pair(ngram, it->second));
+    }
+    ngramMap.clear();
+    std::sort(ngrams.begin(), ngrams.end(),
+	      [](const std::pair<Ngram, int>& a, const std::pair<Ngram, int>& b) {
+		  if (a.first.size() != b.first.size()) {
+		      return a.first.size() < b.first.size();
+		  }
+		  return a.first < b.first;
+	      });
+
+    return ngrams;
 }
 
-void SmoothedNgramPredictor::check_learn_consistency(const Ngram& ngram) const
+void SmoothedNgramPredictor::commit_ngram_counts(DatabaseConnector* db,
+						 const NgramCounts& ngrams,
+						 const Logger<char>& logger)
 {
-    // no need to begin a new transaction, as we'll be called from
-    // within an existing transaction from learn()
-
-    // BEWARE: if the previous sentence is not true, then performance
-    // WILL suffer!
-
-    size_t size = ngram.size();
-    for (size_t i = 0; i < size; i++) {
-	if (count(ngram, -i, size - i) > count(ngram, -(i + 1), size - (i + 1))) {
-	    logger << INFO << "consistency adjustment needed!" << endl;
-
-	    int offset = -(i + 1);
-	    int sub_ngram_size = size - (i + 1);
-
-	    logger << DEBUG << "i: " << i << " | offset: " << offset << " | sub_ngram_size: " << sub_ngram_size << endl;
-
-	    Ngram sub_ngram(sub_ngram_size); // need to init to right size for sub_ngram
-	    copy(ngram.end() - sub_ngram_size + offset, ngram.end() + offset, sub_ngram.begin());
+    try
+    {
+	db->beginTransaction();
+
+	// large updates, such as a whole document learnt through
+	// Presage::learn(), show their progress when logging info
+	std::unique_ptr< ProgressBar<char> > progress;
+	if (ngrams.size() >= LEARN_PROGRESS_THRESHOLD
+	    && logger.getLevel() >= Logger<char>::INFO) {
+	    PRESAGE_LOG(logger, INFO) << "Learning " << ngrams.size() << " ngrams" << endl;
+	    progress.reset(new ProgressBar<char>(std::cerr));
+	}
 
-	    if (logger.shouldLog()) {
-		logger << "ngram to be count adjusted is: ";
-		for (size_t i = 0; i < sub_ngram.size(); i++) {
-		    logger << sub_ngram[i] << ' ';
-		}
-		logger << endl;
+	for (size_t done = 0; done < ngrams.size(); ) {
+	    size_t next = std::min(done + LEARN_BATCH_SIZE, ngrams.size());
+	    db->addNgramCounts(ngrams.begin() + done, ngrams.begin() + next);
+	    done = next;
+	    if (progress) {
+		progress->update(static_cast<double>(done) / ngrams.size());
 	    }
-
-	    db->incrementNgramCount(sub_ngram);
-	    logger << DEBUG << "consistency adjusted" << endl;
 	}
+
+	// make sure that no ngram is more frequent than its prefixes
+	db->raisePrefixCounts(ngrams);
+	progress.reset();
+
+	db->endTransaction();
+	PRESAGE_LOG(logger, INFO) << "Committed learning update to database" << endl;
+    }
+    catch (PresageException& ex)
+    {
+	db->rollbackTransaction();
+	logger << ERROR << "Rolling back learning update : " << ex.what() << endl;
+	throw;
     }
 }
 
 void SmoothedNgramPredictor::forget(const std::string& word)
 {
-    logger << INFO << "forget(\"" << word << "\")" << endl;
+    PRESAGE_LOG(logger, INFO) << "forget(\"" << word << "\")" << endl;
 
     if (learn_mode) {
 	// learning is turned on
+	invalidate_prediction_state();
         db->beginTransaction();
         db->dropNgramsWithWord(word);
 
@@ -526,11 +754,10 @@ void SmoothedNgramPredictor::forget(const std::string& word)
         db->endTransaction();
     }
     
-    logger << DEBUG << "end forget()" << endl;
+    PRESAGE_LOG(logger, DEBUG) << "end forget()" << endl;
 }
 
 void SmoothedNgramPredictor::update (const Observable* var)
 {
-    logger << DEBUG << "About to invoke dispatcher: " << var->get_name () << " - " << var->get_value() << endl;
-    dispatcher.dispatch (var);
+    dispatch (dispatcher, var);
 }
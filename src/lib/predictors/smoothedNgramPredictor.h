@@ -31,6 +31,7 @@
 #include "dbconnector/sqliteDatabaseConnector.h"
 
 #include <assert.h>
+#include <set>
 
 #if defined(HAVE_SQLITE3_H) 
 # include <sqlite3.h>
@@ -57,6 +58,23 @@ public:
 
     virtual void update (const Observable* variable);
 
+    /** Counts the ngrams of up to cardinality tokens in change, and
+     *  those joining its first token to the past stream tokens that
+     *  precede it, sorted by cardinality and then by tokens.
+     */
+    static NgramCounts count_ngrams (const std::vector<std::string>& change,
+				     const size_t cardinality,
+				     const ContextTracker* contextTracker,
+				     const Logger<char>& logger);
+
+    /** Adds the ngram counts to the database, then raises the counts
+     *  of their prefixes, in one transaction that is rolled back on
+     *  error.
+     */
+    static void commit_ngram_counts (DatabaseConnector* db,
+				     const NgramCounts& ngrams,
+				     const Logger<char>& logger);
+
 private:
     std::string LOGGER;
     std::string DBFILENAME;
@@ -66,7 +84,6 @@ private:
     std::string DATABASE_LOGGER;
 
     unsigned int count(const std::vector<std::string>& tokens, int offset, int ngram_size) const;
-    void check_learn_consistency(const Ngram& name) const;
 
     void set_dbfilename (const std::string& filename);
     void set_deltas (const std::string& deltas);
@@ -76,6 +93,11 @@ private:
 
     void init_database_connector_if_ready ();
 
+    bool is_prediction_state_valid (const std::vector<std::string>& tokens, const char** filter) const;
+    bool narrow_prediction_state (const std::vector<std::string>& tokens, const char** filter) const;
+    void reset_prediction_state (const std::vector<std::string>& tokens, const char** filter) const;
+    void invalidate_prediction_state ();
+
     DatabaseConnector*  db;
     std::string         dbfilename;
     std::string         dbloglevel;
@@ -85,6 +107,35 @@ private:
     bool                learn_mode;
     bool                learn_mode_set;
 
+    /** Candidates computed by the last call to predict().
+     *
+     * When predict() is invoked again for the same context, filter
+     * and count threshold, the candidates found so far are reused and
+     * only the missing ones are fetched from the database, resuming
+     * each n-gram table query where the previous call left off.
+     *
+     * When one more character of the same word has been entered, the
+     * candidates are narrowed down to those matching the longer
+     * prefix instead.
+     */
+    struct PredictionState {
+	bool                     valid;
+	std::vector<std::string> tokens;
+	std::vector<std::string> filter;
+	bool                     filtered;
+	int                      count_threshold;
+
+	std::vector<std::string> candidates;
+	std::set<std::string>    known;
+	std::vector<double>      probabilities;
+	std::vector<int>         denominators; // counts of the candidate contexts
+
+	// words read from each n-gram table, and whether all have been read
+	std::vector< std::vector<std::string> > rows;
+	std::vector<bool>                       exhausted;
+    };
+    mutable PredictionState state;
+
     Dispatcher<SmoothedNgramPredictor> dispatcher;
 };
 
@@ -25,9 +25,11 @@
 
 
 #include "smoothedNgramTriePredictor.h"
+#include "smoothedNgramPredictor.h"
 
 #include <sstream>
 #include <algorithm>
+#include <map>
 
 
 SmoothedNgramTriePredictor::SmoothedNgramTriePredictor(Configuration* config, ContextTracker* ct, const char* name)
@@ -37,15 +39,20 @@ SmoothedNgramTriePredictor::SmoothedNgramTriePredictor(Configuration* config, Co
               "SmoothedNgramTriePredictor, a linear interpolating n-gram predictor",
               "SmoothedNgramTriePredictor, long description." ),
     db (0),
-    count_threshold (0),
     cardinality (0),
+    count_threshold (0),
+    learn_mode (false),
+    learn_mode_set (false),
     dispatcher (this)
 {
+  state.valid = false;
+
   LOGGER          = PREDICTORS + name + ".LOGGER";
   DBFILENAME      = PREDICTORS + name + ".DBFILENAME";
   DELTAS          = PREDICTORS + name + ".DELTAS";
   COUNT_THRESHOLD = PREDICTORS + name + ".COUNT_THRESHOLD";
   DATABASE_LOGGER = PREDICTORS + name + ".DatabaseConnector.LOGGER";
+  LEARN           = PREDICTORS + name + ".LEARN";
 
   // build notification dispatch map
   dispatcher.map (config->find (LOGGER), & SmoothedNgramTriePredictor::set_logger);
@@ -53,6 +60,7 @@ SmoothedNgramTriePredictor::SmoothedNgramTriePredictor(Configuration* config, Co
   dispatcher.map (config->find (DBFILENAME), & SmoothedNgramTriePredictor::set_dbfilename);
   dispatcher.map (config->find (DELTAS), & SmoothedNgramTriePredictor::set_deltas);
   dispatcher.map (config->find (COUNT_THRESHOLD), & SmoothedNgramTriePredictor::set_count_threshold);
+  dispatcher.map (config->find (LEARN), & SmoothedNgramTriePredictor::set_learn);
 }
 
 
@@ -66,7 +74,7 @@ SmoothedNgramTriePredictor::~SmoothedNgramTriePredictor()
 void SmoothedNgramTriePredictor::set_dbfilename (const std::string& filename)
 {
   dbfilename = filename;
-  logger << INFO << "DBFILENAME: " << dbfilename << endl;
+  PRESAGE_LOG(logger, INFO) << "DBFILENAME: " << dbfilename << endl;
 
   this->init_database_connector_if_ready ();
 }
@@ -84,12 +92,14 @@ void SmoothedNgramTriePredictor::set_deltas (const std::string& value)
   cardinality = 0;
   std::string delta;
   while (ss_deltas >> delta) {
-    logger << DEBUG << "Pushing delta: " << delta << endl;
+    PRESAGE_LOG(logger, DEBUG) << "Pushing delta: " << delta << endl;
     deltas.push_back (Utility::toDouble (delta));
     cardinality++;
   }
-  logger << INFO << "DELTAS: " << value << endl;
-  logger << INFO << "CARDINALITY: " << cardinality << endl;
+  PRESAGE_LOG(logger, INFO) << "DELTAS: " << value << endl;
+  PRESAGE_LOG(logger, INFO) << "CARDINALITY: " << cardinality << endl;
+
+  invalidate_prediction_state ();
 
   this->init_database_connector_if_ready ();
 }
@@ -98,7 +108,18 @@ void SmoothedNgramTriePredictor::set_deltas (const std::string& value)
 void SmoothedNgramTriePredictor::set_count_threshold (const std::string& value)
 {
   count_threshold = Utility::toInt (value);
-  logger << INFO << "COUNT_THRESHOLD: " << count_threshold << endl;
+  PRESAGE_LOG(logger, INFO) << "COUNT_THRESHOLD: " << count_threshold << endl;
+}
+
+
+void SmoothedNgramTriePredictor::set_learn (const std::string& value)
+{
+  learn_mode = Utility::isYes (value);
+  PRESAGE_LOG(logger, INFO) << "LEARN: " << value << endl;
+
+  learn_mode_set = true;
+
+  this->init_database_connector_if_ready ();
 }
 
 
@@ -112,26 +133,157 @@ void SmoothedNgramTriePredictor::init_database_connector_if_ready ()
   //    read/write mode (learning requires read/write access)
   //
   if (! dbfilename.empty()
-      && cardinality > 0) {
+      && cardinality > 0
+      && learn_mode_set) {
 
     delete db;
+    invalidate_prediction_state ();
 
     if (dbloglevel.empty ()) {
       // open database connector
       db = new TrieDatabaseConnector(dbfilename,
                                      cardinality,
-                                     false);
+                                     learn_mode);
     } else {
       // open database connector with logger lever
       db = new TrieDatabaseConnector(dbfilename,
                                      cardinality,
-                                     false,
+                                     learn_mode,
                                      dbloglevel);
     }
   }
 }
 
 
+bool SmoothedNgramTriePredictor::is_prediction_state_valid (const std::vector<std::string>& tokens, const char** filter) const
+{
+  if (! state.valid
+      || state.tokens != tokens
+      || state.count_threshold != count_threshold
+      || state.filtered != (filter != 0)) {
+    return false;
+  }
+
+  if (filter) {
+    size_t i = 0;
+    for (; filter[i] != 0; i++) {
+      if (i >= state.filter.size() || state.filter[i] != filter[i]) {
+        return false;
+      }
+    }
+    if (i != state.filter.size()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+/** Narrows the candidates of the previous prediction down to the ones
+ *  matching a longer prefix.
+ *
+ * When one more character of the same word has been entered, the words
+ * matching the new prefix are a subset of those that matched the
+ * previous one, in the same order, and their probabilities do not
+ * depend on the prefix. The words read from each n-gram order are
+ * filtered, so that only those that were not read yet need to be
+ * looked up in the trie.
+ *
+ * \return false if the context does not extend the previous one
+ */
+bool SmoothedNgramTriePredictor::narrow_prediction_state (const std::vector<std::string>& tokens, const char** filter) const
+{
+  // filter strings are appended to the prefix in the search, so a
+  // longer prefix would not select a subset of the previous words
+  if (! state.valid
+      || tokens.empty()
+      || filter != 0
+      || state.filtered
+      || state.count_threshold != count_threshold
+      || state.tokens.size() != tokens.size()
+      || state.probabilities.size() != state.candidates.size()
+      || ! std::equal(tokens.begin(), tokens.end() - 1, state.tokens.begin())) {
+    return false;
+  }
+
+  const std::string& prefix = tokens.back();
+  const std::string& previous_prefix = state.tokens.back();
+  if (prefix.size() <= previous_prefix.size()
+      || prefix.compare(0, previous_prefix.size(), previous_prefix) != 0) {
+    return false;
+  }
+
+  PRESAGE_LOG(logger, DEBUG) << "Narrowing candidates from prefix " << previous_prefix << " to " << prefix << endl;
+
+  std::map<std::string, double> probabilities;
+  for (size_t j = 0; j < state.candidates.size(); j++) {
+    probabilities[state.candidates[j]] = state.probabilities[j];
+  }
+
+  state.tokens = tokens;
+  state.candidates.clear();
+  state.known.clear();
+  state.probabilities.clear();
+
+  // words from a lower order are only candidates once all the words
+  // from the higher orders have been read
+  bool complete = true;
+  for (size_t k = cardinality; k > 0; k--) {
+    std::vector<std::string>& rows = state.rows[k - 1];
+    if (! complete) {
+      rows.clear();
+      state.exhausted[k - 1] = false;
+      continue;
+    }
+
+    std::vector<std::string> narrowed;
+    for (std::vector<std::string>::const_iterator it = rows.cbegin(); it != rows.cend(); ++it) {
+      if (it->compare(0, prefix.size(), prefix) == 0) {
+        narrowed.push_back(*it);
+        if (state.known.insert(*it).second) {
+          state.candidates.push_back(*it);
+          state.probabilities.push_back(probabilities[*it]);
+        }
+      }
+    }
+    rows.swap(narrowed);
+
+    complete = state.exhausted[k - 1];
+  }
+
+  return true;
+}
+
+
+void SmoothedNgramTriePredictor::reset_prediction_state (const std::vector<std::string>& tokens, const char** filter) const
+{
+  state.valid = true;
+  state.tokens = tokens;
+  state.filter.clear();
+  state.filtered = (filter != 0);
+  if (filter) {
+    for (size_t i = 0; filter[i] != 0; i++) {
+      state.filter.push_back(filter[i]);
+    }
+  }
+  state.count_threshold = count_threshold;
+
+  state.candidates.clear();
+  state.known.clear();
+  state.probabilities.clear();
+  state.rows.assign(cardinality, std::vector<std::string>());
+  state.exhausted.assign(cardinality, false);
+  state.denominators.clear();
+}
+
+
+void SmoothedNgramTriePredictor::invalidate_prediction_state ()
+{
+  state.valid = false;
+}
+
+
 // convenience function to convert ngram to string
 //
 static std::string ngram_to_string(const Ngram& ngram)
@@ -176,10 +328,10 @@ unsigned int SmoothedNgramTriePredictor::count(const std::vector<std::string>& t
     Ngram ngram(ngram_size);
     copy(tokens.end() - ngram_size + offset , tokens.end() + offset, ngram.begin());
     result = db->getNgramCount(ngram);
-    logger << DEBUG << "count ngram: " << ngram_to_string (ngram) << " : " << result << endl;
+    PRESAGE_LOG(logger, DEBUG) << "count ngram: " << ngram_to_string (ngram) << " : " << result << endl;
   } else {
     result = db->getUnigramCountsSum();
-    logger << DEBUG << "unigram counts sum: " << result << endl;
+    PRESAGE_LOG(logger, DEBUG) << "unigram counts sum: " << result << endl;
   }
 
   return result;
@@ -187,7 +339,7 @@ unsigned int SmoothedNgramTriePredictor::count(const std::vector<std::string>& t
 
 Prediction SmoothedNgramTriePredictor::predict(const size_t max_partial_prediction_size, const char** filter) const
 {
-  logger << DEBUG << "predict()" << endl;
+  PRESAGE_LOG(logger, DEBUG) << "predict()" << endl;
 
   // Result prediction
   Prediction prediction;
@@ -199,7 +351,7 @@ Prediction SmoothedNgramTriePredictor::predict(const size_t max_partial_predicti
   std::vector<std::string> tokens(cardinality);
   for (int i = 0; i < cardinality; i++) {
     tokens[cardinality - 1 - i] = contextTracker->getToken(i);
-    logger << DEBUG << "Cached tokens[" << cardinality - 1 - i << "] = " << tokens[cardinality - 1 - i] << endl;
+    PRESAGE_LOG(logger, DEBUG) << "Cached tokens[" << cardinality - 1 - i << "] = " << tokens[cardinality - 1 - i] << endl;
   }
 
   // Generate list of prefix completition candidates.
@@ -214,38 +366,68 @@ Prediction SmoothedNgramTriePredictor::predict(const size_t max_partial_predicti
   // n-gram table, falling back on lower order n-gram tables if
   // initial completion set is smaller than required.
   //
-  std::vector<std::string> prefixCompletionCandidates;
-  for (size_t k = cardinality; (k > 0 && prefixCompletionCandidates.size() < max_partial_prediction_size); k--) {
-    logger << DEBUG << "Building partial prefix completion table of cardinality: " << k << endl;
+  // Candidates found by the previous call are reused if the context
+  // has not changed since, so that asking for more suggestions only
+  // fetches the ones that are missing, or narrowed down if the prefix
+  // has grown.
+  //
+  if (! is_prediction_state_valid(tokens, filter)
+      && ! narrow_prediction_state(tokens, filter)) {
+    reset_prediction_state(tokens, filter);
+  }
+  std::vector<std::string>& prefixCompletionCandidates = state.candidates;
+  const size_t known_candidates = prefixCompletionCandidates.size();
+
+  // Duplicates may leave room for more candidates after an order
+  // has been searched, in which case it is searched further until
+  // it is exhausted.
+  //
+  size_t k = cardinality;
+  while (k > 0 && prefixCompletionCandidates.size() < max_partial_prediction_size) {
+    if (state.exhausted[k - 1]) {
+      // all matching k-grams have been read, fall back on
+      // lower order n-grams
+      k--;
+      continue;
+    }
+
+    PRESAGE_LOG(logger, DEBUG) << "Building partial prefix completion table of cardinality: " << k << endl;
     // create n-gram used to retrieve initial prefix completion table
     Ngram prefix_ngram(k);
     copy(tokens.end() - k, tokens.end(), prefix_ngram.begin());
 
-    if (logger.shouldLog()) {
-      logger << DEBUG << "prefix_ngram: ";
+    if ((logger << DEBUG).shouldLog()) {
+      logger << "prefix_ngram: ";
       for (size_t r = 0; r < prefix_ngram.size(); r++) {
-        logger << DEBUG << prefix_ngram[r] << ' ';
+        logger << prefix_ngram[r] << ' ';
       }
-      logger << DEBUG << endl;
+      logger << endl;
     }
 
-    // obtain initial prefix completion candidates
+    // obtain initial prefix completion candidates, skipping the
+    // rows read by previous calls
     std::vector<std::string> partial;
+    size_t limit = max_partial_prediction_size - prefixCompletionCandidates.size();
 
     partial = db->getPredictedWords(prefix_ngram,
                                     filter,
                                     count_threshold,
-                                    max_partial_prediction_size - prefixCompletionCandidates.size());
-    
-    if (logger.shouldLog()) {
-      logger << DEBUG << "partial prefixCompletionCandidates" << endl
-             << DEBUG << "----------------------------------" << endl;
+                                    limit,
+                                    state.rows[k - 1].size());
+
+    if (partial.size() < limit) {
+      state.exhausted[k - 1] = true;
+    }
+
+    if ((logger << DEBUG).shouldLog()) {
+      logger << "partial prefixCompletionCandidates" << endl
+             << "----------------------------------" << endl;
       for (size_t j = 0; j < partial.size(); j++) {
-        logger << DEBUG << partial[j] << "\n";
+        logger << partial[j] << endl;
       }
     }
 
-    logger << DEBUG << "Partial prefix completion table contains " << partial.size() << " potential completions." << endl;
+    PRESAGE_LOG(logger, DEBUG) << "Partial prefix completion table contains " << partial.size() << " potential completions." << endl;
 
     // append newly discovered potential completions to prefix
     // completion candidates array to fill it up to
@@ -254,78 +436,138 @@ Prediction SmoothedNgramTriePredictor::predict(const size_t max_partial_predicti
     std::vector<std::string>::const_iterator it = partial.cbegin();
     while (it != partial.cend() && prefixCompletionCandidates.size() < max_partial_prediction_size) {
       const std::string &candidate = (*it);
-      if (find(prefixCompletionCandidates.begin(),
-               prefixCompletionCandidates.end(),
-               candidate) == prefixCompletionCandidates.end()) {
+      if (state.known.insert(candidate).second) {
         prefixCompletionCandidates.push_back(candidate);
       }
       it++;
     }
+    state.rows[k - 1].insert(state.rows[k - 1].end(), partial.cbegin(), it);
   }
 
-  if (logger.shouldLog()) {
-    logger << DEBUG << "prefixCompletionCandidates" << endl
-           << DEBUG << "--------------------------" << endl;
+  if ((logger << DEBUG).shouldLog()) {
+    logger << "prefixCompletionCandidates" << endl
+           << "--------------------------" << endl;
     for (size_t j = 0; j < prefixCompletionCandidates.size(); j++) {
-      logger << DEBUG << prefixCompletionCandidates[j] << endl;
+      logger << prefixCompletionCandidates[j] << endl;
     }
   }
 
-  // compute smoothed probabilities for all candidates
-  int unigrams_counts_sum = db->getUnigramCountsSum(); 
-  for (size_t j = 0; (j < prefixCompletionCandidates.size() && j < max_partial_prediction_size); j++) {
-    // store w_i candidate at end of tokens
-    tokens[cardinality - 1] = prefixCompletionCandidates[j];
-
-    logger << DEBUG << "------------------" << endl;
-    logger << DEBUG << "w_i: " << tokens[cardinality - 1] << endl;
+  // compute smoothed probabilities for the new candidates
+  //
+  if (prefixCompletionCandidates.size() > known_candidates) {
+    // denominators do not depend on the candidate w_i, so they
+    // are only looked up once per context.
+    //
+    // denominators[k] is the count of the k-gram context of the
+    // (k+1)-gram ending with the candidate
+    if (state.denominators.empty()) {
+      int unigrams_counts_sum = db->getUnigramCountsSum();
+
+      state.denominators.resize(cardinality);
+      for (int k = 0; k < cardinality; k++) {
+        // reuse cached unigrams_counts_sum to speed things up
+        state.denominators[k] = (k == 0 ? unigrams_counts_sum : count(tokens, -1, k));
+      }
+    }
 
-    double probability = 0;
+    // fetch the counts for all new candidates at once, one batch
+    // per order.
+    //
+    // numerators[k][j] is the count of the (k+1)-gram ending with
+    // new candidate j
+    std::vector<std::string> candidates(prefixCompletionCandidates.begin() + known_candidates,
+                                        prefixCompletionCandidates.end());
+    std::vector< std::vector<int> > numerators(cardinality);
     for (int k = 0; k < cardinality; k++) {
-      double numerator = count(tokens, 0, k+1);
-      // reuse cached unigrams_counts_sum to speed things up
-      double denominator = (k == 0 ? unigrams_counts_sum : count(tokens, -1, k));
-      // probably not a proper fix, but done to go around some cases where denominator < numerator
-      // double frequency = ((denominator > 0) ? (numerator / denominator) : 0);
-      double frequency = ((denominator > 0 && denominator >= numerator) ? (numerator / denominator) : 0);
-      probability += deltas[k] * frequency;
-
-      logger << DEBUG << "numerator:   " << numerator << endl;
-      logger << DEBUG << "denominator: " << denominator << endl;
-      logger << DEBUG << "frequency:   " << frequency << endl;
-      logger << DEBUG << "delta:       " << deltas[k] << endl;
-
-      // for some sanity checks
-      // these assertions fail occasionally. to fix, the calculation of frequency was adjusted above
-      //assert(numerator <= denominator);
-      assert(frequency <= 1);
+      Ngram context(k);
+      copy(tokens.end() - 1 - k, tokens.end() - 1, context.begin());
+      numerators[k] = db->getNgramCounts(context, candidates);
     }
 
-    logger << DEBUG << "____________" << endl;
-    logger << DEBUG << "probability: " << probability << endl;
+    for (size_t j = 0; j < candidates.size(); j++) {
+      PRESAGE_LOG(logger, DEBUG) << "------------------" << endl;
+      PRESAGE_LOG(logger, DEBUG) << "w_i: " << candidates[j] << endl;
+
+      double probability = 0;
+      for (int k = 0; k < cardinality; k++) {
+        double numerator = numerators[k][j];
+        double denominator = state.denominators[k];
+        // probably not a proper fix, but done to go around some cases where denominator < numerator
+        // double frequency = ((denominator > 0) ? (numerator / denominator) : 0);
+        double frequency = ((denominator > 0 && denominator >= numerator) ? (numerator / denominator) : 0);
+        probability += deltas[k] * frequency;
+
+        PRESAGE_LOG(logger, DEBUG) << "numerator:   " << numerator << endl;
+        PRESAGE_LOG(logger, DEBUG) << "denominator: " << denominator << endl;
+        PRESAGE_LOG(logger, DEBUG) << "frequency:   " << frequency << endl;
+        PRESAGE_LOG(logger, DEBUG) << "delta:       " << deltas[k] << endl;
+
+        // for some sanity checks
+        // these assertions fail occasionally. to fix, the calculation of frequency was adjusted above
+        //assert(numerator <= denominator);
+        assert(frequency <= 1);
+      }
+
+      PRESAGE_LOG(logger, DEBUG) << "____________" << endl;
+      PRESAGE_LOG(logger, DEBUG) << "probability: " << probability << endl;
+
+      state.probabilities.push_back(probability);
+    }
+  }
 
-    if (probability > 0) {
-      prediction.addSuggestion(Suggestion(tokens[cardinality - 1], probability));
+  for (size_t j = 0; (j < prefixCompletionCandidates.size() && j < max_partial_prediction_size); j++) {
+    if (state.probabilities[j] > 0) {
+      prediction.addSuggestion(Suggestion(prefixCompletionCandidates[j], state.probabilities[j]));
     }
   }
 
-  logger << DEBUG << "Prediction:" << endl;
-  logger << DEBUG << "-----------" << endl;
-  logger << DEBUG << prediction << endl;
+  PRESAGE_LOG(logger, DEBUG) << "Prediction:" << endl;
+  PRESAGE_LOG(logger, DEBUG) << "-----------" << endl;
+  PRESAGE_LOG(logger, DEBUG) << prediction << endl;
 
   return prediction;
 }
 
 void SmoothedNgramTriePredictor::learn(const std::vector<std::string>& change)
 {
+  PRESAGE_LOG(logger, INFO) << "learn(\"" << ngram_to_string(change) << "\")" << endl;
+
+  if (learn_mode) {
+    // learning is turned on
+    invalidate_prediction_state();
+
+    // counted and written out as by SmoothedNgramPredictor, the
+    // connector keeps the counts on top of the trie
+    SmoothedNgramPredictor::commit_ngram_counts(db,
+                                                SmoothedNgramPredictor::count_ngrams(change, cardinality,
+                                                                                     contextTracker, logger),
+                                                logger);
+  }
+
+  PRESAGE_LOG(logger, DEBUG) << "end learn()" << endl;
 }
 
 void SmoothedNgramTriePredictor::forget(const std::string& word)
 {
+  PRESAGE_LOG(logger, INFO) << "forget(\"" << word << "\")" << endl;
+
+  if (learn_mode) {
+    // learning is turned on
+    invalidate_prediction_state();
+    db->beginTransaction();
+    db->dropNgramsWithWord(word);
+
+    std::string word_normalized = Utility::strtolower(word);
+    if (word_normalized != word)
+      db->dropNgramsWithWord(word_normalized);
+
+    db->endTransaction();
+  }
+
+  PRESAGE_LOG(logger, DEBUG) << "end forget()" << endl;
 }
 
 void SmoothedNgramTriePredictor::update (const Observable* var)
 {
-  logger << DEBUG << "About to invoke dispatcher: " << var->get_name () << " - " << var->get_value() << endl;
-  dispatcher.dispatch (var);
+  dispatch (dispatcher, var);
 }
@@ -33,6 +33,7 @@
 #include "dbconnector/trieDatabaseConnector.h"
 
 #include <assert.h>
+#include <set>
 
 /** Smoothed n-gram statistical predictor.
  *
@@ -44,10 +45,10 @@ public:
 
   virtual Prediction predict(const size_t size, const char** filter) const;
 
-  // no-op
+  // learnt n-grams are kept on top of the trie by the database
+  // connector, see TrieDatabaseConnector
   virtual void learn(const std::vector<std::string>& change);
 
-  // no-op
   virtual void forget(const std::string& word);
 
   virtual void update (const Observable* variable);
@@ -62,6 +63,14 @@ private:
   void set_deltas (const std::string& deltas);
   void set_count_threshold (const std::string& value);
   void set_database_logger_level (const std::string& level);
+  void set_learn (const std::string& learn_mode);
+
+  bool is_prediction_state_valid (const std::vector<std::string>& tokens, const char** filter) const;
+  bool narrow_prediction_state (const std::vector<std::string>& tokens, const char** filter) const;
+  void reset_prediction_state (const std::vector<std::string>& tokens, const char** filter) const;
+
+protected:
+  void invalidate_prediction_state ();
 
 protected:
   TrieDatabaseConnector*  db;
@@ -73,12 +82,44 @@ protected:
   std::string DELTAS;
   std::string COUNT_THRESHOLD;
   std::string DATABASE_LOGGER;
+  std::string LEARN;
 
   size_t              cardinality; // cardinality == what is the n in n-gram?
 
 private:
   std::vector<double> deltas;
   int                 count_threshold;
+  bool                learn_mode;
+  bool                learn_mode_set;
+
+  /** Candidates computed by the last call to predict().
+   *
+   * When predict() is invoked again for the same context, filter
+   * and count threshold, the candidates found so far are reused and
+   * only the missing ones are looked up in the trie, resuming each
+   * n-gram search where the previous call left off.
+   *
+   * When one more character of the same word has been entered, the
+   * candidates are narrowed down to those matching the longer
+   * prefix instead.
+   */
+  struct PredictionState {
+    bool                     valid;
+    std::vector<std::string> tokens;
+    std::vector<std::string> filter;
+    bool                     filtered;
+    int                      count_threshold;
+
+    std::vector<std::string> candidates;
+    std::set<std::string>    known;
+    std::vector<double>      probabilities;
+    std::vector<int>         denominators; // counts of the candidate contexts
+
+    // words read from each n-gram order, and whether all have been read
+    std::vector< std::vector<std::string> > rows;
+    std::vector<bool>                       exhausted;
+  };
+  mutable PredictionState state;
 
   Dispatcher<SmoothedNgramTriePredictor> dispatcher;
 };
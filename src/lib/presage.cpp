@@ -29,6 +29,47 @@
 #include "core/context_tracker/contextTracker.h"
 #include "core/selector.h"
 #include "core/predictorActivator.h"
+#include "core/predictionCache.h"
+#include "core/learner.h"
+
+#include <string.h>
+
+namespace {
+
+/** Holds a ContextTracker token snapshot for the lifetime of the
+ *  object, so that predictors share one tokenization of the past
+ *  stream and the snapshot is released if a predictor throws.
+ */
+class TokenSnapshot {
+public:
+    TokenSnapshot(ContextTracker* tracker) : m_tracker(tracker) { m_tracker->beginTokenSnapshot(); }
+    ~TokenSnapshot() { m_tracker->endTokenSnapshot(); }
+
+private:
+    ContextTracker* m_tracker;
+};
+
+/** Returns the combined prediction for the current context, running
+ *  the predictors only if it is not found in the cache.
+ */
+Prediction cached_predict(PredictorActivator* activator,
+			  PredictionCache* cache,
+			  const unsigned int multiplier,
+			  const char** filter)
+{
+    Prediction prediction;
+    if (! cache->lookup(multiplier, filter, prediction)) {
+	prediction = activator->predict(multiplier, filter);
+	// a prediction that some predictors did not contribute to in
+	// time is not worth keeping
+	if (activator->getLatePredictors().empty()) {
+	    cache->insert(multiplier, filter, prediction);
+	}
+    }
+    return prediction;
+}
+
+}
 
 Presage::Presage (PresageCallback* callback)
     noexcept(false)
@@ -38,6 +79,8 @@ Presage::Presage (PresageCallback* callback)
     predictorRegistry = new PredictorRegistry(configuration);
     contextTracker = new ContextTracker(configuration, predictorRegistry, callback);
     predictorActivator = new PredictorActivator(configuration, predictorRegistry, contextTracker);
+    predictionCache = new PredictionCache(configuration, contextTracker);
+    learner = new Learner(configuration, contextTracker);
     selector = new Selector(configuration, contextTracker);
 }
 
@@ -49,12 +92,16 @@ Presage::Presage (PresageCallback* callback, const std::string config_filename)
     predictorRegistry = new PredictorRegistry(configuration);
     contextTracker = new ContextTracker(configuration, predictorRegistry, callback);
     predictorActivator = new PredictorActivator(configuration, predictorRegistry, contextTracker);
+    predictionCache = new PredictionCache(configuration, contextTracker);
+    learner = new Learner(configuration, contextTracker);
     selector = new Selector(configuration, contextTracker);
 }
 
 Presage::~Presage()
 {
+    delete learner;
     delete selector;
+    delete predictionCache;
     delete predictorActivator;
     delete contextTracker;
     delete predictorRegistry;
@@ -66,13 +113,15 @@ std::vector<std::string> Presage::predict ()
 {
     std::vector<std::string> result;
 
+    TokenSnapshot snapshot(contextTracker);
+
     unsigned int multiplier = 1;
-    Prediction prediction = predictorActivator->predict(multiplier++, 0);
+    Prediction prediction = cached_predict(predictorActivator, predictionCache, multiplier++, 0);
     result = selector->select(prediction);
 
     Prediction previous_prediction = prediction;
     while ((result.size() < (selector->get_suggestions()))
-	   && (prediction = predictorActivator->predict(multiplier++, 0)).size() > previous_prediction.size()) {
+	   && (prediction = cached_predict(predictorActivator, predictionCache, multiplier++, 0)).size() > previous_prediction.size()) {
 	// while the number of predicted tokens is lower than desired,
 	// search harder (i.e. higher multiplier) for a prediction of
 	// sufficient size (i.e. that satisfies selector), as long as
@@ -105,13 +154,15 @@ std::multimap<double, std::string> Presage::predict (std::vector<std::string> fi
 	internal_filter[filter.size()] = 0;
     }
 
+    TokenSnapshot snapshot(contextTracker);
+
     unsigned int multiplier = 1;
-    Prediction prediction = predictorActivator->predict(multiplier++, internal_filter);
+    Prediction prediction = cached_predict(predictorActivator, predictionCache, multiplier++, internal_filter);
     selection = selector->select(prediction);
 
     Prediction previous_prediction = prediction;
     while ((selection.size() < (selector->get_suggestions()))
-	   && (prediction = predictorActivator->predict(multiplier++, internal_filter)).size() > previous_prediction.size()) {
+	   && (prediction = cached_predict(predictorActivator, predictionCache, multiplier++, internal_filter)).size() > previous_prediction.size()) {
 	// while the number of predicted tokens is lower than desired,
 	// search harder (i.e. higher multiplier) for a prediction of
 	// sufficient size (i.e. that satisfies selector), as long as
@@ -139,6 +190,8 @@ std::multimap<double, std::string> Presage::predict (std::vector<std::string> fi
 void Presage::learn(const std::string text) const
     noexcept(false)
 {
+    // learn after the changes queued so far
+    learner->flush();
     contextTracker->learn(text); // TODO: can pass additional param to
 				 // learn to specify offline learning
 }
@@ -146,12 +199,14 @@ void Presage::learn(const std::string text) const
 void Presage::forget(const std::string word) const
     noexcept(false)
 {
+    learner->flush();
     contextTracker->forget(word);
 }
 
 PresageCallback* Presage::callback (PresageCallback* callback)
     noexcept(false)
 {
+    predictionCache->clear();
     return const_cast<PresageCallback*>(contextTracker->callback(callback));
 }
 
@@ -230,7 +285,12 @@ std::string Presage::config (const std::string variable) const
 void Presage::config (const std::string variable, const std::string value) const
     noexcept(false)
 {
+    // predictors must not be reconfigured while they learn
+    learner->flush();
     configuration->insert (variable, value);
+
+    // predictions computed with the previous configuration are stale
+    predictionCache->clear();
 }
 
 void Presage::save_config () const
@@ -275,6 +335,14 @@ public:
     return (*m_get_future_stream_cb) (m_get_future_stream_cb_arg);
   }
 
+  std::string get_past_stream_tail(size_t max_size, size_t& offset) const {
+    // copy just the tail of the past stream
+    const char* past_stream = (*m_get_past_stream_cb) (m_get_past_stream_cb_arg);
+    size_t size = strlen (past_stream);
+    offset = (size > max_size ? size - max_size : 0);
+    return std::string (past_stream + offset, size - offset);
+  }
+
 private:
   _presage_callback_get_past_stream   m_get_past_stream_cb;
   void*                               m_get_past_stream_cb_arg;
@@ -100,6 +100,8 @@ class Profile;
 class ContextTracker;
 class PredictorRegistry;
 class PredictorActivator;
+class PredictionCache;
+class Learner;
 class Selector;
 
 /** \brief Presage, the intelligent predictive text entry platform.
@@ -266,6 +268,8 @@ private:
     PredictorRegistry*  predictorRegistry;
     ContextTracker*     contextTracker;
     PredictorActivator* predictorActivator;
+    PredictionCache*    predictionCache;
+    Learner*            learner;
     Selector*           selector;
 
 };
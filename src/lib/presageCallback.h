@@ -62,6 +62,11 @@ extern "C" {
  * getFutureStream() must return a string containing the text
  * following the current insertion point.
  *
+ * Presage mostly needs the text just before the insertion point.
+ * Callbacks holding large documents may override
+ * get_past_stream_tail() to hand over just that, rather than a copy
+ * of the whole past stream.
+ *
  */ 
 class PresageCallback {
 public:
@@ -70,6 +75,18 @@ public:
     virtual std::string get_past_stream() const = 0;
     virtual std::string get_future_stream() const = 0;
 
+    /** Returns the last max_size characters of the past stream, or
+     *  the whole past stream if it is shorter, and sets offset to the
+     *  position in the past stream of the first character returned.
+     *
+     * The default implementation takes them from get_past_stream().
+     */
+    virtual std::string get_past_stream_tail(size_t max_size, size_t& offset) const {
+        std::string past_stream = get_past_stream();
+        offset = (past_stream.size() > max_size ? past_stream.size() - max_size : 0);
+        return past_stream.substr(offset);
+    }
+
 protected:
     PresageCallback() { };
 
@@ -98,6 +115,10 @@ public:
     
     std::string get_past_stream() const { return m_stream; }
     std::string get_future_stream() const { return m_empty; }
+    std::string get_past_stream_tail(size_t max_size, size_t& offset) const {
+        offset = (m_stream.size() > max_size ? m_stream.size() - max_size : 0);
+        return m_stream.substr(offset);
+    }
 
     void update(std::string str) { for (size_t sz = 0; sz < str.size(); sz++) { update(str[sz]); } }
 
@@ -0,0 +1,162 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#include "config.h"
+
+#include <iostream>
+#include <string>
+
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+
+#include <getopt.h>
+
+#include "predictors/ARPAModel.h"
+#include "presageException.h"
+
+const std::string PROGRAM_NAME = "arpa2bin";
+
+void usage();
+void version();
+
+int main(int argc, char* argv[])
+{
+    int next_option;
+
+    std::string output;
+    std::string vocabulary;
+    int order = 0;
+
+    // getopt structures
+    const char * const  short_options  = "o:V:n:hv";
+    const struct option long_options[] =
+	{
+	    { "output",     required_argument, 0, 'o' },
+	    { "vocabulary", required_argument, 0, 'V' },
+	    { "ngrams",     required_argument, 0, 'n' },
+	    { "help",       no_argument,       0, 'h' },
+	    { "version",    no_argument,       0, 'v' },
+	    { 0,            0,                 0, 0   }
+	};
+
+    do {
+	next_option = getopt_long(argc,
+				  argv,
+				  short_options,
+				  long_options,
+				  NULL);
+
+	switch (next_option) {
+	case 'o': // --output or -o option
+	    output = optarg;
+	    break;
+	case 'V': // --vocabulary or -V option
+	    vocabulary = optarg;
+	    break;
+	case 'n': // --ngrams or -n option
+	    if (atoi(optarg) > 0) {
+		order = atoi(optarg);
+	    } else {
+		usage();
+		return -1;
+	    }
+	    break;
+	case 'h': // --help or -h option
+	    usage();
+	    exit (0);
+	    break;
+	case 'v': // --version or -v option
+	    version();
+	    exit (0);
+	    break;
+	case '?': // unknown option
+	    usage();
+	    exit (0);
+	    break;
+	case -1:
+	    break;
+	default:
+	    std::cerr << "Error: unhandled option." << std::endl;
+	    exit(0);
+	}
+
+    } while (next_option != -1);
+
+    if ((argc - optind != 1) || output.empty()) {
+	usage();
+	return -1;
+    }
+
+    try {
+	ARPAModel model;
+	model.compile(argv[optind], vocabulary, order, &std::cerr);
+	std::cerr << std::endl << std::endl;
+
+	std::cerr << "Vocabulary: " << model.size(1) << " words" << std::endl;
+	for (size_t n = 2; n <= model.order(); n++) {
+	    std::cerr << n << "-grams: " << model.size(n) << std::endl;
+	}
+
+	model.save(output);
+
+    } catch (const PresageException& e) {
+	std::cerr << "Error: " << e.what() << std::endl;
+	return -1;
+    }
+
+    return 0;
+}
+
+
+void version()
+{
+    std::cout
+	<< PROGRAM_NAME << " (" << PACKAGE << ") version " << VERSION << std::endl
+	<< "Copyright (C) Matteo Vescovi" << std::endl
+	<< "This is free software; see the source for copying conditions.  There is NO" << std::endl
+	<< "warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE." << std::endl
+	<< std::endl;
+}
+
+
+void usage()
+{
+    std::cout
+	<< "Usage: " << PROGRAM_NAME << " [OPTION]... -o FILE ARPA_FILE" << std::endl
+	<< std::endl
+	<< "Compile an ARPA language model into the binary format mapped into memory by ARPAPredictor." << std::endl
+	<< std::endl
+	<< "  --output, -o F     " << "Output file F" << std::endl
+	<< "  --vocabulary, -V F " << "Vocabulary file F, one word per line (default: the unigrams)" << std::endl
+	<< "  --ngrams, -n N     " << "Keep 1..N-grams only (default: all)" << std::endl
+	<< "  --help, -h         " << "Display this information" << std::endl
+	<< "  --version, -v      " << "Show version information" << std::endl
+	<< std::endl
+	<< "Set ARPAFILENAME to the output file to use the compiled model." << std::endl
+	<< std::endl
+	<< PROGRAM_NAME << " is free software distributed under the GPL." << std::endl
+	<< "Send bug reports to " << PACKAGE_BUGREPORT << std::endl
+	<< "Copyright (C) Matteo Vescovi" << std::endl;
+}
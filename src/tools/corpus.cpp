@@ -0,0 +1,169 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#include "corpus.h"
+
+#include <stdexcept>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+std::vector<Chunk> splitFiles(const std::vector<std::string>& files,
+			      const std::streamoff chunk_size)
+{
+    std::vector<Chunk> chunks;
+    for (size_t i = 0; i < files.size(); i++) {
+	std::ifstream in(files[i].c_str(), std::ios::in | std::ios::binary);
+	if (! in) {
+	    throw std::runtime_error("Unable to open input file " + files[i]);
+	}
+	in.seekg(0, std::ios::end);
+	std::streamoff size = in.tellg();
+
+	std::streamoff begin = 0;
+	while (begin < size) {
+	    std::streamoff end = begin + chunk_size;
+	    if (end >= size) {
+		end = size;
+	    } else {
+		// move on to the end of the line
+		in.seekg(end);
+		std::string rest;
+		std::getline(in, rest);
+		end = (in ? static_cast<std::streamoff>(in.tellg()) : size);
+		in.clear();
+	    }
+	    Chunk chunk = { files[i], begin, end, end == size };
+	    chunks.push_back(chunk);
+	    begin = end;
+	}
+    }
+    return chunks;
+}
+
+size_t parseMemorySize(const std::string& size)
+{
+    char* end = 0;
+    double value = strtod(size.c_str(), &end);
+    if (end == size.c_str() || value <= 0) {
+	return 0;
+    }
+
+    double unit = 1024 * 1024;
+    std::string suffix(end);
+    if (suffix == "K" || suffix == "k") {
+	unit = 1024;
+    } else if (suffix == "M" || suffix == "m" || suffix.empty()) {
+	unit = 1024 * 1024;
+    } else if (suffix == "G" || suffix == "g") {
+	unit = 1024.0 * 1024 * 1024;
+    } else {
+	return 0;
+    }
+    return static_cast<size_t>(value * unit);
+}
+
+
+CorpusTokenizer::CorpusTokenizer(const std::string& blankspaces,
+				 const std::string& separators,
+				 const bool lowercase)
+    : lowercase(lowercase),
+      trailing_empty_token(false)
+{
+    memset(delimiter, 0, sizeof(delimiter));
+    std::string delimiters = blankspaces + separators;
+    for (size_t i = 0; i < delimiters.size(); i++) {
+	delimiter[static_cast<unsigned char>(delimiters[i])] = true;
+    }
+}
+
+bool CorpusTokenizer::isDelimiter(const char c) const
+{
+    return delimiter[static_cast<unsigned char>(c)];
+}
+
+void CorpusTokenizer::trailingEmptyToken(const bool value)
+{
+    trailing_empty_token = value;
+}
+
+void CorpusTokenizer::tokenize(const std::string& text, std::vector<std::string>& tokens) const
+{
+    std::string::size_type i = 0;
+    while (i < text.size()) {
+	while (i < text.size() && isDelimiter(text[i])) {
+	    i++;
+	}
+	std::string::size_type begin = i;
+	while (i < text.size() && ! isDelimiter(text[i])) {
+	    i++;
+	}
+	if (i > begin) {
+	    tokens.push_back(text.substr(begin, i - begin));
+	    if (lowercase) {
+		std::string& token = tokens.back();
+		for (size_t j = 0; j < token.size(); j++) {
+		    token[j] = tolower(static_cast<unsigned char>(token[j]));
+		}
+	    }
+	}
+    }
+}
+
+size_t CorpusTokenizer::readChunk(std::ifstream& in,
+				  const Chunk& chunk,
+				  const size_t lookahead,
+				  std::vector<std::string>& tokens) const
+{
+    std::string text(chunk.end - chunk.begin, '\0');
+    in.clear();
+    in.seekg(chunk.begin);
+    in.read(&text[0], text.size());
+
+    size_t first = tokens.size();
+    tokenize(text, tokens);
+    if (chunk.last) {
+	if (trailing_empty_token && ! text.empty() && isDelimiter(text[text.size() - 1])) {
+	    tokens.push_back(std::string());
+	}
+	return tokens.size() - first;
+    }
+    size_t owned = tokens.size() - first;
+
+    std::string line;
+    bool delimited = false;
+    while (tokens.size() - first < owned + lookahead && std::getline(in, line)) {
+	tokenize(line, tokens);
+	// getline swallowed the newline unless it hit the end of file
+	delimited = ! in.eof() || (! line.empty() && isDelimiter(line[line.size() - 1]));
+    }
+    if (trailing_empty_token && in.eof() && delimited) {
+	tokens.push_back(std::string());
+    }
+    if (tokens.size() - first > owned + lookahead) {
+	tokens.resize(first + owned + lookahead);
+    }
+
+    return owned;
+}
@@ -0,0 +1,97 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#ifndef PRESAGE_CORPUS
+#define PRESAGE_CORPUS
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/** Portion of a corpus file, starting and ending at a line boundary.
+ */
+struct Chunk {
+    std::string file;
+    std::streamoff begin;
+    std::streamoff end;
+    bool last;
+};
+
+/** Splits corpus files into line aligned chunks of about chunk_size
+ *  bytes, so that a single large file can be processed by several
+ *  threads.
+ *
+ * Throws std::runtime_error if a file cannot be opened.
+ */
+std::vector<Chunk> splitFiles(const std::vector<std::string>& files,
+			      const std::streamoff chunk_size);
+
+/** Parses a memory size such as 512M or 4G into bytes. A number
+ *  without suffix is taken as megabytes.
+ *
+ * \return zero if the size is not valid.
+ */
+size_t parseMemorySize(const std::string& size);
+
+
+/** Splits corpus chunks into tokens the way ForwardTokenizer splits
+ *  a whole file, using a lookup table instead of a stream.
+ *
+ * Tokens never span lines, so the tokens following a chunk are found
+ * by reading on line by line.
+ */
+class CorpusTokenizer {
+public:
+    CorpusTokenizer(const std::string& blankspaces,
+		    const std::string& separators,
+		    const bool lowercase);
+
+    /** Appends the tokens of the chunk to tokens, followed by up to
+     *  lookahead tokens from the rest of the file.
+     *
+     * \return number of tokens read from the chunk itself.
+     */
+    size_t readChunk(std::ifstream& in,
+		     const Chunk& chunk,
+		     const size_t lookahead,
+		     std::vector<std::string>& tokens) const;
+
+    /** Appends the tokens found in text to tokens. */
+    void tokenize(const std::string& text, std::vector<std::string>& tokens) const;
+
+    /** ForwardTokenizer returns a last empty token when the stream
+     *  ends with blankspace or separator characters. Enable this to
+     *  reproduce it.
+     */
+    void trailingEmptyToken(const bool value);
+
+private:
+    bool isDelimiter(const char c) const;
+
+    bool delimiter[256];
+    bool lowercase;
+    bool trailing_empty_token;
+};
+
+#endif // PRESAGE_CORPUS
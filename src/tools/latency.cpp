@@ -0,0 +1,90 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+
+#include "latency.h"
+
+#include <algorithm>
+#include <math.h>
+
+LatencyHistogram::LatencyHistogram()
+    : sorted(true),
+      total(0)
+{
+    // nothing to do here, move along
+}
+
+void LatencyHistogram::add(const double microseconds)
+{
+    samples.push_back(microseconds);
+    sorted = false;
+    total += microseconds;
+
+    size_t bucket = 0;
+    for (double bound = 1; microseconds >= bound; bound *= 2) {
+	bucket++;
+    }
+    if (bucket >= histogram.size()) {
+	histogram.resize(bucket + 1, 0);
+    }
+    histogram[bucket]++;
+}
+
+size_t LatencyHistogram::count() const
+{
+    return samples.size();
+}
+
+double LatencyHistogram::mean() const
+{
+    return (samples.empty() ? 0 : total / samples.size());
+}
+
+double LatencyHistogram::max() const
+{
+    return percentile(100);
+}
+
+double LatencyHistogram::percentile(const double percent) const
+{
+    if (samples.empty()) {
+	return 0;
+    }
+    if (! sorted) {
+	std::sort(samples.begin(), samples.end());
+	sorted = true;
+    }
+
+    // nearest rank
+    size_t rank = static_cast<size_t>(ceil(percent / 100 * samples.size()));
+    if (rank > 0) {
+	rank--;
+    }
+    return samples[std::min(rank, samples.size() - 1)];
+}
+
+const std::vector<size_t>& LatencyHistogram::buckets() const
+{
+    return histogram;
+}
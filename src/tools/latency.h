@@ -0,0 +1,64 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+
+#ifndef PRESAGE_LATENCY
+#define PRESAGE_LATENCY
+
+#include <string>
+#include <vector>
+
+/** Collects latency samples and summarizes their distribution.
+ *
+ * Samples are kept, so that percentiles are exact. The histogram
+ * counts samples in power of two buckets: bucket 0 holds samples
+ * below 1 microsecond, bucket i samples from 2^(i-1) up to 2^i
+ * microseconds.
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    /** Adds a sample, in microseconds. */
+    void add(const double microseconds);
+
+    size_t count() const;
+    double mean() const;
+    double max() const;
+
+    /** Returns the sample that percent percent of the samples do not
+     *  exceed, zero if there are no samples.
+     */
+    double percentile(const double percent) const;
+
+    const std::vector<size_t>& buckets() const;
+
+private:
+    mutable std::vector<double> samples;
+    mutable bool sorted;
+    double total;
+    std::vector<size_t> histogram;
+};
+
+#endif // PRESAGE_LATENCY
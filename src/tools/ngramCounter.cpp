@@ -0,0 +1,299 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#include "ngramCounter.h"
+
+#include <algorithm>
+#include <memory>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// estimated memory used by a counted n-gram or an interned token
+// besides the token ids and characters
+static const size_t ENTRY_OVERHEAD = 64;
+
+NgramCounter::NgramCounter(const size_t cardinality,
+			   const std::string& tmpdir,
+			   const size_t memory,
+			   const size_t id)
+    : cardinality(cardinality),
+      tmpdir(tmpdir),
+      memory(memory),
+      id(id),
+      used(0)
+{
+    // nothing to do here, move along
+}
+
+void NgramCounter::count(const std::vector<std::string>& tokens,
+			 const size_t pos,
+			 const long occurrences)
+{
+    count(tokens, pos, cardinality, occurrences);
+}
+
+void NgramCounter::count(const std::vector<std::string>& tokens,
+			 const size_t pos,
+			 const size_t n,
+			 const long occurrences)
+{
+    Key key;
+    key.reserve(n);
+    for (size_t i = pos; i < pos + n; i++) {
+	std::unordered_map<std::string, char32_t>::const_iterator it = vocabulary.find(tokens[i]);
+	if (it == vocabulary.end()) {
+	    char32_t token_id = static_cast<char32_t>(words.size());
+	    vocabulary[tokens[i]] = token_id;
+	    words.push_back(tokens[i]);
+	    used += 2 * tokens[i].size() + ENTRY_OVERHEAD;
+	    key.push_back(token_id);
+	} else {
+	    key.push_back(it->second);
+	}
+    }
+
+    std::pair<std::unordered_map<Key, long>::iterator, bool> result =
+	counts.insert(std::make_pair(key, occurrences));
+    if (result.second) {
+	used += sizeof(char32_t) * n + ENTRY_OVERHEAD;
+	if (memory > 0 && used > memory) {
+	    spill();
+	}
+    } else {
+	result.first->second += occurrences;
+    }
+}
+
+void NgramCounter::sortKeys(std::vector<const std::pair<const Key, long>*>& keys) const
+{
+    // rank token ids by token, so that keys can be compared without
+    // looking up their tokens
+    std::vector<char32_t> ids(words.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+	ids[i] = static_cast<char32_t>(i);
+    }
+    std::sort(ids.begin(), ids.end(),
+	      [this](char32_t a, char32_t b) { return words[a] < words[b]; });
+    std::vector<char32_t> rank(words.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+	rank[ids[i]] = static_cast<char32_t>(i);
+    }
+
+    keys.clear();
+    keys.reserve(counts.size());
+    for (std::unordered_map<Key, long>::const_iterator it = counts.begin(); it != counts.end(); it++) {
+	keys.push_back(&*it);
+    }
+    std::sort(keys.begin(), keys.end(),
+	      [&rank](const std::pair<const Key, long>* a, const std::pair<const Key, long>* b) {
+		  return std::lexicographical_compare(
+		      a->first.begin(), a->first.end(),
+		      b->first.begin(), b->first.end(),
+		      [&rank](char32_t x, char32_t y) { return rank[x] < rank[y]; });
+	      });
+}
+
+void NgramCounter::spill()
+{
+    if (counts.empty()) {
+	return;
+    }
+
+    std::vector<const std::pair<const Key, long>*> keys;
+    sortKeys(keys);
+
+    std::string name = runName(runs.size());
+    std::ofstream out(name.c_str(), std::ios::out | std::ios::binary);
+    for (size_t i = 0; i < keys.size(); i++) {
+	for (size_t j = 0; j < keys[i]->first.size(); j++) {
+	    out << words[keys[i]->first[j]] << '\t';
+	}
+	out << keys[i]->second << '\n';
+    }
+    out.close();
+    if (out.fail()) {
+	throw std::runtime_error("Error writing temporary file " + name);
+    }
+    runs.push_back(name);
+
+    counts.clear();
+    vocabulary.clear();
+    words.clear();
+    used = 0;
+}
+
+void NgramCounter::sortedCounts(std::vector<NgramCount>& result)
+{
+    std::vector<const std::pair<const Key, long>*> keys;
+    sortKeys(keys);
+
+    result.reserve(result.size() + keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+	NgramCount ngram;
+	ngram.first.reserve(keys[i]->first.size());
+	for (size_t j = 0; j < keys[i]->first.size(); j++) {
+	    ngram.first.push_back(words[keys[i]->first[j]]);
+	}
+	ngram.second = keys[i]->second;
+	result.push_back(ngram);
+    }
+
+    counts.clear();
+    vocabulary.clear();
+    words.clear();
+    used = 0;
+}
+
+const std::vector<std::string>& NgramCounter::getRuns() const
+{
+    return runs;
+}
+
+std::string NgramCounter::runName(const size_t run) const
+{
+    std::stringstream name;
+    name << tmpdir << "/ngramcounter." << getpid() << '.' << id << '.' << run;
+    return name.str();
+}
+
+
+NgramRunReader::NgramRunReader(const std::string& filename)
+    : in(filename.c_str(), std::ios::in | std::ios::binary)
+{
+    if (! in) {
+	throw std::runtime_error("Unable to open temporary file " + filename);
+    }
+}
+
+bool NgramRunReader::next(NgramCount& ngram)
+{
+    if (! std::getline(in, line)) {
+	return false;
+    }
+
+    ngram.first.clear();
+    std::string::size_type begin = 0;
+    std::string::size_type tab;
+    while ((tab = line.find('\t', begin)) != std::string::npos) {
+	ngram.first.push_back(line.substr(begin, tab - begin));
+	begin = tab + 1;
+    }
+    ngram.second = atol(line.c_str() + begin);
+
+    return true;
+}
+
+
+NgramRunMerger::NgramRunMerger(const std::string& tmpdir, const size_t fanin)
+    : tmpdir(tmpdir),
+      fanin(std::max<size_t>(fanin, 2)),
+      pass(0)
+{
+    // nothing to do here, move along
+}
+
+void NgramRunMerger::write(std::ostream& out, const NgramCount& ngram)
+{
+    for (size_t i = 0; i < ngram.first.size(); i++) {
+	out << ngram.first[i] << '\t';
+    }
+    out << ngram.second << '\n';
+}
+
+std::string NgramRunMerger::merge(std::vector<std::string> runs, size_t& distinct)
+{
+    std::string output;
+    do {
+	std::stringstream name;
+	name << tmpdir << "/ngrammerger." << getpid() << '.' << pass++;
+	output = name.str();
+
+	size_t n = std::min(runs.size(), fanin);
+	std::vector<std::string> group(runs.begin(), runs.begin() + n);
+	distinct = mergeInto(group, output);
+
+	runs.erase(runs.begin(), runs.begin() + n);
+	runs.push_back(output);
+    } while (runs.size() > 1);
+
+    return output;
+}
+
+size_t NgramRunMerger::mergeInto(const std::vector<std::string>& runs, const std::string& output)
+{
+    std::vector< std::unique_ptr<NgramRunReader> > readers;
+    std::vector<NgramCount> current(runs.size());
+    auto greater = [&current](size_t a, size_t b) { return current[b].first < current[a].first; };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+
+    for (size_t i = 0; i < runs.size(); i++) {
+	readers.push_back(std::unique_ptr<NgramRunReader>(new NgramRunReader(runs[i])));
+	if (readers[i]->next(current[i])) {
+	    heap.push(i);
+	}
+    }
+
+    std::ofstream out(output.c_str(), std::ios::out | std::ios::binary);
+    size_t distinct = 0;
+    NgramCount merged;
+    bool pending = false;
+    while (! heap.empty()) {
+	size_t i = heap.top();
+	heap.pop();
+
+	if (pending && current[i].first == merged.first) {
+	    merged.second += current[i].second;
+	} else {
+	    if (pending) {
+		write(out, merged);
+		distinct++;
+	    }
+	    merged = current[i];
+	    pending = true;
+	}
+
+	if (readers[i]->next(current[i])) {
+	    heap.push(i);
+	}
+    }
+    if (pending) {
+	write(out, merged);
+	distinct++;
+    }
+    out.close();
+    if (out.fail()) {
+	throw std::runtime_error("Error writing temporary file " + output);
+    }
+
+    readers.clear();
+    for (size_t i = 0; i < runs.size(); i++) {
+	remove(runs[i].c_str());
+    }
+
+    return distinct;
+}
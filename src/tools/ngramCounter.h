@@ -0,0 +1,161 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#ifndef PRESAGE_NGRAMCOUNTER
+#define PRESAGE_NGRAMCOUNTER
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+
+/** An n-gram, as its tokens, and the number of times it occurred.
+ *
+ * N-gram counts are ordered by comparing their tokens one by one,
+ * which is the order text2ngram has always written them in.
+ */
+typedef std::pair<std::vector<std::string>, long> NgramCount;
+
+
+/** Counts n-grams of a given cardinality within a memory budget.
+ *
+ * Tokens are interned to integer ids and n-grams are hashed as
+ * strings of ids. When the estimated memory use exceeds the budget,
+ * the counts are written to a run file sorted in n-gram order and
+ * counting starts afresh. Runs are later combined by
+ * NgramRunMerger.
+ *
+ * Each thread is expected to use its own counter.
+ */
+class NgramCounter {
+public:
+    /**
+     * \param cardinality n-gram cardinality
+     * \param tmpdir directory run files are written to
+     * \param memory budget in bytes, zero means unlimited
+     * \param id tells apart run files of counters in the same process
+     */
+    NgramCounter(const size_t cardinality,
+		 const std::string& tmpdir,
+		 const size_t memory,
+		 const size_t id);
+
+    /** Counts the n-gram made of the tokens starting at pos. */
+    void count(const std::vector<std::string>& tokens,
+	       const size_t pos,
+	       const long occurrences = 1);
+
+    /** Counts the n-gram made of the n tokens starting at pos.
+     *
+     * N-grams of different cardinality may be counted by the same
+     * counter, shorter n-grams sort before the longer n-grams they
+     * are a prefix of.
+     */
+    void count(const std::vector<std::string>& tokens,
+	       const size_t pos,
+	       const size_t n,
+	       const long occurrences);
+
+    /** Writes counts held in memory to a new run file. */
+    void spill();
+
+    /** Moves counts held in memory to counts, sorted in n-gram order. */
+    void sortedCounts(std::vector<NgramCount>& counts);
+
+    const std::vector<std::string>& getRuns() const;
+
+private:
+    typedef std::u32string Key;
+
+    /** Sorts the counted keys in n-gram order. */
+    void sortKeys(std::vector<const std::pair<const Key, long>*>& keys) const;
+
+    std::string runName(const size_t run) const;
+
+    size_t cardinality;
+    std::string tmpdir;
+    size_t memory;
+    size_t id;
+    size_t used;
+
+    std::unordered_map<std::string, char32_t> vocabulary;
+    std::vector<std::string> words;
+    std::unordered_map<Key, long> counts;
+
+    std::vector<std::string> runs;
+};
+
+
+/** Reads n-gram counts back from a run file.
+ *
+ * Run files hold the tokens of each n-gram and its count separated by
+ * tabs, one n-gram per line, in the same format as text2ngram tsv
+ * output.
+ */
+class NgramRunReader {
+public:
+    NgramRunReader(const std::string& filename);
+
+    /** Reads the next n-gram count, returns false at the end of file. */
+    bool next(NgramCount& ngram);
+
+private:
+    std::ifstream in;
+    std::string line;
+};
+
+
+/** Merges sorted runs of n-gram counts, adding up the counts of
+ *  n-grams found in more than one run.
+ */
+class NgramRunMerger {
+public:
+    /**
+     * \param fanin maximum number of runs opened at once
+     */
+    NgramRunMerger(const std::string& tmpdir, const size_t fanin);
+
+    /** Merges runs into a single run, removing the merged runs.
+     *
+     * Runs are merged fanin at a time as long as there are more than
+     * fanin of them.
+     *
+     * \return name of the merged run file, distinct is set to the
+     * number of distinct n-grams in it.
+     */
+    std::string merge(std::vector<std::string> runs, size_t& distinct);
+
+    /** Writes one n-gram count in run file format. */
+    static void write(std::ostream& out, const NgramCount& ngram);
+
+private:
+    size_t mergeInto(const std::vector<std::string>& runs, const std::string& output);
+
+    std::string tmpdir;
+    size_t fanin;
+    size_t pass;
+};
+
+#endif // PRESAGE_NGRAMCOUNTER
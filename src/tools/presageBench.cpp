@@ -0,0 +1,411 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+
+#include <getopt.h>
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+
+#include "presage.h"
+#include "presageException.h"
+#include "core/profileManager.h"
+#include "core/predictorRegistry.h"
+#include "core/predictorActivator.h"
+#include "core/context_tracker/contextTracker.h"
+#include "predictors/dbconnector/databaseConnector.h"
+#include "latency.h"
+
+const char PROGRAM_NAME[] = "presage_bench";
+
+void parseCommandLineArgs(int argc, char* argv[]);
+void printUsage();
+void printVersion();
+
+std::string config;
+unsigned long max_keystrokes = 0;
+bool time_predictors = false;
+bool json_output = false;
+bool learning = false;
+
+// Counts the new-expressions evaluated by the whole process, presage
+// included. Memory allocated by malloc, as sqlite and other C
+// libraries do, is not counted. Every replaceable form of new and
+// delete not defaulting to another is replaced, so that each
+// allocation is freed by its matching form.
+static std::atomic<unsigned long> allocations(0);
+
+static void* counted_malloc(std::size_t size)
+{
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (! p) {
+	throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(std::size_t size)
+{
+    return counted_malloc(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return counted_malloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    free(p);
+}
+
+// Past stream is the text replayed so far
+class BenchPresageCallback
+    : public PresageCallback
+{
+public:
+    BenchPresageCallback(std::stringstream& sstream) : m_sstream(sstream) { }
+    ~BenchPresageCallback() { };
+
+    std::string get_past_stream() const { return m_sstream.str(); }
+    std::string get_future_stream() const { return m_empty; }
+
+private:
+    std::stringstream& m_sstream;
+    const std::string m_empty;
+};
+
+std::string json_string(const std::string& str)
+{
+    std::stringstream result;
+    result << '"';
+    for (std::string::const_iterator it = str.begin(); it != str.end(); it++) {
+	if (*it == '"' || *it == '\\') {
+	    result << '\\' << *it;
+	} else if (static_cast<unsigned char>(*it) < 0x20) {
+	    result << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+		   << static_cast<int>(*it) << std::dec;
+	} else {
+	    result << *it;
+	}
+    }
+    result << '"';
+    return result.str();
+}
+
+void printJson(std::ostream& out, const LatencyHistogram& latency)
+{
+    out << "{ \"count\": " << latency.count()
+	<< ", \"mean_us\": " << latency.mean()
+	<< ", \"p50_us\": " << latency.percentile(50)
+	<< ", \"p95_us\": " << latency.percentile(95)
+	<< ", \"p99_us\": " << latency.percentile(99)
+	<< ", \"max_us\": " << latency.max()
+	<< ", \"histogram\": [";
+    const std::vector<size_t>& buckets = latency.buckets();
+    for (size_t i = 0; i < buckets.size(); i++) {
+	out << (i ? ", " : "") << buckets[i];
+    }
+    out << "] }";
+}
+
+void printText(std::ostream& out, const std::string& name, const LatencyHistogram& latency)
+{
+    out << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(1)
+	<< std::setw(10) << latency.percentile(50)
+	<< std::setw(10) << latency.percentile(95)
+	<< std::setw(10) << latency.percentile(99)
+	<< std::setw(10) << latency.max()
+	<< std::setw(10) << latency.mean() << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    parseCommandLineArgs(argc, argv);
+
+    // check we have enough arguments
+    if (argc - optind < 1) {
+	printUsage();
+	exit (0);
+    }
+
+    // text to replay
+    std::string text;
+    for (int i = optind; i < argc; i++) {
+	std::ifstream infile(argv[i], std::ios::in | std::ios::binary);
+	if (! infile) {
+	    std::cerr << "\aError: could not open file " << argv[i] << std::endl;
+	    return 1;
+	}
+	std::stringstream contents;
+	contents << infile.rdbuf();
+	text += contents.str();
+    }
+    if (max_keystrokes > 0 && text.size() > max_keystrokes) {
+	text.resize(max_keystrokes);
+    }
+
+    LatencyHistogram end_to_end;
+    std::map<std::string, LatencyHistogram> predictor_latency;
+    unsigned long keystrokes = 0;
+    unsigned long queries = 0;
+    unsigned long allocated = 0;
+
+    try {
+	std::stringstream sstream;
+	BenchPresageCallback callback(sstream);
+	Presage presage(&callback, config);
+	if (! learning) {
+	    presage.config("Presage.ContextTracker.ONLINE_LEARNING", "no");
+	}
+
+	// Predictors are timed one by one on a separate set of
+	// predictors, reading the same past stream but not learning
+	// from it, so that their own timings do not add to the end to
+	// end latency.
+	ProfileManager* profileManager = 0;
+	PredictorRegistry* registry = 0;
+	ContextTracker* tracker = 0;
+	size_t size = 0;
+	if (time_predictors) {
+	    profileManager = new ProfileManager(config);
+	    Configuration* configuration = profileManager->get_configuration();
+	    configuration->insert("Presage.ContextTracker.ONLINE_LEARNING", "no");
+	    registry = new PredictorRegistry(configuration);
+	    tracker = new ContextTracker(configuration, registry, &callback);
+	    size = atoi(configuration->find(PredictorActivator::MAX_PARTIAL_PREDICTION_SIZE)->get_value().c_str());
+	}
+
+	for (std::string::const_iterator it = text.begin(); it != text.end(); it++) {
+	    sstream << *it;
+
+	    unsigned long queries_before = DatabaseConnector::getQueryCount();
+	    unsigned long allocations_before = allocations;
+	    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	    presage.predict();
+	    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	    allocated += allocations - allocations_before;
+	    queries += DatabaseConnector::getQueryCount() - queries_before;
+	    end_to_end.add(std::chrono::duration<double, std::micro>(end - begin).count());
+	    keystrokes++;
+
+	    if (tracker) {
+		tracker->beginTokenSnapshot();
+		PredictorRegistry::Iterator predictors = registry->iterator();
+		while (predictors.hasNext()) {
+		    Predictor* predictor = predictors.next();
+		    begin = std::chrono::steady_clock::now();
+		    predictor->predict(size, 0);
+		    end = std::chrono::steady_clock::now();
+		    predictor_latency[predictor->getName()].add(std::chrono::duration<double, std::micro>(end - begin).count());
+		}
+		tracker->endTokenSnapshot();
+	    }
+	}
+
+	delete tracker;
+	delete registry;
+	delete profileManager;
+
+    } catch (PresageException& e) {
+	std::cerr << "\aError: " << e.what() << std::endl;
+	return 1;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long peak_rss = usage.ru_maxrss;
+
+    double queries_per_keystroke = (keystrokes ? double(queries) / keystrokes : 0);
+    double new_expressions_per_keystroke = (keystrokes ? double(allocated) / keystrokes : 0);
+
+    if (json_output) {
+	std::cout << "{" << std::endl
+		  << "  \"keystrokes\": " << keystrokes << "," << std::endl
+		  << "  \"end_to_end\": ";
+	printJson(std::cout, end_to_end);
+	std::cout << "," << std::endl
+		  << "  \"predictors\": {";
+	for (std::map<std::string, LatencyHistogram>::const_iterator it = predictor_latency.begin();
+	     it != predictor_latency.end();
+	     it++) {
+	    std::cout << (it == predictor_latency.begin() ? "" : ",") << std::endl
+		      << "    " << json_string(it->first) << ": ";
+	    printJson(std::cout, it->second);
+	}
+	std::cout << (predictor_latency.empty() ? "" : "\n  ") << "}," << std::endl
+		  << "  \"db_queries\": " << queries << "," << std::endl
+		  << "  \"db_queries_per_keystroke\": " << queries_per_keystroke << "," << std::endl
+		  << "  \"new_expressions_per_keystroke\": " << new_expressions_per_keystroke << "," << std::endl
+		  << "  \"peak_rss_kb\": " << peak_rss << std::endl
+		  << "}" << std::endl;
+    } else {
+	std::cout << "Keystrokes:                    " << keystrokes << std::endl
+		  << "DB queries per keystroke:      " << queries_per_keystroke << std::endl
+		  << "New-expressions per keystroke: " << new_expressions_per_keystroke << std::endl
+		  << "Peak RSS:                      " << peak_rss << " kB" << std::endl
+		  << std::endl
+		  << std::left << std::setw(32) << "Latency (us)" << std::right
+		  << std::setw(10) << "p50"
+		  << std::setw(10) << "p95"
+		  << std::setw(10) << "p99"
+		  << std::setw(10) << "max"
+		  << std::setw(10) << "mean" << std::endl;
+	printText(std::cout, "end to end", end_to_end);
+	for (std::map<std::string, LatencyHistogram>::const_iterator it = predictor_latency.begin();
+	     it != predictor_latency.end();
+	     it++) {
+	    printText(std::cout, it->first, it->second);
+	}
+    }
+
+    return 0;
+}
+
+
+void parseCommandLineArgs(int argc, char* argv[])
+{
+    int next_option;
+
+    // getopt structures
+    const char* const short_options = "c:n:pljhv";
+
+    const struct option long_options[] = {
+        { "config",      required_argument, 0, 'c' },
+        { "keystrokes",  required_argument, 0, 'n' },
+        { "predictors",  no_argument,       0, 'p' },
+        { "learn",       no_argument,       0, 'l' },
+        { "json",        no_argument,       0, 'j' },
+	{ "help",        no_argument,       0, 'h' },
+	{ "version",     no_argument,       0, 'v' },
+	{ 0, 0, 0, 0 }
+    };
+
+    do {
+	next_option = getopt_long( argc, argv,
+				   short_options, long_options, NULL );
+
+	switch( next_option ) {
+          case 'c': // --config or -c option
+            config = optarg;
+            break;
+          case 'n': // --keystrokes or -n option
+            max_keystrokes = strtoul(optarg, 0, 10);
+            break;
+          case 'p': // --predictors or -p option
+            time_predictors = true;
+            break;
+          case 'l': // --learn or -l option
+            learning = true;
+            break;
+          case 'j': // --json or -j option
+            json_output = true;
+            break;
+          case 'h': // --help or -h option
+	    printUsage();
+	    exit (0);
+	    break;
+          case 'v': // --version or -v option
+            printVersion();
+            exit (0);
+	    break;
+          case '?': // unknown option
+	    printUsage();
+	    exit (0);
+	    break;
+          case -1:
+	    break;
+          default:
+	    abort();
+	}
+
+    } while( next_option != -1 );
+}
+
+void printVersion()
+{
+    std::cout << PROGRAM_NAME << " (" << PACKAGE << ") version " << VERSION << std::endl
+	      << "Copyright (C) Matteo Vescovi." << std::endl
+	      << "This is free software; see the source for copying conditions.  There is NO" << std::endl
+	      << "warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE," << std::endl
+	      << "to the extent permitted by law." << std::endl;
+}
+
+void printUsage()
+{
+    std::cout << "Usage: " << PROGRAM_NAME << " [OPTION]... FILE..." << std::endl
+	      << std::endl
+	      << "Replays the text in FILE one keystroke at a time, requesting a prediction" << std::endl
+	      << "after each keystroke, and reports prediction latency percentiles, database" << std::endl
+	      << "queries and new-expressions per keystroke and peak resident set size." << std::endl
+	      << std::endl
+              << "  -c, --config CONFIG     use config file CONFIG" << std::endl
+              << "  -n, --keystrokes N      replay at most N keystrokes" << std::endl
+              << "  -p, --predictors        also time each predictor on its own" << std::endl
+              << "  -l, --learn             learn from the replayed text while timing it" << std::endl
+              << "  -j, --json              print results in JSON format" << std::endl
+	      << "  -h, --help              display this help and exit" << std::endl
+	      << "  -v, --version           output version information and exit" << std::endl
+	      << std::endl
+	      << "Predictors are timed on a second instance of each predictor, which adds to" << std::endl
+	      << "the peak resident set size." << std::endl
+	      << std::endl
+	      << "Online learning is disabled unless --learn is given, so that repeated runs" << std::endl
+	      << "time the same language model." << std::endl
+	      << std::endl
+	      << "New-expressions count the calls to operator new, memory allocated by malloc" << std::endl
+	      << "in C libraries such as sqlite is not counted." << std::endl
+	      << std::endl
+	      << "Direct your bug reports to: " << PACKAGE_BUGREPORT << std::endl;
+}
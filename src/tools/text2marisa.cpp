@@ -0,0 +1,496 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#include "config.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+
+#include <getopt.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <marisa.h>
+
+#include "core/progress.h"
+
+#include "corpus.h"
+#include "ngramCounter.h"
+
+const std::string PROGRAM_NAME = "text2marisa";
+
+// same character classes as text2ngram
+const std::string BLANKSPACES = " \f\n\r\t\v ";
+const std::string SEPARATORS  = "`~!@#$%^&*()_-+=\\|]}[{'\";:/?.>,<«»";
+
+const std::string TEXT  = "text";
+const std::string NGRAM = "ngram";
+const std::string TSV   = "tsv";
+
+// input files are split into chunks of about this size, so that a
+// single large corpus is processed by all threads
+const std::streamoff CHUNK_SIZE = 16 * 1024 * 1024;
+
+// maximum number of run files merged at once, to stay well below the
+// open files limit
+const size_t MERGE_FANIN = 128;
+
+struct Options {
+    std::string format;
+    std::string tmpdir;
+    int ngrams;
+    bool lowercase;
+    size_t memory;
+};
+
+void usage();
+void version();
+
+
+/** Counts all 1..N-grams starting within the chunk.
+ *
+ * Tokens never span lines, so the text following the chunk is read
+ * line by line until the N-1 tokens needed to complete the n-grams
+ * starting at the end of the chunk are known.
+ */
+void count_text(std::ifstream& in, const Chunk& chunk, const Options& options, NgramCounter& counter)
+{
+    CorpusTokenizer tokenizer(BLANKSPACES, SEPARATORS, options.lowercase);
+
+    std::vector<std::string> tokens;
+    size_t owned = tokenizer.readChunk(in, chunk, options.ngrams - 1, tokens);
+
+    for (size_t i = 0; i < owned; i++) {
+	for (size_t n = 1; n <= static_cast<size_t>(options.ngrams) && i + n <= tokens.size(); n++) {
+	    counter.count(tokens, i, n, 1);
+	}
+    }
+}
+
+
+/** Counts n-grams listed one per line in the chunk.
+ *
+ * ngram lines look like "N word word ... word\tCOUNT", tsv lines
+ * written by text2ngram look like "word\tword\t...\tword\tCOUNT".
+ */
+size_t count_lines(std::ifstream& in, const Chunk& chunk, const Options& options, NgramCounter& counter)
+{
+    size_t malformed = 0;
+
+    in.seekg(chunk.begin);
+    std::string line;
+    std::vector<std::string> tokens;
+    while (in.tellg() < chunk.end && std::getline(in, line)) {
+	if (! line.empty() && line[line.size() - 1] == '\r') {
+	    line.erase(line.size() - 1);
+	}
+	std::string::size_type tab = line.rfind('\t');
+	if (tab == std::string::npos || tab == 0) {
+	    malformed++;
+	    continue;
+	}
+	long count = atol(line.c_str() + tab + 1);
+	std::string words = line.substr(0, tab);
+	if (options.format == NGRAM) {
+	    std::string::size_type space = words.find(' ');
+	    if (! isdigit(static_cast<unsigned char>(words[0])) || space == std::string::npos) {
+		malformed++;
+		continue;
+	    }
+	    size_t n = atoi(words.c_str());
+	    words.erase(0, space + 1);
+	    if (static_cast<size_t>(std::count(words.begin(), words.end(), ' ')) + 1 != n) {
+		malformed++;
+		continue;
+	    }
+	} else {
+	    std::replace(words.begin(), words.end(), '\t', ' ');
+	}
+	if (options.lowercase) {
+	    std::transform(words.begin(), words.end(), words.begin(), ::tolower);
+	}
+
+	tokens.clear();
+	std::string::size_type begin = 0;
+	std::string::size_type end;
+	while ((end = words.find(' ', begin)) != std::string::npos) {
+	    tokens.push_back(words.substr(begin, end - begin));
+	    begin = end + 1;
+	}
+	tokens.push_back(words.substr(begin));
+	counter.count(tokens, 0, tokens.size(), count);
+    }
+
+    return malformed;
+}
+
+
+int main(int argc, char* argv[])
+{
+    int next_option;
+
+    // Setup some defaults
+    Options options;
+    //  - default to generating 1-gram counts from text
+    options.format = TEXT;
+    options.ngrams = 1;
+    //  - default to case sensitive
+    options.lowercase = false;
+    //  - default to 1G memory budget for n-gram counting
+    options.memory = parseMemorySize("1G");
+
+    std::string output;
+    int threshold = 0;
+    bool overwrite = false;
+    unsigned int threads = std::thread::hardware_concurrency();
+    if (threads == 0) {
+	threads = 1;
+    }
+
+    // getopt structures
+    const char * const  short_options  = "n:o:f:t:j:m:T:lwhv";
+    const struct option long_options[] =
+	{
+	    { "ngrams",    required_argument, 0, 'n' },
+	    { "output",    required_argument, 0, 'o' },
+	    { "format",    required_argument, 0, 'f' },
+	    { "threshold", required_argument, 0, 't' },
+	    { "threads",   required_argument, 0, 'j' },
+	    { "memory",    required_argument, 0, 'm' },
+	    { "tmpdir",    required_argument, 0, 'T' },
+	    { "lowercase", no_argument,       0, 'l' },
+	    { "overwrite", no_argument,       0, 'w' },
+	    { "help",      no_argument,       0, 'h' },
+	    { "version",   no_argument,       0, 'v' },
+	    { 0,           0,                 0, 0   }
+	};
+
+    do {
+	next_option = getopt_long(argc,
+				  argv,
+				  short_options,
+				  long_options,
+				  NULL);
+
+	switch (next_option) {
+	case 'n': // --ngrams or -n option
+	    if (atoi(optarg) > 0) {
+		options.ngrams = atoi(optarg);
+	    } else {
+		usage();
+		return -1;
+	    }
+	    break;
+	case 'o': // --output or -o option
+	    output = optarg;
+	    break;
+	case 'f': // --format or -f option
+	    if (optarg == TEXT
+		|| optarg == NGRAM
+		|| optarg == TSV) {
+		options.format = optarg;
+	    } else {
+		std::cerr << "Unknown format " << optarg << std::endl << std::endl;
+		usage();
+		return -1;
+	    }
+	    break;
+	case 't': // --threshold or -t option
+	    threshold = atoi(optarg);
+	    break;
+	case 'j': // --threads or -j option
+	    if (atoi(optarg) > 0) {
+		threads = atoi(optarg);
+	    } else {
+		usage();
+		return -1;
+	    }
+	    break;
+	case 'm': // --memory or -m option
+	    options.memory = parseMemorySize(optarg);
+	    if (options.memory == 0) {
+		std::cerr << "Invalid memory size " << optarg << std::endl << std::endl;
+		usage();
+		return -1;
+	    }
+	    break;
+	case 'T': // --tmpdir or -T option
+	    options.tmpdir = optarg;
+	    break;
+	case 'l': // --lowercase or -l option
+	    options.lowercase = true;
+	    break;
+	case 'w': // --overwrite or -w option
+	    overwrite = true;
+	    break;
+	case 'h': // --help or -h option
+	    usage();
+	    exit (0);
+	    break;
+	case 'v': // --version or -v option
+	    version();
+	    exit (0);
+	    break;
+	case '?': // unknown option
+	    usage();
+	    exit (0);
+	    break;
+	case -1:
+	    break;
+	default:
+	    std::cerr << "Error: unhandled option." << std::endl;
+	    exit(0);
+	}
+
+    } while (next_option != -1);
+
+
+    if ((argc - optind < 1) || output.empty()) {
+	usage();
+	return -1;
+    }
+
+    if (mkdir(output.c_str(), 0755) != 0) {
+	if (errno != EEXIST || ! overwrite) {
+	    std::cerr << "Cannot write MARISA database into directory " << output
+		      << ": " << strerror(errno) << std::endl
+		      << "Please provide path for directory that will be created, "
+		      << "or use --overwrite" << std::endl;
+	    return -1;
+	}
+	std::cout << "Going to overwrite existing MARISA trie database" << std::endl;
+    }
+    if (options.tmpdir.empty()) {
+	options.tmpdir = output;
+    }
+
+    std::vector<std::string> files(argv + optind, argv + argc);
+    std::vector<std::string> runs;
+    size_t malformed = 0;
+
+    try {
+	// count n-grams: each thread takes the next chunk and keeps
+	// its share of the memory budget before spilling to disk
+	std::vector<Chunk> chunks = splitFiles(files, CHUNK_SIZE);
+	threads = std::min<size_t>(threads, std::max<size_t>(chunks.size(), 1));
+	size_t memory = options.memory / threads;
+
+	std::cout << "Counting n-grams in " << files.size() << " files ("
+		  << chunks.size() << " chunks) using " << threads << " threads..." << std::endl;
+
+	std::string error;
+	std::vector< std::unique_ptr<NgramCounter> > counters;
+	for (unsigned int i = 0; i < threads; i++) {
+	    counters.push_back(std::unique_ptr<NgramCounter>(
+		new NgramCounter(options.ngrams, options.tmpdir, memory, i)));
+	}
+
+	{
+	std::atomic<size_t> next_chunk(0);
+	size_t done = 0;
+	std::mutex mutex;
+	ProgressBar<char> progressBar;
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < threads; i++) {
+	    workers.push_back(std::thread([&, i]() {
+		try {
+		    size_t c;
+		    while ((c = next_chunk++) < chunks.size()) {
+			std::ifstream in(chunks[c].file.c_str(), std::ios::in | std::ios::binary);
+			if (options.format == TEXT) {
+			    count_text(in, chunks[c], options, *counters[i]);
+			} else {
+			    size_t bad = count_lines(in, chunks[c], options, *counters[i]);
+			    std::lock_guard<std::mutex> lock(mutex);
+			    malformed += bad;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			progressBar.update(static_cast<double>(++done) / chunks.size());
+		    }
+		    counters[i]->spill();
+		} catch (const std::exception& e) {
+		    std::lock_guard<std::mutex> lock(mutex);
+		    error = e.what();
+		    next_chunk = chunks.size();
+		}
+	    }));
+	}
+	for (size_t i = 0; i < workers.size(); i++) {
+	    workers[i].join();
+	}
+	}
+
+	for (size_t i = 0; i < counters.size(); i++) {
+	    runs.insert(runs.end(), counters[i]->getRuns().begin(), counters[i]->getRuns().end());
+	}
+	if (! error.empty()) {
+	    throw std::runtime_error(error);
+	}
+	if (malformed > 0) {
+	    std::cerr << "Skipped " << malformed << " malformed lines" << std::endl;
+	}
+
+	// merge runs into the keyset, applying the count threshold
+	std::cout << "Merging " << runs.size() << " sorted runs..." << std::endl;
+	NgramRunMerger merger(options.tmpdir, MERGE_FANIN);
+	size_t distinct = 0;
+	std::string merged = merger.merge(runs, distinct);
+	runs.assign(1, merged);
+
+	// keys are the n-gram cardinality followed by its tokens, all
+	// separated by spaces
+	const long factor = std::max(threshold, 1);
+	marisa::Keyset keyset;
+	std::vector<int32_t> counts;
+	long scount = 0;
+	bool overflow = false;
+	{
+	NgramRunReader reader(merged);
+	NgramCount ngram;
+	std::string key;
+	while (reader.next(ngram)) {
+	    if (ngram.second < threshold) {
+		continue;
+	    }
+	    key = std::to_string(ngram.first.size());
+	    for (size_t i = 0; i < ngram.first.size(); i++) {
+		key += ' ';
+		key += ngram.first[i];
+	    }
+	    keyset.push_back(key.c_str(), key.size());
+	    if (ngram.second / factor > INT32_MAX) {
+		overflow = true;
+	    }
+	    counts.push_back(static_cast<int32_t>(ngram.second / factor));
+	    if (ngram.first.size() == 1) {
+		scount += ngram.second;
+	    }
+	}
+	}
+
+	remove(merged.c_str());
+	runs.clear();
+
+	std::cout << "Sum of 1-gram: " << scount << std::endl;
+	scount = std::max(scount / factor, 1L);
+	if (factor > 1) {
+	    std::cout << "Normalized sum of 1-gram: " << scount << std::endl;
+	}
+	if (scount > INT32_MAX || overflow) {
+	    std::cerr << "Trouble: counts don't fit INT32. Please normalize the data manually "
+		      << "or automatically by increasing threshold for counts" << std::endl;
+	    return -1;
+	}
+
+	// build the trie, key ids are assigned to the keyset by build
+	std::cout << "Saving in MARISA format..." << std::endl;
+	marisa::Trie trie;
+	trie.build(keyset);
+	trie.save((output + "/ngrams.trie").c_str());
+
+	std::cout << "Keys: " << trie.num_keys() << std::endl;
+
+	std::vector<int32_t> arr(trie.num_keys() + 1, 0);
+	arr[0] = static_cast<int32_t>(scount);
+	for (size_t i = 0; i < keyset.size(); i++) {
+	    arr[keyset[i].id() + 1] = counts[i];
+	}
+
+	std::string countsname = output + "/ngrams.counts";
+	std::ofstream binwrite(countsname.c_str(), std::ios::out | std::ios::binary);
+	binwrite.write(reinterpret_cast<const char*>(&arr[0]), arr.size() * sizeof(int32_t));
+	binwrite.close();
+	if (binwrite.fail()) {
+	    throw std::runtime_error("Error writing " + countsname);
+	}
+
+    } catch (const std::exception& e) {
+	for (size_t i = 0; i < runs.size(); i++) {
+	    remove(runs[i].c_str());
+	}
+	std::cerr << "Error: " << e.what() << std::endl;
+	return -1;
+    }
+
+    return 0;
+}
+
+
+void version()
+{
+    std::cout
+	<< PROGRAM_NAME << " (" << PACKAGE << ") version " << VERSION << std::endl
+	<< "Copyright (C) Matteo Vescovi" << std::endl
+	<< "This is free software; see the source for copying conditions.  There is NO" << std::endl
+	<< "warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE." << std::endl
+	<< std::endl;
+}
+
+
+void usage()
+{
+    std::cout
+	<< "Usage: " << PROGRAM_NAME << " [OPTION]... -o DIR infiles..." << std::endl
+	<< std::endl
+	<< "Build n-gram database for the MARISA-based predictor from text or n-gram counts." << std::endl
+	<< std::endl
+	<< "  --output, -o D    " << "Output directory D, created if it does not exist" << std::endl
+	<< "  --format, -f F    " << "Input file format F: text (default), ngram (N word ... word<TAB>COUNT)," << std::endl
+	<< "                    " << "tsv (word<TAB>...<TAB>word<TAB>COUNT as written by text2ngram)" << std::endl
+	<< "  --ngrams, -n N    " << "Count 1..N-grams when format is text" << std::endl
+	<< "  --threshold, -t T " << "Minimal n-gram count propagated into the database" << std::endl
+	<< "  --threads, -j J   " << "Number of counting threads J" << std::endl
+	<< "  --memory, -m M    " << "Use about M memory for counting, e.g. 512M or 4G (default 1G)" << std::endl
+	<< "  --tmpdir, -T D    " << "Directory for temporary files (default output directory)" << std::endl
+	<< "  --lowercase, -l   " << "Enable lowercase conversion mode" << std::endl
+	<< "  --overwrite, -w   " << "Overwrite existing MARISA database" << std::endl
+	<< "  --help, -h        " << "Display this information" << std::endl
+	<< "  --version, -v     " << "Show version information" << std::endl
+	<< std::endl
+	<< PROGRAM_NAME << " is free software distributed under the GPL." << std::endl
+	<< "Send bug reports to " << PACKAGE_BUGREPORT << std::endl
+	<< "Copyright (C) Matteo Vescovi" << std::endl;
+}
@@ -27,9 +27,13 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
-#include <list>
 #include <string>
-#include <map>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
@@ -42,15 +46,25 @@
 #include <getopt.h>
 #include <assert.h>
 
-#include "core/tokenizer/forwardTokenizer.h"
-#include "core/iso8859_1.h"
 #include "core/progress.h"
 
+#include "corpus.h"
+#include "ngramCounter.h"
+
 #include "../lib/predictors/dbconnector/sqliteDatabaseConnector.h"
 
 const std::string PROGRAM_NAME = "text2ngram";
 
-typedef std::list<std::string> NgramList;
+// same character classes ForwardTokenizer was used with
+const std::string BLANKSPACES = " \f\n\r\t\v ";
+const std::string SEPARATORS  = "`~!@#$%^&*()_-+=\\|]}[{'\";:/?.>,<«»";
+
+// input files are split into chunks of about this size, so that a
+// single large corpus is processed by all threads
+const std::streamoff CHUNK_SIZE = 16 * 1024 * 1024;
+
+// maximum number of run files merged at once
+const size_t MERGE_FANIN = 128;
 
 void usage();
 void version();
@@ -77,14 +91,29 @@ int main(int argc, char* argv[])
     //  - default to no append
     bool append    = false;
 
+    //  - default to one counting thread per core
+    unsigned int threads = std::thread::hardware_concurrency();
+    if (threads == 0) {
+	threads = 1;
+    }
+
+    //  - default to 1G memory budget for counting
+    size_t memory = parseMemorySize("1G");
+
+    //  - default temporary files directory
+    std::string tmpdir = (getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+
 	
     // getopt structures
-    const char * const  short_options  = "n:o:f:alhv";
+    const char * const  short_options  = "n:o:f:j:m:T:alhv";
     const struct option long_options[] =
 	{
 	    { "ngrams",    required_argument, 0, 'n' },
 	    { "output",    required_argument, 0, 'o' },
 	    { "format",    required_argument, 0, 'f' },
+	    { "threads",   required_argument, 0, 'j' },
+	    { "memory",    required_argument, 0, 'm' },
+	    { "tmpdir",    required_argument, 0, 'T' },
 	    { "append",    no_argument,       0, 'a' },
 	    { "lowercase", no_argument,       0, 'l' },
 	    { "help",      no_argument,       0, 'h' },
@@ -120,6 +149,25 @@ int main(int argc, char* argv[])
 		return -1;
 	    }
 	    break;
+	case 'j': // --threads or -j option
+	    if (atoi(optarg) > 0) {
+		threads = atoi(optarg);
+	    } else {
+		usage();
+		return -1;
+	    }
+	    break;
+	case 'm': // --memory or -m option
+	    memory = parseMemorySize(optarg);
+	    if (memory == 0) {
+		std::cerr << "Invalid memory size " << optarg << std::endl << std::endl;
+		usage();
+		return -1;
+	    }
+	    break;
+	case 'T': // --tmpdir or -T option
+	    tmpdir = optarg;
+	    break;
 	case 'a': // --append or -a option
 	    // append mode
             append = true;
@@ -155,54 +203,139 @@ int main(int argc, char* argv[])
     }
 	
 
-    // ngramMap stores <token,count> pairs
-    std::map<NgramList, int> ngramMap;
-
-    for (int i = optind; i < argc; i++) {
-	// do the actual processing file by file
-	std::string token;
-	NgramList ngram;
-
-	// points to output file
-	// print out file information
-	std::cout << "Parsing " << argv[i] << "..."
+    std::vector<std::string> files(argv + optind, argv + argc);
+    for (size_t i = 0; i < files.size(); i++) {
+	std::cout << "Parsing " << files[i] << "..."
 		  << std::endl;
+    }
 
-	ProgressBar<char> progressBar;
+    // n-grams are counted in memory, unless the memory budget is
+    // exceeded, in which case they end up sorted in a single run file
+    std::vector<NgramCount> ngramCounts;
+    std::unique_ptr<NgramRunReader> ngramRun;
+    std::string ngramRunName;
+    long total = 0;
+
+    try {
+	std::vector<Chunk> chunks = splitFiles(files, CHUNK_SIZE);
+	threads = std::min<size_t>(threads, std::max<size_t>(chunks.size(), 1));
+
+	std::vector< std::unique_ptr<NgramCounter> > counters;
+	for (unsigned int i = 0; i < threads; i++) {
+	    counters.push_back(std::unique_ptr<NgramCounter>(
+		new NgramCounter(ngrams, tmpdir, memory / threads, i)));
+	}
 
-	// create tokenizer object and open input file stream
-	std::ifstream infile(argv[i]);
-	ForwardTokenizer tokenizer(infile,
-				   " \f\n\r\t\v ",
-				   "`~!@#$%^&*()_-+=\\|]}[{'\";:/?.>,<«»");
-	tokenizer.lowercaseMode(lowercase);
+	// count n-grams: each thread takes the next chunk of the
+	// corpus, n-grams starting in a chunk are completed with the
+	// tokens that follow it
+	std::string error;
+	{
+	    std::atomic<size_t> next_chunk(0);
+	    size_t done = 0;
+	    std::mutex mutex;
+	    ProgressBar<char> progressBar;
+
+	    std::vector<std::thread> workers;
+	    for (unsigned int i = 0; i < threads; i++) {
+		workers.push_back(std::thread([&, i]() {
+		    try {
+			CorpusTokenizer tokenizer(BLANKSPACES, SEPARATORS, lowercase);
+			tokenizer.trailingEmptyToken(true);
+
+			std::vector<std::string> tokens;
+			size_t c;
+			while ((c = next_chunk++) < chunks.size()) {
+			    std::ifstream infile(chunks[c].file.c_str(), std::ios::in | std::ios::binary);
+			    tokens.clear();
+			    size_t owned = tokenizer.readChunk(infile, chunks[c], ngrams - 1, tokens);
+			    for (size_t j = 0; j < owned && j + ngrams <= tokens.size(); j++) {
+				counters[i]->count(tokens, j);
+			    }
+
+			    std::lock_guard<std::mutex> lock(mutex);
+			    progressBar.update(static_cast<double>(++done) / chunks.size());
+			}
+		    } catch (const std::exception& e) {
+			std::lock_guard<std::mutex> lock(mutex);
+			error = e.what();
+			next_chunk = chunks.size();
+		    }
+		}));
+	    }
+	    for (size_t i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	    }
+	}
 
-	// take care of first N-1 tokens
-	for (int i = 0; (i < ngrams - 1 && tokenizer.hasMoreTokens()); i++) {
-	    ngram.push_back(tokenizer.nextToken());
+	bool spilled = false;
+	for (size_t i = 0; i < counters.size(); i++) {
+	    spilled = spilled || ! counters[i]->getRuns().empty();
 	}
 
-	while (tokenizer.hasMoreTokens()) {
-	    // extract token from input stream
-	    token = tokenizer.nextToken();
-
-	    // update ngram with new token
-	    ngram.push_back(token);
-			
-	    // update map with new token occurrence
-	    ngramMap[ngram] = ngramMap[ngram] + 1;
-		    
-	    // update progress bar
-	    //progressBar(tokenizer.progress());
-	    progressBar.update(tokenizer.progress());
-
-	    // remove front token from ngram
-	    ngram.pop_front();
+	if (spilled || ! error.empty()) {
+	    std::vector<std::string> runs;
+	    for (size_t i = 0; i < counters.size(); i++) {
+		if (error.empty()) {
+		    counters[i]->spill();
+		}
+		runs.insert(runs.end(), counters[i]->getRuns().begin(), counters[i]->getRuns().end());
+	    }
+	    if (! error.empty()) {
+		for (size_t i = 0; i < runs.size(); i++) {
+		    remove(runs[i].c_str());
+		}
+		throw std::runtime_error(error);
+	    }
+
+	    std::cout << "Merging " << runs.size() << " sorted runs..." << std::endl;
+	    NgramRunMerger merger(tmpdir, MERGE_FANIN);
+	    size_t distinct = 0;
+	    ngramRunName = merger.merge(runs, distinct);
+	    ngramRun.reset(new NgramRunReader(ngramRunName));
+	    total = distinct;
+
+	} else {
+	    for (size_t i = 0; i < counters.size(); i++) {
+		counters[i]->sortedCounts(ngramCounts);
+	    }
+	    if (counters.size() > 1) {
+		// combine counts of n-grams found by more than one thread
+		std::sort(ngramCounts.begin(), ngramCounts.end(),
+			  [](const NgramCount& a, const NgramCount& b) { return a.first < b.first; });
+		size_t last = 0;
+		for (size_t i = 1; i < ngramCounts.size(); i++) {
+		    if (ngramCounts[i].first == ngramCounts[last].first) {
+			ngramCounts[last].second += ngramCounts[i].second;
+		    } else if (++last != i) {
+			std::swap(ngramCounts[last], ngramCounts[i]);
+		    }
+		}
+		if (! ngramCounts.empty()) {
+		    ngramCounts.resize(last + 1);
+		}
+	    }
+	    total = ngramCounts.size();
 	}
-	
-	infile.close();
+
+    } catch (const std::exception& e) {
+	std::cerr << "Error: " << e.what() << std::endl;
+	return -1;
     }
 
+    // yields the counted n-grams in order
+    size_t position = 0;
+    auto nextNgram = [&](NgramCount& ngram) -> bool {
+	if (ngramRun) {
+	    return ngramRun->next(ngram);
+	}
+	if (position < ngramCounts.size()) {
+	    ngram = ngramCounts[position++];
+	    return true;
+	}
+	return false;
+    };
+
 
     std::cout << "Writing out to " << format << " format file "
 	      << output << "..." << std::endl;
@@ -222,16 +355,15 @@ int main(int argc, char* argv[])
 
 	// write results to output stream
 	ProgressBar<char> progressBar;
-	long total = ngramMap.size();
 	long count = 0;
-	std::map<NgramList, int>::const_iterator it;
-	for (it = ngramMap.begin(); it != ngramMap.end(); it++) {
-	    for (NgramList::const_iterator ngram_it = it->first.begin();
-		 ngram_it != it->first.end();
+	NgramCount it;
+	while (nextNgram(it)) {
+	    for (std::vector<std::string>::const_iterator ngram_it = it.first.begin();
+		 ngram_it != it.first.end();
 		 ngram_it++) {
 		std::cout << *ngram_it << '\t';
 	    }
-	    std::cout << it->second << std::endl;
+	    std::cout << it.second << std::endl;
 	    progressBar.update(static_cast<double>(count++)/total);
 	}
 
@@ -251,18 +383,11 @@ int main(int argc, char* argv[])
 
 	// write results to output stream
 	ProgressBar<char> progressBar;
-	long total = ngramMap.size();
 	long count = 0;
-	std::map<NgramList, int>::const_iterator it;
-	for (it = ngramMap.begin(); it != ngramMap.end(); it++) {
-
-	    // convert from NgramList to Ngram
-	    Ngram ngram;
-	    for (NgramList::const_iterator jt = it->first.begin();
-		 jt != it->first.end();
-		 jt++) {
-		ngram.push_back(*jt);
-	    }
+	NgramCount it;
+	while (nextNgram(it)) {
+
+	    const Ngram& ngram = it.first;
 
             if (append) {
                 // need to check whether ngram is already in database.
@@ -270,14 +395,14 @@ int main(int argc, char* argv[])
                 int count = sqliteDbCntr.getNgramCount(ngram);
                 if (count > 0) {
                     // ngram already in database, update count
-                    sqliteDbCntr.updateNgram(ngram, count + it->second);
+                    sqliteDbCntr.updateNgram(ngram, count + it.second);
                 } else {
                     // ngram not in database, insert it
-                    sqliteDbCntr.insertNgram(ngram, it->second);
+                    sqliteDbCntr.insertNgram(ngram, it.second);
                 }
             } else {
                 // insert ngram
-                sqliteDbCntr.insertNgram(ngram, it->second);
+                sqliteDbCntr.insertNgram(ngram, it.second);
             }
 
 	    progressBar.update(static_cast<double>(count++)/total);
@@ -287,6 +412,10 @@ int main(int argc, char* argv[])
 	abort();
     }
 
+    if (ngramRun) {
+	ngramRun.reset();
+	remove(ngramRunName.c_str());
+    }
 
     std::cout << std::endl;
 
@@ -313,6 +442,9 @@ void usage()
         << "  --output, -o O  " << "Output file name O" << std::endl
 	<< "  --ngrams, -n N  " << "Specify ngram cardinality N" << std::endl
 	<< "  --format, -f F  " << "Output file format F: sqlite, tsv (tabbed separated values)" << std::endl
+	<< "  --threads, -j J " << "Count n-grams using J threads" << std::endl
+	<< "  --memory, -m M  " << "Use about M memory for counting, e.g. 512M or 4G (default 1G)" << std::endl
+	<< "  --tmpdir, -T D  " << "Directory for temporary files (default $TMPDIR or /tmp)" << std::endl
 	<< "  --lowercase, -l " << "Enable lowercase conversion mode" << std::endl
 	<< "  --append, -a    " << "Open output file in append mode" << std::endl
 	<< "  --help, -h      " << "Display this information" << std::endl
@@ -118,3 +118,41 @@ void ContextChangeDetectorTest::testGetChange()
     CPPUNIT_ASSERT_EQUAL(detector->get_sliding_window(), std::string("quick brow"));
     CPPUNIT_ASSERT_EQUAL(detector->change(str), std::string("n fox jumped over the lazy dog"));
 }
+
+void ContextChangeDetectorTest::testAnchoredSlidingWindow()
+{
+    detector->set_sliding_window_size("10");
+
+    // sliding window found where it was left
+    detector->update_sliding_window("The quick brown");
+    CPPUNIT_ASSERT_EQUAL(static_cast<std::string::size_type>(5),
+			 detector->find_sliding_window("The quick brown fox"));
+    CPPUNIT_ASSERT_EQUAL(std::string(" fox"), detector->change("The quick brown fox"));
+
+    // text before the sliding window was edited
+    CPPUNIT_ASSERT_EQUAL(static_cast<std::string::size_type>(3),
+			 detector->find_sliding_window("A quick brown fox"));
+    CPPUNIT_ASSERT_EQUAL(std::string(" fox"), detector->change("A quick brown fox"));
+
+    // the last occurrence of the sliding window wins
+    const std::string repeated = "The quick brown. The quick brown";
+    CPPUNIT_ASSERT_EQUAL(static_cast<std::string::size_type>(22),
+			 detector->find_sliding_window(repeated));
+    CPPUNIT_ASSERT_EQUAL(std::string(""), detector->change(repeated));
+    CPPUNIT_ASSERT_EQUAL(false, detector->context_change(repeated));
+
+    // the end of the past stream and its offset give the same answers
+    // as the whole past stream
+    const std::string past_stream = "The quick brown fox jumped";
+    detector->update_sliding_window(past_stream.substr(4, 15), 4);
+    CPPUNIT_ASSERT_EQUAL(detector->change(past_stream),
+			 detector->change(past_stream.substr(8), 8));
+    CPPUNIT_ASSERT_EQUAL(detector->context_change(past_stream),
+			 detector->context_change(past_stream.substr(8), 8));
+    CPPUNIT_ASSERT_EQUAL(std::string(" jumped"), detector->change(past_stream.substr(8), 8));
+
+    detector->update_sliding_window(past_stream.substr(8), 8);
+    CPPUNIT_ASSERT_EQUAL(std::string("fox jumped"), detector->get_sliding_window());
+    CPPUNIT_ASSERT_EQUAL(false, detector->context_change(past_stream.substr(12), 12));
+    CPPUNIT_ASSERT_EQUAL(true, detector->context_change(past_stream.substr(12) + " ", 12));
+}
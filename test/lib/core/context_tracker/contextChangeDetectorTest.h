@@ -37,12 +37,14 @@ public:
     void testCharChanges();
     void testBlockChanges();
     void testGetChange();
+    void testAnchoredSlidingWindow();
 
 private:
     CPPUNIT_TEST_SUITE( ContextChangeDetectorTest );
     CPPUNIT_TEST( testCharChanges                 );
     CPPUNIT_TEST( testBlockChanges                );
     CPPUNIT_TEST( testGetChange                   );
+    CPPUNIT_TEST( testAnchoredSlidingWindow       );
     CPPUNIT_TEST_SUITE_END();
 
     ContextChangeDetector* detector;
@@ -26,10 +26,47 @@
 #include "../../common/stringstreamPresageCallback.h"
 
 #include <string>
+#include <thread>
 #include <assert.h>
 
 CPPUNIT_TEST_SUITE_REGISTRATION( ContextTrackerTest );
 
+namespace {
+
+/** String callback counting the past stream characters it copies.
+ */
+class TailPresageCallback : public PresageCallback {
+public:
+    TailPresageCallback() : copied(0) { }
+
+    std::string get_past_stream() const { copied += text.size(); return text; }
+    std::string get_future_stream() const { return ""; }
+    std::string get_past_stream_tail(size_t max_size, size_t& offset) const {
+	offset = (text.size() > max_size ? text.size() - max_size : 0);
+	copied += text.size() - offset;
+	return text.substr(offset);
+    }
+
+    std::string text;
+    mutable size_t copied;
+};
+
+std::string reverseToken(const std::string& text, const int index,
+			 const std::string& blankspaces, const std::string& separators)
+{
+    std::stringstream stream(text);
+    ReverseTokenizer tokenizer(stream, blankspaces, separators);
+    std::string token;
+    int i = 0;
+    while (tokenizer.hasMoreTokens() && i <= index) {
+	token = tokenizer.nextToken();
+	i++;
+    }
+    return (i <= index ? "" : token);
+}
+
+}
+
 void ContextTrackerTest::setUp()
 {
     testStringSuite = new TestStringSuite();
@@ -112,6 +149,185 @@ void ContextTrackerTest::testGetToken()
 }
 
 
+void ContextTrackerTest::testGetTokenIncremental()
+{
+    // edits applied in sequence to the past stream; the tokens
+    // returned by a tracker that has seen all previous edits must
+    // match the tokens of a freshly tokenized past stream
+    const char* edits[] = {
+	"The",
+	"The quick",
+	"The quick ",
+	"The quick brown",
+	"The quick brown fox.",
+	"The quick brown fox. Jumped",
+	"The quick brown fox. Jump",
+	"The quick brown fox.",
+	"The quick brown",
+	"The quack brown",
+	"The quack brown dog",
+	"",
+	"  leading blanks",
+	"  leading blanks, separators;",
+	0
+    };
+
+    std::stringstream buffer;
+    StringstreamPresageCallback callback(buffer);
+    ContextTracker hT(configuration, predictorRegistry, &callback);
+
+    for (int e = 0; edits[e] != 0; e++) {
+	buffer.str(edits[e]);
+	buffer.seekp(0, std::ios::end);
+
+	std::stringstream fresh_buffer(edits[e]);
+	for (int i = 0; i < 8; i++) {
+	    ReverseTokenizer tokenizer(fresh_buffer, hT.getBlankspaceChars(), hT.getSeparatorChars());
+	    std::string expected_token;
+	    int j = 0;
+	    while (tokenizer.hasMoreTokens() && j <= i) {
+		expected_token = tokenizer.nextToken();
+		j++;
+	    }
+	    if (j <= i) {
+		expected_token = "";
+	    }
+
+	    CPPUNIT_ASSERT_EQUAL( expected_token, hT.getToken(i) );
+	}
+    }
+
+    // tokens are not refreshed while a snapshot is held
+    buffer.str("foo bar");
+    hT.beginTokenSnapshot();
+    buffer.str("foo bar foobar");
+    CPPUNIT_ASSERT_EQUAL( std::string("bar"), hT.getPrefix() );
+    hT.endTokenSnapshot();
+    CPPUNIT_ASSERT_EQUAL( std::string("foobar"), hT.getPrefix() );
+}
+
+void ContextTrackerTest::testGetTokenWorkerThread()
+{
+    TailPresageCallback callback;
+    ContextTracker hT(configuration, predictorRegistry, &callback);
+
+    callback.text = "foo bar";
+    CPPUNIT_ASSERT_EQUAL( std::string("bar"), hT.getPrefix() );
+
+    // worker threads are answered from the cache, the callback is
+    // only queried from the thread driving the tracker
+    callback.text = "foo bar foobar";
+    callback.copied = 0;
+    std::string prefix;
+    std::thread worker([&hT, &prefix]() {
+	    ContextTracker::setWorkerThread();
+	    prefix = hT.getPrefix();
+	});
+    worker.join();
+    CPPUNIT_ASSERT_EQUAL( std::string("bar"), prefix );
+    CPPUNIT_ASSERT_EQUAL( (size_t) 0, callback.copied );
+
+    CPPUNIT_ASSERT_EQUAL( std::string("foobar"), hT.getPrefix() );
+}
+
+void ContextTrackerTest::testPastStreamWindow()
+{
+    TailPresageCallback callback;
+    ContextTracker hT(configuration, predictorRegistry, &callback);
+
+    std::stringstream words;
+    for (int i = 0; i < 20000; i++) {
+	words << "word" << i << (i % 10 == 9 ? ". " : " ");
+    }
+    const std::string document = words.str();
+    const std::string blankspaces = hT.getBlankspaceChars();
+    const std::string separators = hT.getSeparatorChars();
+
+    // tokens of a long past stream are taken from its end only
+    const char* edits[] = {
+	"foo",
+	" bar",
+	"\b",
+	"\b",
+	"r, foobar",
+	0
+    };
+    callback.text = document;
+    for (int e = 0; edits[e] != 0; e++) {
+	if (std::string(edits[e]) == "\b") {
+	    callback.text.erase(callback.text.size() - 1);
+	} else {
+	    callback.text += edits[e];
+	}
+	callback.copied = 0;
+	for (int i = 0; i < 6; i++) {
+	    CPPUNIT_ASSERT_EQUAL( reverseToken(callback.text, i, blankspaces, separators),
+				  hT.getToken(i) );
+	}
+	CPPUNIT_ASSERT( callback.copied < document.size() / 10 );
+    }
+
+    // tokens further back are found by requesting more of it
+    CPPUNIT_ASSERT_EQUAL( reverseToken(callback.text, 5000, blankspaces, separators),
+			  hT.getToken(5000) );
+    CPPUNIT_ASSERT_EQUAL( std::string("word19999"), hT.getToken(3) );
+
+    // and so is context change detection, once the sliding window
+    // has been filled
+    hT.update();
+    callback.copied = 0;
+    callback.text += " foo";
+    CPPUNIT_ASSERT( ! hT.contextChange() );
+    hT.update();
+    callback.text += " ";
+    CPPUNIT_ASSERT( hT.contextChange() );
+    hT.update();
+    CPPUNIT_ASSERT( callback.copied < document.size() );
+}
+
+void ContextTrackerTest::testPastStreamWindowSnapshot()
+{
+    TailPresageCallback callback;
+    ContextTracker hT(configuration, predictorRegistry, &callback);
+
+    std::stringstream words;
+    for (int i = 0; i < 20000; i++) {
+	words << "word" << i << ' ';
+    }
+    callback.text = words.str();
+    const std::string expected = reverseToken(callback.text, 5000,
+					      hT.getBlankspaceChars(),
+					      hT.getSeparatorChars());
+
+    // the callback is not queried during a snapshot, tokens further
+    // back are requested when the next one begins
+    hT.beginTokenSnapshot();
+    CPPUNIT_ASSERT_EQUAL( std::string(""), hT.getToken(5000) );
+    hT.endTokenSnapshot();
+
+    callback.copied = 0;
+    hT.beginTokenSnapshot();
+    CPPUNIT_ASSERT( callback.copied > 0 );
+    callback.copied = 0;
+    CPPUNIT_ASSERT_EQUAL( expected, hT.getToken(5000) );
+    CPPUNIT_ASSERT_EQUAL( (size_t) 0, callback.copied );
+    hT.endTokenSnapshot();
+
+    // the window stays grown while tokens that far back are needed...
+    callback.copied = 0;
+    hT.beginTokenSnapshot();
+    CPPUNIT_ASSERT_EQUAL( std::string("word19997"), hT.getToken(3) );
+    hT.endTokenSnapshot();
+    CPPUNIT_ASSERT( callback.copied > 5000 );
+
+    // ...and shrinks back once they are not
+    callback.copied = 0;
+    hT.beginTokenSnapshot();
+    CPPUNIT_ASSERT_EQUAL( std::string("word19997"), hT.getToken(3) );
+    hT.endTokenSnapshot();
+    CPPUNIT_ASSERT( callback.copied <= 1024 );
+}
+
 void ContextTrackerTest::testGetFutureStream()
 {}
 
@@ -41,6 +41,10 @@ public:
     void testConstructor();
     void testGetPrefix();
     void testGetToken();
+    void testGetTokenIncremental();
+    void testGetTokenWorkerThread();
+    void testPastStreamWindow();
+    void testPastStreamWindowSnapshot();
 
     void testGetFutureStream();
     void testGetPastStream();
@@ -61,6 +65,10 @@ private:
     CPPUNIT_TEST( testConstructor          );
     CPPUNIT_TEST( testGetPrefix            );
     CPPUNIT_TEST( testGetToken             );
+    CPPUNIT_TEST( testGetTokenIncremental  );
+    CPPUNIT_TEST( testGetTokenWorkerThread );
+    CPPUNIT_TEST( testPastStreamWindow     );
+    CPPUNIT_TEST( testPastStreamWindowSnapshot );
     CPPUNIT_TEST( testGetFutureStream      );
     CPPUNIT_TEST( testGetPastStream        );
     CPPUNIT_TEST( testToString             );
@@ -0,0 +1,206 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+#include "learnerTest.h"
+
+#include "../common/stringstreamPresageCallback.h"
+
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <stdio.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION( LearnerTest );
+
+void LearnerTest::setUp()
+{
+    journal = "learnerTest.journal";
+    remove(journal.c_str());
+    remove((journal + ".lock").c_str());
+
+    configuration = new Configuration();
+    configuration->insert (PredictorRegistry::LOGGER, "ERROR");
+    configuration->insert (PredictorRegistry::PREDICTORS, "");
+    configuration->insert (ContextTracker::LOGGER, "ERROR");
+    configuration->insert (ContextTracker::SLIDING_WINDOW_SIZE, "80");
+    configuration->insert (ContextTracker::LOWERCASE_MODE, "no");
+    configuration->insert (ContextTracker::ONLINE_LEARNING, "yes");
+    configuration->insert (Learner::LOGGER, "ERROR");
+    configuration->insert (Learner::QUEUE_SIZE, "8");
+    configuration->insert (Learner::IDLE_DELAY, "60000");
+    configuration->insert (Learner::CONTEXT_TOKENS, "2");
+    configuration->insert (Learner::JOURNAL, "");
+
+    predictorRegistry = new PredictorRegistry(configuration);
+    strstream = new std::stringstream();
+    callback = new StringstreamPresageCallback(*strstream);
+    contextTracker = new ContextTracker(configuration, predictorRegistry, callback);
+    learner = new Learner(configuration, contextTracker);
+}
+
+void LearnerTest::tearDown()
+{
+    delete learner;
+    delete contextTracker;
+    delete callback;
+    delete strstream;
+    delete predictorRegistry;
+    delete configuration;
+
+    remove(journal.c_str());
+    remove((journal + ".lock").c_str());
+}
+
+std::string LearnerTest::readJournal() const
+{
+    std::ifstream in(journal.c_str());
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+void LearnerTest::testSynchronous()
+{
+    configuration->find (Learner::QUEUE_SIZE)->set_value ("0");
+
+    *strstream << "the quick brown ";
+    contextTracker->update();
+
+    CPPUNIT_ASSERT_EQUAL(0ul, (unsigned long) learner->pending());
+    CPPUNIT_ASSERT_EQUAL(1ul, contextTracker->getLearnCount());
+}
+
+void LearnerTest::testLearntOnFlush()
+{
+    *strstream << "the quick brown ";
+    contextTracker->update();
+
+    CPPUNIT_ASSERT_EQUAL(1ul, (unsigned long) learner->pending());
+    CPPUNIT_ASSERT_EQUAL(0ul, contextTracker->getLearnCount());
+
+    learner->flush();
+    CPPUNIT_ASSERT_EQUAL(0ul, (unsigned long) learner->pending());
+    CPPUNIT_ASSERT_EQUAL(1ul, contextTracker->getLearnCount());
+
+    // nothing left to learn
+    learner->flush();
+    CPPUNIT_ASSERT_EQUAL(1ul, contextTracker->getLearnCount());
+}
+
+void LearnerTest::testLearntWhenIdle()
+{
+    configuration->find (Learner::IDLE_DELAY)->set_value ("10");
+
+    *strstream << "the quick brown ";
+    contextTracker->update();
+
+    for (int i = 0; i < 500 && contextTracker->getLearnCount() == 0; i++) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CPPUNIT_ASSERT_EQUAL(1ul, contextTracker->getLearnCount());
+}
+
+void LearnerTest::testMerge()
+{
+    // changes continuing the text of the previous change are learnt
+    // at once
+    *strstream << "the quick brown ";
+    contextTracker->update();
+    *strstream << "fox jumped ";
+    contextTracker->update();
+    *strstream << "over the ";
+    contextTracker->update();
+    CPPUNIT_ASSERT_EQUAL(1ul, (unsigned long) learner->pending());
+
+    // text entered elsewhere is learnt on its own
+    strstream->str("once upon a time ");
+    contextTracker->update();
+    CPPUNIT_ASSERT_EQUAL(2ul, (unsigned long) learner->pending());
+
+    learner->flush();
+    CPPUNIT_ASSERT_EQUAL(2ul, contextTracker->getLearnCount());
+}
+
+void LearnerTest::testJournal()
+{
+    configuration->find (Learner::JOURNAL)->set_value (journal);
+
+    *strstream << "the quick brown ";
+    contextTracker->update();
+    CPPUNIT_ASSERT_EQUAL(std::string("3\tthe\tquick\tbrown\t\tbrown\tquick\tthe\n"), readJournal());
+
+    *strstream << "fox ";
+    contextTracker->update();
+    CPPUNIT_ASSERT_EQUAL(std::string("3\tthe\tquick\tbrown\t\tbrown\tquick\tthe\n"
+				     "1\tfox\t\tfox\tbrown\tquick\n"), readJournal());
+
+    // learnt changes are dropped from the journal
+    learner->flush();
+    CPPUNIT_ASSERT_EQUAL(std::string(), readJournal());
+}
+
+void LearnerTest::testJournalReplay()
+{
+    {
+	std::ofstream out(journal.c_str());
+	out << "2\tthe\tquick\t\tquick\tthe\n"
+	    << "1\tbrown\t\tbrown\tquick\tthe\n"
+	    << "garbage\n";
+    }
+
+    // a learner opening the journal learns the changes left in it
+    delete learner;
+    configuration->find (Learner::JOURNAL)->set_value (journal);
+    learner = new Learner(configuration, contextTracker);
+
+    CPPUNIT_ASSERT_EQUAL(1ul, (unsigned long) learner->pending());
+    learner->flush();
+    CPPUNIT_ASSERT_EQUAL(1ul, contextTracker->getLearnCount());
+    CPPUNIT_ASSERT_EQUAL(std::string(), readJournal());
+}
+
+void LearnerTest::testJournalInUse()
+{
+    configuration->find (Learner::JOURNAL)->set_value (journal);
+
+    *strstream << "the quick brown ";
+    contextTracker->update();
+    const std::string journaled = readJournal();
+
+    // a learner finding the journal in use, as another process would,
+    // neither learns nor rewrites the changes left in it
+    Learner* other = new Learner(configuration, contextTracker);
+    CPPUNIT_ASSERT_EQUAL(0ul, (unsigned long) other->pending());
+    other->flush();
+    delete other;
+    CPPUNIT_ASSERT_EQUAL(journaled, readJournal());
+    CPPUNIT_ASSERT_EQUAL(0ul, contextTracker->getLearnCount());
+
+    // the journal is released with the learner holding it
+    delete learner;
+    CPPUNIT_ASSERT_EQUAL(std::string(), readJournal());
+    learner = new Learner(configuration, contextTracker);
+    *strstream << "fox ";
+    contextTracker->update();
+    CPPUNIT_ASSERT(! readJournal().empty());
+}
@@ -24,6 +24,8 @@
 
 #include "loggerTest.h"
 
+#include <sstream>
+
 CPPUNIT_TEST_SUITE_REGISTRATION( LoggerTest );
 
 void LoggerTest::setUp()
@@ -97,3 +99,43 @@ void LoggerTest::testCurrentLevelManipulator()
     logger << ALL   << "[LoggerTest] testCurrentLevelManipulator: ALL\n";
     CPPUNIT_ASSERT_EQUAL( Logger<char>::ALL, logger.getCurrentLevel());
 }
+
+static int evaluations = 0;
+
+static std::string evaluate()
+{
+    evaluations++;
+    return "evaluated";
+}
+
+void LoggerTest::testLazyEvaluation()
+{
+    std::stringstream stream;
+    Logger<char> logger("LoggerTest", stream, "ERROR");
+
+    evaluations = 0;
+    PRESAGE_LOG(logger, INFO) << evaluate() << endl;
+    CPPUNIT_ASSERT_EQUAL(0, evaluations);
+    CPPUNIT_ASSERT(stream.str().empty());
+
+    PRESAGE_LOG(logger, ERROR) << evaluate() << endl;
+    CPPUNIT_ASSERT_EQUAL(1, evaluations);
+    CPPUNIT_ASSERT_EQUAL(std::string("[LoggerTest] evaluated\n"), stream.str());
+
+    // the statement is not split by an enclosing if
+    stream.str("");
+    if (evaluations == 0)
+	PRESAGE_LOG(logger, ERROR) << "not reached" << endl;
+    else
+	PRESAGE_LOG(logger, ERROR) << "reached" << endl;
+    CPPUNIT_ASSERT_EQUAL(std::string("[LoggerTest] reached\n"), stream.str());
+
+    // messages built by several statements are guarded by their level
+    stream.str("");
+    if ((logger << DEBUG).shouldLog()) {
+	logger << evaluate();
+	logger << endl;
+    }
+    CPPUNIT_ASSERT_EQUAL(1, evaluations);
+    CPPUNIT_ASSERT(stream.str().empty());
+}
@@ -39,6 +39,7 @@ public:
 
     void testSetLevelManipulator();
     void testCurrentLevelManipulator();
+    void testLazyEvaluation();
 
 private:
 
@@ -47,6 +48,7 @@ private:
     CPPUNIT_TEST( testFileOutput          );
     CPPUNIT_TEST( testSetLevelManipulator );
     CPPUNIT_TEST( testCurrentLevelManipulator );
+    CPPUNIT_TEST( testLazyEvaluation );
     CPPUNIT_TEST_SUITE_END();
 };
 
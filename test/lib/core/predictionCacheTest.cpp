@@ -0,0 +1,196 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+#include "predictionCacheTest.h"
+#include "../common/stringstreamPresageCallback.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION( PredictionCacheTest );
+
+void PredictionCacheTest::setUp()
+{
+    configuration = new Configuration();
+    configuration->insert (PredictorRegistry::LOGGER, "ERROR");
+    configuration->insert (PredictorRegistry::PREDICTORS, "");
+    configuration->insert (ContextTracker::LOGGER, "ERROR");
+    configuration->insert (ContextTracker::SLIDING_WINDOW_SIZE, "80");
+    configuration->insert (ContextTracker::LOWERCASE_MODE, "no");
+    configuration->insert (ContextTracker::ONLINE_LEARNING, "yes");
+    configuration->insert (PredictionCache::LOGGER, "ERROR");
+    configuration->insert (PredictionCache::SIZE, "2");
+    configuration->insert (PredictionCache::CONTEXT_TOKENS, "1");
+
+    predictorRegistry = new PredictorRegistry(configuration);
+    strstream = new std::stringstream();
+    callback = new StringstreamPresageCallback(*strstream);
+    contextTracker  = new ContextTracker(configuration, predictorRegistry, callback);
+    predictionCache = new PredictionCache(configuration, contextTracker);
+}
+
+void PredictionCacheTest::tearDown()
+{
+    delete predictionCache;
+    delete contextTracker;
+    delete callback;
+    delete strstream;
+    delete predictorRegistry;
+    delete configuration;
+}
+
+Prediction PredictionCacheTest::makePrediction(const std::string& word) const
+{
+    Prediction prediction;
+    prediction.addSuggestion(Suggestion(word, 0.5));
+    prediction.addSuggestion(Suggestion(word + "s", 0.25));
+    return prediction;
+}
+
+void PredictionCacheTest::testLookupMissThenHit()
+{
+    *strstream << "the quick bro";
+
+    Prediction actual;
+    CPPUNIT_ASSERT(! predictionCache->lookup(1, 0, actual));
+    CPPUNIT_ASSERT_EQUAL(1ul, predictionCache->get_misses());
+
+    Prediction expected = makePrediction("brown");
+    predictionCache->insert(1, 0, expected);
+
+    CPPUNIT_ASSERT(predictionCache->lookup(1, 0, actual));
+    CPPUNIT_ASSERT(expected == actual);
+    CPPUNIT_ASSERT_EQUAL(1ul, predictionCache->get_hits());
+
+    // statistics are not configuration, they must not be saved to
+    // the profile
+    CPPUNIT_ASSERT_THROW(configuration->find("Presage.PredictionCache.HITS"),
+			 Configuration::ConfigurationException);
+}
+
+void PredictionCacheTest::testContextChange()
+{
+    *strstream << "the quick bro";
+    predictionCache->insert(1, 0, makePrediction("brown"));
+
+    Prediction actual;
+    *strstream << "w";
+    CPPUNIT_ASSERT(! predictionCache->lookup(1, 0, actual));
+
+    // deleting a character and typing it again finds the prediction
+    strstream->str("the quick bro");
+    CPPUNIT_ASSERT(predictionCache->lookup(1, 0, actual));
+    CPPUNIT_ASSERT(makePrediction("brown") == actual);
+
+    // the same tokens occurring again later are another context
+    *strstream << "wn fox and the quick bro";
+    CPPUNIT_ASSERT(! predictionCache->lookup(1, 0, actual));
+
+    strstream->str("a very slow bro");
+    CPPUNIT_ASSERT(! predictionCache->lookup(1, 0, actual));
+}
+
+void PredictionCacheTest::testMultiplierAndFilter()
+{
+    *strstream << "the quick bro";
+    predictionCache->insert(1, 0, makePrediction("brown"));
+
+    Prediction actual;
+    CPPUNIT_ASSERT(! predictionCache->lookup(2, 0, actual));
+
+    const char* filter[] = { "w", 0 };
+    CPPUNIT_ASSERT(! predictionCache->lookup(1, filter, actual));
+
+    predictionCache->insert(1, filter, makePrediction("brow"));
+    CPPUNIT_ASSERT(predictionCache->lookup(1, filter, actual));
+    CPPUNIT_ASSERT(makePrediction("brow") == actual);
+
+    const char* empty_filter[] = { 0 };
+    CPPUNIT_ASSERT(! predictionCache->lookup(1, empty_filter, actual));
+}
+
+void PredictionCacheTest::testEviction()
+{
+    Prediction actual;
+
+    strstream->str("the quick a");
+    predictionCache->insert(1, 0, makePrediction("a"));
+    strstream->str("the quick b");
+    predictionCache->insert(1, 0, makePrediction("b"));
+
+    // use a, so that b is the least recently used
+    strstream->str("the quick a");
+    CPPUNIT_ASSERT(predictionCache->lookup(1, 0, actual));
+
+    strstream->str("the quick c");
+    predictionCache->insert(1, 0, makePrediction("c"));
+
+    strstream->str("the quick b");
+    CPPUNIT_ASSERT(! predictionCache->lookup(1, 0, actual));
+    strstream->str("the quick a");
+    CPPUNIT_ASSERT(predictionCache->lookup(1, 0, actual));
+    strstream->str("the quick c");
+    CPPUNIT_ASSERT(predictionCache->lookup(1, 0, actual));
+
+    // shrinking the cache evicts the least recently used
+    configuration->find (PredictionCache::SIZE)->set_value ("1");
+    strstream->str("the quick a");
+    CPPUNIT_ASSERT(! predictionCache->lookup(1, 0, actual));
+    strstream->str("the quick c");
+    CPPUNIT_ASSERT(predictionCache->lookup(1, 0, actual));
+}
+
+void PredictionCacheTest::testLearnInvalidates()
+{
+    *strstream << "the quick bro";
+    predictionCache->insert(1, 0, makePrediction("brown"));
+
+    contextTracker->learn("the quick brown fox");
+
+    Prediction actual;
+    CPPUNIT_ASSERT(! predictionCache->lookup(1, 0, actual));
+
+    predictionCache->insert(1, 0, makePrediction("brown"));
+    contextTracker->forget("fox");
+    CPPUNIT_ASSERT(! predictionCache->lookup(1, 0, actual));
+}
+
+void PredictionCacheTest::testClear()
+{
+    *strstream << "the quick bro";
+    predictionCache->insert(1, 0, makePrediction("brown"));
+    predictionCache->clear();
+
+    Prediction actual;
+    CPPUNIT_ASSERT(! predictionCache->lookup(1, 0, actual));
+}
+
+void PredictionCacheTest::testDisabled()
+{
+    configuration->find (PredictionCache::SIZE)->set_value ("0");
+
+    *strstream << "the quick bro";
+    predictionCache->insert(1, 0, makePrediction("brown"));
+
+    Prediction actual;
+    CPPUNIT_ASSERT(! predictionCache->lookup(1, 0, actual));
+    CPPUNIT_ASSERT_EQUAL(0ul, predictionCache->get_hits());
+    CPPUNIT_ASSERT_EQUAL(0ul, predictionCache->get_misses());
+}
@@ -0,0 +1,66 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+#ifndef PRESAGE_PREDICTIONCACHETEST
+#define PRESAGE_PREDICTIONCACHETEST
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "core/predictorRegistry.h"
+#include "core/predictionCache.h"
+
+class PredictionCacheTest : public CppUnit::TestFixture { 
+public:
+    void setUp();
+    void tearDown();
+
+    void testLookupMissThenHit();
+    void testContextChange();
+    void testMultiplierAndFilter();
+    void testEviction();
+    void testLearnInvalidates();
+    void testClear();
+    void testDisabled();
+
+private:
+    Prediction makePrediction(const std::string& word) const;
+
+    Configuration*      configuration;
+    PredictorRegistry*  predictorRegistry;
+    std::stringstream*  strstream;
+    PresageCallback*    callback;
+    ContextTracker*     contextTracker;
+    PredictionCache*    predictionCache;
+
+    CPPUNIT_TEST_SUITE( PredictionCacheTest );
+    CPPUNIT_TEST( testLookupMissThenHit   );
+    CPPUNIT_TEST( testContextChange       );
+    CPPUNIT_TEST( testMultiplierAndFilter );
+    CPPUNIT_TEST( testEviction            );
+    CPPUNIT_TEST( testLearnInvalidates    );
+    CPPUNIT_TEST( testClear               );
+    CPPUNIT_TEST( testDisabled            );
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // PRESAGE_PREDICTIONCACHETEST
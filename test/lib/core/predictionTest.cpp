@@ -156,3 +156,30 @@ void PredictionTest::testAddSuggestion()
 
     delete pred;
 }
+
+void PredictionTest::testAddSuggestionAfterGetSuggestion()
+{
+    // suggestions added after the most probable suggestions have
+    // been read must still be ordered correctly
+    Prediction* pred = new Prediction();
+    const int total = 50;
+    for (int i = 0; i < total; i++) {
+	pred->addSuggestion(Suggestion("low", 0.001 * ((i * 7) % total)));
+    }
+    CPPUNIT_ASSERT_EQUAL( 0.049, pred->getSuggestion(0).getProbability() );
+
+    pred->addSuggestion(*sugg3Ptr);
+    pred->addSuggestion(*sugg1Ptr);
+    CPPUNIT_ASSERT( pred->getSuggestion(0) == *sugg3Ptr );
+    CPPUNIT_ASSERT( pred->getSuggestion(total + 1) == *sugg1Ptr );
+
+    for (size_t i = 1; i < pred->size(); i++) {
+	CPPUNIT_ASSERT( ! (pred->getSuggestion(i - 1) < pred->getSuggestion(i)) );
+    }
+
+    // the most probable suggestion with given token is returned
+    pred->addSuggestion(Suggestion("low", 0.2));
+    CPPUNIT_ASSERT_EQUAL( 0.2, pred->getSuggestion(std::string("low")).getProbability() );
+
+    delete pred;
+}
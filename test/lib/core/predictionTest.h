@@ -38,6 +38,7 @@ public:
     void testGetSize();
     void testGetSuggestion();
     void testAddSuggestion();
+    void testAddSuggestionAfterGetSuggestion();
 
 private:
     Suggestion* sugg1Ptr;
@@ -58,6 +59,7 @@ private:
     CPPUNIT_TEST( testGetSize );
     CPPUNIT_TEST( testGetSuggestion );
     CPPUNIT_TEST( testAddSuggestion );
+    CPPUNIT_TEST( testAddSuggestionAfterGetSuggestion );
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -0,0 +1,114 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#include "predictorActivatorTest.h"
+
+#include "../common/stringstreamPresageCallback.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION( PredictorActivatorTest );
+
+const int PredictorActivatorTest::DELAY = 300;
+const int PredictorActivatorTest::PREDICT_TIME = 20;
+
+void PredictorActivatorTest::setUp()
+{
+    configuration = new Configuration();
+    configuration->insert (PredictorRegistry::LOGGER, "ERROR");
+    configuration->insert (PredictorRegistry::PREDICTORS, "SlowPredictor");
+    configuration->insert ("Presage.Predictors.SlowPredictor.PREDICTOR", "DummyPredictor");
+    configuration->insert ("Presage.Predictors.SlowPredictor.DELAY", std::to_string (DELAY));
+    configuration->insert (ContextTracker::LOGGER, "ERROR");
+    configuration->insert (ContextTracker::SLIDING_WINDOW_SIZE, "80");
+    configuration->insert (ContextTracker::LOWERCASE_MODE, "no");
+    configuration->insert (ContextTracker::ONLINE_LEARNING, "no");
+    configuration->insert (PredictorActivator::LOGGER, "ERROR");
+    configuration->insert (PredictorActivator::PREDICT_TIME, std::to_string (PREDICT_TIME));
+    configuration->insert (PredictorActivator::COMBINATION_POLICY, "Meritocracy");
+    configuration->insert (PredictorActivator::MAX_PARTIAL_PREDICTION_SIZE, "6");
+
+    predictorRegistry = new PredictorRegistry(configuration);
+    strstream = new std::stringstream();
+    callback = new StringstreamPresageCallback(*strstream);
+    contextTracker = new ContextTracker(configuration, predictorRegistry, callback);
+    predictorActivator = new PredictorActivator(configuration, predictorRegistry, contextTracker);
+
+    *strstream << "the quick brown ";
+    start = std::chrono::steady_clock::now();
+}
+
+void PredictorActivatorTest::tearDown()
+{
+    delete predictorActivator;
+    delete contextTracker;
+    delete callback;
+    delete strstream;
+    delete predictorRegistry;
+    delete configuration;
+}
+
+long PredictorActivatorTest::elapsed() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>
+	(std::chrono::steady_clock::now() - start).count();
+}
+
+void PredictorActivatorTest::testLatePredictor()
+{
+    Prediction prediction = predictorActivator->predict (1, 0);
+
+    CPPUNIT_ASSERT(elapsed() < DELAY);
+    CPPUNIT_ASSERT_EQUAL(0ul, (unsigned long) prediction.size());
+
+    std::vector<std::string> late = predictorActivator->getLatePredictors();
+    CPPUNIT_ASSERT_EQUAL(1ul, (unsigned long) late.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("SlowPredictor"), late[0]);
+}
+
+void PredictorActivatorTest::testRemoveLatePredictor()
+{
+    predictorActivator->predict (1, 0);
+    CPPUNIT_ASSERT_EQUAL(1ul, (unsigned long) predictorActivator->getLatePredictors().size());
+
+    // the late predictor is deleted only once its prediction is over
+    configuration->find (PredictorRegistry::PREDICTORS)->set_value ("");
+    CPPUNIT_ASSERT(elapsed() >= DELAY);
+
+    Prediction prediction = predictorActivator->predict (1, 0);
+    CPPUNIT_ASSERT_EQUAL(0ul, (unsigned long) prediction.size());
+    CPPUNIT_ASSERT(predictorActivator->getLatePredictors().empty());
+}
+
+void PredictorActivatorTest::testReconfigureLatePredictor()
+{
+    predictorActivator->predict (1, 0);
+    CPPUNIT_ASSERT_EQUAL(1ul, (unsigned long) predictorActivator->getLatePredictors().size());
+
+    // the late predictor is reconfigured only once its prediction is over
+    configuration->find ("Presage.Predictors.SlowPredictor.DELAY")->set_value ("0");
+    CPPUNIT_ASSERT(elapsed() >= DELAY);
+
+    Prediction prediction = predictorActivator->predict (1, 0);
+    CPPUNIT_ASSERT(prediction.size() > 0);
+    CPPUNIT_ASSERT(predictorActivator->getLatePredictors().empty());
+}
@@ -0,0 +1,64 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#ifndef PRESAGE_PREDICTORACTIVATORTEST
+#define PRESAGE_PREDICTORACTIVATORTEST
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "core/predictorActivator.h"
+
+#include <chrono>
+
+class PredictorActivatorTest : public CppUnit::TestFixture { 
+public:
+    void setUp();
+    void tearDown();
+
+    void testLatePredictor();
+    void testRemoveLatePredictor();
+    void testReconfigureLatePredictor();
+
+private:
+    static const int DELAY;
+    static const int PREDICT_TIME;
+
+    long elapsed() const;
+
+    Configuration*      configuration;
+    PredictorRegistry*  predictorRegistry;
+    std::stringstream*  strstream;
+    PresageCallback*    callback;
+    ContextTracker*     contextTracker;
+    PredictorActivator* predictorActivator;
+    std::chrono::steady_clock::time_point start;
+
+    CPPUNIT_TEST_SUITE( PredictorActivatorTest );
+    CPPUNIT_TEST( testLatePredictor            );
+    CPPUNIT_TEST( testRemoveLatePredictor      );
+    CPPUNIT_TEST( testReconfigureLatePredictor );
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // PRESAGE_PREDICTORACTIVATORTEST
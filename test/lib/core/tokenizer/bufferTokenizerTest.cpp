@@ -0,0 +1,180 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#include "bufferTokenizerTest.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION( BufferTokenizerTest );
+
+void BufferTokenizerTest::setUp()
+{
+    tokenizer = new BufferTokenizer(" \n\t", ".,!");
+}
+
+void BufferTokenizerTest::tearDown()
+{
+    delete tokenizer;
+}
+
+void BufferTokenizerTest::testForward()
+{
+    const std::string text = "  foo, bar.\tfoobar";
+    size_t pos = 0;
+
+    CPPUNIT_ASSERT_EQUAL(std::string("foo"),
+			 tokenizer->forward(text.data(), text.size(), pos).str());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), pos);
+    CPPUNIT_ASSERT_EQUAL(std::string("bar"),
+			 tokenizer->forward(text.data(), text.size(), pos).str());
+    CPPUNIT_ASSERT_EQUAL(std::string("foobar"),
+			 tokenizer->forward(text.data(), text.size(), pos).str());
+    CPPUNIT_ASSERT_EQUAL(text.size(), pos);
+    CPPUNIT_ASSERT(tokenizer->forward(text.data(), text.size(), pos).empty());
+}
+
+void BufferTokenizerTest::testReverse()
+{
+    const std::string text = "foo, bar.\tfoobar";
+    size_t pos = text.size();
+
+    CPPUNIT_ASSERT_EQUAL(std::string("foobar"),
+			 tokenizer->reverse(text.data(), text.size(), pos).str());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(10), pos);
+    CPPUNIT_ASSERT_EQUAL(std::string("bar"),
+			 tokenizer->reverse(text.data(), text.size(), pos).str());
+    CPPUNIT_ASSERT_EQUAL(std::string("foo"),
+			 tokenizer->reverse(text.data(), text.size(), pos).str());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), pos);
+    CPPUNIT_ASSERT(tokenizer->reverse(text.data(), text.size(), pos).empty());
+}
+
+void BufferTokenizerTest::testTokensPointIntoBuffer()
+{
+    const std::string text = "foo bar";
+    size_t pos = 0;
+
+    tokenizer->forward(text.data(), text.size(), pos);
+    BufferTokenizer::Token token = tokenizer->forward(text.data(), text.size(), pos);
+    CPPUNIT_ASSERT(token.data == text.data() + 4);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), token.size);
+
+    pos = text.size();
+    token = tokenizer->reverse(text.data(), text.size(), pos);
+    CPPUNIT_ASSERT(token.data == text.data() + 4);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), token.size);
+}
+
+void BufferTokenizerTest::testTrailingDelimiters()
+{
+    // a buffer ending with delimiters has an empty last token
+    const std::string text = "foo bar. ";
+
+    size_t pos = 0;
+    CPPUNIT_ASSERT_EQUAL(std::string("foo"),
+			 tokenizer->forward(text.data(), text.size(), pos).str());
+    CPPUNIT_ASSERT_EQUAL(std::string("bar"),
+			 tokenizer->forward(text.data(), text.size(), pos).str());
+    CPPUNIT_ASSERT(pos < text.size());
+    CPPUNIT_ASSERT(tokenizer->forward(text.data(), text.size(), pos).empty());
+    CPPUNIT_ASSERT_EQUAL(text.size(), pos);
+
+    pos = text.size();
+    CPPUNIT_ASSERT(tokenizer->reverse(text.data(), text.size(), pos).empty());
+    CPPUNIT_ASSERT_EQUAL(text.size() - 1, pos);
+    CPPUNIT_ASSERT_EQUAL(std::string("bar"),
+			 tokenizer->reverse(text.data(), text.size(), pos).str());
+    CPPUNIT_ASSERT_EQUAL(std::string("foo"),
+			 tokenizer->reverse(text.data(), text.size(), pos).str());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), pos);
+}
+
+void BufferTokenizerTest::testOnlyDelimiters()
+{
+    const std::string text = " ,. ";
+
+    size_t pos = 0;
+    CPPUNIT_ASSERT(tokenizer->forward(text.data(), text.size(), pos).empty());
+    CPPUNIT_ASSERT_EQUAL(text.size(), pos);
+
+    pos = text.size();
+    CPPUNIT_ASSERT(tokenizer->reverse(text.data(), text.size(), pos).empty());
+    CPPUNIT_ASSERT(tokenizer->reverse(text.data(), text.size(), pos).empty());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), pos);
+
+    pos = 0;
+    CPPUNIT_ASSERT(tokenizer->forward("", 0, pos).empty());
+    CPPUNIT_ASSERT(tokenizer->reverse("", 0, pos).empty());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), pos);
+}
+
+void BufferTokenizerTest::testCharacterClasses()
+{
+    CPPUNIT_ASSERT(tokenizer->isBlankspace(' '));
+    CPPUNIT_ASSERT(! tokenizer->isSeparator(' '));
+    CPPUNIT_ASSERT(tokenizer->isSeparator(','));
+    CPPUNIT_ASSERT(! tokenizer->isBlankspace(','));
+    CPPUNIT_ASSERT(! tokenizer->isDelimiter('a'));
+
+    // setters replace the previous characters of their class only
+    tokenizer->separatorChars("-");
+    CPPUNIT_ASSERT(! tokenizer->isSeparator(','));
+    CPPUNIT_ASSERT(tokenizer->isSeparator('-'));
+    CPPUNIT_ASSERT(tokenizer->isBlankspace(' '));
+
+    tokenizer->blankspaceChars("_");
+    CPPUNIT_ASSERT(! tokenizer->isBlankspace(' '));
+    CPPUNIT_ASSERT(tokenizer->isBlankspace('_'));
+    CPPUNIT_ASSERT(tokenizer->isSeparator('-'));
+
+    const std::string text = "foo bar_baz-qux";
+    size_t pos = 0;
+    CPPUNIT_ASSERT_EQUAL(std::string("foo bar"),
+			 tokenizer->forward(text.data(), text.size(), pos).str());
+    CPPUNIT_ASSERT_EQUAL(std::string("baz"),
+			 tokenizer->forward(text.data(), text.size(), pos).str());
+    CPPUNIT_ASSERT_EQUAL(std::string("qux"),
+			 tokenizer->forward(text.data(), text.size(), pos).str());
+}
+
+void BufferTokenizerTest::testHighCharacters()
+{
+    // bytes above 0x7f index the table as unsigned characters
+    BufferTokenizer high(" \xa0", "\xbb");
+    CPPUNIT_ASSERT(high.isBlankspace('\xa0'));
+    CPPUNIT_ASSERT(high.isSeparator('\xbb'));
+    CPPUNIT_ASSERT(! high.isDelimiter('\xe8'));
+
+    const std::string text = "caff\xe8\xa0\xbbqui";
+    size_t pos = 0;
+    CPPUNIT_ASSERT_EQUAL(std::string("caff\xe8"),
+			 high.forward(text.data(), text.size(), pos).str());
+    CPPUNIT_ASSERT_EQUAL(std::string("qui"),
+			 high.forward(text.data(), text.size(), pos).str());
+}
+
+void BufferTokenizerTest::testLowercase()
+{
+    std::string str = "FooBAR";
+    BufferTokenizer::lowercase(str);
+    CPPUNIT_ASSERT_EQUAL(std::string("foobar"), str);
+}
@@ -0,0 +1,61 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#ifndef PRESAGE_BUFFERTOKENIZERTEST
+#define PRESAGE_BUFFERTOKENIZERTEST
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "core/tokenizer/bufferTokenizer.h"
+
+class BufferTokenizerTest : public CppUnit::TestFixture { 
+public:
+    void setUp();
+    void tearDown();
+
+    void testForward();
+    void testReverse();
+    void testTokensPointIntoBuffer();
+    void testTrailingDelimiters();
+    void testOnlyDelimiters();
+    void testCharacterClasses();
+    void testHighCharacters();
+    void testLowercase();
+
+private:
+    BufferTokenizer* tokenizer;
+
+    CPPUNIT_TEST_SUITE( BufferTokenizerTest );
+    CPPUNIT_TEST( testForward               );
+    CPPUNIT_TEST( testReverse               );
+    CPPUNIT_TEST( testTokensPointIntoBuffer );
+    CPPUNIT_TEST( testTrailingDelimiters    );
+    CPPUNIT_TEST( testOnlyDelimiters        );
+    CPPUNIT_TEST( testCharacterClasses      );
+    CPPUNIT_TEST( testHighCharacters        );
+    CPPUNIT_TEST( testLowercase             );
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // PRESAGE_BUFFERTOKENIZERTEST
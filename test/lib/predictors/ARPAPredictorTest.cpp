@@ -0,0 +1,343 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+#include "ARPAPredictorTest.h"
+#include "../common/stringstreamPresageCallback.h"
+
+#include "core/predictorRegistry.h"
+#include <fstream>
+#include <cstdio>  // for remove()
+#include <cmath>
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ARPAPredictorTest );
+
+const int   ARPAPredictorTest::SIZE          = 20;
+const char* ARPAPredictorTest::NAME          = "ARPAPredictor";
+const char* ARPAPredictorTest::ARPAFILENAME  = "Presage.Predictors.ARPAPredictor.ARPAFILENAME";
+const char* ARPAPredictorTest::ARPA_FILE     = "model.arpa";
+const char* ARPAPredictorTest::VOCAB_FILE    = "model.vocab";
+const char* ARPAPredictorTest::COMPILED_FILE = "model.bin";
+
+void ARPAPredictorTest::setUp()
+{
+    std::ofstream arpa(ARPA_FILE);
+    arpa << "\\data\\"                       << std::endl
+	 << "ngram 1=6"                      << std::endl
+	 << "ngram 2=5"                      << std::endl
+	 << "ngram 3=3"                      << std::endl
+	 << std::endl
+	 << "\\1-grams:"                     << std::endl
+	 << "-99.0\t<UNK>\t0"                << std::endl
+	 << "-1.0\tthe\t-0.5"                << std::endl
+	 << "-1.2\tquick\t-0.4"              << std::endl
+	 << "-1.5\tqueen\t-0.3"              << std::endl
+	 << "-1.1\tfox\t-0.2"                << std::endl
+	 << "-2.0\truns\t0"                  << std::endl
+	 << std::endl
+	 << "\\2-grams:"                     << std::endl
+	 << "-0.3\tthe quick\t-0.1"          << std::endl
+	 << "-0.7\tthe queen\t-0.2"          << std::endl
+	 << "-0.5\tquick fox\t-0.1"          << std::endl
+	 << "-0.4\tfox runs"                 << std::endl
+	 << "-0.9\tqueen runs"               << std::endl
+	 << std::endl
+	 << "\\3-grams:"                     << std::endl
+	 << "-0.1\tthe quick fox"            << std::endl
+	 << "-0.2\tthe queen runs"           << std::endl
+	 << "-0.3\tquick fox runs"           << std::endl
+	 << std::endl
+	 << "\\end\\"                        << std::endl;
+    arpa.close();
+
+    // vocabulary lists words in a different order than the unigrams
+    std::ofstream vocab(VOCAB_FILE);
+    vocab << "## vocabulary" << std::endl
+	  << "fox"           << std::endl
+	  << "the"           << std::endl
+	  << "quick"         << std::endl
+	  << "queen"         << std::endl
+	  << "runs"          << std::endl;
+    vocab.close();
+
+    config = new Configuration();
+    // set context tracker config variables
+    config->insert ("Presage.ContextTracker.LOGGER", "ERROR");
+    config->insert ("Presage.ContextTracker.SLIDING_WINDOW_SIZE", "80");
+    config->insert ("Presage.ContextTracker.LOWERCASE_MODE", "no");
+    config->insert ("Presage.ContextTracker.ONLINE_LEARNING", "no");
+    // set predictor registry config variables
+    config->insert ("Presage.PredictorRegistry.LOGGER", "ERROR");
+    config->insert ("Presage.PredictorRegistry.PREDICTORS", "");
+    // set ARPA predictor config variables
+    config->insert ("Presage.Predictors.ARPAPredictor.PREDICTOR", NAME);
+    config->insert ("Presage.Predictors.ARPAPredictor.LOGGER", "ERROR");
+    config->insert (ARPAFILENAME, ARPA_FILE);
+    config->insert ("Presage.Predictors.ARPAPredictor.VOCABFILENAME", VOCAB_FILE);
+    config->insert ("Presage.Predictors.ARPAPredictor.TIMEOUT", "100");
+
+    predictorRegistry = new PredictorRegistry(config);
+    stream = new std::stringstream();
+    callback = new StringstreamPresageCallback(*stream);
+    ct = new ContextTracker(config, predictorRegistry, callback);
+}
+
+void ARPAPredictorTest::tearDown()
+{
+    delete ct;
+    delete callback;
+    delete stream;
+    delete predictorRegistry;
+    delete config;
+
+    remove(ARPA_FILE);
+    remove(VOCAB_FILE);
+    remove(COMPILED_FILE);
+}
+
+void ARPAPredictorTest::assertModel(const ARPAModel& model) const
+{
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), model.order());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), model.size(1));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), model.size(2));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), model.size(3));
+
+    // word ids follow the vocabulary
+    CPPUNIT_ASSERT_EQUAL(0, model.find("fox"));
+    CPPUNIT_ASSERT_EQUAL(1, model.find("the"));
+    CPPUNIT_ASSERT_EQUAL(4, model.find("runs"));
+    CPPUNIT_ASSERT_EQUAL(-1, model.find("dog"));
+    CPPUNIT_ASSERT_EQUAL(-1, model.find("<UNK>"));
+    CPPUNIT_ASSERT_EQUAL(std::string("queen"), std::string(model.word(3)));
+
+    int the = model.find("the");
+    int quick = model.find("quick");
+    int fox = model.find("fox");
+    int runs = model.find("runs");
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, model.logProb(1, the), 1e-6);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(-0.5, model.backoff(1, the), 1e-6);
+
+    const int trigram[] = { the, quick, fox };
+    long index = model.find(trigram, 3);
+    CPPUNIT_ASSERT(index >= 0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(-0.1, model.logProb(3, index), 1e-6);
+    index = model.find(trigram, 2);
+    CPPUNIT_ASSERT(index >= 0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(-0.3, model.logProb(2, index), 1e-6);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(-0.1, model.backoff(2, index), 1e-6);
+
+    const int missing[] = { quick, the, runs };
+    CPPUNIT_ASSERT_EQUAL(-1L, model.find(missing, 2));
+    CPPUNIT_ASSERT_EQUAL(-1L, model.find(missing, 3));
+
+    const int other[] = { fox, runs };
+    index = model.find(other, 2);
+    CPPUNIT_ASSERT(index >= 0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(-0.4, model.logProb(2, index), 1e-6);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, model.backoff(2, index), 1e-6);
+
+    // words starting with a prefix are contiguous in the sorted vocabulary
+    size_t first, last;
+    model.prefixRange("qu", first, last);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), last - first);
+    CPPUNIT_ASSERT_EQUAL(model.find("queen"), model.sortedId(first));
+    CPPUNIT_ASSERT_EQUAL(quick, model.sortedId(first + 1));
+    model.prefixRange("", first, last);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), last - first);
+    model.prefixRange("dog", first, last);
+    CPPUNIT_ASSERT_EQUAL(first, last);
+
+    // likeliest words first
+    CPPUNIT_ASSERT_EQUAL(the, model.likeliestId(0));
+    CPPUNIT_ASSERT_EQUAL(fox, model.likeliestId(1));
+    CPPUNIT_ASSERT_EQUAL(runs, model.likeliestId(4));
+
+    // successors of a context, sorted by word id
+    long begin, end;
+    model.successors(2, the, begin, end);
+    CPPUNIT_ASSERT_EQUAL(2L, end - begin);
+    CPPUNIT_ASSERT_EQUAL(quick, model.lastWord(2, begin));
+    CPPUNIT_ASSERT_EQUAL(model.find("queen"), model.lastWord(2, begin + 1));
+    model.successors(3, model.find(trigram, 2), begin, end);
+    CPPUNIT_ASSERT_EQUAL(1L, end - begin);
+    CPPUNIT_ASSERT_EQUAL(fox, model.lastWord(3, begin));
+    model.successors(2, runs, begin, end);
+    CPPUNIT_ASSERT_EQUAL(begin, end);
+}
+
+void ARPAPredictorTest::testCompile()
+{
+    ARPAModel model;
+    model.compile(ARPA_FILE, VOCAB_FILE, 0);
+    assertModel(model);
+
+    // higher orders are skipped
+    model.compile(ARPA_FILE, VOCAB_FILE, 2);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), model.order());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), model.size(2));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), model.size(3));
+
+    CPPUNIT_ASSERT_THROW(model.compile("missing.arpa", "", 0), PresageException);
+}
+
+void ARPAPredictorTest::testCompileWithoutVocabulary()
+{
+    ARPAModel model;
+    model.compile(ARPA_FILE, "", 0);
+
+    // word ids follow the unigrams, the unknown word is skipped
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), model.size(1));
+    CPPUNIT_ASSERT_EQUAL(0, model.find("the"));
+    CPPUNIT_ASSERT_EQUAL(3, model.find("fox"));
+    CPPUNIT_ASSERT_EQUAL(-1, model.find("<UNK>"));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), model.size(3));
+}
+
+void ARPAPredictorTest::testSaveAndLoad()
+{
+    {
+	ARPAModel model;
+	model.compile(ARPA_FILE, VOCAB_FILE, 0);
+	model.save(COMPILED_FILE);
+    }
+
+    CPPUNIT_ASSERT(ARPAModel::isCompiled(COMPILED_FILE));
+    CPPUNIT_ASSERT(! ARPAModel::isCompiled(ARPA_FILE));
+    CPPUNIT_ASSERT(! ARPAModel::isCompiled("missing.bin"));
+
+    ARPAModel model;
+    model.load(COMPILED_FILE);
+    assertModel(model);
+
+    // a loaded model can be saved again
+    model.save(std::string(COMPILED_FILE) + ".copy");
+    ARPAModel copy;
+    copy.load(std::string(COMPILED_FILE) + ".copy");
+    assertModel(copy);
+    remove((std::string(COMPILED_FILE) + ".copy").c_str());
+
+    CPPUNIT_ASSERT_THROW(model.load(ARPA_FILE), PresageException);
+}
+
+void ARPAPredictorTest::testPredict()
+{
+    ARPAPredictor predictor(config, ct, NAME);
+
+    {
+	*stream << "the quick ";
+	Prediction actual = predictor.predict(SIZE, 0);
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), actual.size());
+	CPPUNIT_ASSERT_EQUAL(std::string("fox"), actual.getSuggestion(0).getWord());
+    }
+
+    {
+	*stream << "q";
+	Prediction actual = predictor.predict(SIZE, 0);
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), actual.size());
+	CPPUNIT_ASSERT_EQUAL(std::string("quick"), actual.getSuggestion(0).getWord());
+	CPPUNIT_ASSERT_EQUAL(std::string("queen"), actual.getSuggestion(1).getWord());
+    }
+
+    {
+	const char* filter[] = { "ue", 0 };
+	Prediction actual = predictor.predict(SIZE, filter);
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), actual.size());
+	CPPUNIT_ASSERT_EQUAL(std::string("queen"), actual.getSuggestion(0).getWord());
+    }
+}
+
+void ARPAPredictorTest::testPredictCompiled()
+{
+    {
+	ARPAModel model;
+	model.compile(ARPA_FILE, VOCAB_FILE, 0);
+	model.save(COMPILED_FILE);
+    }
+
+    ARPAPredictor text(config, ct, NAME);
+    config->find(ARPAFILENAME)->set_value(COMPILED_FILE);
+    ARPAPredictor compiled(config, ct, NAME);
+
+    // both models predict the same, whatever the context
+    const char* contexts[] = { "", "r", "the ", "the q", "the quick ", "quick fox ",
+			       "the queen ", "fox ", "dog ", "dog the ", "the dog ", 0 };
+    for (int i = 0; contexts[i] != 0; i++) {
+	stream->str(contexts[i]);
+	CPPUNIT_ASSERT_EQUAL(text.predict(SIZE, 0).toString(),
+			     compiled.predict(SIZE, 0).toString());
+	CPPUNIT_ASSERT_EQUAL(text.predict(2, 0).toString(),
+			     compiled.predict(2, 0).toString());
+    }
+}
+
+void ARPAPredictorTest::testPredictHigherOrder()
+{
+    std::ofstream arpa(ARPA_FILE);
+    arpa << "\\data\\"                       << std::endl
+	 << "ngram 1=5"                      << std::endl
+	 << "ngram 2=3"                      << std::endl
+	 << "ngram 3=1"                      << std::endl
+	 << "ngram 4=1"                      << std::endl
+	 << std::endl
+	 << "\\1-grams:"                     << std::endl
+	 << "-1.0\tthe\t-0.5"                << std::endl
+	 << "-1.2\tquick\t-0.4"              << std::endl
+	 << "-1.1\tfox\t-0.2"                << std::endl
+	 << "-2.0\truns\t0"                  << std::endl
+	 << "-1.8\tjumps\t0"                 << std::endl
+	 << std::endl
+	 << "\\2-grams:"                     << std::endl
+	 << "-0.3\tthe quick\t-0.1"          << std::endl
+	 << "-0.5\tquick fox\t-0.1"          << std::endl
+	 << "-0.4\tfox runs"                 << std::endl
+	 << std::endl
+	 << "\\3-grams:"                     << std::endl
+	 << "-0.1\tthe quick fox\t-0.3"      << std::endl
+	 << std::endl
+	 << "\\4-grams:"                     << std::endl
+	 << "-0.05\tthe quick fox jumps"     << std::endl
+	 << std::endl
+	 << "\\end\\"                        << std::endl;
+    arpa.close();
+
+    {
+	ARPAModel model;
+	model.compile(ARPA_FILE, "", 0);
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), model.order());
+	model.save(COMPILED_FILE);
+    }
+    config->find(ARPAFILENAME)->set_value(COMPILED_FILE);
+    ARPAPredictor predictor(config, ct, NAME);
+
+    *stream << "the quick fox ";
+    Prediction actual = predictor.predict(2, 0);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), actual.size());
+
+    // the 4-gram wins over the bigram the trigram context backs off to
+    CPPUNIT_ASSERT_EQUAL(std::string("jumps"), actual.getSuggestion(0).getWord());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(exp(-0.05), actual.getSuggestion(0).getProbability(), 1e-6);
+
+    // P(runs | the quick fox) = bow(the quick fox) + bow(quick fox) + P(runs | fox)
+    CPPUNIT_ASSERT_EQUAL(std::string("runs"), actual.getSuggestion(1).getWord());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(exp(-0.3 - 0.1 - 0.4), actual.getSuggestion(1).getProbability(), 1e-6);
+}
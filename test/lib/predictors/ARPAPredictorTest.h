@@ -0,0 +1,73 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+#ifndef PRESAGE_ARPAPREDICTORTEST
+#define PRESAGE_ARPAPREDICTORTEST
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <predictors/ARPAPredictor.h>
+
+/** Test ARPAPredictor and its ARPAModel.
+ * 
+ */
+class ARPAPredictorTest : public CppUnit::TestFixture {
+public: 
+    void setUp();
+    void tearDown();
+    
+    void testCompile();
+    void testCompileWithoutVocabulary();
+    void testSaveAndLoad();
+    void testPredict();
+    void testPredictCompiled();
+    void testPredictHigherOrder();
+
+private:
+    void assertModel(const ARPAModel& model) const;
+
+    Configuration*  config;
+    std::stringstream* stream;
+    PresageCallback* callback;
+    ContextTracker* ct;
+    PredictorRegistry* predictorRegistry;
+
+    static const int SIZE;
+    static const char* NAME;
+    static const char* ARPAFILENAME;
+    static const char* ARPA_FILE;
+    static const char* VOCAB_FILE;
+    static const char* COMPILED_FILE;
+
+    CPPUNIT_TEST_SUITE( ARPAPredictorTest );
+    CPPUNIT_TEST( testCompile );
+    CPPUNIT_TEST( testCompileWithoutVocabulary );
+    CPPUNIT_TEST( testSaveAndLoad );
+    CPPUNIT_TEST( testPredict );
+    CPPUNIT_TEST( testPredictCompiled );
+    CPPUNIT_TEST( testPredictHigherOrder );
+    CPPUNIT_TEST_SUITE_END();
+};
+
+
+#endif // PRESAGE_ARPAPREDICTORTEST
@@ -239,6 +239,51 @@ void SqliteDatabaseConnectorTest::testGetNgramCount()
     delete ngram;
 }
 
+void SqliteDatabaseConnectorTest::testGetNgramCounts()
+{
+    // populate database
+    sqliteDatabaseConnector->insertNgram(*unigram, MAGIC_NUMBER);
+    sqliteDatabaseConnector->insertNgram(*unigram1, MAGIC_NUMBER - 1);
+    sqliteDatabaseConnector->insertNgram(*trigram, MAGIC_NUMBER);
+    sqliteDatabaseConnector->insertNgram(*trigram1, MAGIC_NUMBER + 1);
+
+    std::vector<std::string> words;
+    words.push_back("foobar1");
+    words.push_back("unknown");
+    words.push_back("foobar");
+
+    Ngram context;
+    context.push_back("foo");
+    context.push_back("bar");
+    std::vector<int> counts = sqliteDatabaseConnector->getNgramCounts(context, words);
+    CPPUNIT_ASSERT_EQUAL(size_t(3), counts.size());
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER + 1, counts[0]);
+    CPPUNIT_ASSERT_EQUAL(0, counts[1]);
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER, counts[2]);
+
+    // empty context looks up unigrams
+    words.push_back("foo1");
+    words.push_back("foo");
+    counts = sqliteDatabaseConnector->getNgramCounts(Ngram(), words);
+    CPPUNIT_ASSERT_EQUAL(size_t(5), counts.size());
+    CPPUNIT_ASSERT_EQUAL(0, counts[0]);
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER - 1, counts[3]);
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER, counts[4]);
+
+    // batches larger than a single query agree with single lookups
+    std::vector<std::string> many;
+    for (int i = 0; i < 150; i++) {
+	std::stringstream ss;
+	ss << "foobar" << i;
+	many.push_back(ss.str());
+    }
+    counts = sqliteDatabaseConnector->getNgramCounts(context, many);
+    CPPUNIT_ASSERT_EQUAL(many.size(), counts.size());
+    for (size_t i = 0; i < many.size(); i++) {
+	CPPUNIT_ASSERT_EQUAL((i == 1 ? MAGIC_NUMBER + 1 : 0), counts[i]);
+    }
+}
+
 void SqliteDatabaseConnectorTest::testIncrementNgramCount()
 {
     // populate database
@@ -281,6 +326,63 @@ void SqliteDatabaseConnectorTest::testIncrementNgramCount()
     assertDatabaseDumpEqualsBenchmark(benchmark);
 }
 
+void SqliteDatabaseConnectorTest::testAddNgramCounts()
+{
+    sqliteDatabaseConnector->insertNgram(*unigram, MAGIC_NUMBER);
+    sqliteDatabaseConnector->insertNgram(*trigram, MAGIC_NUMBER);
+
+    NgramCounts ngrams;
+    ngrams.push_back(std::make_pair(*unigram, 2));
+    ngrams.push_back(std::make_pair(*unigram1, 3));
+    ngrams.push_back(std::make_pair(*bigram, 4));
+    ngrams.push_back(std::make_pair(*trigram, 5));
+    sqliteDatabaseConnector->addNgramCounts(ngrams.begin(), ngrams.end());
+
+    // counts are added to existing ngrams, new ngrams are inserted
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER + 2, sqliteDatabaseConnector->getNgramCount(*unigram));
+    CPPUNIT_ASSERT_EQUAL(3, sqliteDatabaseConnector->getNgramCount(*unigram1));
+    CPPUNIT_ASSERT_EQUAL(4, sqliteDatabaseConnector->getNgramCount(*bigram));
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER + 5, sqliteDatabaseConnector->getNgramCount(*trigram));
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER + 5, sqliteDatabaseConnector->getUnigramCountsSum());
+
+    sqliteDatabaseConnector->addNgramCounts(ngrams.begin() + 1, ngrams.begin() + 2);
+    CPPUNIT_ASSERT_EQUAL(6, sqliteDatabaseConnector->getNgramCount(*unigram1));
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER + 2, sqliteDatabaseConnector->getNgramCount(*unigram));
+}
+
+void SqliteDatabaseConnectorTest::testRaisePrefixCounts()
+{
+    sqliteDatabaseConnector->insertNgram(*unigram, 2);
+    sqliteDatabaseConnector->insertNgram(*bigram, 1);
+    sqliteDatabaseConnector->insertNgram(*bigram1, 3);
+    sqliteDatabaseConnector->insertNgram(*trigram, MAGIC_NUMBER);
+    sqliteDatabaseConnector->insertNgram(*trigram1, MAGIC_NUMBER + 1);
+
+    NgramCounts ngrams;
+    ngrams.push_back(std::make_pair(*trigram, 1));
+    sqliteDatabaseConnector->raisePrefixCounts(ngrams);
+
+    // prefixes are raised to the most frequent ngram extending them,
+    // longer prefixes first
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER + 1, sqliteDatabaseConnector->getNgramCount(*bigram));
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER + 1, sqliteDatabaseConnector->getNgramCount(*unigram));
+    CPPUNIT_ASSERT_EQUAL(3, sqliteDatabaseConnector->getNgramCount(*bigram1));
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER + 1, sqliteDatabaseConnector->getUnigramCountsSum());
+
+    // missing prefixes are created, consistent ones are left alone
+    Ngram other;
+    other.push_back("foo1");
+    other.push_back("bar");
+    sqliteDatabaseConnector->insertNgram(other, 2);
+    ngrams.push_back(std::make_pair(other, 2));
+    ngrams.push_back(std::make_pair(*bigram1, 3));
+    sqliteDatabaseConnector->raisePrefixCounts(ngrams);
+
+    CPPUNIT_ASSERT_EQUAL(2, sqliteDatabaseConnector->getNgramCount(*unigram1));
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER + 1, sqliteDatabaseConnector->getNgramCount(*bigram));
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER + 1, sqliteDatabaseConnector->getNgramCount(*unigram));
+}
+
 void SqliteDatabaseConnectorTest::testGetNgramLikeTable()
 {
     // populate database
@@ -367,6 +469,79 @@ void SqliteDatabaseConnectorTest::testGetNgramLikeTable()
     delete expected_tri;
 }
 
+void SqliteDatabaseConnectorTest::testGetPredictedWords()
+{
+    // populate database
+    sqliteDatabaseConnector->insertNgram(*trigram, MAGIC_NUMBER);
+    sqliteDatabaseConnector->insertNgram(*trigram1, MAGIC_NUMBER + 1);
+    sqliteDatabaseConnector->insertNgram(*unigram, MAGIC_NUMBER);
+    sqliteDatabaseConnector->insertNgram(*unigram1, MAGIC_NUMBER - 1);
+
+    // words are returned in descending count order
+    std::vector<std::string> actual =
+	sqliteDatabaseConnector->getPredictedWords(*trigram, 0, 0);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), actual.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("foobar1"), actual[0]);
+    CPPUNIT_ASSERT_EQUAL(std::string("foobar"), actual[1]);
+
+    // limit and count threshold are honoured
+    actual = sqliteDatabaseConnector->getPredictedWords(*trigram, 0, 0, 1);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), actual.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("foobar1"), actual[0]);
+
+    // offset resumes where a previous query left off
+    actual = sqliteDatabaseConnector->getPredictedWords(*trigram, 0, 0, 1, 1);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), actual.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("foobar"), actual[0]);
+
+    actual = sqliteDatabaseConnector->getPredictedWords(*trigram, 0, 0, -1, 1);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), actual.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("foobar"), actual[0]);
+
+    actual = sqliteDatabaseConnector->getPredictedWords(*trigram, 0, 0, 1, 2);
+    CPPUNIT_ASSERT(actual.empty());
+
+    actual = sqliteDatabaseConnector->getPredictedWords(*unigram, 0, MAGIC_NUMBER);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), actual.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("foo"), actual[0]);
+
+    // filter restricts candidates to the given prefixes
+    const char* filter[] = { "1", 0 };
+    actual = sqliteDatabaseConnector->getPredictedWords(*unigram, filter, 0);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), actual.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("foo1"), actual[0]);
+
+    // repeated lookups reuse the cached statements
+    actual = sqliteDatabaseConnector->getPredictedWords(*unigram, filter, 0);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), actual.size());
+
+    // an empty filter is no filter
+    const char* empty_filter[] = { 0 };
+    actual = sqliteDatabaseConnector->getPredictedWords(*unigram, empty_filter, 0);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), actual.size());
+}
+
+void SqliteDatabaseConnectorTest::testQuotedNgram()
+{
+    Ngram ngram;
+    ngram.push_back("don't");
+    ngram.push_back("o'clock");
+
+    sqliteDatabaseConnector->insertNgram(ngram, MAGIC_NUMBER);
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER, sqliteDatabaseConnector->getNgramCount(ngram));
+
+    sqliteDatabaseConnector->incrementNgramCount(ngram);
+    CPPUNIT_ASSERT_EQUAL(MAGIC_NUMBER + 1, sqliteDatabaseConnector->getNgramCount(ngram));
+
+    Ngram prefix;
+    prefix.push_back("don't");
+    prefix.push_back("o'");
+    std::vector<std::string> actual =
+	sqliteDatabaseConnector->getPredictedWords(prefix, 0, 0);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), actual.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("o'clock"), actual[0]);
+}
+
 void SqliteDatabaseConnectorTest::assertEqualNgramTable(const NgramTable* const expected, const NgramTable& actual)
 {
     CPPUNIT_ASSERT_EQUAL(expected->size(), actual.size());
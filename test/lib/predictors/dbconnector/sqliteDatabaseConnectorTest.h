@@ -47,8 +47,13 @@ public:
     void testUpdateNgram();
     void testRemoveNgram();
     void testGetNgramCount();
+    void testGetNgramCounts();
     void testIncrementNgramCount();
+    void testAddNgramCounts();
+    void testRaisePrefixCounts();
     void testGetNgramLikeTable();
+    void testGetPredictedWords();
+    void testQuotedNgram();
 
 private:
     void assertExistsAndRemoveFile(const char* filename) const;
@@ -75,8 +80,13 @@ private:
     CPPUNIT_TEST( testUpdateNgram                   );
     CPPUNIT_TEST( testRemoveNgram                   );
     CPPUNIT_TEST( testGetNgramCount                 );
+    CPPUNIT_TEST( testGetNgramCounts                );
     CPPUNIT_TEST( testIncrementNgramCount           );
+    CPPUNIT_TEST( testAddNgramCounts                );
+    CPPUNIT_TEST( testRaisePrefixCounts             );
     CPPUNIT_TEST( testGetNgramLikeTable             );
+    CPPUNIT_TEST( testGetPredictedWords             );
+    CPPUNIT_TEST( testQuotedNgram                   );
     CPPUNIT_TEST_SUITE_END();
 };
 
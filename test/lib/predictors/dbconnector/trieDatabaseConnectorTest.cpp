@@ -0,0 +1,270 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#include "trieDatabaseConnectorTest.h"
+
+#include <marisa.h>
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TrieDatabaseConnectorTest );
+
+const char*  TrieDatabaseConnectorTest::DATABASE = "trie_database";
+const size_t TrieDatabaseConnectorTest::CARDINALITY = 3;
+
+static const char* DATABASE_FILES[] = {
+    "/ngrams.trie",
+    "/ngrams.counts",
+    "/ngrams.log",
+    "/ngrams.trie.compact",
+    "/ngrams.trie.compact.part",
+    "/ngrams.counts.compact",
+    "/ngrams.log.compact",
+    0
+};
+
+void TrieDatabaseConnectorTest::setUp()
+{
+    buildDatabase();
+    db = new TrieDatabaseConnector(DATABASE, CARDINALITY, true, "ERROR");
+    db->setCompactionThreshold(0);
+}
+
+void TrieDatabaseConnectorTest::tearDown()
+{
+    delete db;
+
+    for (int i = 0; DATABASE_FILES[i] != 0; i++) {
+	remove((std::string(DATABASE) + DATABASE_FILES[i]).c_str());
+    }
+    rmdir(DATABASE);
+}
+
+void TrieDatabaseConnectorTest::buildDatabase() const
+{
+    const char* keys[] = {
+	"1 foo",
+	"1 bar",
+	"1 foobar",
+	"2 foo bar",
+	"2 bar foobar",
+	"3 foo bar foobar",
+	0
+    };
+    const int counts[] = { 4, 2, 1, 2, 1, 1 };
+
+    mkdir(DATABASE, 0755);
+
+    marisa::Keyset keyset;
+    for (int i = 0; keys[i] != 0; i++) {
+	keyset.push_back(keys[i], std::string(keys[i]).length());
+    }
+    marisa::Trie trie;
+    trie.build(keyset);
+    trie.save((std::string(DATABASE) + "/ngrams.trie").c_str());
+
+    // unigram counts sum, then counts by key id
+    std::vector<int32_t> data(trie.num_keys() + 1, 0);
+    data[0] = 7;
+    for (size_t i = 0; i < keyset.size(); i++) {
+	data[keyset[i].id() + 1] = counts[i];
+    }
+    std::ofstream out((std::string(DATABASE) + "/ngrams.counts").c_str(),
+		      std::ios::out | std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&data[0]), data.size() * sizeof(int32_t));
+}
+
+void TrieDatabaseConnectorTest::reopen()
+{
+    delete db;
+    db = new TrieDatabaseConnector(DATABASE, CARDINALITY, true, "ERROR");
+    db->setCompactionThreshold(0);
+}
+
+std::string TrieDatabaseConnectorTest::readLog() const
+{
+    std::ifstream in((std::string(DATABASE) + "/ngrams.log").c_str());
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+int TrieDatabaseConnectorTest::count(const char* w1, const char* w2, const char* w3) const
+{
+    Ngram ngram;
+    ngram.push_back(w1);
+    if (w2) {
+	ngram.push_back(w2);
+    }
+    if (w3) {
+	ngram.push_back(w3);
+    }
+    return db->getNgramCount(ngram);
+}
+
+void TrieDatabaseConnectorTest::testGetNgramCount()
+{
+    CPPUNIT_ASSERT_EQUAL(4, count("foo"));
+    CPPUNIT_ASSERT_EQUAL(2, count("foo", "bar"));
+    CPPUNIT_ASSERT_EQUAL(1, count("foo", "bar", "foobar"));
+    CPPUNIT_ASSERT_EQUAL(0, count("baz"));
+    CPPUNIT_ASSERT_EQUAL(7, db->getUnigramCountsSum());
+}
+
+void TrieDatabaseConnectorTest::testLearn()
+{
+    NgramCounts ngrams;
+    ngrams.push_back(std::make_pair(Ngram(1, "foo"), 1));
+    ngrams.push_back(std::make_pair(Ngram(1, "baz"), 3));
+    Ngram foo_baz;
+    foo_baz.push_back("foo");
+    foo_baz.push_back("baz");
+    ngrams.push_back(std::make_pair(foo_baz, 3));
+
+    db->beginTransaction();
+    db->addNgramCounts(ngrams.begin(), ngrams.end());
+    db->endTransaction();
+
+    CPPUNIT_ASSERT_EQUAL(5, count("foo"));
+    CPPUNIT_ASSERT_EQUAL(3, count("baz"));
+    CPPUNIT_ASSERT_EQUAL(3, count("foo", "baz"));
+    CPPUNIT_ASSERT_EQUAL(11, db->getUnigramCountsSum());
+
+    // learnt counts are replayed from the log
+    reopen();
+    CPPUNIT_ASSERT_EQUAL(5, count("foo"));
+    CPPUNIT_ASSERT_EQUAL(3, count("foo", "baz"));
+    CPPUNIT_ASSERT_EQUAL(11, db->getUnigramCountsSum());
+
+    // learnt n-grams are merged with those in the trie
+    Ngram foo_b;
+    foo_b.push_back("foo");
+    foo_b.push_back("b");
+    std::vector<std::string> predicted = db->getPredictedWords(foo_b, 0, 0);
+    CPPUNIT_ASSERT_EQUAL((size_t) 2, predicted.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("baz"), predicted[0]);
+    CPPUNIT_ASSERT_EQUAL(std::string("bar"), predicted[1]);
+}
+
+void TrieDatabaseConnectorTest::testForget()
+{
+    db->beginTransaction();
+    db->dropNgramsWithWord("bar");
+    db->endTransaction();
+
+    // one line is logged for the word, not one per n-gram
+    CPPUNIT_ASSERT_EQUAL(std::string("- bar\n"), readLog());
+
+    CPPUNIT_ASSERT_EQUAL(0, count("bar"));
+    CPPUNIT_ASSERT_EQUAL(0, count("foo", "bar"));
+    CPPUNIT_ASSERT_EQUAL(0, count("foo", "bar", "foobar"));
+    CPPUNIT_ASSERT_EQUAL(4, count("foo"));
+    CPPUNIT_ASSERT_EQUAL(1, count("foobar"));
+    CPPUNIT_ASSERT_EQUAL(5, db->getUnigramCountsSum());
+
+    Ngram foo_b;
+    foo_b.push_back("foo");
+    foo_b.push_back("b");
+    CPPUNIT_ASSERT(db->getPredictedWords(foo_b, 0, 0).empty());
+
+    std::vector<std::string> words;
+    words.push_back("bar");
+    CPPUNIT_ASSERT_EQUAL(0, db->getNgramCounts(Ngram(1, "foo"), words)[0]);
+
+    reopen();
+    CPPUNIT_ASSERT_EQUAL(0, count("foo", "bar"));
+    CPPUNIT_ASSERT_EQUAL(4, count("foo"));
+    CPPUNIT_ASSERT_EQUAL(5, db->getUnigramCountsSum());
+}
+
+void TrieDatabaseConnectorTest::testRelearnForgotten()
+{
+    Ngram foo_bar;
+    foo_bar.push_back("foo");
+    foo_bar.push_back("bar");
+
+    db->insertNgram(Ngram(1, "baz"), 1);
+    db->insertNgram(Ngram(1, "bar"), 1);
+    db->dropNgramsWithWord("bar");
+    db->insertNgram(foo_bar, 1);
+    db->endTransaction();
+
+    // n-grams learnt after the word was dropped are kept
+    CPPUNIT_ASSERT_EQUAL(1, count("foo", "bar"));
+    CPPUNIT_ASSERT_EQUAL(0, count("bar"));
+    CPPUNIT_ASSERT_EQUAL(0, count("foo", "bar", "foobar"));
+    CPPUNIT_ASSERT_EQUAL(1, count("baz"));
+    CPPUNIT_ASSERT_EQUAL(6, db->getUnigramCountsSum());
+
+    reopen();
+    CPPUNIT_ASSERT_EQUAL(1, count("foo", "bar"));
+    CPPUNIT_ASSERT_EQUAL(0, count("bar"));
+    CPPUNIT_ASSERT_EQUAL(0, count("foo", "bar", "foobar"));
+    CPPUNIT_ASSERT_EQUAL(1, count("baz"));
+    CPPUNIT_ASSERT_EQUAL(6, db->getUnigramCountsSum());
+}
+
+void TrieDatabaseConnectorTest::testCompact()
+{
+    Ngram foo_bar;
+    foo_bar.push_back("foo");
+    foo_bar.push_back("bar");
+
+    db->insertNgram(Ngram(1, "baz"), 3);
+    db->dropNgramsWithWord("foobar");
+    db->updateNgram(foo_bar, 5);
+    db->endTransaction();
+
+    db->compact();
+
+    // the learnt counts and dropped word are folded into the new
+    // trie, leaving the log empty
+    CPPUNIT_ASSERT_EQUAL(std::string(""), readLog());
+    CPPUNIT_ASSERT_EQUAL(3, count("baz"));
+    CPPUNIT_ASSERT_EQUAL(5, count("foo", "bar"));
+    CPPUNIT_ASSERT_EQUAL(0, count("foobar"));
+    CPPUNIT_ASSERT_EQUAL(0, count("bar", "foobar"));
+    CPPUNIT_ASSERT_EQUAL(9, db->getUnigramCountsSum());
+
+    // words dropped and counts learnt after compaction still apply
+    db->dropNgramsWithWord("baz");
+    db->insertNgram(Ngram(1, "foobar"), 2);
+    db->endTransaction();
+    CPPUNIT_ASSERT_EQUAL(0, count("baz"));
+    CPPUNIT_ASSERT_EQUAL(2, count("foobar"));
+    CPPUNIT_ASSERT_EQUAL(8, db->getUnigramCountsSum());
+
+    reopen();
+    CPPUNIT_ASSERT_EQUAL(0, count("baz"));
+    CPPUNIT_ASSERT_EQUAL(2, count("foobar"));
+    CPPUNIT_ASSERT_EQUAL(5, count("foo", "bar"));
+    CPPUNIT_ASSERT_EQUAL(0, count("bar", "foobar"));
+    CPPUNIT_ASSERT_EQUAL(8, db->getUnigramCountsSum());
+}
@@ -0,0 +1,69 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#ifndef PRESAGE_TRIEDATABASECONNECTORTEST
+#define PRESAGE_TRIEDATABASECONNECTORTEST
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "predictors/dbconnector/trieDatabaseConnector.h"
+
+#include <string>
+
+/** Tests learning, forgetting and compaction of the n-gram counts
+ *  kept on top of a MARISA trie.
+ */
+class TrieDatabaseConnectorTest : public CppUnit::TestFixture { 
+public:
+    void setUp();
+    void tearDown();
+
+    void testGetNgramCount();
+    void testLearn();
+    void testForget();
+    void testRelearnForgotten();
+    void testCompact();
+
+private:
+    void buildDatabase() const;
+    void reopen();
+    std::string readLog() const;
+
+    int count(const char* w1, const char* w2 = 0, const char* w3 = 0) const;
+
+    TrieDatabaseConnector* db;
+
+    static const char*  DATABASE;
+    static const size_t CARDINALITY;
+
+    CPPUNIT_TEST_SUITE( TrieDatabaseConnectorTest );
+    CPPUNIT_TEST( testGetNgramCount    );
+    CPPUNIT_TEST( testLearn            );
+    CPPUNIT_TEST( testForget           );
+    CPPUNIT_TEST( testRelearnForgotten );
+    CPPUNIT_TEST( testCompact          );
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // PRESAGE_TRIEDATABASECONNECTORTEST
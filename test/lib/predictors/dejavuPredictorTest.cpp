@@ -28,6 +28,7 @@
 #include "core/predictorRegistry.h"
 #include <math.h>  // for exp()
 #include <cstdio>  // for remove()
+#include <fstream>
 
 CPPUNIT_TEST_SUITE_REGISTRATION( DejavuPredictorTest );
 
@@ -191,3 +192,61 @@ void DejavuPredictorTest::testPredict()
     *stream << "uddle ";
     ct->update();
 }
+
+void DejavuPredictorTest::testMemoryFile()
+{
+    {
+        std::ofstream memory_file(MEMORY_FILENAME);
+        memory_file << "polly wants a cracker" << std::endl
+                    << "polly wants a soda" << std::endl;
+    }
+
+    Predictor* predictor = predictorRegistry->iterator().next();
+
+    {
+        // memory is read from the existing file
+        *stream << "polly wants a ";
+        Prediction expected;
+        expected.addSuggestion(Suggestion("cracker", 1.0));
+        expected.addSuggestion(Suggestion("soda",    1.0));
+        CPPUNIT_ASSERT_EQUAL(expected, predictor->predict(SIZE, 0));
+    }
+
+    {
+        // learnt tokens are remembered and appended to the file
+        std::vector<std::string> change;
+        change.push_back("polly");
+        change.push_back("wants");
+        change.push_back("a");
+        change.push_back("cake");
+        predictor->learn(change);
+
+        *stream << "cake polly wants a ";
+        Prediction expected;
+        expected.addSuggestion(Suggestion("cracker", 1.0));
+        expected.addSuggestion(Suggestion("soda",    1.0));
+        expected.addSuggestion(Suggestion("cake",    1.0));
+        CPPUNIT_ASSERT_EQUAL(expected, predictor->predict(SIZE, 0));
+
+        std::ifstream memory_file(MEMORY_FILENAME);
+        std::string token;
+        std::vector<std::string> tokens;
+        while (memory_file >> token) {
+            tokens.push_back(token);
+        }
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(12), tokens.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("polly"), tokens[8]);
+        CPPUNIT_ASSERT_EQUAL(std::string("cake"), tokens[11]);
+    }
+
+    {
+        // memory is indexed again when the trigger changes
+        config->find(TRIGGER)->set_value("1");
+        *stream << "cake polly ";
+        Prediction expected;
+        expected.addSuggestion(Suggestion("wants", 1.0));
+        expected.addSuggestion(Suggestion("wants", 1.0));
+        expected.addSuggestion(Suggestion("wants", 1.0));
+        CPPUNIT_ASSERT_EQUAL(expected, predictor->predict(SIZE, 0));
+    }
+}
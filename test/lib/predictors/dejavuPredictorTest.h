@@ -38,6 +38,7 @@ public:
     void tearDown();
     
     void testPredict();
+    void testMemoryFile();
 
 private:
     Configuration*  config;
@@ -56,6 +57,7 @@ private:
 
     CPPUNIT_TEST_SUITE( DejavuPredictorTest );
     CPPUNIT_TEST( testPredict );
+    CPPUNIT_TEST( testMemoryFile );
     CPPUNIT_TEST_SUITE_END();
 };
 
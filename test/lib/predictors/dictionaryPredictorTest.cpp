@@ -0,0 +1,167 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+#include "dictionaryPredictorTest.h"
+#include "../common/stringstreamPresageCallback.h"
+
+#include "core/predictorRegistry.h"
+#include <fstream>
+#include <cstdio>  // for remove()
+
+CPPUNIT_TEST_SUITE_REGISTRATION( DictionaryPredictorTest );
+
+const int   DictionaryPredictorTest::SIZE                 = 2;
+const char* DictionaryPredictorTest::NAME                 = "DictionaryPredictor";
+const char* DictionaryPredictorTest::DICTIONARY           = "Presage.Predictors.DictionaryPredictor.DICTIONARY";
+const char* DictionaryPredictorTest::DICTIONARY_FILENAME  = "dictionary.txt";
+const char* DictionaryPredictorTest::FREQUENCIES_FILENAME = "frequencies.txt";
+
+void DictionaryPredictorTest::setUp()
+{
+    std::ofstream dictionary(DICTIONARY_FILENAME);
+    dictionary << "banana"          << std::endl
+	       << "avocado apple"   << std::endl
+	       << "apricot"         << std::endl
+	       << "apple"           << std::endl
+	       << "cherry"          << std::endl;
+    dictionary.close();
+
+    std::ofstream frequencies(FREQUENCIES_FILENAME);
+    frequencies << "banana\t5"     << std::endl
+		<< "avocado\t20"   << std::endl
+		<< "apple\t10"     << std::endl
+		<< "apricot\t40"   << std::endl
+		<< "cherry"        << std::endl;
+    frequencies.close();
+
+    config = new Configuration();
+    // set context tracker config variables
+    config->insert ("Presage.ContextTracker.LOGGER", "ERROR");
+    config->insert ("Presage.ContextTracker.SLIDING_WINDOW_SIZE", "80");
+    config->insert ("Presage.ContextTracker.LOWERCASE_MODE", "no");
+    config->insert ("Presage.ContextTracker.ONLINE_LEARNING", "no");
+    // set predictor registry config variables
+    config->insert ("Presage.PredictorRegistry.LOGGER", "ERROR");
+    config->insert ("Presage.PredictorRegistry.PREDICTORS", "DictionaryPredictor");
+    // set dictionary predictor config variables
+    config->insert ("Presage.Predictors.DictionaryPredictor.PREDICTOR", NAME);
+    config->insert ("Presage.Predictors.DictionaryPredictor.LOGGER", "ERROR");
+    config->insert (DICTIONARY, DICTIONARY_FILENAME);
+    config->insert ("Presage.Predictors.DictionaryPredictor.PROBABILITY", "0.5");
+
+    predictorRegistry = new PredictorRegistry(config);
+    stream = new std::stringstream();
+    callback = new StringstreamPresageCallback(*stream);
+    ct = new ContextTracker(config, predictorRegistry, callback);
+}
+
+void DictionaryPredictorTest::tearDown()
+{
+    delete ct;
+    delete callback;
+    delete stream;
+    delete predictorRegistry;
+    delete config;
+
+    remove(DICTIONARY_FILENAME);
+    remove(FREQUENCIES_FILENAME);
+}
+
+void DictionaryPredictorTest::testPredict()
+{
+    Predictor* predictor = predictorRegistry->iterator().next();
+
+    {
+	// first words in dictionary order, repeated words once
+	*stream << "a";
+	Prediction expected;
+	expected.addSuggestion(Suggestion("avocado", 0.5));
+	expected.addSuggestion(Suggestion("apple",   0.5));
+	CPPUNIT_ASSERT_EQUAL(expected, predictor->predict(SIZE, 0));
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), predictor->predict(10, 0).size());
+    }
+
+    {
+	*stream << "pr";
+	Prediction expected;
+	expected.addSuggestion(Suggestion("apricot", 0.5));
+	CPPUNIT_ASSERT_EQUAL(expected, predictor->predict(SIZE, 0));
+    }
+
+    {
+	*stream << "x";
+	Prediction expected;
+	CPPUNIT_ASSERT_EQUAL(expected, predictor->predict(SIZE, 0));
+    }
+
+    {
+	// every word matches the empty prefix
+	*stream << " ";
+	Prediction expected;
+	expected.addSuggestion(Suggestion("banana",  0.5));
+	expected.addSuggestion(Suggestion("avocado", 0.5));
+	CPPUNIT_ASSERT_EQUAL(expected, predictor->predict(SIZE, 0));
+    }
+}
+
+void DictionaryPredictorTest::testFilter()
+{
+    Predictor* predictor = predictorRegistry->iterator().next();
+
+    *stream << "a";
+    const char* filter[] = { "pr", "p", 0 };
+    Prediction expected;
+    expected.addSuggestion(Suggestion("apricot", 0.5));
+    expected.addSuggestion(Suggestion("apple",   0.5));
+    CPPUNIT_ASSERT_EQUAL(expected, predictor->predict(10, filter));
+}
+
+void DictionaryPredictorTest::testFrequencies()
+{
+    Predictor* predictor = predictorRegistry->iterator().next();
+    config->find(DICTIONARY)->set_value(FREQUENCIES_FILENAME);
+
+    {
+	// most frequent words first
+	*stream << "a";
+	Prediction expected;
+	expected.addSuggestion(Suggestion("apricot", 0.5));
+	expected.addSuggestion(Suggestion("avocado", 0.25));
+	CPPUNIT_ASSERT_EQUAL(expected, predictor->predict(SIZE, 0));
+    }
+
+    {
+	// words without frequency come last
+	*stream << "ppl";
+	Prediction expected;
+	expected.addSuggestion(Suggestion("apple", 0.125));
+	CPPUNIT_ASSERT_EQUAL(expected, predictor->predict(SIZE, 0));
+    }
+
+    {
+	*stream << " ";
+	Prediction actual = predictor->predict(10, 0);
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), actual.size());
+	CPPUNIT_ASSERT_EQUAL(std::string("cherry"), actual.getSuggestion(4).getWord());
+    }
+}
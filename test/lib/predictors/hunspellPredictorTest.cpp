@@ -0,0 +1,218 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+
+#include "hunspellPredictorTest.h"
+#include "../common/stringstreamPresageCallback.h"
+
+#include "core/predictorRegistry.h"
+#include "presage.h"
+
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <cstdio>  // for remove()
+
+CPPUNIT_TEST_SUITE_REGISTRATION( HunspellPredictorTest );
+
+const int   HunspellPredictorTest::SIZE       = 10;
+const char* HunspellPredictorTest::NAME       = "HunspellPredictor";
+const char* HunspellPredictorTest::CACHE_SIZE = "Presage.Predictors.HunspellPredictor.CACHE_SIZE";
+const char* HunspellPredictorTest::TIMEOUT    = "Presage.Predictors.HunspellPredictor.TIMEOUT";
+const char* HunspellPredictorTest::PROFILE_FILENAME = "hunspellPredictorTest.xml";
+const char* HunspellPredictorTest::JOURNAL_FILENAME = "hunspellPredictorTest.journal";
+
+void HunspellPredictorTest::setUp()
+{
+    Hunspell::words().clear();
+    Hunspell::words().push_back("app");
+    Hunspell::words().push_back("apple");
+    Hunspell::words().push_back("apply");
+    Hunspell::words().push_back("application");
+    Hunspell::words().push_back("banana");
+    Hunspell::words().push_back("cherry");
+    Hunspell::calls() = 0;
+    Hunspell::hold(false);
+
+    config = new Configuration();
+    // set context tracker config variables
+    config->insert ("Presage.ContextTracker.LOGGER", "ERROR");
+    config->insert ("Presage.ContextTracker.SLIDING_WINDOW_SIZE", "80");
+    config->insert ("Presage.ContextTracker.LOWERCASE_MODE", "no");
+    config->insert ("Presage.ContextTracker.ONLINE_LEARNING", "no");
+    // set predictor registry config variables
+    config->insert ("Presage.PredictorRegistry.LOGGER", "ERROR");
+    config->insert ("Presage.PredictorRegistry.PREDICTORS", "");
+    // set hunspell predictor config variables, the stub ignores the dictionary
+    config->insert ("Presage.Predictors.HunspellPredictor.LOGGER", "ERROR");
+    config->insert ("Presage.Predictors.HunspellPredictor.DICTIONARYBASE", "dictionary");
+    config->insert ("Presage.Predictors.HunspellPredictor.PROBABILITY", "0.5");
+    config->insert (CACHE_SIZE, "8");
+    config->insert (TIMEOUT, "0");
+
+    predictorRegistry = new PredictorRegistry(config);
+    stream = new std::stringstream();
+    callback = new StringstreamPresageCallback(*stream);
+    ct = new ContextTracker(config, predictorRegistry, callback);
+    predictor = new HunspellPredictor(config, ct, NAME);
+}
+
+void HunspellPredictorTest::tearDown()
+{
+    // a held speller would never let the predictor join its worker
+    Hunspell::hold(false);
+
+    delete predictor;
+    delete ct;
+    delete callback;
+    delete stream;
+    delete predictorRegistry;
+    delete config;
+
+    remove(PROFILE_FILENAME);
+    remove(JOURNAL_FILENAME);
+}
+
+void HunspellPredictorTest::testCacheHit()
+{
+    *stream << "app";
+    Prediction expected = predictor->predict(SIZE, 0);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), expected.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("app"), expected.getSuggestion(0).getWord());
+    CPPUNIT_ASSERT_EQUAL(1, Hunspell::calls().load());
+
+    // same prefix, answered by the cache
+    CPPUNIT_ASSERT_EQUAL(expected, predictor->predict(SIZE, 0));
+    CPPUNIT_ASSERT_EQUAL(1, Hunspell::calls().load());
+}
+
+void HunspellPredictorTest::testTimeout()
+{
+    config->find(TIMEOUT)->set_value("20");
+    Hunspell::hold(true);
+
+    // nothing cached to fall back on
+    *stream << "ban";
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), predictor->predict(SIZE, 0).size());
+
+    // the late speller is waited for once released
+    Hunspell::hold(false);
+    config->find(TIMEOUT)->set_value("0");
+    Prediction actual = predictor->predict(SIZE, 0);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), actual.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("banana"), actual.getSuggestion(0).getWord());
+}
+
+void HunspellPredictorTest::testTimeoutExtend()
+{
+    *stream << "app";
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), predictor->predict(SIZE, 0).size());
+
+    config->find(TIMEOUT)->set_value("20");
+    Hunspell::hold(true);
+
+    // late on appli, the cached suffixes of app are filtered instead
+    *stream << "li";
+    Prediction actual = predictor->predict(SIZE, 0);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), actual.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("application"), actual.getSuggestion(0).getWord());
+}
+
+void HunspellPredictorTest::testEviction()
+{
+    config->find(CACHE_SIZE)->set_value("2");
+
+    *stream << "app";
+    predictor->predict(SIZE, 0);
+    *stream << " ban";
+    predictor->predict(SIZE, 0);
+    CPPUNIT_ASSERT_EQUAL(2, Hunspell::calls().load());
+
+    // app is the least recent prefix
+    *stream << " che";
+    predictor->predict(SIZE, 0);
+    CPPUNIT_ASSERT_EQUAL(3, Hunspell::calls().load());
+    *stream << " ban";
+    predictor->predict(SIZE, 0);
+    CPPUNIT_ASSERT_EQUAL(3, Hunspell::calls().load());
+    *stream << " app";
+    predictor->predict(SIZE, 0);
+    CPPUNIT_ASSERT_EQUAL(4, Hunspell::calls().load());
+
+    // ban was used after che, hence che was dropped for app
+    *stream << " ban";
+    predictor->predict(SIZE, 0);
+    CPPUNIT_ASSERT_EQUAL(4, Hunspell::calls().load());
+    *stream << " che";
+    predictor->predict(SIZE, 0);
+    CPPUNIT_ASSERT_EQUAL(5, Hunspell::calls().load());
+}
+
+void HunspellPredictorTest::testPresageLate()
+{
+    std::ofstream profile(PROFILE_FILENAME);
+    profile << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\" ?>" << std::endl
+	    << "<Presage>" << std::endl
+	    << "<PredictorRegistry><LOGGER>ERROR</LOGGER>"
+	    << "<PREDICTORS>HunspellPredictor</PREDICTORS></PredictorRegistry>" << std::endl
+	    << "<ContextTracker><LOGGER>ERROR</LOGGER><SLIDING_WINDOW_SIZE>80</SLIDING_WINDOW_SIZE>"
+	    << "<LOWERCASE_MODE>no</LOWERCASE_MODE><ONLINE_LEARNING>no</ONLINE_LEARNING></ContextTracker>" << std::endl
+	    << "<Selector><LOGGER>ERROR</LOGGER><SUGGESTIONS>6</SUGGESTIONS>"
+	    << "<REPEAT_SUGGESTIONS>no</REPEAT_SUGGESTIONS>"
+	    << "<GREEDY_SUGGESTION_THRESHOLD>0</GREEDY_SUGGESTION_THRESHOLD></Selector>" << std::endl
+	    << "<PredictorActivator><LOGGER>ERROR</LOGGER><PREDICT_TIME>1000</PREDICT_TIME>"
+	    << "<MAX_PARTIAL_PREDICTION_SIZE>60</MAX_PARTIAL_PREDICTION_SIZE>"
+	    << "<COMBINATION_POLICY>Meritocracy</COMBINATION_POLICY></PredictorActivator>" << std::endl
+	    << "<PredictionCache><LOGGER>ERROR</LOGGER><SIZE>32</SIZE>"
+	    << "<CONTEXT_TOKENS>3</CONTEXT_TOKENS></PredictionCache>" << std::endl
+	    << "<Learner><LOGGER>ERROR</LOGGER><QUEUE_SIZE>0</QUEUE_SIZE><IDLE_DELAY>0</IDLE_DELAY>"
+	    << "<CONTEXT_TOKENS>2</CONTEXT_TOKENS><JOURNAL>" << JOURNAL_FILENAME << "</JOURNAL></Learner>" << std::endl
+	    << "<ProfileManager><LOGGER>ERROR</LOGGER><AUTOPERSIST>false</AUTOPERSIST></ProfileManager>" << std::endl
+	    << "<Predictors><HunspellPredictor><PREDICTOR>HunspellPredictor</PREDICTOR>"
+	    << "<LOGGER>ERROR</LOGGER><DICTIONARYBASE>dictionary</DICTIONARYBASE>"
+	    << "<PROBABILITY>0.5</PROBABILITY><CACHE_SIZE>8</CACHE_SIZE>"
+	    << "<TIMEOUT>20</TIMEOUT></HunspellPredictor></Predictors>" << std::endl
+	    << "</Presage>" << std::endl;
+    profile.close();
+
+    std::stringstream past;
+    StringstreamPresageCallback presage_callback(past);
+    Presage presage(&presage_callback, PROFILE_FILENAME);
+
+    // the speller is late, the prediction goes without it
+    Hunspell::hold(true);
+    past << "ban";
+    CPPUNIT_ASSERT(presage.predict().empty());
+    Hunspell::hold(false);
+
+    // the partial prediction was not cached, the speller answer is
+    // picked up once it is ready
+    std::vector<std::string> actual;
+    for (int i = 0; i < 500 && actual.empty(); i++) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	actual = presage.predict();
+    }
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), actual.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("banana"), actual[0]);
+}
@@ -0,0 +1,72 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+
+#ifndef PRESAGE_HUNSPELLPREDICTORTEST
+#define PRESAGE_HUNSPELLPREDICTORTEST
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <predictors/hunspellPredictor.h>
+
+/** Test HunspellPredictor against the stub speller.
+ * 
+ */
+class HunspellPredictorTest : public CppUnit::TestFixture {
+public: 
+    void setUp();
+    void tearDown();
+    
+    void testCacheHit();
+    void testTimeout();
+    void testTimeoutExtend();
+    void testEviction();
+    void testPresageLate();
+
+private:
+    Configuration*  config;
+    PredictorRegistry* predictorRegistry;
+    std::stringstream* stream;
+    PresageCallback* callback;
+    ContextTracker* ct;
+    HunspellPredictor* predictor;
+
+    static const int SIZE;
+    static const char* NAME;
+    static const char* CACHE_SIZE;
+    static const char* TIMEOUT;
+    static const char* PROFILE_FILENAME;
+    static const char* JOURNAL_FILENAME;
+
+    CPPUNIT_TEST_SUITE( HunspellPredictorTest );
+    CPPUNIT_TEST( testCacheHit );
+    CPPUNIT_TEST( testTimeout );
+    CPPUNIT_TEST( testTimeoutExtend );
+    CPPUNIT_TEST( testEviction );
+    CPPUNIT_TEST( testPresageLate );
+    CPPUNIT_TEST_SUITE_END();
+};
+
+
+#endif // PRESAGE_HUNSPELLPREDICTORTEST
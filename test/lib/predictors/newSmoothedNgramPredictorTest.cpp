@@ -26,6 +26,7 @@
 #include "../common/stringstreamPresageCallback.h"
 
 #include "core/predictorRegistry.h"
+#include "core/learner.h"
 
 #include <cstdio>  // for remove()
 
@@ -322,3 +323,71 @@ void NewSmoothedNgramPredictorTest::testFilter()
     }
 
 }
+
+void NewSmoothedNgramPredictorTest::testPrefixExtension()
+{
+    // get pointer to predictor
+    Predictor* predictor = predictorRegistry->iterator().next();
+
+    std::vector<std::string> change;
+    const char* words[] = { "the", "quick", "Queen", "quietly", "quits",
+			    "the", "quiz", "the", "quack", "quality",
+			    "quorum", "the", "quilt", "quip", "quint", 0 };
+    for (int i = 0; words[i] != 0; i++) {
+	change.push_back(words[i]);
+    }
+    predictor->learn(change);
+
+    // predictions narrowed down from the previous keystroke must match
+    // those computed from scratch, whether or not the previous
+    // candidates were all the matching words
+    const char* prefixes[] = { "", "q", "qu", "qui", "quie", 0 };
+    for (size_t size = 1; size <= 6; size++) {
+	for (int i = 0; prefixes[i] != 0; i++) {
+	    stream->str(std::string("so the ") + prefixes[i]);
+
+	    Prediction actual = predictor->predict(size, 0);
+
+	    SmoothedNgramPredictor fresh(config, ct, "SmoothedNgramPredictor");
+	    Prediction expected = fresh.predict(size, 0);
+
+	    CPPUNIT_ASSERT_EQUAL(expected.toString(), actual.toString());
+	}
+    }
+}
+
+void NewSmoothedNgramPredictorTest::testLearner()
+{
+    config->insert (Learner::LOGGER, "ERROR");
+    config->insert (Learner::QUEUE_SIZE, "8");
+    config->insert (Learner::IDLE_DELAY, "60000");
+    config->insert (Learner::CONTEXT_TOKENS, "2");
+    config->insert (Learner::JOURNAL, "");
+    Learner* learner = new Learner(config, ct);
+
+    *stream << "the quick brown ";
+    ct->update();
+    learner->flush();
+
+    // the past stream has moved on by the time fox is learnt, the
+    // predictor must see the tokens that preceded it
+    *stream << "fox ";
+    ct->update();
+    stream->str("once upon a time ");
+    ct->update();
+    CPPUNIT_ASSERT_EQUAL(2ul, (unsigned long) learner->pending());
+    learner->flush();
+    delete learner;
+
+    SqliteDatabaseConnector db(DATABASE, CARDINALITY, false);
+    Ngram ngram;
+    ngram.push_back("brown");
+    ngram.push_back("fox");
+    CPPUNIT_ASSERT_EQUAL(1, db.getNgramCount(ngram));
+    ngram.insert(ngram.begin(), "quick");
+    CPPUNIT_ASSERT_EQUAL(1, db.getNgramCount(ngram));
+    ngram.clear();
+    ngram.push_back("time");
+    ngram.push_back("fox");
+    CPPUNIT_ASSERT_EQUAL(0, db.getNgramCount(ngram));
+}
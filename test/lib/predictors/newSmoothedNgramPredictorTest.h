@@ -45,6 +45,8 @@ public:
     void testOnlineLearning();
     void testOfflineLearning();
     void testFilter();
+    void testPrefixExtension();
+    void testLearner();
 
 private:
     Configuration*  config;
@@ -64,6 +66,8 @@ private:
     CPPUNIT_TEST( testOnlineLearning );
     CPPUNIT_TEST( testOfflineLearning );
     CPPUNIT_TEST( testFilter );
+    CPPUNIT_TEST( testPrefixExtension );
+    CPPUNIT_TEST( testLearner );
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -35,7 +35,8 @@ ContextTracker::ContextTracker(Configuration* config,
 			       const char sc[],
 			       const char bc[],
 			       const char cc[])
-    : logger ("MockContextTracker", std::cerr),
+    : scanner (bc, sc),
+      logger ("MockContextTracker", std::cerr),
       dispatcher (this)
 {
     const char** history = (const char**) config;
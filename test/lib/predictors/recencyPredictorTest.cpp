@@ -176,3 +176,67 @@ void RecencyPredictorTest::testFilter()
     }
 
 }
+
+void RecencyPredictorTest::testChangingContext()
+{
+    RecencyPredictor predictor(config, ct, NAME);
+
+    *stream << "foo bar f";
+    {
+	Prediction expected;
+	expected.addSuggestion(Suggestion("foo",    1.0 * exp(-1.0 * 1)));
+	CPPUNIT_ASSERT_EQUAL(expected, predictor.predict(SIZE, 0));
+    }
+
+    // tokens appended to the context
+    *stream << "oobar baz fo";
+    {
+	Prediction expected;
+	expected.addSuggestion(Suggestion("foobar", 1.0 * exp(-1.0 * 1)));
+	expected.addSuggestion(Suggestion("foo",    1.0 * exp(-1.0 * 3)));
+	CPPUNIT_ASSERT_EQUAL(expected, predictor.predict(SIZE, 0));
+    }
+
+    // earlier token changed
+    stream->str("fig bar foobar baz f");
+    {
+	Prediction expected;
+	expected.addSuggestion(Suggestion("foobar", 1.0 * exp(-1.0 * 1)));
+	expected.addSuggestion(Suggestion("fig",    1.0 * exp(-1.0 * 3)));
+	CPPUNIT_ASSERT_EQUAL(expected, predictor.predict(SIZE, 0));
+    }
+
+    // tokens deleted from the context
+    stream->str("fig f");
+    {
+	Prediction expected;
+	expected.addSuggestion(Suggestion("fig",    1.0 * exp(-1.0 * 0)));
+	CPPUNIT_ASSERT_EQUAL(expected, predictor.predict(SIZE, 0));
+    }
+}
+
+void RecencyPredictorTest::testLargeCutoffThreshold()
+{
+    config->insert (LAMBDA, "0.001");
+
+    *stream << "foo";
+    for (int i = 0; i < 999; i++) {
+	*stream << " bar";
+    }
+    *stream << " f";
+
+    {
+	config->insert (CUTOFF, "999");
+	Prediction expected;
+	RecencyPredictor predictor(config, ct, NAME);
+	CPPUNIT_ASSERT_EQUAL(expected, predictor.predict(SIZE, 0));
+    }
+
+    {
+	config->insert (CUTOFF, "1000");
+	Prediction expected;
+	expected.addSuggestion(Suggestion("foo",    1.0 * exp(-0.001 * 999)));
+	RecencyPredictor predictor(config, ct, NAME);
+	CPPUNIT_ASSERT_EQUAL(expected, predictor.predict(SIZE, 0));
+    }
+}
@@ -40,6 +40,8 @@ public:
     void testMaxPartialPredictionSize();
     void testCutoffThreshold();
     void testFilter();
+    void testChangingContext();
+    void testLargeCutoffThreshold();
 
 private:
     Configuration*  config;
@@ -60,6 +62,8 @@ private:
     CPPUNIT_TEST( testMaxPartialPredictionSize );
     CPPUNIT_TEST( testCutoffThreshold );
     CPPUNIT_TEST( testFilter );
+    CPPUNIT_TEST( testChangingContext );
+    CPPUNIT_TEST( testLargeCutoffThreshold );
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -0,0 +1,165 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#include "smoothedNgramTriePredictorTest.h"
+#include "../common/stringstreamPresageCallback.h"
+
+#include "core/predictorRegistry.h"
+
+#include <marisa.h>
+
+#include <fstream>
+#include <sstream>
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SmoothedNgramTriePredictorTest );
+
+const char*  SmoothedNgramTriePredictorTest::DATABASE = "trie_predictor_database";
+
+const int    SmoothedNgramTriePredictorTest::SIZE     = 20;
+
+void SmoothedNgramTriePredictorTest::setUp()
+{
+    // prepare database, holding a single unigram
+    mkdir(DATABASE, 0755);
+    {
+	marisa::Keyset keyset;
+	keyset.push_back("1 the", 5);
+	marisa::Trie trie;
+	trie.build(keyset);
+	trie.save((std::string(DATABASE) + "/ngrams.trie").c_str());
+
+	int32_t counts[] = { 1, 1 };
+	std::ofstream out((std::string(DATABASE) + "/ngrams.counts").c_str(),
+			  std::ios::out | std::ios::binary);
+	out.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+    }
+
+    config = new Configuration();
+    // set context tracker config variables
+    config->insert ("Presage.ContextTracker.LOGGER", "ERROR");
+    config->insert ("Presage.ContextTracker.SLIDING_WINDOW_SIZE", "80");
+    config->insert ("Presage.ContextTracker.LOWERCASE_MODE", "no");
+    config->insert ("Presage.ContextTracker.ONLINE_LEARNING", "no");
+
+    // set predictor registry config variables
+    config->insert ("Presage.PredictorRegistry.LOGGER", "ERROR");
+    config->insert ("Presage.PredictorRegistry.PREDICTORS", "SmoothedNgramTriePredictor");
+    // set predictor config variables
+    config->insert ("Presage.Predictors.SmoothedNgramTriePredictor.PREDICTOR", "SmoothedNgramTriePredictor");
+    config->insert ("Presage.Predictors.SmoothedNgramTriePredictor.LOGGER", "ERROR");
+    config->insert ("Presage.Predictors.SmoothedNgramTriePredictor.DELTAS", "0.001 0.01 0.889");
+    config->insert ("Presage.Predictors.SmoothedNgramTriePredictor.COUNT_THRESHOLD", "0");
+    config->insert ("Presage.Predictors.SmoothedNgramTriePredictor.DBFILENAME", DATABASE);
+    config->insert ("Presage.Predictors.SmoothedNgramTriePredictor.LEARN", "true");
+    config->insert ("Presage.Predictors.SmoothedNgramTriePredictor.DatabaseConnector.LOGGER", "ERROR");
+
+    predictorRegistry = new PredictorRegistry(config);
+    stream = new std::stringstream();
+    callback = new StringstreamPresageCallback(*stream);
+    ct = new ContextTracker(config, predictorRegistry, callback);
+
+    predictor = predictorRegistry->iterator().next();
+}
+
+void SmoothedNgramTriePredictorTest::tearDown()
+{
+    delete ct;
+    delete callback;
+    delete stream;
+    delete predictorRegistry;
+    delete config;
+
+    remove((std::string(DATABASE) + "/ngrams.trie").c_str());
+    remove((std::string(DATABASE) + "/ngrams.counts").c_str());
+    remove((std::string(DATABASE) + "/ngrams.log").c_str());
+    rmdir(DATABASE);
+}
+
+void SmoothedNgramTriePredictorTest::learn(const char* text)
+{
+    // the change is the text after the first word, which is learnt
+    // as its context from the past stream
+    stream->str(text);
+    std::vector<std::string> change;
+    std::stringstream words(text);
+    std::string word;
+    words >> word;
+    while (words >> word) {
+	change.push_back(word);
+    }
+    predictor->learn(change);
+}
+
+std::string SmoothedNgramTriePredictorTest::predictFirst(const char* context)
+{
+    stream->str(context);
+    Prediction prediction = predictor->predict(SIZE, 0);
+    return (prediction.size() > 0 ? prediction.getSuggestion(0).getWord() : "");
+}
+
+bool SmoothedNgramTriePredictorTest::predicts(const char* context, const char* word)
+{
+    stream->str(context);
+    Prediction prediction = predictor->predict(SIZE, 0);
+    for (size_t i = 0; i < prediction.size(); i++) {
+	if (prediction.getSuggestion(i).getWord() == word) {
+	    return true;
+	}
+    }
+    return false;
+}
+
+void SmoothedNgramTriePredictorTest::testLearn()
+{
+    learn("the foo bar foobar ");
+
+    CPPUNIT_ASSERT_EQUAL(std::string("bar"), predictFirst("foo "));
+    CPPUNIT_ASSERT_EQUAL(std::string("foobar"), predictFirst("bar "));
+    CPPUNIT_ASSERT_EQUAL(std::string("foobar"), predictFirst("foo bar "));
+
+    // the first word of the change is learnt in the context of the
+    // past stream
+    CPPUNIT_ASSERT_EQUAL(std::string("foo"), predictFirst("the "));
+
+    // learnt counts persist
+    config->find ("Presage.Predictors.SmoothedNgramTriePredictor.DBFILENAME")->set_value (DATABASE);
+    CPPUNIT_ASSERT_EQUAL(std::string("bar"), predictFirst("foo "));
+}
+
+void SmoothedNgramTriePredictorTest::testForget()
+{
+    learn("the foo bar foobar ");
+    learn("the foo baz ");
+    CPPUNIT_ASSERT(predicts("foo ", "bar"));
+
+    predictor->forget("bar");
+    CPPUNIT_ASSERT(! predicts("foo ", "bar"));
+    CPPUNIT_ASSERT(! predicts("b", "bar"));
+    CPPUNIT_ASSERT_EQUAL(std::string("baz"), predictFirst("foo "));
+    CPPUNIT_ASSERT(predicts("", "foobar"));
+}
@@ -0,0 +1,125 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+
+#ifndef PRESAGE_HUNSPELLSTUB
+#define PRESAGE_HUNSPELLSTUB
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+/** Stub of the Hunspell speller used to test HunspellPredictor.
+ *
+ * The dictionary files are ignored: the words known to the speller
+ * are set by the test through words(). A held speller blocks on
+ * spell() until it is released, which lets a test make the speller
+ * late on purpose.
+ *
+ */
+class Hunspell {
+public:
+    Hunspell (const char* affpath, const char* dpath) { }
+
+    bool spell (const std::string& word)
+    {
+	{
+	    std::unique_lock<std::mutex> lock(gate_mutex());
+	    gate_condition().wait(lock, [] { return ! held(); });
+	}
+	calls()++;
+	return std::find(words().begin(), words().end(), word) != words().end();
+    }
+
+    /** Suggests the known words starting with the same letter. */
+    std::vector<std::string> suggest (const std::string& word)
+    {
+	std::vector<std::string> result;
+	for (size_t i = 0; i < words().size(); i++) {
+	    if (! word.empty() && words()[i][0] == word[0]) {
+		result.push_back(words()[i]);
+	    }
+	}
+	return result;
+    }
+
+    /** Suggests the known words extending root_word. */
+    std::vector<std::string> suffix_suggest (const std::string& root_word)
+    {
+	std::vector<std::string> result;
+	for (size_t i = 0; i < words().size(); i++) {
+	    if (words()[i].size() > root_word.size()
+		&& words()[i].compare(0, root_word.size(), root_word) == 0) {
+		result.push_back(words()[i]);
+	    }
+	}
+	return result;
+    }
+
+    static std::vector<std::string>& words()
+    {
+	static std::vector<std::string> instance;
+	return instance;
+    }
+
+    /** Number of words spelled so far. */
+    static std::atomic<int>& calls()
+    {
+	static std::atomic<int> instance(0);
+	return instance;
+    }
+
+    static void hold (bool value)
+    {
+	{
+	    std::lock_guard<std::mutex> lock(gate_mutex());
+	    held() = value;
+	}
+	gate_condition().notify_all();
+    }
+
+private:
+    static bool& held()
+    {
+	static bool instance = false;
+	return instance;
+    }
+
+    static std::mutex& gate_mutex()
+    {
+	static std::mutex instance;
+	return instance;
+    }
+
+    static std::condition_variable& gate_condition()
+    {
+	static std::condition_variable instance;
+	return instance;
+    }
+};
+
+#endif // PRESAGE_HUNSPELLSTUB
@@ -0,0 +1,83 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+#include "latencyTest.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION( LatencyHistogramTest );
+
+void LatencyHistogramTest::setUp()
+{
+}
+
+void LatencyHistogramTest::tearDown()
+{
+}
+
+void LatencyHistogramTest::testPercentiles()
+{
+    LatencyHistogram histogram;
+    // samples added out of order
+    for (int i = 100; i >= 1; i--) {
+	histogram.add(i);
+    }
+
+    CPPUNIT_ASSERT_EQUAL(size_t(100), histogram.count());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(50.5, histogram.mean(), 1e-9);
+    CPPUNIT_ASSERT_EQUAL(50.0,  histogram.percentile(50));
+    CPPUNIT_ASSERT_EQUAL(95.0,  histogram.percentile(95));
+    CPPUNIT_ASSERT_EQUAL(99.0,  histogram.percentile(99));
+    CPPUNIT_ASSERT_EQUAL(1.0,   histogram.percentile(0));
+    CPPUNIT_ASSERT_EQUAL(100.0, histogram.max());
+
+    // percentiles follow samples added later
+    histogram.add(1000);
+    CPPUNIT_ASSERT_EQUAL(1000.0, histogram.max());
+}
+
+void LatencyHistogramTest::testBuckets()
+{
+    LatencyHistogram histogram;
+    histogram.add(0.5);
+    histogram.add(1);
+    histogram.add(3);
+    histogram.add(3.5);
+    histogram.add(8);
+
+    // [0, 1) [1, 2) [2, 4) [4, 8) [8, 16)
+    const size_t expected[] = { 1, 1, 2, 0, 1 };
+    std::vector<size_t> buckets = histogram.buckets();
+    CPPUNIT_ASSERT_EQUAL(sizeof(expected) / sizeof(expected[0]), buckets.size());
+    for (size_t i = 0; i < buckets.size(); i++) {
+	CPPUNIT_ASSERT_EQUAL(expected[i], buckets[i]);
+    }
+}
+
+void LatencyHistogramTest::testEmpty()
+{
+    LatencyHistogram histogram;
+
+    CPPUNIT_ASSERT_EQUAL(size_t(0), histogram.count());
+    CPPUNIT_ASSERT_EQUAL(0.0, histogram.mean());
+    CPPUNIT_ASSERT_EQUAL(0.0, histogram.percentile(99));
+    CPPUNIT_ASSERT(histogram.buckets().empty());
+}
@@ -0,0 +1,47 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+#ifndef PRESAGE_LATENCYTEST
+#define PRESAGE_LATENCYTEST
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "tools/latency.h"
+
+class LatencyHistogramTest : public CppUnit::TestFixture { 
+public:
+    void setUp();
+    void tearDown();
+
+    void testPercentiles();
+    void testBuckets();
+    void testEmpty();
+
+private:
+    CPPUNIT_TEST_SUITE( LatencyHistogramTest );
+    CPPUNIT_TEST( testPercentiles );
+    CPPUNIT_TEST( testBuckets     );
+    CPPUNIT_TEST( testEmpty       );
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // PRESAGE_LATENCYTEST
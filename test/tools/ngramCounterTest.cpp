@@ -0,0 +1,163 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#include "ngramCounterTest.h"
+
+#include <sstream>
+#include <stdio.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION( NgramCounterTest );
+
+const size_t NgramCounterTest::CARDINALITY = 2;
+
+void NgramCounterTest::setUp()
+{
+    // "a" sorts before "ab", which matters when n-grams are compared
+    // token by token rather than as joined strings
+    const char* words[] = { "the", "ab", "a", "b", "the", "a", "b", "", "the", "ab", "a", "zz", "the", "a" };
+    tokens.assign(words, words + sizeof(words) / sizeof(words[0]));
+
+    expected.clear();
+    for (size_t i = 0; i + CARDINALITY <= tokens.size(); i++) {
+	std::vector<std::string> ngram(tokens.begin() + i, tokens.begin() + i + CARDINALITY);
+	expected[ngram]++;
+    }
+}
+
+void NgramCounterTest::tearDown()
+{
+    tokens.clear();
+    expected.clear();
+}
+
+void NgramCounterTest::countAll(NgramCounter& counter) const
+{
+    for (size_t i = 0; i + CARDINALITY <= tokens.size(); i++) {
+	counter.count(tokens, i);
+    }
+}
+
+void NgramCounterTest::testSortedCounts()
+{
+    NgramCounter counter(CARDINALITY, ".", 0, 0);
+    countAll(counter);
+
+    std::vector<NgramCount> counts;
+    counter.sortedCounts(counts);
+    CPPUNIT_ASSERT(counter.getRuns().empty());
+
+    CPPUNIT_ASSERT_EQUAL(expected.size(), counts.size());
+    std::map<std::vector<std::string>, long>::const_iterator it = expected.begin();
+    for (size_t i = 0; i < counts.size(); i++, it++) {
+	CPPUNIT_ASSERT(it->first == counts[i].first);
+	CPPUNIT_ASSERT_EQUAL(it->second, counts[i].second);
+    }
+}
+
+void NgramCounterTest::testSpillAndMerge()
+{
+    // a tiny memory budget forces a spill every few n-grams
+    NgramCounter counter(CARDINALITY, ".", 200, 1);
+    countAll(counter);
+    countAll(counter);
+    counter.spill();
+    CPPUNIT_ASSERT(counter.getRuns().size() > 2);
+
+    NgramRunMerger merger(".", 2);
+    size_t distinct = 0;
+    std::string merged = merger.merge(counter.getRuns(), distinct);
+    CPPUNIT_ASSERT_EQUAL(expected.size(), distinct);
+
+    NgramRunReader reader(merged);
+    NgramCount ngram;
+    std::map<std::vector<std::string>, long>::const_iterator it = expected.begin();
+    while (reader.next(ngram)) {
+	CPPUNIT_ASSERT(it != expected.end());
+	CPPUNIT_ASSERT(it->first == ngram.first);
+	CPPUNIT_ASSERT_EQUAL(2 * it->second, ngram.second);
+	it++;
+    }
+    CPPUNIT_ASSERT(it == expected.end());
+
+    remove(merged.c_str());
+}
+
+void NgramCounterTest::testRunReader()
+{
+    NgramCount ngram;
+    ngram.first.push_back("foo");
+    ngram.first.push_back("");
+    ngram.second = 42;
+
+    std::stringstream ss;
+    NgramRunMerger::write(ss, ngram);
+    CPPUNIT_ASSERT_EQUAL(std::string("foo\t\t42\n"), ss.str());
+
+    const char* filename = "ngramCounterTest.run";
+    {
+	std::ofstream out(filename);
+	out << ss.str();
+    }
+
+    NgramRunReader reader(filename);
+    NgramCount read;
+    CPPUNIT_ASSERT(reader.next(read));
+    CPPUNIT_ASSERT(ngram.first == read.first);
+    CPPUNIT_ASSERT_EQUAL(42L, read.second);
+    CPPUNIT_ASSERT(! reader.next(read));
+
+    remove(filename);
+}
+
+void NgramCounterTest::testMixedCardinality()
+{
+    // 1-grams and 2-grams counted together, spilled every few n-grams
+    std::map<std::vector<std::string>, long> mixed(expected);
+    NgramCounter counter(CARDINALITY, ".", 200, 2);
+    countAll(counter);
+    for (size_t i = 0; i < tokens.size(); i++) {
+	counter.count(tokens, i, 1, 3);
+	mixed[std::vector<std::string>(1, tokens[i])] += 3;
+    }
+    counter.spill();
+    CPPUNIT_ASSERT(counter.getRuns().size() > 2);
+
+    NgramRunMerger merger(".", 2);
+    size_t distinct = 0;
+    std::string merged = merger.merge(counter.getRuns(), distinct);
+    CPPUNIT_ASSERT_EQUAL(mixed.size(), distinct);
+
+    NgramRunReader reader(merged);
+    NgramCount ngram;
+    std::map<std::vector<std::string>, long>::const_iterator it = mixed.begin();
+    while (reader.next(ngram)) {
+	CPPUNIT_ASSERT(it != mixed.end());
+	CPPUNIT_ASSERT(it->first == ngram.first);
+	CPPUNIT_ASSERT_EQUAL(it->second, ngram.second);
+	it++;
+    }
+    CPPUNIT_ASSERT(it == mixed.end());
+
+    remove(merged.c_str());
+}
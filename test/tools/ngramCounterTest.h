@@ -0,0 +1,60 @@
+
+/******************************************************
+ *  Presage, an extensible predictive text entry system
+ *  ---------------------------------------------------
+ *
+ *  Copyright (C) 2008  Matteo Vescovi <matteo.vescovi@yahoo.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+                                                                             *
+                                                                **********(*)*/
+
+
+#ifndef PRESAGE_NGRAMCOUNTERTEST
+#define PRESAGE_NGRAMCOUNTERTEST
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "tools/ngramCounter.h"
+
+#include <map>
+
+class NgramCounterTest : public CppUnit::TestFixture { 
+public:
+    void setUp();
+    void tearDown();
+
+    void testSortedCounts();
+    void testSpillAndMerge();
+    void testRunReader();
+    void testMixedCardinality();
+
+private:
+    void countAll(NgramCounter& counter) const;
+
+    std::vector<std::string> tokens;
+    std::map<std::vector<std::string>, long> expected;
+
+    static const size_t CARDINALITY;
+
+    CPPUNIT_TEST_SUITE( NgramCounterTest );
+    CPPUNIT_TEST( testSortedCounts  );
+    CPPUNIT_TEST( testSpillAndMerge );
+    CPPUNIT_TEST( testRunReader     );
+    CPPUNIT_TEST( testMixedCardinality );
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // PRESAGE_NGRAMCOUNTERTEST